@@ -6,72 +6,159 @@
                  0x1 + 1x2 + 2x3 + 2x4 + 1x5 ≥ 12
 */
 
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <memory>
 #include "gurobi_c++.h"
+#include "dualcheck.h"
+#include "linexpr.h"
+#include "phase.h"
+#include "solution.h"
+#include "tracecallback.h"
 using namespace std;
 
+/* Usage:  diet [-csv file] [-bin file] [-trace file.mlog]
+                [-phases report.json] [-verifydual]
+
+   -csv and -bin also write the solution to file, see solution.h.  -trace
+   records the solve from a callback into a log store (tracecallback.h).
+   -phases times the phases of the run with their RSS and writes them as a
+   JSON report (../C/phase.h).
+   The dual values are the Pi and RC of this one solve, which diet checks
+   for strong duality (dualcheck.h); diet_dual is not needed for them.
+   -verifydual also solves the transposed dual model, for testing only.
+   Build with solution.c++, dualcheck.c++, ../C/dualcheck.c, ../C/solvetrace.c,
+   ../C/phase.c, -I../C and -lpthread.
+*/
+
 int
 main(int   argc,
      char *argv[])
 {
+  const char *csvfile = NULL;
+  const char *binfile = NULL;
+  const char *tracefile = NULL;
+  SolveTrace *trace = NULL;
+  const char *phasefile = NULL;
+  PhaseLog *phases = NULL;
+  bool verifydual = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-csv") == 0 && i+1 < argc) {
+      csvfile = argv[++i];
+    } else if (strcmp(argv[i], "-bin") == 0 && i+1 < argc) {
+      binfile = argv[++i];
+    } else if (strcmp(argv[i], "-trace") == 0 && i+1 < argc) {
+      tracefile = argv[++i];
+    } else if (strcmp(argv[i], "-phases") == 0 && i+1 < argc) {
+      phasefile = argv[++i];
+    } else if (strcmp(argv[i], "-verifydual") == 0) {
+      verifydual = true;
+    } else {
+      cerr << "usage: " << argv[0] << " [-csv file] [-bin file] [-trace file.mlog]"
+           << " [-phases report.json] [-verifydual]" << endl;
+      return 1;
+    }
+  }
+
+  if (phasefile && (phases = ph_create("diet")) == NULL) {
+    cerr << "Out of memory" << endl;
+    return 1;
+  }
+
   try {
+    // The environment and the model outlive their phases, which end by hand
+
+    ph_begin(phases, "loadenv");
     GRBEnv env = GRBEnv();
+    ph_end(phases);
 
+    ph_begin(phases, "newmodel");
     GRBModel model = GRBModel(env);
+    ph_end(phases);
 
-    // Create variables
+    // Create variables; lx::Var lets the rows below be built without
+    // GRBLinExpr temporaries and without the zero terms (linexpr.h)
 
-    GRBVar x1 = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS, "x1");
-    GRBVar x2 = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS, "x2");
-    GRBVar x3 = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS, "x3");
-    GRBVar x4 = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS, "x4");
-    GRBVar x5 = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS, "x5");
+    ph_begin(phases, "addvars");
+    lx::Var x1 = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS, "x1");
+    lx::Var x2 = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS, "x2");
+    lx::Var x3 = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS, "x3");
+    lx::Var x4 = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS, "x4");
+    lx::Var x5 = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS, "x5");
+    ph_end(phases);
 
     // Integrate new variables
 
-    model.update();
+    {
+      PhaseScope ph(phases, "update");
+      model.update();
+    }
+
+    {
+      PhaseScope ph(phases, "addconstrs");
 
-    // Set objective: minimize   min z=20x1 + 10x2 + 31x3 + 11x4 + 12x5
+      // Set objective: minimize   min z=20x1 + 10x2 + 31x3 + 11x4 + 12x5
 
-    model.setObjective(20 * x1 + 10 * x2 + 31 * x3 + 11 * x4 + 12 * x5, GRB_MINIMIZE);
+      lx::setObjective(model, 20 * x1 + 10 * x2 + 31 * x3 + 11 * x4 + 12 * x5, GRB_MINIMIZE);
 
-    // Add constraint: 2x1 + 0x2 + 3x3 + 1x4 + 2x5 ≥ 21
+      // Add constraint: 2x1 + 0x2 + 3x3 + 1x4 + 2x5 ≥ 21
 
-    GRBConstr iron = model.addConstr(2 * x1 + 0 * x2 + 3 * x3 + 1 * x4 + 2 * x5 >= 21, "iron");
+      lx::addConstr(model, 2 * x1 + 0 * x2 + 3 * x3 + 1 * x4 + 2 * x5 >= 21, "iron");
 
-    // Add constraint: 0x1 + 1x2 + 2x3 + 2x4 + 1x5 ≥ 12
+      // Add constraint: 0x1 + 1x2 + 2x3 + 2x4 + 1x5 ≥ 12
 
-    GRBConstr calcium = model.addConstr(0 * x1 + 1 * x2 + 2 * x3 + 2 * x4 + 1 * x5 >= 12, "calcium");
+      lx::addConstr(model, 0 * x1 + 1 * x2 + 2 * x3 + 2 * x4 + 1 * x5 >= 12, "calcium");
+    }
 
-    // Optimize model
+    // Optimize model, recording its progress if asked to
 
-    model.optimize();
-    cout << "\nVariables:\nV Name" << "\t" << "Value" << "\t" << "Red. Cost" << endl;
-    cout << x1.get(GRB_StringAttr_VarName) << "\t"
-         << x1.get(GRB_DoubleAttr_X) << "\t"
-         << x1.get(GRB_DoubleAttr_RC) << endl;
-    cout << x2.get(GRB_StringAttr_VarName) << "\t"
-         << x2.get(GRB_DoubleAttr_X) << "\t"
-         << x2.get(GRB_DoubleAttr_RC) << endl;
-    cout << x3.get(GRB_StringAttr_VarName) << "\t"
-         << x3.get(GRB_DoubleAttr_X) << "\t"
-         << x3.get(GRB_DoubleAttr_RC) << endl;
-    cout << x4.get(GRB_StringAttr_VarName) << "\t"
-         << x4.get(GRB_DoubleAttr_X) << "\t"
-         << x4.get(GRB_DoubleAttr_RC) << endl;
-    cout << x5.get(GRB_StringAttr_VarName) << "\t"
-         << x5.get(GRB_DoubleAttr_X) << "\t"
-         << x5.get(GRB_DoubleAttr_RC) << endl;
+    unique_ptr<TraceCallback> cb;
+    if (tracefile) {
+      trace = st_create(0);
+      if (!trace) throw GRBException("Cannot start the trace", GRB_ERROR_OUT_OF_MEMORY);
+      cb.reset(new TraceCallback(trace));
+      model.setCallback(cb.get());
+    }
 
-    cout << "\nObj: " << model.get(GRB_DoubleAttr_ObjVal) << endl;
+    {
+      PhaseScope ph(phases, "optimize");
+      model.optimize();
+    }
 
-    cout << "\nConstraints:\nC Name" << "\t" << "Slack" << "\t" << "Dual Val" << endl;
-    cout << iron.get(GRB_StringAttr_ConstrName) << "\t"
-         << iron.get(GRB_DoubleAttr_Slack) << "\t"
-         << iron.get(GRB_DoubleAttr_Pi) << endl;
-    cout << calcium.get(GRB_StringAttr_ConstrName) << "\t"
-         << calcium.get(GRB_DoubleAttr_Slack) << "\t"
-         << calcium.get(GRB_DoubleAttr_Pi) << endl;
+    if (trace) {
+      TraceInstance inst = trace_instance(model, "diet");
+      if (st_finish(trace, &inst, tracefile) != 0)
+        cerr << tracefile << ": " << strerror(errno) << endl;
+      else
+        cout << "Trace: " << st_count(trace) << " callback records ("
+             << st_dropped(trace) << " dropped) written to " << tracefile << endl;
+      model.setCallback(NULL);
+    }
 
+    // Read the whole solution with one call per attribute and report it
+
+    ph_begin(phases, "extract");
+    Solution sol(model);
+    ph_end(phases);
+    sol.print(cout);
+
+    // Check the duals against the primal solution
+
+    ph_begin(phases, verifydual ? "dualcheck+verify" : "dualcheck");
+    DualCheck dc = checkDuality(model, sol, verifydual);
+    ph_end(phases);
+    printDualCheck(cout, dc);
+
+    if (csvfile) {
+      ofstream out(csvfile);
+      sol.writeCSV(out);
+    }
+    if (binfile) {
+      ofstream out(binfile, ios::binary);
+      sol.writeBinary(out);
+    }
 
   } catch(GRBException e) {
     cout << "Error code = " << e.getErrorCode() << endl;
@@ -80,5 +167,15 @@ main(int   argc,
     cout << "Exception during optimization" << endl;
   }
 
+  // Phase report, also of a failed run: the failed phase ends here
+
+  if (phases) {
+    if (ph_write_json(phases, phasefile) != 0)
+      cerr << phasefile << ": " << strerror(errno) << endl;
+    ph_print(phases, stdout);
+    ph_free(phases);
+  }
+
+  st_free(trace);
   return 0;
 }
@@ -9,13 +9,36 @@
                  2pi + 1pc <= 12
 */
 
+#include <cstring>
+#include <fstream>
 #include "gurobi_c++.h"
+#include "solution.h"
 using namespace std;
 
+/* Usage:  diet_dual [-csv file] [-bin file]
+
+   -csv and -bin also write the solution to file, see solution.h.
+   Build with solution.c++.
+*/
+
 int
 main(int   argc,
      char *argv[])
 {
+  const char *csvfile = NULL;
+  const char *binfile = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-csv") == 0 && i+1 < argc) {
+      csvfile = argv[++i];
+    } else if (strcmp(argv[i], "-bin") == 0 && i+1 < argc) {
+      binfile = argv[++i];
+    } else {
+      cerr << "usage: " << argv[0] << " [-csv file] [-bin file]" << endl;
+      return 1;
+    }
+  }
+
   try {
     GRBEnv env = GRBEnv();
 
@@ -36,54 +59,41 @@ main(int   argc,
 
     // Add constraint: 2pi + 0pc <= 20
 
-    GRBConstr c1 = model.addConstr(2 * pi + 0 * pc <= 20, "c1");
+    model.addConstr(2 * pi + 0 * pc <= 20, "c1");
 
     // Add constraint: 0pi + 1pc <= 10
 
-    GRBConstr c2 = model.addConstr(0 * pi + 1 * pc <= 10, "c2");
+    model.addConstr(0 * pi + 1 * pc <= 10, "c2");
 
     // Add constraint: 3pi + 2pc <= 31
 
-    GRBConstr c3 = model.addConstr(3 * pi + 2 * pc <= 31, "c3");
+    model.addConstr(3 * pi + 2 * pc <= 31, "c3");
 
     // Add constraint: 1pi + 2pc <= 11
 
-    GRBConstr c4 = model.addConstr(1 * pi + 2 * pc <= 11, "c4");
+    model.addConstr(1 * pi + 2 * pc <= 11, "c4");
 
     // Add constraint: 2pi + 1pc <= 12
 
-    GRBConstr c5 = model.addConstr(2 * pi + 1 * pc <= 12, "c5");
+    model.addConstr(2 * pi + 1 * pc <= 12, "c5");
 
     // Optimize model
 
     model.optimize();
-    cout << "\nVariables:\nV Name" << "\t" << "Value" << "\t" << "Red. Cost" << endl;
-    cout << pi.get(GRB_StringAttr_VarName) << "\t"
-         << pi.get(GRB_DoubleAttr_X) << "\t"
-         << pi.get(GRB_DoubleAttr_RC) << endl;
-    cout << pc.get(GRB_StringAttr_VarName) << "\t"
-         << pc.get(GRB_DoubleAttr_X) << "\t"
-         << pc.get(GRB_DoubleAttr_RC) << endl;
-
-    cout << "\nObj: " << model.get(GRB_DoubleAttr_ObjVal) << endl;
-
-    cout << "\nConstraints:\nC Name" << "\t" << "Slack" << "\t" << "Dual Val" << endl;
-    cout << c1.get(GRB_StringAttr_ConstrName) << "\t"
-         << c1.get(GRB_DoubleAttr_Slack) << "\t"
-         << c1.get(GRB_DoubleAttr_Pi) << endl;
-    cout << c2.get(GRB_StringAttr_ConstrName) << "\t"
-         << c2.get(GRB_DoubleAttr_Slack) << "\t"
-         << c2.get(GRB_DoubleAttr_Pi) << endl;
-    cout << c3.get(GRB_StringAttr_ConstrName) << "\t"
-         << c3.get(GRB_DoubleAttr_Slack) << "\t"
-         << c3.get(GRB_DoubleAttr_Pi) << endl;
-    cout << c4.get(GRB_StringAttr_ConstrName) << "\t"
-         << c4.get(GRB_DoubleAttr_Slack) << "\t"
-         << c4.get(GRB_DoubleAttr_Pi) << endl;
-    cout << c5.get(GRB_StringAttr_ConstrName) << "\t"
-         << c5.get(GRB_DoubleAttr_Slack) << "\t"
-         << c5.get(GRB_DoubleAttr_Pi) << endl;
 
+    // Read the whole solution with one call per attribute and report it
+
+    Solution sol(model);
+    sol.print(cout);
+
+    if (csvfile) {
+      ofstream out(csvfile);
+      sol.writeCSV(out);
+    }
+    if (binfile) {
+      ofstream out(binfile, ios::binary);
+      sol.writeBinary(out);
+    }
 
   } catch(GRBException e) {
     cout << "Error code = " << e.getErrorCode() << endl;
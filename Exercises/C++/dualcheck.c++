@@ -0,0 +1,207 @@
+/* Primal and dual report of an LP from a single solve, see dualcheck.h.
+   The measures are computed by dc_measure of ../C/dualcheck.c. */
+
+#include <cmath>
+#include <iomanip>
+#include "dualcheck.h"
+using namespace std;
+
+// The data of a continuous, linear model, rows in CSR form
+
+struct LPData
+{
+  int            n, m, sense;
+  vector<double> obj, lb, ub, rhs;
+  vector<char>   rsense;
+  vector<int>    beg, ind;
+  vector<double> val;
+};
+
+template <class T> static void take(vector<T>& dst, T* src, int len)
+{
+  dst.assign(src, src + len);
+  delete[] src;
+}
+
+static void getLP(GRBModel& model, LPData& lp)
+{
+  if (model.get(GRB_IntAttr_IsMIP) || model.get(GRB_IntAttr_IsQP) ||
+      model.get(GRB_IntAttr_IsQCP))
+    throw GRBException("Duals need a continuous, linear model", GRB_ERROR_INVALID_ARGUMENT);
+
+  lp.n     = model.get(GRB_IntAttr_NumVars);
+  lp.m     = model.get(GRB_IntAttr_NumConstrs);
+  lp.sense = model.get(GRB_IntAttr_ModelSense);
+
+  GRBVar*    vars    = model.getVars();
+  GRBConstr* constrs = model.getConstrs();
+  take(lp.obj, model.get(GRB_DoubleAttr_Obj, vars, lp.n), lp.n);
+  take(lp.lb, model.get(GRB_DoubleAttr_LB, vars, lp.n), lp.n);
+  take(lp.ub, model.get(GRB_DoubleAttr_UB, vars, lp.n), lp.n);
+  take(lp.rhs, model.get(GRB_DoubleAttr_RHS, constrs, lp.m), lp.m);
+  take(lp.rsense, model.get(GRB_CharAttr_Sense, constrs, lp.m), lp.m);
+
+  lp.beg.resize(lp.m + 1);
+  for (int i = 0; i < lp.m; i++) {
+    GRBLinExpr row = model.getRow(constrs[i]);
+    lp.beg[i] = lp.ind.size();
+    for (unsigned int k = 0; k < row.size(); k++) {
+      lp.ind.push_back(row.getVar(k).index());
+      lp.val.push_back(row.getCoeff(k));
+    }
+  }
+  lp.beg[lp.m] = lp.ind.size();
+  delete[] vars;
+  delete[] constrs;
+}
+
+// Sign a row dual must have in a minimization: 1 for >= 0, -1 for <= 0,
+// 0 for free; the opposite in a maximization
+
+static int rowSign(char sense)
+{
+  return sense == GRB_GREATER_EQUAL ? 1 : sense == GRB_LESS_EQUAL ? -1 : 0;
+}
+
+static bool isFinite(double bnd)
+{
+  return bnd > -GRB_INFINITY && bnd < GRB_INFINITY;
+}
+
+GRBModel* dualModel(GRBModel& model)
+{
+  LPData lp;
+  getLP(model, lp);
+
+  GRBModel* dual = new GRBModel(model.getEnv());
+  try {
+    // y_i, then zl_j and zu_j where the bound is finite
+
+    vector<double> ylb(lp.m), yub(lp.m);
+    for (int i = 0; i < lp.m; i++) {
+      int s = rowSign(lp.rsense[i]) * lp.sense;
+      ylb[i] = s > 0 ? 0.0 : -GRB_INFINITY;
+      yub[i] = s < 0 ? 0.0 : GRB_INFINITY;
+    }
+    GRBVar* y = NULL;
+    if (lp.m > 0)
+      y = dual->addVars(&ylb[0], &yub[0], &lp.rhs[0], NULL, NULL, lp.m);
+
+    double zlb = lp.sense == GRB_MINIMIZE ? 0.0 : -GRB_INFINITY;
+    double zub = lp.sense == GRB_MINIMIZE ? GRB_INFINITY : 0.0;
+    vector<GRBLinExpr> rows(lp.n);
+    for (int j = 0; j < lp.n; j++) {
+      if (isFinite(lp.lb[j]))
+        rows[j] += dual->addVar(zlb, zub, lp.lb[j], GRB_CONTINUOUS);
+      if (isFinite(lp.ub[j]))
+        rows[j] -= dual->addVar(zlb, zub, -lp.ub[j], GRB_CONTINUOUS);
+    }
+
+    // Row i of the primal is the column of y_i
+
+    for (int i = 0; i < lp.m; i++)
+      for (int k = lp.beg[i]; k < lp.beg[i+1]; k++)
+        rows[lp.ind[k]] += lp.val[k] * y[i];
+    delete[] y;
+
+    dual->set(GRB_IntAttr_ModelSense, -lp.sense);
+    dual->update();
+    for (int j = 0; j < lp.n; j++)
+      dual->addConstr(rows[j], GRB_EQUAL, lp.obj[j]);
+    dual->update();
+  } catch (...) {
+    delete dual;
+    throw;
+  }
+  return dual;
+}
+
+// First element of v for the C arrays, NULL if there is none
+
+template <class T> static const T* start(const vector<T>& v)
+{
+  return v.empty() ? NULL : &v[0];
+}
+
+DualCheck checkDuality(GRBModel& model, const Solution& sol, bool verify)
+{
+  DualCheck dc;
+  dc.status = sol.status();
+  dc.primalobj = dc.dualobj = dc.gap = NAN;
+  dc.dualresid = dc.signviol = dc.compslack = NAN;
+  dc.explicitstatus = 0;
+  dc.explicitobj = NAN;
+
+  LPData lp;
+  getLP(model, lp);
+
+  if (dc.status == GRB_OPTIMAL) {
+    DCProblem p;
+    p.n      = lp.n;
+    p.m      = lp.m;
+    p.sense  = lp.sense;
+    p.obj    = start(lp.obj);
+    p.lb     = start(lp.lb);
+    p.ub     = start(lp.ub);
+    p.rsense = start(lp.rsense);
+    p.rhs    = start(lp.rhs);
+    p.cbeg   = start(lp.beg);
+    p.cind   = start(lp.ind);
+    p.cval   = start(lp.val);
+    dc_measure(&p, sol.objVal(), sol.x(), sol.rc(), sol.slack(), sol.pi(), &dc);
+  }
+
+  if (verify) {
+    GRBModel* dual = dualModel(model);
+    try {
+      dual->optimize();
+      dc.explicitstatus = dual->get(GRB_IntAttr_Status);
+      if (dc.explicitstatus == GRB_OPTIMAL)
+        dc.explicitobj = dual->get(GRB_DoubleAttr_ObjVal);
+    } catch (...) {
+      delete dual;
+      throw;
+    }
+    delete dual;
+  }
+  return dc;
+}
+
+// A measure in scientific notation, or "< 1e-09" below DC_NOISE
+
+static void printMeasure(ostream& out, const char* label, double v)
+{
+  out << "  " << label;
+  if (v < DC_NOISE)
+    out << "< " << setprecision(0) << DC_NOISE << setprecision(3) << endl;
+  else
+    out << v << endl;
+}
+
+void printDualCheck(ostream& out, const DualCheck& dc)
+{
+  if (dc.status != GRB_OPTIMAL) {
+    out << "\nDuality check: primal status " << dc.status << ", no duals" << endl;
+    return;
+  }
+
+  ios::fmtflags flags = out.flags();
+  streamsize prec = out.precision();
+
+  out << "\nDuality check (from Pi and RC):" << endl << scientific;
+  out << "  primal objective   " << setprecision(10) << dc.primalobj << endl;
+  out << "  dual objective     " << dc.dualobj << endl;
+  out << setprecision(3);
+  printMeasure(out, "relative gap       ", dc.gap);
+  printMeasure(out, "dual residual      ", dc.dualresid);
+  printMeasure(out, "sign violation     ", dc.signviol);
+  printMeasure(out, "compl. slackness   ", dc.compslack);
+  if (dc.explicitstatus == GRB_OPTIMAL)
+    out << "  explicit dual      " << setprecision(10) << dc.explicitobj << endl;
+  else if (dc.explicitstatus != 0)
+    out << "  explicit dual      status " << dc.explicitstatus << endl;
+  out << "  strong duality     " << (dc_ok(&dc, 1e-6) ? "holds" : "FAILS") << endl;
+
+  out.flags(flags);
+  out.precision(prec);
+}
@@ -0,0 +1,45 @@
+/* Primal and dual report of an LP from a single solve, C++ interface to
+   ../C/dualcheck.h: DualCheck and the measures are the C ones.
+
+   The duals are the Pi and RC that Solution already read from the primal
+   solve, so there is no dual model to build and solve (diet_dual).
+   DualCheck measures how well they satisfy the dual problem:
+
+     dualobj    b'y + d'l over the reduced costs at their lower bound side
+                      + d'u over those at their upper bound side
+     gap        |primalobj - dualobj| / max(1, |primalobj|)
+     dualresid  max_j |c_j - (A'y)_j - d_j|
+     signviol   largest dual of the wrong sign for its row sense or bound
+     compslack  largest |y_i slack_i| and |d_j (x_j - bound_j)|
+
+   With verify, the transposed dual model of dualModel is solved as well
+   and its objective compared, which is for testing only:
+
+     DualCheck dc = checkDuality(model, sol, true);
+     printDualCheck(cout, dc);
+
+   Only continuous, linear models are accepted; the others throw a
+   GRBException with GRB_ERROR_INVALID_ARGUMENT.
+*/
+
+#ifndef DUALCHECK_CXX_H
+#define DUALCHECK_CXX_H
+
+#include <ostream>
+#include "gurobi_c++.h"
+#include "solution.h"
+#include "../C/dualcheck.h"
+
+// The transposed dual model: a row A_j'y + zl_j - zu_j = c_j per primal
+// variable, y_i signed by the row sense, zl_j / zu_j for finite bounds
+// only and the objective b'y + l'zl - u'zu in the opposite sense.
+// The caller deletes it.
+GRBModel* dualModel(GRBModel& model);
+
+// The measures are those of dc_measure; dc_ok tells whether they are all
+// within a tolerance
+DualCheck checkDuality(GRBModel& model, const Solution& sol, bool verify);
+
+void printDualCheck(std::ostream& out, const DualCheck& dc);
+
+#endif
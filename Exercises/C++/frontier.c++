@@ -0,0 +1,488 @@
+/* This example traces the efficient frontier of a long-only Markowitz
+   portfolio:
+
+     minimize    x' Sigma x            (variance of the portfolio)
+     subject to  sum_i x_i = 1         (budget)
+                 mu' x >= target       (return)
+                 0 <= x_i <= 1
+
+   for a range of return targets, from the return of the minimum variance
+   portfolio up to the largest mean return.  Each target is one point
+   (risk, return, weights) of the frontier, risk being the standard
+   deviation sqrt(x' Sigma x).
+
+   The built-in data are five asset classes; a file or -generate gives any
+   number of assets.
+*/
+
+/* Usage:  frontier [-points n] [-segments n] [-workers n] [-cold]
+                    [-out file.csv] [-generate assets seed] [datafile]
+
+   The QP is built once per worker; a point only changes the right hand
+   side of the return row and re-solves with dual simplex, which starts
+   from the basis of the worker's previous point.  The points (20 by
+   default) are split into segments of consecutive targets (one per worker
+   by default) and the segments are solved concurrently on a thread pool
+   (../C/threadpool.h).  Gurobi environments are not shared between
+   threads, so every worker starts its own, with Threads=1, and builds its
+   own copy of the model on its first segment.  -workers sets the number
+   of workers (one per processor by default), -cold resets the model
+   before every point, for comparison.
+
+   Points are streamed as CSV to -out (default standard output) as they
+   finish, in completion order:
+
+     point,target,return,risk,iterations,ms,asset:weight,...
+
+   with only the weights above 1e-6.  A table of the frontier in target
+   order and the totals follow on standard output.
+
+   Data file (lines starting with '#' and blank lines are ignored):
+
+     assets,3
+     bonds,0.03            name,mean return
+     ...
+     covariance
+     0.0025,-0.0009,...    one row per asset
+
+   -generate draws a covariance from a random 10 factor model instead.
+
+   Build with ../C/threadpool.c, -I../C and -lpthread.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "gurobi_c++.h"
+#include "threadpool.h"
+using namespace std;
+
+struct Portfolio
+{
+  int            n;
+  vector<string> name;
+  vector<double> mu;     // [n] mean returns
+  vector<double> cov;    // [n*n] covariance, row major
+};
+
+// The built-in asset classes: mean returns, volatilities and correlations
+
+static const char*  Asset[] = { "bonds", "stocks", "realestate", "commodities", "cash" };
+static const double Mean[]  = { 0.030, 0.085, 0.065, 0.070, 0.010 };
+static const double Vol[]   = { 0.050, 0.180, 0.140, 0.220, 0.005 };
+static const double Corr[5][5] = {
+  {  1.00, -0.10,  0.10,  0.00,  0.05 },
+  { -0.10,  1.00,  0.60,  0.30,  0.00 },
+  {  0.10,  0.60,  1.00,  0.20,  0.00 },
+  {  0.00,  0.30,  0.20,  1.00,  0.00 },
+  {  0.05,  0.00,  0.00,  0.00,  1.00 } };
+
+static double now()
+{
+  return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void defaultPortfolio(Portfolio& p)
+{
+  p.n = 5;
+  p.name.assign(Asset, Asset + 5);
+  p.mu.assign(Mean, Mean + 5);
+  p.cov.resize(25);
+  for (int i = 0; i < 5; i++)
+    for (int j = 0; j < 5; j++)
+      p.cov[i*5+j] = Corr[i][j] * Vol[i] * Vol[j];
+}
+
+// Sigma = B B' + D for k factors with exposures B and specific variances
+// D; mean returns follow the exposures plus noise
+
+static void generatePortfolio(int n, unsigned long long seed, Portfolio& p)
+{
+  const int k = 10;
+  mt19937_64 rng(seed);
+  normal_distribution<double> normal(0.0, 1.0);
+  uniform_real_distribution<double> uniform(0.0, 1.0);
+  vector<double> B((size_t) n*k), premium(k);
+
+  for (int f = 0; f < k; f++)
+    premium[f] = 0.02 * uniform(rng);
+  p.n = n;
+  p.name.resize(n);
+  p.mu.resize(n);
+  p.cov.assign((size_t) n*n, 0.0);
+  for (int i = 0; i < n; i++) {
+    ostringstream s;
+    s << "a" << i;
+    p.name[i] = s.str();
+    p.mu[i] = 0.01 + 0.01 * normal(rng);
+    for (int f = 0; f < k; f++) {
+      B[(size_t) i*k+f] = 0.05 * normal(rng);
+      p.mu[i] += fabs(B[(size_t) i*k+f]) / 0.05 * premium[f];
+    }
+  }
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j <= i; j++) {
+      double s = 0.0;
+      for (int f = 0; f < k; f++)
+        s += B[(size_t) i*k+f] * B[(size_t) j*k+f];
+      p.cov[(size_t) i*n+j] = p.cov[(size_t) j*n+i] = s;
+    }
+    p.cov[(size_t) i*n+i] += 0.01 * (0.5 + uniform(rng));
+  }
+}
+
+// Next line that is neither blank nor a comment; false at end of file
+
+static bool nextLine(istream& in, string& line, int& lineno)
+{
+  while (getline(in, line)) {
+    lineno++;
+    if (!line.empty() && line[line.size()-1] == '\r')
+      line.erase(line.size()-1);
+    if (!line.empty() && line[0] != '#')
+      return true;
+  }
+  return false;
+}
+
+static bool loadPortfolio(const char* file, Portfolio& p)
+{
+  ifstream in(file);
+  string   line, field;
+  int      lineno = 0;
+
+  if (!in) {
+    cerr << file << ": " << strerror(errno) << endl;
+    return false;
+  }
+  if (!nextLine(in, line, lineno) || line.compare(0, 7, "assets,") != 0 ||
+      (p.n = atoi(line.c_str() + 7)) <= 0) {
+    cerr << file << ":" << lineno << ": expected assets,<count>" << endl;
+    return false;
+  }
+  p.name.resize(p.n);
+  p.mu.resize(p.n);
+  p.cov.resize((size_t) p.n*p.n);
+  for (int i = 0; i < p.n; i++) {
+    char* end;
+    size_t comma;
+    if (!nextLine(in, line, lineno) || (comma = line.find(',')) == string::npos) {
+      cerr << file << ":" << lineno << ": expected name,mean return" << endl;
+      return false;
+    }
+    p.name[i] = line.substr(0, comma);
+    p.mu[i] = strtod(line.c_str() + comma + 1, &end);
+    if (end == line.c_str() + comma + 1) {
+      cerr << file << ":" << lineno << ": bad mean return" << endl;
+      return false;
+    }
+  }
+  if (!nextLine(in, line, lineno) || line != "covariance") {
+    cerr << file << ":" << lineno << ": expected covariance" << endl;
+    return false;
+  }
+  for (int i = 0; i < p.n; i++) {
+    if (!nextLine(in, line, lineno)) {
+      cerr << file << ": unexpected end of file" << endl;
+      return false;
+    }
+    const char* s = line.c_str();
+    for (int j = 0; j < p.n; j++) {
+      char* end;
+      p.cov[(size_t) i*p.n+j] = strtod(s, &end);
+      if (end == s || (j < p.n-1 && *end != ',')) {
+        cerr << file << ":" << lineno << ": expected " << p.n << " covariances" << endl;
+        return false;
+      }
+      s = end + 1;
+    }
+  }
+  return true;
+}
+
+// A worker's own environment and copy of the model, built on its first
+// segment
+
+struct Worker
+{
+  GRBEnv*   env;
+  GRBModel* model;
+  GRBVar*   x;
+  GRBConstr ret;
+  string    error;
+
+  Worker() : env(NULL), model(NULL), x(NULL) {}
+};
+
+static void buildModel(Worker& w, const Portfolio& p)
+{
+  int n = p.n;
+
+  w.env = new GRBEnv();
+  w.env->set(GRB_IntParam_OutputFlag, 0);
+  w.env->set(GRB_IntParam_Threads, 1);
+  w.env->set(GRB_IntParam_Method, GRB_METHOD_DUAL);
+  w.model = new GRBModel(*w.env);
+
+  vector<double> ub(n, 1.0), one(n, 1.0);
+  w.x = w.model->addVars(NULL, &ub[0], NULL, NULL, &p.name[0], n);
+  w.model->update();
+
+  GRBLinExpr budget, ret;
+  budget.addTerms(&one[0], w.x, n);
+  ret.addTerms(&p.mu[0], w.x, n);
+  w.model->addConstr(budget == 1.0, "budget");
+  w.ret = w.model->addConstr(ret >= *min_element(p.mu.begin(), p.mu.end()), "return");
+
+  // x' Sigma x from the upper triangle, the off-diagonal terms doubled
+
+  size_t         nq = (size_t) n*(n+1)/2, k = 0;
+  vector<double> coef(nq);
+  vector<GRBVar> xi(nq), xj(nq);
+  for (int i = 0; i < n; i++)
+    for (int j = i; j < n; j++, k++) {
+      coef[k] = (i == j ? 1.0 : 2.0) * p.cov[(size_t) i*n+j];
+      xi[k] = w.x[i];
+      xj[k] = w.x[j];
+    }
+  GRBQuadExpr risk;
+  risk.addTerms(&coef[0], &xi[0], &xj[0], (int) nq);
+  w.model->setObjective(risk, GRB_MINIMIZE);
+  w.model->update();
+}
+
+static void freeWorker(Worker& w)
+{
+  delete[] w.x;
+  delete w.model;
+  delete w.env;
+}
+
+struct FrontierPoint
+{
+  int    status;
+  double target, ret, risk;
+  double iters, secs;
+};
+
+// Shared by the segment tasks; only the stream is written under the lock
+
+struct Frontier
+{
+  const Portfolio*      p;
+  int                   segments;
+  bool                  cold;
+  vector<FrontierPoint> point;
+  vector<Worker>        worker;
+  ostream*              out;
+  mutex                 lock;
+};
+
+static void streamPoint(Frontier& f, int k, const double* x)
+{
+  const FrontierPoint& pt = f.point[k];
+  ostringstream line;
+
+  line << k << ',' << pt.target << ',' << pt.ret << ',' << pt.risk << ','
+       << pt.iters << ',' << 1e3*pt.secs;
+  for (int j = 0; j < f.p->n; j++)
+    if (x[j] > 1e-6)
+      line << ',' << f.p->name[j] << ':' << x[j];
+  line << '\n';
+
+  lock_guard<mutex> guard(f.lock);
+  *f.out << line.str() << flush;
+}
+
+// Task s: the points of segment s in order of their targets, each warm
+// started from the one before on the worker's model
+
+static void solveSegment(void* arg, int s, int w)
+{
+  Frontier& f = *(Frontier*) arg;
+  Worker&   wk = f.worker[w];
+  int       npoints = (int) f.point.size();
+  int       first = (int) ((long long) s*npoints/f.segments);
+  int       last = (int) ((long long) (s+1)*npoints/f.segments);
+
+  if (!wk.error.empty())
+    return;
+  try {
+    if (!wk.model)
+      buildModel(wk, *f.p);
+    for (int k = first; k < last; k++) {
+      FrontierPoint& pt = f.point[k];
+      double start = now();
+
+      if (f.cold)
+        wk.model->reset();
+      wk.ret.set(GRB_DoubleAttr_RHS, pt.target);
+      wk.model->optimize();
+      pt.status = wk.model->get(GRB_IntAttr_Status);
+      pt.iters = wk.model->get(GRB_DoubleAttr_IterCount);
+      if (pt.status != GRB_OPTIMAL) {
+        pt.secs = now() - start;
+        continue;
+      }
+      double* x = wk.model->get(GRB_DoubleAttr_X, wk.x, f.p->n);
+      pt.ret = 0.0;
+      for (int j = 0; j < f.p->n; j++)
+        pt.ret += f.p->mu[j] * x[j];
+      pt.risk = sqrt(max(0.0, wk.model->get(GRB_DoubleAttr_ObjVal)));
+      pt.secs = now() - start;
+      streamPoint(f, k, x);
+      delete[] x;
+    }
+  } catch (GRBException& e) {
+    ostringstream s;
+    s << "Error code = " << e.getErrorCode() << ": " << e.getMessage();
+    wk.error = s.str();
+  }
+}
+
+int
+main(int   argc,
+     char *argv[])
+{
+  const char* datafile = NULL;
+  const char* outfile = NULL;
+  int         npoints = 20;
+  int         segments = 0;
+  int         workers = 0;
+  int         genassets = 0;
+  unsigned long long seed = 1;
+  bool        cold = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-points") == 0 && i+1 < argc) {
+      npoints = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-segments") == 0 && i+1 < argc) {
+      segments = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-workers") == 0 && i+1 < argc) {
+      workers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-cold") == 0) {
+      cold = true;
+    } else if (strcmp(argv[i], "-out") == 0 && i+1 < argc) {
+      outfile = argv[++i];
+    } else if (strcmp(argv[i], "-generate") == 0 && i+2 < argc) {
+      genassets = atoi(argv[++i]);
+      seed = strtoull(argv[++i], NULL, 10);
+    } else if (argv[i][0] != '-' && datafile == NULL) {
+      datafile = argv[i];
+    } else {
+      cerr << "usage: " << argv[0] << " [-points n] [-segments n] [-workers n] [-cold]"
+           << " [-out file.csv] [-generate assets seed] [datafile]" << endl;
+      return 1;
+    }
+  }
+  if (npoints < 1) {
+    cerr << "-points needs at least one point" << endl;
+    return 1;
+  }
+
+  Portfolio p;
+  if (genassets > 0)
+    generatePortfolio(genassets, seed, p);
+  else if (!datafile)
+    defaultPortfolio(p);
+  else if (!loadPortfolio(datafile, p))
+    return 1;
+
+  ThreadPool* pool = tp_create(workers);
+  if (!pool) {
+    cerr << "Cannot start the workers" << endl;
+    return 1;
+  }
+
+  ofstream  file;
+  Frontier  f;
+  f.p = &p;
+  f.cold = cold;
+  f.worker.resize(tp_size(pool));
+  f.segments = segments > 0 ? min(segments, npoints) : min(tp_size(pool), npoints);
+  f.point.resize(npoints);
+  f.out = &cout;
+  if (outfile) {
+    file.open(outfile);
+    if (!file) {
+      cerr << outfile << ": " << strerror(errno) << endl;
+      tp_free(pool);
+      return 1;
+    }
+    f.out = &file;
+  }
+
+  try {
+    // The frontier starts at the minimum variance portfolio, which the
+    // model gives while the return row is slack
+
+    double start = now();
+    buildModel(f.worker[0], p);
+    double tbuild = now() - start;
+
+    f.worker[0].model->optimize();
+    if (f.worker[0].model->get(GRB_IntAttr_Status) != GRB_OPTIMAL)
+      throw GRBException("No minimum variance portfolio", 0);
+    double* x = f.worker[0].model->get(GRB_DoubleAttr_X, f.worker[0].x, p.n);
+    double lo = 0.0, hi = *max_element(p.mu.begin(), p.mu.end());
+    for (int j = 0; j < p.n; j++)
+      lo += p.mu[j] * x[j];
+    delete[] x;
+    for (int k = 0; k < npoints; k++)
+      f.point[k].target = npoints == 1 ? lo : lo + (hi - lo) * k / (npoints - 1);
+
+    cout << "Frontier of " << p.n << " assets, returns " << lo << " to " << hi
+         << ": " << npoints << " points in " << f.segments << " segments on "
+         << tp_size(pool) << " workers, " << (cold ? "cold" : "warm") << " start" << endl;
+    cout << "Model built in " << fixed << setprecision(3) << 1e3*tbuild << " ms" << endl;
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+
+    // Stream the points as the segments finish them
+
+    *f.out << "point,target,return,risk,iterations,ms,weights" << endl;
+    start = now();
+    tp_run(pool, f.segments, solveSegment, &f);
+    double secs = now() - start;
+
+    for (size_t w = 0; w < f.worker.size(); w++)
+      if (!f.worker[w].error.empty())
+        throw GRBException(f.worker[w].error, 0);
+
+    // The frontier in target order, and the totals
+
+    double iters = 0.0, solvesecs = 0.0;
+    cout << "\nEfficient frontier:\nPoint      Return        Risk  Iterations" << endl;
+    for (int k = 0; k < npoints; k++) {
+      const FrontierPoint& pt = f.point[k];
+      iters += pt.iters;
+      solvesecs += pt.secs;
+      if (pt.status == GRB_OPTIMAL)
+        cout << setw(5) << k << fixed << setprecision(6) << setw(12) << pt.ret
+             << setw(12) << pt.risk << setprecision(0) << setw(12) << pt.iters << endl;
+      else
+        cout << setw(5) << k << "  status " << pt.status << endl;
+    }
+    cout << "\nTiming: " << setprecision(3) << secs << " s wall, "
+         << solvesecs << " s in solves, " << setprecision(0) << iters
+         << " iterations" << endl;
+
+  } catch (GRBException& e) {
+    cout << e.getMessage() << endl;
+  } catch (...) {
+    cout << "Exception during optimization" << endl;
+  }
+
+  for (size_t w = 0; w < f.worker.size(); w++)
+    freeWorker(f.worker[w]);
+  tp_free(pool);
+  return 0;
+}
@@ -0,0 +1,171 @@
+/* Expression templates for building linear rows with the C++ API.
+
+   With plain GRBVar, 20 * x1 + 10 * x2 + 31 * x3 builds a GRBLinExpr for
+   every product and another for every partial sum, and keeps terms such as
+   0 * x2.  With the lx::Var wrapper the same source text builds a small
+   tree of value types whose number of terms is known at compile time:
+
+     lx::Var x1 = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS, "x1");
+     ...
+     lx::addConstr(model, 2 * x1 + 0 * x2 + 3 * x3 >= 21, "iron");
+     lx::setObjective(model, 20 * x1 + 10 * x2 + 31 * x3, GRB_MINIMIZE);
+
+   addConstr and setObjective flatten the tree into coefficient and
+   variable arrays of exactly that size on the stack, skip zero
+   coefficients, and hand them to the model with one addTerms and one
+   addConstr/setObjective call.
+
+   Supported are c * x, x * c, x, e + e, e - e and -e, where x is an
+   lx::Var and e any such expression.  Constants belong on the right hand
+   side.
+*/
+
+#ifndef LINEXPR_H
+#define LINEXPR_H
+
+#include <string>
+#include "gurobi_c++.h"
+
+namespace lx {
+
+// Every expression type E derives from Expr<E>, has a compile time term
+// count E::size and can write its terms scaled by s to (coef, var, n)
+
+template <class E>
+struct Expr
+{
+  const E& self() const { return static_cast<const E&>(*this); }
+};
+
+struct Var : Expr<Var>
+{
+  enum { size = 1 };
+  GRBVar v;
+
+  Var() {}
+  Var(const GRBVar& x) : v(x) {}
+  operator GRBVar() const { return v; }
+
+  void emit(double s, double* coef, GRBVar* var, int& n) const
+  {
+    coef[n] = s;
+    var[n++] = v;
+  }
+};
+
+struct Term : Expr<Term>
+{
+  enum { size = 1 };
+  double c;
+  GRBVar v;
+
+  Term(double k, const GRBVar& x) : c(k), v(x) {}
+
+  void emit(double s, double* coef, GRBVar* var, int& n) const
+  {
+    if (c != 0.0) {
+      coef[n] = s*c;
+      var[n++] = v;
+    }
+  }
+};
+
+template <class L, class R, int Sign>
+struct Sum : Expr< Sum<L, R, Sign> >
+{
+  enum { size = L::size + R::size };
+  L l;
+  R r;
+
+  Sum(const L& a, const R& b) : l(a), r(b) {}
+
+  void emit(double s, double* coef, GRBVar* var, int& n) const
+  {
+    l.emit(s, coef, var, n);
+    r.emit(Sign*s, coef, var, n);
+  }
+};
+
+template <class E>
+struct Neg : Expr< Neg<E> >
+{
+  enum { size = E::size };
+  E e;
+
+  explicit Neg(const E& a) : e(a) {}
+
+  void emit(double s, double* coef, GRBVar* var, int& n) const
+  {
+    e.emit(-s, coef, var, n);
+  }
+};
+
+template <class E>
+struct Row
+{
+  E      lhs;
+  char   sense;
+  double rhs;
+
+  Row(const E& e, char sns, double b) : lhs(e), sense(sns), rhs(b) {}
+};
+
+inline Term operator*(double c, const Var& x) { return Term(c, x.v); }
+inline Term operator*(const Var& x, double c) { return Term(c, x.v); }
+
+template <class L, class R>
+inline Sum<L, R, 1> operator+(const Expr<L>& a, const Expr<R>& b)
+{
+  return Sum<L, R, 1>(a.self(), b.self());
+}
+
+template <class L, class R>
+inline Sum<L, R, -1> operator-(const Expr<L>& a, const Expr<R>& b)
+{
+  return Sum<L, R, -1>(a.self(), b.self());
+}
+
+template <class E>
+inline Neg<E> operator-(const Expr<E>& a)
+{
+  return Neg<E>(a.self());
+}
+
+template <class E>
+inline Row<E> operator<=(const Expr<E>& a, double b) { return Row<E>(a.self(), GRB_LESS_EQUAL, b); }
+template <class E>
+inline Row<E> operator>=(const Expr<E>& a, double b) { return Row<E>(a.self(), GRB_GREATER_EQUAL, b); }
+template <class E>
+inline Row<E> operator==(const Expr<E>& a, double b) { return Row<E>(a.self(), GRB_EQUAL, b); }
+
+// Flatten e into one GRBLinExpr with a single addTerms call
+
+template <class E>
+inline GRBLinExpr flatten(const Expr<E>& e)
+{
+  double     coef[E::size];
+  GRBVar     var[E::size];
+  int        n = 0;
+  GRBLinExpr expr;
+
+  e.self().emit(1.0, coef, var, n);
+  if (n > 0)
+    expr.addTerms(coef, var, n);
+  return expr;
+}
+
+template <class E>
+inline GRBConstr addConstr(GRBModel& model, const Row<E>& row, const std::string& name = "")
+{
+  return model.addConstr(flatten(row.lhs), row.sense, row.rhs, name);
+}
+
+template <class E>
+inline void setObjective(GRBModel& model, const Expr<E>& e, int sense)
+{
+  model.setObjective(flatten(e), sense);
+}
+
+}
+
+#endif
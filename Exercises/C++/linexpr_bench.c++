@@ -0,0 +1,113 @@
+/* This example compares building a large LP with plain GRBLinExpr
+   arithmetic against the expression templates of linexpr.h.
+
+   Both builds add the same rows
+
+     3 x[i] + 0 x[i+1] + 2 x[i+2] - x[i+3] + 0 x[i+4] + 5 x[i+5] >= 1
+
+   (indices modulo the number of variables) and the objective sum x[i], and
+   report the wall time of adding the rows plus the model update, and the
+   number of nonzeros that reached the model.
+*/
+
+/* Usage:  linexpr_bench [rows] [reps]
+
+   rows defaults to 100000, reps (builds per method, best time is kept)
+   to 3.
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include "gurobi_c++.h"
+#include "linexpr.h"
+using namespace std;
+
+static double now()
+{
+  return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Build with GRBLinExpr temporaries, the way diet.c++ writes its rows
+
+static double build_plain(GRBEnv& env, int rows, int& nnz)
+{
+  GRBModel model = GRBModel(env);
+  vector<GRBVar> x(rows);
+  double start = now();
+
+  for (int i = 0; i < rows; i++)
+    x[i] = model.addVar(0.0, GRB_INFINITY, 1.0, GRB_CONTINUOUS);
+  model.update();
+
+  for (int i = 0; i < rows; i++)
+    model.addConstr(3 * x[i] + 0 * x[(i+1)%rows] + 2 * x[(i+2)%rows]
+                    - 1 * x[(i+3)%rows] + 0 * x[(i+4)%rows] + 5 * x[(i+5)%rows] >= 1);
+  model.update();
+
+  double secs = now() - start;
+  nnz = model.get(GRB_IntAttr_NumNZs);
+  return secs;
+}
+
+// Same rows through lx::addConstr
+
+static double build_lx(GRBEnv& env, int rows, int& nnz)
+{
+  GRBModel model = GRBModel(env);
+  vector<lx::Var> x(rows);
+  double start = now();
+
+  for (int i = 0; i < rows; i++)
+    x[i] = model.addVar(0.0, GRB_INFINITY, 1.0, GRB_CONTINUOUS);
+  model.update();
+
+  for (int i = 0; i < rows; i++)
+    lx::addConstr(model, 3 * x[i] + 0 * x[(i+1)%rows] + 2 * x[(i+2)%rows]
+                         - x[(i+3)%rows] + 0 * x[(i+4)%rows] + 5 * x[(i+5)%rows] >= 1);
+  model.update();
+
+  double secs = now() - start;
+  nnz = model.get(GRB_IntAttr_NumNZs);
+  return secs;
+}
+
+int
+main(int   argc,
+     char *argv[])
+{
+  int rows = argc > 1 ? atoi(argv[1]) : 100000;
+  int reps = argc > 2 ? atoi(argv[2]) : 3;
+
+  if (rows < 6 || reps < 1) {
+    cerr << "usage: " << argv[0] << " [rows >= 6] [reps >= 1]" << endl;
+    return 1;
+  }
+
+  try {
+    GRBEnv env = GRBEnv();
+    double tplain = 0, tlx = 0;
+    int    nzplain = 0, nzlx = 0;
+
+    for (int r = 0; r < reps; r++) {
+      double t = build_plain(env, rows, nzplain);
+      if (r == 0 || t < tplain) tplain = t;
+      t = build_lx(env, rows, nzlx);
+      if (r == 0 || t < tlx) tlx = t;
+    }
+
+    cout << "\nBuild benchmark: " << rows << " rows, 6 terms per row, best of "
+         << reps << endl;
+    cout << "  GRBLinExpr  " << 1e3*tplain << " ms, " << nzplain << " nonzeros" << endl;
+    cout << "  lx          " << 1e3*tlx << " ms, " << nzlx << " nonzeros" << endl;
+    cout << "  speedup     " << (tlx > 0 ? tplain/tlx : 0.0) << "x" << endl;
+
+  } catch(GRBException e) {
+    cout << "Error code = " << e.getErrorCode() << endl;
+    cout << e.getMessage() << endl;
+  } catch(...) {
+    cout << "Exception during optimization" << endl;
+  }
+
+  return 0;
+}
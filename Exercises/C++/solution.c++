@@ -0,0 +1,121 @@
+/* Bulk extraction of an LP solution, see solution.h */
+
+#include <cstring>
+#include <stdint.h>
+#include "solution.h"
+using namespace std;
+
+struct SolutionHeader {
+  char    magic[8];
+  int32_t numvars;
+  int32_t numconstrs;
+  int32_t status;
+  int32_t reserved;
+  double  objval;
+};
+
+// Copy one attribute array returned by the model into dst and release it
+
+static void take(double* dst, double* src, int len)
+{
+  if (len > 0)
+    memcpy(dst, src, len*sizeof(double));
+  delete[] src;
+}
+
+Solution::Solution(GRBModel& m)
+  : model(m), vars(0), constrs(0), objval(0.0), varnames(0), constrnames(0)
+{
+  nvars    = model.get(GRB_IntAttr_NumVars);
+  nconstrs = model.get(GRB_IntAttr_NumConstrs);
+  stat     = model.get(GRB_IntAttr_Status);
+  buf.assign(2*(size_t) nvars + 2*(size_t) nconstrs + 1, 0.0);
+
+  // The destructor does not run if the constructor throws
+
+  try {
+    vars    = model.getVars();
+    constrs = model.getConstrs();
+
+    if (stat != GRB_OPTIMAL)
+      return;
+
+    double* b = &buf[0];
+    objval = model.get(GRB_DoubleAttr_ObjVal);
+    take(b,                    model.get(GRB_DoubleAttr_X, vars, nvars), nvars);
+    take(b + nvars,            model.get(GRB_DoubleAttr_RC, vars, nvars), nvars);
+    take(b + 2*nvars,          model.get(GRB_DoubleAttr_Slack, constrs, nconstrs), nconstrs);
+    take(b + 2*nvars+nconstrs, model.get(GRB_DoubleAttr_Pi, constrs, nconstrs), nconstrs);
+  } catch (...) {
+    delete[] vars;
+    delete[] constrs;
+    throw;
+  }
+}
+
+Solution::~Solution()
+{
+  delete[] varnames;
+  delete[] constrnames;
+  delete[] vars;
+  delete[] constrs;
+}
+
+const string& Solution::varName(int j) const
+{
+  if (varnames == 0)
+    varnames = model.get(GRB_StringAttr_VarName, vars, nvars);
+  return varnames[j];
+}
+
+const string& Solution::constrName(int i) const
+{
+  if (constrnames == 0)
+    constrnames = model.get(GRB_StringAttr_ConstrName, constrs, nconstrs);
+  return constrnames[i];
+}
+
+void Solution::print(ostream& out) const
+{
+  // Nothing was read but the status; the buffer holds zeros, not values
+  if (stat != GRB_OPTIMAL) {
+    out << "\nNo solution, status " << stat << endl;
+    return;
+  }
+
+  out << "\nVariables:\nV Name" << "\t" << "Value" << "\t" << "Red. Cost" << endl;
+  for (int j = 0; j < nvars; j++)
+    out << varName(j) << "\t" << x()[j] << "\t" << rc()[j] << endl;
+
+  out << "\nObj: " << objval << endl;
+
+  out << "\nConstraints:\nC Name" << "\t" << "Slack" << "\t" << "Dual Val" << endl;
+  for (int i = 0; i < nconstrs; i++)
+    out << constrName(i) << "\t" << slack()[i] << "\t" << pi()[i] << endl;
+}
+
+void Solution::writeCSV(ostream& out) const
+{
+  streamsize prec = out.precision(17);
+
+  out << "kind,name,value,dual\n";
+  for (int j = 0; j < nvars; j++)
+    out << "var," << varName(j) << "," << x()[j] << "," << rc()[j] << "\n";
+  for (int i = 0; i < nconstrs; i++)
+    out << "constr," << constrName(i) << "," << slack()[i] << "," << pi()[i] << "\n";
+  out.precision(prec);
+}
+
+void Solution::writeBinary(ostream& out) const
+{
+  SolutionHeader h;
+
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, "GRBSOL1\n", 8);
+  h.numvars    = nvars;
+  h.numconstrs = nconstrs;
+  h.status     = stat;
+  h.objval     = objval;
+  out.write((const char*) &h, sizeof(h));
+  out.write((const char*) &buf[0], (2*(size_t) nvars + 2*(size_t) nconstrs)*sizeof(double));
+}
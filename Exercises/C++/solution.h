@@ -0,0 +1,74 @@
+/* Bulk extraction of an LP solution.
+
+   Solution reads X and RC for all variables and Slack and Pi for all
+   constraints with one array call per attribute into a single contiguous
+   buffer laid out as
+
+     x[numvars] | rc[numvars] | slack[numconstrs] | pi[numconstrs]
+
+   instead of one var.get()/constr.get() call per element.  Names are only
+   fetched (again with one call each for variables and constraints) the
+   first time they are needed, i.e. when printing or writing CSV.
+
+   The binary sink writes SolutionHeader followed by the buffer as is, in
+   model order and without names:
+
+     char    magic[8]       "GRBSOL1\n"
+     int32   numvars, numconstrs, status, reserved
+     double  objval
+     double  x, rc, slack, pi
+*/
+
+#ifndef SOLUTION_H
+#define SOLUTION_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "gurobi_c++.h"
+
+class Solution
+{
+  public:
+    explicit Solution(GRBModel& model);
+    ~Solution();
+
+    int    numVars() const    { return nvars; }
+    int    numConstrs() const { return nconstrs; }
+    int    status() const     { return stat; }
+    double objVal() const     { return objval; }
+
+    // Zero filled unless status() is GRB_OPTIMAL
+    const double* x() const     { return &buf[0]; }
+    const double* rc() const    { return &buf[0] + nvars; }
+    const double* slack() const { return &buf[0] + 2*nvars; }
+    const double* pi() const    { return &buf[0] + 2*nvars + nconstrs; }
+
+    const std::string& varName(int j) const;
+    const std::string& constrName(int i) const;
+
+    // The diet example report: name, value and reduced cost or dual, or
+    // the status when there is no solution
+    void print(std::ostream& out) const;
+
+    // One line per variable and constraint: kind,name,value,dual
+    void writeCSV(std::ostream& out) const;
+    void writeBinary(std::ostream& out) const;
+
+  private:
+    Solution(const Solution&);
+    Solution& operator=(const Solution&);
+
+    GRBModel&           model;
+    GRBVar*             vars;
+    GRBConstr*          constrs;
+    int                 nvars;
+    int                 nconstrs;
+    int                 stat;
+    double              objval;
+    std::vector<double> buf;
+    mutable std::string* varnames;
+    mutable std::string* constrnames;
+};
+
+#endif
@@ -0,0 +1,96 @@
+/* GRBCallback front end of the C solve trace (../C/solvetrace.h).
+
+   TraceCallback reads the same callback values as st_callback and pushes
+   them into the trace's ring buffer; the drain thread and the log store
+   writer are shared with the C drivers.
+
+     SolveTrace* trace = st_create(0);
+     TraceCallback cb(trace);
+     model.setCallback(&cb);
+     model.optimize();
+     TraceInstance inst = trace_instance(model, "diet");
+     st_finish(trace, &inst, "diet.mlog");
+     st_free(trace);
+
+   Build with ../C/solvetrace.c, -I../C and -lpthread.
+*/
+
+#ifndef TRACECALLBACK_H
+#define TRACECALLBACK_H
+
+#include <cmath>
+#include "gurobi_c++.h"
+#include "solvetrace.h"
+
+class TraceCallback : public GRBCallback
+{
+  public:
+    explicit TraceCallback(SolveTrace* st) : trace(st) {}
+
+  protected:
+    void callback()
+    {
+      TraceRecord r;
+
+      r.ns = 0;
+      r.runtime = r.obj = r.objbst = r.objbnd = NAN;
+      r.nodes = r.nodlft = r.iters = r.infeas = NAN;
+      r.where = where;
+
+      switch (where) {
+      case GRB_CB_SIMPLEX:
+        r.iters  = getDoubleInfo(GRB_CB_SPX_ITRCNT);
+        r.obj    = getDoubleInfo(GRB_CB_SPX_OBJVAL);
+        r.infeas = getDoubleInfo(GRB_CB_SPX_PRIMINF);
+        break;
+      case GRB_CB_BARRIER:
+        r.iters  = getIntInfo(GRB_CB_BARRIER_ITRCNT);
+        r.obj    = getDoubleInfo(GRB_CB_BARRIER_PRIMOBJ);
+        break;
+      case GRB_CB_MIP:
+        r.objbst = getDoubleInfo(GRB_CB_MIP_OBJBST);
+        r.objbnd = getDoubleInfo(GRB_CB_MIP_OBJBND);
+        r.nodes  = getDoubleInfo(GRB_CB_MIP_NODCNT);
+        r.nodlft = getDoubleInfo(GRB_CB_MIP_NODLFT);
+        r.iters  = getDoubleInfo(GRB_CB_MIP_ITRCNT);
+        break;
+      case GRB_CB_MIPSOL:
+        r.obj    = getDoubleInfo(GRB_CB_MIPSOL_OBJ);
+        r.objbst = getDoubleInfo(GRB_CB_MIPSOL_OBJBST);
+        r.objbnd = getDoubleInfo(GRB_CB_MIPSOL_OBJBND);
+        r.nodes  = getDoubleInfo(GRB_CB_MIPSOL_NODCNT);
+        break;
+      default:
+        return;
+      }
+      r.runtime = getDoubleInfo(GRB_CB_RUNTIME);
+      st_push(trace, &r);
+    }
+
+  private:
+    SolveTrace* trace;
+};
+
+// What st_instance reads, through the C++ attributes; name must outlive it
+
+inline TraceInstance trace_instance(GRBModel& model, const char* name)
+{
+  TraceInstance inst;
+
+  inst.name      = name;
+  inst.rows      = model.get(GRB_IntAttr_NumConstrs);
+  inst.cols      = model.get(GRB_IntAttr_NumVars);
+  inst.nonzeros  = model.get(GRB_IntAttr_NumNZs);
+  inst.status    = model.get(GRB_IntAttr_Status);
+  inst.runtime   = model.get(GRB_DoubleAttr_Runtime);
+  inst.timelimit = model.getEnv().get(GRB_DoubleParam_TimeLimit);
+
+  // Not available for every model or status
+  try { inst.objval = model.get(GRB_DoubleAttr_ObjVal); } catch (GRBException&) { inst.objval = NAN; }
+  try { inst.objbound = model.get(GRB_DoubleAttr_ObjBound); } catch (GRBException&) { inst.objbound = NAN; }
+  try { inst.nodes = model.get(GRB_DoubleAttr_NodeCount); } catch (GRBException&) { inst.nodes = NAN; }
+  try { inst.iters = model.get(GRB_DoubleAttr_IterCount); } catch (GRBException&) { inst.iters = NAN; }
+  return inst;
+}
+
+#endif
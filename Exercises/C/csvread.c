@@ -0,0 +1,120 @@
+/* Reading the CSV instance files.  See csvread.h */
+
+#include <stdlib.h>
+#include <string.h>
+#include "csvread.h"
+#include "modelcache.h"
+
+int csv_next_record(CsvCursor *c, const char **rec, const char **recend)
+{
+	while (c->p < c->end) {
+		const char *s = c->p;
+		const char *e = memchr(s, '\n', c->end - s);
+		if (e == NULL) e = c->end;
+		c->p = e < c->end ? e+1 : e;
+		c->line++;
+		if (e > s && e[-1] == '\r') e--;
+		if (e == s || *s == '#') continue;
+		*rec = s;
+		*recend = e;
+		return 1;
+	}
+	return 0;
+}
+
+const char *csv_next_field(const char **p, const char *end, int sep, size_t *len)
+{
+	const char *s = *p;
+	const char *e;
+
+	if (s > end) {
+		*len = 0;
+		return NULL;
+	}
+	e = memchr(s, sep, end - s);
+	if (e == NULL) e = end;
+	*len = e - s;
+	*p = e+1;
+	return s;
+}
+
+int csv_parse_num(const char *s, size_t len, double *v)
+{
+	char  buf[64];
+	char *e;
+
+	while (len > 0 && (*s == ' ' || *s == '\t')) { s++; len--; }
+	if (len == 0 || len >= sizeof(buf)) return 1;
+	memcpy(buf, s, len);
+	buf[len] = '\0';
+	*v = strtod(buf, &e);
+	while (*e == ' ' || *e == '\t') e++;
+	if (*v >= GRB_INFINITY) *v = GRB_INFINITY;
+	if (*v <= -GRB_INFINITY) *v = -GRB_INFINITY;
+	return *e != '\0' || *v != *v;
+}
+
+int csv_parse_header(CsvCursor *c, const char *name, int numcounts, int *count)
+{
+	const char *rec, *end, *f;
+	size_t      len;
+	double      v;
+	int         i;
+
+	if (!csv_next_record(c, &rec, &end)) return 1;
+	f = csv_next_field(&rec, end, ',', &len);
+	if (len != strlen(name) || memcmp(f, name, len) != 0) return 1;
+	for (i=0; i<numcounts; i++) {
+		f = csv_next_field(&rec, end, ',', &len);
+		if (f == NULL || csv_parse_num(f, len, &v) || v < 0 || v > INT32_MAX) return 1;
+		count[i] = (int) v;
+	}
+	return 0;
+}
+
+long csv_measure_names(CsvCursor *c, int count, int sep)
+{
+	const char *rec, *end;
+	size_t      len;
+	long        bytes = 0;
+	int         i;
+
+	for (i=0; i<count; i++) {
+		if (!csv_next_record(c, &rec, &end)) return -1;
+		csv_next_field(&rec, end, sep, &len);
+		bytes += len + 1;
+	}
+	return bytes;
+}
+
+int csv_hash_init(NameHash *h, int n)
+{
+	size_t size = 16;
+	while (size < 2*(size_t) n) size <<= 1;
+	h->mask = size-1;
+	h->slot = calloc(size, sizeof(int));
+	return h->slot == NULL;
+}
+
+int csv_hash_find(NameHash *h, char **names, const char *s, size_t len,
+                  int insert, int n)
+{
+	size_t i = mc_hash(1469598103934665603ULL, s, len) & h->mask;
+	while (h->slot[i]) {
+		const char *t = names[h->slot[i]-1];
+		if (strncmp(t, s, len) == 0 && t[len] == '\0')
+			return h->slot[i]-1;
+		i = (i+1) & h->mask;
+	}
+	if (!insert) return -1;
+	h->slot[i] = n+1;
+	return n;
+}
+
+uint64_t splitmix64(uint64_t *s)
+{
+	uint64_t z = (*s += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
@@ -0,0 +1,81 @@
+/* Reading the CSV instance files of mf_data.c and diet_data.c.
+
+   Both loaders map their file and walk it with a CsvCursor: records are
+   lines, blank lines and lines starting with '#' are skipped, and a
+   section starts with a header record "<name>,<count>,...".  Fields are
+   split in place, so nothing is copied until a loader stores a name.
+   Names are resolved to indices with a NameHash over the loader's own
+   array of names.
+*/
+
+#ifndef CSVREAD_H
+#define CSVREAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Cursor over a mapped CSV file */
+
+typedef struct {
+  const char *p;
+  const char *end;
+  int         line;   /* of the last record read, for messages */
+} CsvCursor;
+
+/* csv_next_record
+ * output: 1 and [*rec,*recend) set to the next non-blank, non-comment line
+ *         (without its line terminator), or 0 at end of file
+ */
+int csv_next_record(CsvCursor *c, const char **rec, const char **recend);
+
+/* csv_next_field
+ * output: start of the next field of [*p,end) ended by sep, its length in
+ *         *len, and *p advanced past sep; NULL and *len 0 if no field is
+ *         left
+ */
+const char *csv_next_field(const char **p, const char *end, int sep, size_t *len);
+
+/* csv_parse_num
+ * output: 0 and *v set if [s,s+len) is a complete number, 1 otherwise;
+ *         "inf" is read as GRB_INFINITY and NaN is refused
+ */
+int csv_parse_num(const char *s, size_t len, double *v);
+
+/* csv_parse_header
+ * output: 0 and count[0..numcounts-1] set if the next record is
+ *         "<name>,<count>,..."
+ */
+int csv_parse_header(CsvCursor *c, const char *name, int numcounts, int *count);
+
+/* csv_measure_names
+ * output: bytes needed to store the next count records as names, each up
+ *         to its first sep ('\n' for the whole record), or -1
+ */
+long csv_measure_names(CsvCursor *c, int count, int sep);
+
+/* Open addressing hash of names, mapping them to their index */
+
+typedef struct {
+  int     *slot;   /* index + 1, 0 for empty */
+  size_t   mask;
+} NameHash;
+
+/* csv_hash_init
+ * output: 0 on success with h empty and sized for n names, 1 out of memory
+ */
+int csv_hash_init(NameHash *h, int n);
+
+/* csv_hash_find
+ * output: index of the name [s,s+len) in names, or -1; with insert set,
+ *         an absent name is entered as index n
+ */
+int csv_hash_find(NameHash *h, char **names, const char *s, size_t len,
+                  int insert, int n);
+
+/* splitmix64
+ * output: the next value of the generator whose state is *s; the random
+ *         instances and scenarios of both loaders are drawn from it
+ */
+uint64_t splitmix64(uint64_t *s);
+
+#endif
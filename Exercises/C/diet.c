@@ -5,16 +5,42 @@
                  0x1 + 1x2 + 2x3 + 2x4 + 1x5 ≥ 12
 */
 
+#include <errno.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "gurobi_c.h"
+#include "dualcheck.h"
+#include "lpmodel.h"
+#include "phase.h"
+#include "sensitivity.h"
+
+/* Usage:  diet [-backend auto|dense|gurobi] [-phases report.json]
+                [-verifydual] [-sensitivity]
+
+   The model is built into an LPModel (lpmodel.h), which the dense simplex
+   solves in process unless -backend gurobi asks for Gurobi, so diet runs
+   without a license and without starting an environment.  The Gurobi log
+   goes to diet.log, as before, when Gurobi is used.
+
+   The dual values are the Pi and RC of this one solve, which diet checks
+   for strong duality (dualcheck.h); diet_dual is not needed for them.
+   -verifydual also builds and solves the transposed dual model and
+   compares its objective, for testing only.
+   -sensitivity adds the ranges of every cost, bound and requirement over
+   which the optimal basis stays optimal to the tables (sensitivity.h),
+   from this one solve.
+   -phases times the phases of the run with their RSS and writes them as a
+   JSON report (phase.h).  Build with lpmodel.c, dsimplex.c, dualcheck.c,
+   phase.c, sensitivity.c and -lm.
+*/
 
 int
 main(int   argc,
      char *argv[])
 {
-  GRBenv   *env   = NULL;
-  GRBmodel *model = NULL;
+  LPModel  *lp    = NULL;
+  LMBackend backend = LM_AUTO;
   int 		i;
   int       error = 0;
   char     *varnames[5] = { "x1", "x2", "x3", "x4", "x5" };
@@ -27,47 +53,74 @@ main(int   argc,
   int       ind[5];
   double    val[5];
   double    obj[5];
-  char      vtype[5];
   int       optimstatus;
   double    objval;
+  const char *phasefile = NULL;
+  PhaseLog *phases = NULL;
+  int       verifydual = 0;
+  DualCheck check;
+  int       sensitivity = 0;
+  SARanges  sa;
+
+  for (i=1; i<argc; i++) {
+    if (strcmp(argv[i], "-backend") == 0 && i+1 < argc) {
+      i++;
+      if (strcmp(argv[i], "auto") == 0) backend = LM_AUTO;
+      else if (strcmp(argv[i], "dense") == 0) backend = LM_DENSE;
+      else if (strcmp(argv[i], "gurobi") == 0) backend = LM_GUROBI;
+      else {
+        fprintf(stderr, "%s: unknown backend %s\n", argv[0], argv[i]);
+        exit(1);
+      }
+    } else if (strcmp(argv[i], "-phases") == 0 && i+1 < argc) {
+      phasefile = argv[++i];
+    } else if (strcmp(argv[i], "-verifydual") == 0) {
+      verifydual = 1;
+    } else if (strcmp(argv[i], "-sensitivity") == 0) {
+      sensitivity = 1;
+    } else {
+      fprintf(stderr, "usage: %s [-backend auto|dense|gurobi] [-phases report.json]"
+              " [-verifydual] [-sensitivity]\n", argv[0]);
+      exit(1);
+    }
+  }
 
-  /* Create environment */
-
-  error = GRBloadenv(&env, "diet.log");
-  if (error) goto QUIT;
+  memset(&sa, 0, sizeof(sa));
+  if (phasefile && (phases = ph_create("diet")) == NULL) {
+    fprintf(stderr, "Out of memory\n");
+    exit(1);
+  }
 
-  /* Create an empty model */
+  /* Create an empty model; the environment, if Gurobi solves it, is only
+     started by lm_optimize */
 
-  error = GRBnewmodel(env, &model, "diet", 0, NULL, NULL, NULL, NULL, NULL);
+  ph_begin(phases, "newmodel");
+  error = lm_new(backend, "diet", "diet.log", &lp);
   if (error) goto QUIT;
+  ph_end(phases);
 
 
   /* Add variables */
 
+  ph_begin(phases, "addvars");
   obj[0] = 20; obj[1] = 10; obj[2] = 31; obj[3] = 11; obj[4] = 12;
-  for ( i = 0; i < 5; i++) {
-	  vtype[i] = GRB_CONTINUOUS;
-  }
-  error = GRBaddvars(model, 5, 0, NULL, NULL, NULL, obj, NULL, NULL, vtype, varnames);
+  error = lm_addvars(lp, 5, obj, NULL, NULL, varnames);
   if (error) goto QUIT;
 
   /* Change objective sense to minimization */
 
-  error = GRBsetintattr(model, GRB_INT_ATTR_MODELSENSE, GRB_MINIMIZE);
-  if (error) goto QUIT;
-
-  /* Integrate new variables */
-
-  error = GRBupdatemodel(model);
+  error = lm_setsense(lp, GRB_MINIMIZE);
   if (error) goto QUIT;
+  ph_end(phases);
 
 
   /* First constraint: 2x1 + 0x2 + 3x3 + 1x4 + 2x5 ≥ 21 */
 
+  ph_begin(phases, "addconstrs");
   ind[0] = 0; ind[1] = 1; ind[2] = 2; ind[3] = 3; ind[4] = 4;
   val[0] = 2; val[1] = 0; val[2] = 3; val[3] = 1; val[4] = 2;
 
-  error = GRBaddconstr(model, 5, ind, val, GRB_GREATER_EQUAL, 21.0, "iron");
+  error = lm_addconstr(lp, 5, ind, val, GRB_GREATER_EQUAL, 21.0, "iron");
   if (error) goto QUIT;
 
   /* Second constraint: 0x1 + 1x2 + 2x3 + 2x4 + 1x5 ≥ 12 */
@@ -75,47 +128,78 @@ main(int   argc,
   ind[0] = 0; ind[1] = 1; ind[2] = 2; ind[3] = 3; ind[4] = 4;
   val[0] = 0; val[1] = 1; val[2] = 2; val[3] = 2; val[4] = 1;
 
-  error = GRBaddconstr(model, 5, ind, val, GRB_GREATER_EQUAL, 12.0, "calcium");
+  error = lm_addconstr(lp, 5, ind, val, GRB_GREATER_EQUAL, 12.0, "calcium");
   if (error) goto QUIT;
+  ph_end(phases);
 
   /* Optimize model */
 
-  error = GRBoptimize(model);
+  ph_begin(phases, "optimize");
+  error = lm_optimize(lp);
   if (error) goto QUIT;
+  ph_end(phases);
 
   /* Write model to 'mip1.lp' */
 
-  error = GRBwrite(model, "diet.lp");
+  ph_begin(phases, "write");
+  error = lm_write(lp, "diet.lp");
   if (error) goto QUIT;
+  ph_end(phases);
 
   /* Capture solution information */
 
-  error = GRBgetintattr(model, GRB_INT_ATTR_STATUS, &optimstatus);
-  if (error) goto QUIT;
+  ph_begin(phases, "extract");
 
-  error = GRBgetdblattr(model, GRB_DBL_ATTR_OBJVAL, &objval);
+  error = lm_getstatus(lp, &optimstatus);
   if (error) goto QUIT;
 
-  error = GRBgetstrattrarray(model, GRB_STR_ATTR_VARNAME, 0, 5, name);
-  if (error) goto QUIT;
+  if (optimstatus == GRB_OPTIMAL) {
+    error = lm_getobjval(lp, &objval);
+    if (error) goto QUIT;
 
-  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_X, 0, 5, sol);
-  if (error) goto QUIT;
+    error = lm_getstrarray(lp, GRB_STR_ATTR_VARNAME, 0, 5, name);
+    if (error) goto QUIT;
 
-  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_RC, 0, 5, rc);
-  if (error) goto QUIT;
+    error = lm_getdblarray(lp, GRB_DBL_ATTR_X, 0, 5, sol);
+    if (error) goto QUIT;
 
-  error = GRBgetstrattrarray(model, GRB_STR_ATTR_CONSTRNAME, 0, 2, conname);
-  if (error) goto QUIT;
+    error = lm_getdblarray(lp, GRB_DBL_ATTR_RC, 0, 5, rc);
+    if (error) goto QUIT;
 
-  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_SLACK, 0, 2, slack);
-  if (error) goto QUIT;
+    error = lm_getstrarray(lp, GRB_STR_ATTR_CONSTRNAME, 0, 2, conname);
+    if (error) goto QUIT;
+
+    error = lm_getdblarray(lp, GRB_DBL_ATTR_SLACK, 0, 2, slack);
+    if (error) goto QUIT;
+
+    error = lm_getdblarray(lp, GRB_DBL_ATTR_PI, 0, 2, pi);
+    if (error) goto QUIT;
+  }
+  ph_end(phases);
+
+  /* Ranges of the optimal basis, in bulk */
+
+  if (sensitivity && optimstatus == GRB_OPTIMAL) {
+    ph_begin(phases, "sensitivity");
+    error = sa_read(lp, 5, 2, &sa);
+    if (error) goto QUIT;
+    ph_end(phases);
+  }
+
+  /* Check the duals against the primal solution */
 
-  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_PI, 0, 2, pi);
+  ph_begin(phases, verifydual ? "dualcheck+verify" : "dualcheck");
+  error = lm_dualcheck(lp, verifydual, &check);
   if (error) goto QUIT;
+  ph_end(phases);
 
-  printf("\nOptimization complete\n");
-  if (optimstatus == GRB_OPTIMAL) {
+  printf("\nOptimization complete (%s)\n", lm_solvedby(lp));
+  if (optimstatus == GRB_OPTIMAL && sensitivity) {
+    sa_print_columns(stdout, name, sol, rc, &sa);
+    printf("\nOptimal objective: %.4e\n", objval);
+    sa_print_rows(stdout, conname, slack, pi, &sa);
+    dc_print(stdout, &check);
+  } else if (optimstatus == GRB_OPTIMAL) {
 	printf("\nVariables:\nV Name      Value    Red. Cost\n");
 	for (i=0; i<5; i++) {
         printf("%4s       %5.1f     %8.4f\n",name[i],sol[i],rc[i]);
@@ -127,6 +211,11 @@ main(int   argc,
 	for (i=0; i<2; i++) {
         printf("%7s    %5.1f     %8.4f\n",conname[i],slack[i],pi[i]);
 	}
+    dc_print(stdout, &check);
+  } else if (optimstatus == GRB_INFEASIBLE) {
+    printf("Model is infeasible\n");
+  } else if (optimstatus == GRB_UNBOUNDED) {
+    printf("Model is unbounded\n");
   } else if (optimstatus == GRB_INF_OR_UNBD) {
     printf("Model is infeasible or unbounded\n");
   } else {
@@ -135,20 +224,26 @@ main(int   argc,
 
 QUIT:
 
+  /* Phase report, also of a failed run: the failed phase ends here */
+
+  if (phases) {
+    if (ph_write_json(phases, phasefile) != 0)
+      fprintf(stderr, "%s: %s\n", phasefile, strerror(errno));
+    ph_print(phases, stdout);
+    ph_free(phases);
+  }
+
   /* Error reporting */
 
   if (error) {
-    printf("ERROR: %s\n", GRBgeterrormsg(env));
+    printf("ERROR: %s\n", lm_errormsg(lp));
     exit(1);
   }
 
-  /* Free model */
-
-  GRBfreemodel(model);
-
-  /* Free environment */
+  /* Free model, and the environment if it was started */
 
-  GRBfreeenv(env);
+  sa_free(&sa);
+  lm_free(lp);
 
   return 0;
 }
@@ -0,0 +1,305 @@
+/* This example formulates and solves the generalized diet model of a food
+   and nutrient catalog (diet_data.h):
+
+     minimize    sum_f cost_f buy_f
+     subject to  sum_f amount_nf buy_f - nutrition_n = 0   for every nutrient n
+                 minimum_n <= nutrition_n <= maximum_n
+                 buy_f >= 0
+
+   The diet of diet.c is the catalog of 5 foods (x1..x5) and 2 nutrients
+   (iron >= 21, calcium >= 12); any other is read from a file.
+*/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gurobi_c.h"
+#include "diet_data.h"
+#include "phase.h"
+#include "walltime.h"
+
+/* Usage:  diet_catalog [-generate foods nutrients perfood [-seed n]]
+                        [-save out.csv] [-write file] [-phases report.json]
+                        [catalog.csv]
+
+   Without a catalog file the diet of diet.c is solved.  -generate makes a
+   random catalog of the given size instead, every food carrying perfood
+   nutrients, for timing large builds; -save writes the catalog as CSV and
+   exits.  -write writes the model to file, in the format its extension
+   names.  -phases times the phases of the run with their RSS and writes
+   them as a JSON report (phase.h).
+
+   The model is built column-wise.  One GRBaddconstrs call adds the empty
+   nutrient rows, one GRBaddvars call every food with its column of the
+   catalog's CSC amounts, passed as they were loaded, and one more the
+   nutrition variables.  The catalog stores no zero amounts, so none
+   reaches Gurobi, and nothing is copied or allocated per food.
+
+   Build with diet_data.c, csvread.c, modelcache.c, phase.c and -lm.
+*/
+
+/* build
+ * inputs: model  empty model
+ *         d      catalog
+ * output: error code; the nutrient rows, the food columns and the
+ *         nutrition columns added, in that order
+ */
+static int build(GRBmodel *model, const DietData *d)
+{
+	int     M = d->numnutrients;
+	char   *sense = NULL;
+	double *rhs = NULL;
+	int    *beg = NULL;
+	double *val = NULL;
+	int     i, error = 0;
+
+	sense = malloc(M + 1);
+	rhs   = calloc(M + 1, sizeof(double));
+	beg   = malloc(M*sizeof(int) + 1);
+	val   = malloc(M*sizeof(double) + 1);
+	if (!sense || !rhs || !beg || !val) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+	for (i = 0; i < M; i++) {
+		sense[i] = GRB_EQUAL;
+		beg[i] = i;
+		val[i] = -1.0;
+	}
+
+	error = GRBsetintattr(model, GRB_INT_ATTR_MODELSENSE, GRB_MINIMIZE);
+	if (error) goto QUIT;
+	error = GRBaddconstrs(model, M, 0, NULL, NULL, NULL, sense, rhs, d->nutrient);
+	if (error) goto QUIT;
+
+	/* Food f is column f; its nonzeros are already in CSC form */
+
+	error = GRBaddvars(model, d->numfoods, d->numnz, d->beg, d->nutr, d->amount,
+	                   d->cost, NULL, NULL, NULL, d->food);
+	if (error) goto QUIT;
+
+	/* nutrition_n is column numfoods+n, its one nonzero -1 in row n */
+
+	error = GRBaddvars(model, M, M, beg, beg, val, NULL, d->minimum, d->maximum,
+	                   NULL, d->nutrient);
+	if (error) goto QUIT;
+	error = GRBupdatemodel(model);
+
+QUIT:
+	free(sense);
+	free(rhs);
+	free(beg);
+	free(val);
+	return error;
+}
+
+int
+main(int   argc,
+     char *argv[])
+{
+  GRBenv   *env   = NULL;
+  GRBmodel *model = NULL;
+  DietData  data;
+  int       i;
+  int       error = 0;
+  const char *datafile = NULL;
+  const char *savefile = NULL;
+  const char *writefile = NULL;
+  const char *phasefile = NULL;
+  PhaseLog *phases = NULL;
+  int       genfoods = -1, gennutrients = 0, genperfood = 0;
+  unsigned long long seed = 1;
+  double    tstart, tload, tbuild, tsolve;
+  double   *buy = NULL;
+  double   *nutrition = NULL;
+  double   *pi = NULL;
+  int       optimstatus;
+  double    objval;
+
+  memset(&data, 0, sizeof(data));
+
+  for (i=1; i<argc; i++) {
+    if (strcmp(argv[i], "-generate") == 0 && i+3 < argc) {
+      genfoods     = atoi(argv[++i]);
+      gennutrients = atoi(argv[++i]);
+      genperfood   = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-seed") == 0 && i+1 < argc) {
+      seed = strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "-save") == 0 && i+1 < argc) {
+      savefile = argv[++i];
+    } else if (strcmp(argv[i], "-write") == 0 && i+1 < argc) {
+      writefile = argv[++i];
+    } else if (strcmp(argv[i], "-phases") == 0 && i+1 < argc) {
+      phasefile = argv[++i];
+    } else if (argv[i][0] != '-' && datafile == NULL) {
+      datafile = argv[i];
+    } else {
+      fprintf(stderr, "usage: %s [-generate foods nutrients perfood [-seed n]] "
+              "[-save out.csv] [-write file] [-phases report.json] [catalog.csv]\n",
+              argv[0]);
+      exit(1);
+    }
+  }
+
+  if (phasefile && (phases = ph_create("diet_catalog")) == NULL) {
+    fprintf(stderr, "Out of memory\n");
+    exit(1);
+  }
+
+  /* Load the catalog */
+
+  ph_begin(phases, "load");
+  tstart = walltime();
+  if (genfoods >= 0) {
+    if (dd_generate(genfoods, gennutrients, genperfood, seed, &data)) {
+      fprintf(stderr, "Could not generate a catalog of %d foods, %d nutrients, "
+              "%d per food\n", genfoods, gennutrients, genperfood);
+      exit(1);
+    }
+  } else if (datafile ? dd_load(datafile, &data) : dd_default(&data)) {
+    fprintf(stderr, "Could not load the catalog\n");
+    exit(1);
+  }
+  tload = walltime() - tstart;
+  ph_end(phases);
+
+  printf("Loaded %d foods, %d nutrients, %d nonzeros in %.3f ms\n",
+         data.numfoods, data.numnutrients, data.numnz, 1e3*tload);
+
+  if (savefile) {
+    error = dd_save(&data, savefile);
+    dd_free(&data);
+    return error;
+  }
+
+  /* Create environment */
+
+  ph_begin(phases, "loadenv");
+  error = GRBloadenv(&env, "diet_catalog.log");
+  if (error) goto QUIT;
+  ph_end(phases);
+
+  /* Create an empty model and add the catalog column-wise */
+
+  ph_begin(phases, "build");
+  tstart = walltime();
+  error = GRBnewmodel(env, &model, "diet_catalog", 0, NULL, NULL, NULL, NULL, NULL);
+  if (error) goto QUIT;
+  error = build(model, &data);
+  if (error) goto QUIT;
+  tbuild = walltime() - tstart;
+  ph_end(phases);
+
+  printf("Built %d columns, %d rows in %.3f ms\n",
+         data.numfoods + data.numnutrients, data.numnutrients, 1e3*tbuild);
+
+  if (writefile) {
+    ph_begin(phases, "write");
+    error = GRBwrite(model, writefile);
+    if (error) goto QUIT;
+    ph_end(phases);
+  }
+
+  /* Optimize model */
+
+  ph_begin(phases, "optimize");
+  tstart = walltime();
+  error = GRBoptimize(model);
+  if (error) goto QUIT;
+  tsolve = walltime() - tstart;
+  ph_end(phases);
+
+  /* Capture solution information */
+
+  ph_begin(phases, "extract");
+
+  error = GRBgetintattr(model, GRB_INT_ATTR_STATUS, &optimstatus);
+  if (error) goto QUIT;
+
+  if (optimstatus == GRB_OPTIMAL) {
+    buy       = malloc(data.numfoods*sizeof(double) + 1);
+    nutrition = malloc(data.numnutrients*sizeof(double) + 1);
+    pi        = malloc(data.numnutrients*sizeof(double) + 1);
+    if (!buy || !nutrition || !pi) {
+      error = GRB_ERROR_OUT_OF_MEMORY;
+      goto QUIT;
+    }
+
+    error = GRBgetdblattr(model, GRB_DBL_ATTR_OBJVAL, &objval);
+    if (error) goto QUIT;
+
+    error = GRBgetdblattrarray(model, GRB_DBL_ATTR_X, 0, data.numfoods, buy);
+    if (error) goto QUIT;
+
+    error = GRBgetdblattrarray(model, GRB_DBL_ATTR_X, data.numfoods,
+                               data.numnutrients, nutrition);
+    if (error) goto QUIT;
+
+    error = GRBgetdblattrarray(model, GRB_DBL_ATTR_PI, 0, data.numnutrients, pi);
+    if (error) goto QUIT;
+  }
+  ph_end(phases);
+
+  printf("\nOptimization complete\n");
+  if (optimstatus == GRB_OPTIMAL) {
+    printf("\nFoods bought:\n      Food      Amount      Cost\n");
+    for (i=0; i<data.numfoods; i++) {
+      if (buy[i] > 1e-6)
+        printf("%10s  %10.4f  %8.4f\n", data.food[i], buy[i], data.cost[i]*buy[i]);
+    }
+
+    printf("\nOptimal objective: %.4e\n", objval);
+
+    printf("\nNutrition:\n  Nutrient      Intake   Minimum   Maximum    Dual Value\n");
+    for (i=0; i<data.numnutrients; i++) {
+      printf("%10s  %10.4f  %8.4g  ", data.nutrient[i], nutrition[i], data.minimum[i]);
+      if (data.maximum[i] < GRB_INFINITY)
+        printf("%8.4g  %12.4f\n", data.maximum[i], pi[i]);
+      else
+        printf("%8s  %12.4f\n", "inf", pi[i]);
+    }
+
+    printf("\nTiming: load %.3f ms, build %.3f ms, solve %.3f s\n",
+           1e3*tload, 1e3*tbuild, tsolve);
+  } else if (optimstatus == GRB_INF_OR_UNBD || optimstatus == GRB_INFEASIBLE) {
+    printf("No diet meets the nutrient bounds\n");
+  } else {
+    printf("Optimization was stopped early\n");
+  }
+
+QUIT:
+
+  /* Phase report, also of a failed run: the failed phase ends here */
+
+  if (phases) {
+    if (ph_write_json(phases, phasefile) != 0)
+      fprintf(stderr, "%s: %s\n", phasefile, strerror(errno));
+    ph_print(phases, stdout);
+    ph_free(phases);
+  }
+
+  /* Error reporting */
+
+  if (error) {
+    printf("ERROR: %s\n", GRBgeterrormsg(env));
+    exit(1);
+  }
+
+  /* Free data */
+
+  free(buy);
+  free(nutrition);
+  free(pi);
+  dd_free(&data);
+
+  /* Free model */
+
+  GRBfreemodel(model);
+
+  /* Free environment */
+
+  GRBfreeenv(env);
+
+  return 0;
+}
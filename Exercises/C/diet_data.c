@@ -0,0 +1,370 @@
+/* Food and nutrient catalog for the generalized diet problem.
+   See diet_data.h for the file format. */
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gurobi_c.h"
+#include "diet_data.h"
+#include "csvread.h"
+
+/* The diet of diet.c */
+
+static char  *Food[]     = { "x1", "x2", "x3", "x4", "x5" };
+static double Cost[]     = { 20, 10, 31, 11, 12 };
+static char  *Nutrient[] = { "iron", "calcium" };
+static double Minimum[]  = { 21, 12 };
+static int    Beg[]      = { 0, 1, 2, 4, 6, 8 };
+static int    Nutr[]     = { 0, 1, 0, 1, 0, 1, 0, 1 };
+static double Amount[]   = { 2, 1, 3, 2, 1, 2, 2, 1 };
+
+/* copy_name
+ * Copy [s,s+len) to *store as a string, advancing *store past it.
+ */
+static char *copy_name(const char *s, size_t len, char **store)
+{
+	char *name = *store;
+
+	memcpy(name, s, len);
+	name[len] = '\0';
+	*store += len + 1;
+	return name;
+}
+
+static int load_csv(const char *map, size_t len, const char *filename, DietData *d)
+{
+	CsvCursor   c = { map, map+len, 0 };
+	CsvCursor   cn, cf;
+	NameHash    hash = { NULL, 0 };
+	const char *rec, *end, *f, *g;
+	size_t      flen, glen;
+	long        mbytes, fbytes;
+	char       *store;
+	int        *seen = NULL;
+	int         count[2];
+	int         M, N, i, j, n, nz = 0;
+	double      v;
+
+	/* Counts and name bytes of both sections, then one allocation each */
+
+	if (csv_parse_header(&c, "nutrients", 1, count)) goto BADHEADER;
+	M = d->numnutrients = count[0];
+	cn = c;
+	if ((mbytes = csv_measure_names(&c, M, ',')) < 0) goto SHORT;
+	if (csv_parse_header(&c, "foods", 2, count)) goto BADHEADER;
+	N = d->numfoods = count[0];
+	cf = c;
+	if ((fbytes = csv_measure_names(&c, N, ',')) < 0) goto SHORT;
+
+	d->strings  = malloc(mbytes+fbytes > 0 ? mbytes+fbytes : 1);
+	d->nutrient = malloc((M > 0 ? M : 1)*sizeof(char *));
+	d->minimum  = malloc((M > 0 ? M : 1)*sizeof(double));
+	d->maximum  = malloc((M > 0 ? M : 1)*sizeof(double));
+	d->food     = malloc((N > 0 ? N : 1)*sizeof(char *));
+	d->cost     = malloc((N > 0 ? N : 1)*sizeof(double));
+	d->beg      = malloc((N+1)*sizeof(int));
+	d->nutr     = malloc((count[1] > 0 ? count[1] : 1)*sizeof(int));
+	d->amount   = malloc((count[1] > 0 ? count[1] : 1)*sizeof(double));
+	seen        = calloc(M > 0 ? M : 1, sizeof(int));
+	if (!d->strings || !d->nutrient || !d->minimum || !d->maximum ||
+	    !d->food || !d->cost || !d->beg || !d->nutr || !d->amount || !seen ||
+	    csv_hash_init(&hash, M))
+		goto NOMEM;
+	store = d->strings;
+
+	/* Nutrients: name,minimum,maximum */
+
+	c = cn;
+	for (i=0; i<M; i++) {
+		csv_next_record(&c, &rec, &end);
+		f = csv_next_field(&rec, end, ',', &flen);
+		d->nutrient[i] = copy_name(f, flen, &store);
+		if (csv_hash_find(&hash, d->nutrient, f, flen, 1, i) != i) {
+			fprintf(stderr, "%s:%d: duplicate nutrient '%s'\n", filename, c.line,
+			        d->nutrient[i]);
+			goto FAIL;
+		}
+		f = csv_next_field(&rec, end, ',', &flen);
+		if (f == NULL || csv_parse_num(f, flen, &d->minimum[i])) goto BADNUM;
+		f = csv_next_field(&rec, end, ',', &flen);
+		if (f == NULL || csv_parse_num(f, flen, &d->maximum[i])) goto BADNUM;
+		if (d->minimum[i] > d->maximum[i]) {
+			fprintf(stderr, "%s:%d: minimum above maximum\n", filename, c.line);
+			goto FAIL;
+		}
+	}
+
+	/* Foods: name,cost,nutrient:amount,... as the columns of the matrix */
+
+	c = cf;
+	d->numnz = count[1];
+	for (j=0; j<N; j++) {
+		csv_next_record(&c, &rec, &end);
+		f = csv_next_field(&rec, end, ',', &flen);
+		d->food[j] = copy_name(f, flen, &store);
+		f = csv_next_field(&rec, end, ',', &flen);
+		if (f == NULL || csv_parse_num(f, flen, &d->cost[j])) goto BADNUM;
+		d->beg[j] = nz;
+		while ((f = csv_next_field(&rec, end, ',', &flen)) != NULL) {
+			g = f;
+			f = csv_next_field(&g, f+flen, ':', &glen);
+			if ((n = csv_hash_find(&hash, d->nutrient, f, glen, 0, 0)) < 0) {
+				fprintf(stderr, "%s:%d: unknown nutrient\n", filename, c.line);
+				goto FAIL;
+			}
+			if (seen[n] == j+1) {
+				fprintf(stderr, "%s:%d: nutrient '%s' listed twice\n", filename, c.line,
+				        d->nutrient[n]);
+				goto FAIL;
+			}
+			seen[n] = j+1;
+			if (glen == flen || csv_parse_num(g, f+flen-g, &v) || fabs(v) >= GRB_INFINITY)
+				goto BADNUM;
+			if (v == 0.0) continue;
+			if (nz == d->numnz) {
+				fprintf(stderr, "%s:%d: more nonzeros than the %d of the header\n",
+				        filename, c.line, d->numnz);
+				goto FAIL;
+			}
+			d->nutr[nz] = n;
+			d->amount[nz++] = v;
+		}
+	}
+	d->beg[N] = nz;
+	d->numnz = nz;
+
+	free(hash.slot);
+	free(seen);
+	return 0;
+
+BADHEADER:
+	fprintf(stderr, "%s:%d: expected section header\n", filename, c.line);
+	goto FAIL;
+SHORT:
+	fprintf(stderr, "%s: unexpected end of file\n", filename);
+	goto FAIL;
+BADNUM:
+	fprintf(stderr, "%s:%d: bad or missing number\n", filename, c.line);
+	goto FAIL;
+NOMEM:
+	fprintf(stderr, "%s: out of memory\n", filename);
+FAIL:
+	free(hash.slot);
+	free(seen);
+	return 1;
+}
+
+int dd_load(const char *filename, DietData *d)
+{
+	struct stat st;
+	void       *map;
+	int         fd;
+	int         error;
+
+	memset(d, 0, sizeof(*d));
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		perror(filename);
+		if (fd >= 0) close(fd);
+		return 1;
+	}
+	if (st.st_size == 0) {
+		fprintf(stderr, "%s: empty file\n", filename);
+		close(fd);
+		return 1;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		perror(filename);
+		return 1;
+	}
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+	error = load_csv(map, st.st_size, filename, d);
+	munmap(map, st.st_size);
+	if (error) dd_free(d);
+	return error;
+}
+
+int dd_default(DietData *d)
+{
+	int M = sizeof(Nutrient)/sizeof(Nutrient[0]);
+	int N = sizeof(Food)/sizeof(Food[0]);
+	int i;
+
+	memset(d, 0, sizeof(*d));
+	d->numfoods = N;
+	d->numnutrients = M;
+	d->numnz = Beg[N];
+	d->food     = malloc(N*sizeof(char *));
+	d->nutrient = malloc(M*sizeof(char *));
+	d->cost     = malloc(N*sizeof(double));
+	d->minimum  = malloc(M*sizeof(double));
+	d->maximum  = malloc(M*sizeof(double));
+	d->beg      = malloc((N+1)*sizeof(int));
+	d->nutr     = malloc(d->numnz*sizeof(int));
+	d->amount   = malloc(d->numnz*sizeof(double));
+	if (!d->food || !d->nutrient || !d->cost || !d->minimum || !d->maximum ||
+	    !d->beg || !d->nutr || !d->amount) {
+		dd_free(d);
+		return 1;
+	}
+	memcpy(d->food, Food, sizeof(Food));
+	memcpy(d->nutrient, Nutrient, sizeof(Nutrient));
+	memcpy(d->cost, Cost, sizeof(Cost));
+	memcpy(d->minimum, Minimum, sizeof(Minimum));
+	for (i=0; i<M; i++) d->maximum[i] = GRB_INFINITY;
+	memcpy(d->beg, Beg, sizeof(Beg));
+	memcpy(d->nutr, Nutr, sizeof(Nutr));
+	memcpy(d->amount, Amount, sizeof(Amount));
+	return 0;
+}
+
+/* uniform
+ * output: a double uniform in [0,1)
+ */
+static double uniform(uint64_t *s)
+{
+	return (splitmix64(s) >> 11) * 0x1.0p-53;
+}
+
+int dd_generate(int numfoods, int numnutrients, int perfood, uint64_t seed,
+                DietData *d)
+{
+	int      M = numnutrients, N = numfoods;
+	int     *perm = NULL;
+	double  *intake = NULL;
+	char    *store;
+	uint64_t state = seed;
+	int      i, j, k, nz;
+
+	memset(d, 0, sizeof(*d));
+	if (M < 0 || N < 0 || perfood < 0 || perfood > M ||
+	    (double) N*perfood > INT32_MAX)
+		return 1;
+	d->numfoods = N;
+	d->numnutrients = M;
+	d->numnz = N*perfood;
+	d->strings  = malloc((size_t) (N+M)*16 + 1);
+	d->food     = malloc((N > 0 ? N : 1)*sizeof(char *));
+	d->nutrient = malloc((M > 0 ? M : 1)*sizeof(char *));
+	d->cost     = malloc((N > 0 ? N : 1)*sizeof(double));
+	d->minimum  = malloc((M > 0 ? M : 1)*sizeof(double));
+	d->maximum  = malloc((M > 0 ? M : 1)*sizeof(double));
+	d->beg      = malloc((N+1)*sizeof(int));
+	d->nutr     = malloc((d->numnz > 0 ? d->numnz : 1)*sizeof(int));
+	d->amount   = malloc((d->numnz > 0 ? d->numnz : 1)*sizeof(double));
+	perm        = malloc((M > 0 ? M : 1)*sizeof(int));
+	intake      = calloc(M > 0 ? M : 1, sizeof(double));
+	if (!d->strings || !d->food || !d->nutrient || !d->cost || !d->minimum ||
+	    !d->maximum || !d->beg || !d->nutr || !d->amount || !perm || !intake) {
+		free(perm);
+		free(intake);
+		dd_free(d);
+		return 1;
+	}
+
+	store = d->strings;
+	for (i=0; i<M; i++) {
+		d->nutrient[i] = store;
+		store += sprintf(store, "n%d", i) + 1;
+		perm[i] = i;
+	}
+
+	/* Each food carries perfood distinct nutrients, the first perfood of a
+	   partial shuffle of perm */
+
+	for (j=0, nz=0; j<N; j++) {
+		d->food[j] = store;
+		store += sprintf(store, "f%d", j) + 1;
+		d->cost[j] = 1 + floor(100*uniform(&state))/10;
+		d->beg[j] = nz;
+		for (k=0; k<perfood; k++) {
+			int r = k + (int) ((M-k)*uniform(&state));
+			int t = perm[k]; perm[k] = perm[r]; perm[r] = t;
+			d->nutr[nz] = perm[k];
+			d->amount[nz] = 0.01 + floor(1000*uniform(&state))/100;
+			intake[perm[k]] += d->amount[nz++];
+		}
+	}
+	d->beg[N] = nz;
+
+	/* One unit of every food is a feasible diet: the minimum is a few
+	   percent of its intake, a quarter of the nutrients also have a maximum
+	   above it */
+
+	for (i=0; i<M; i++) {
+		d->minimum[i] = floor(intake[i]*(0.01 + 0.04*uniform(&state)));
+		d->maximum[i] = uniform(&state) < 0.25 ? ceil(intake[i]*(1 + uniform(&state)))
+		                                       : GRB_INFINITY;
+	}
+	free(perm);
+	free(intake);
+	return 0;
+}
+
+/* put_num
+ * Print v to fp, GRB_INFINITY as inf.
+ */
+static void put_num(FILE *fp, double v)
+{
+	if (v >= GRB_INFINITY)       fputs("inf", fp);
+	else if (v <= -GRB_INFINITY) fputs("-inf", fp);
+	else                         fprintf(fp, "%.17g", v);
+}
+
+int dd_save(const DietData *d, const char *filename)
+{
+	FILE *fp;
+	int   i, j, k;
+
+	fp = fopen(filename, "w");
+	if (fp == NULL) {
+		perror(filename);
+		return 1;
+	}
+	fprintf(fp, "nutrients,%d\n", d->numnutrients);
+	for (i=0; i<d->numnutrients; i++) {
+		fprintf(fp, "%s,", d->nutrient[i]);
+		put_num(fp, d->minimum[i]);
+		fputc(',', fp);
+		put_num(fp, d->maximum[i]);
+		fputc('\n', fp);
+	}
+	fprintf(fp, "foods,%d,%d\n", d->numfoods, d->numnz);
+	for (j=0; j<d->numfoods; j++) {
+		fprintf(fp, "%s,", d->food[j]);
+		put_num(fp, d->cost[j]);
+		for (k=d->beg[j]; k<d->beg[j+1]; k++) {
+			fprintf(fp, ",%s:", d->nutrient[d->nutr[k]]);
+			put_num(fp, d->amount[k]);
+		}
+		fputc('\n', fp);
+	}
+	if (fclose(fp) != 0) {
+		perror(filename);
+		return 1;
+	}
+	return 0;
+}
+
+void dd_free(DietData *d)
+{
+	free(d->food);
+	free(d->nutrient);
+	free(d->cost);
+	free(d->minimum);
+	free(d->maximum);
+	free(d->beg);
+	free(d->nutr);
+	free(d->amount);
+	free(d->strings);
+	memset(d, 0, sizeof(*d));
+}
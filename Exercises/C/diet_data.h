@@ -0,0 +1,86 @@
+/* Food and nutrient catalog for the generalized diet problem.
+
+   The diet of diet.c has 5 foods and 2 nutrients written into the code.
+   A catalog has any number of both: every nutrient has a minimum and a
+   maximum intake, every food a cost per unit and an amount of some of the
+   nutrients.  Most foods carry only a few of the nutrients, so the amounts
+   are kept as a sparse matrix in CSC form, one column per food, which is
+   the layout GRBaddvars takes:
+
+     the nutrients of food f are nutr[beg[f]..beg[f+1]-1], with amounts
+     amount[beg[f]..beg[f+1]-1]
+
+   Zero amounts are never stored.
+
+   CSV layout (lines starting with '#' and blank lines are ignored):
+
+     nutrients,2
+     iron,21,inf              name,minimum,maximum
+     calcium,12,inf
+     foods,5,8                count,nonzeros
+     x1,20,iron:2             name,cost,nutrient:amount,...
+     x2,10,calcium:1
+     ...
+
+   The counts in the section headers size every array, which is allocated
+   once.  The file is memory mapped; a first pass over it only measures
+   the names, the second one parses the records straight into the arrays.
+   The nonzeros count may exceed the amounts actually listed, but not fall
+   short of them.  A nutrient may appear only once per food.
+*/
+
+#ifndef DIET_DATA_H
+#define DIET_DATA_H
+
+#include <stdint.h>
+
+typedef struct {
+  int      numfoods;
+  int      numnutrients;
+  int      numnz;
+  char   **food;       /* [numfoods] names */
+  char   **nutrient;   /* [numnutrients] names */
+  double  *cost;       /* [numfoods] */
+  double  *minimum;    /* [numnutrients] */
+  double  *maximum;    /* [numnutrients], GRB_INFINITY for none */
+  int     *beg;        /* [numfoods+1] */
+  int     *nutr;       /* [numnz] nutrient index of each amount */
+  double  *amount;     /* [numnz] nonzero */
+
+  /* storage, owned by the DietData */
+  char    *strings;    /* name characters */
+} DietData;
+
+/* dd_default
+ * output: 0 on success; d holds the diet of diet.c
+ */
+int dd_default(DietData *d);
+
+/* dd_load
+ * inputs: filename  CSV catalog
+ * output: 0 on success; on failure d is left empty and a message naming
+ *         the file and line is printed to stderr
+ */
+int dd_load(const char *filename, DietData *d);
+
+/* dd_generate
+ * inputs: numfoods, numnutrients  catalog size
+ *         perfood                 nutrients per food, at most numnutrients
+ *         seed                    the catalog depends on it alone
+ * output: 0 on success; d holds a random catalog that always has a
+ *         feasible diet
+ */
+int dd_generate(int numfoods, int numnutrients, int perfood, uint64_t seed,
+                DietData *d);
+
+/* dd_save
+ * output: 0 on success; writes d as a CSV catalog to filename
+ */
+int dd_save(const DietData *d, const char *filename);
+
+/* dd_free
+ * Release everything held by d.  Safe to call on a zeroed DietData.
+ */
+void dd_free(DietData *d);
+
+#endif
@@ -10,14 +10,23 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "gurobi_c.h"
+#include "lpmodel.h"
+
+/* Usage:  diet_dual [-backend auto|dense|gurobi]
+
+   Built into an LPModel (lpmodel.h) like diet, so the dense simplex solves
+   it in process unless -backend gurobi asks for Gurobi.  Build with
+   lpmodel.c, dsimplex.c, dualcheck.c and -lm.
+*/
 
 int
 main(int   argc,
      char *argv[])
 {
-  GRBenv   *env   = NULL;
-  GRBmodel *model = NULL;
+  LPModel  *lp    = NULL;
+  LMBackend backend = LM_AUTO;
   int 		i;
   int       error = 0;
   char     *varnames[2] = { "pi", "pc" };
@@ -30,38 +39,41 @@ main(int   argc,
   int       ind[2];
   double    val[2];
   double    obj[2];
-  char      vtype[2];
   int       optimstatus;
   double    objval;
 
-  /* Create environment */
-
-  error = GRBloadenv(&env, "diet.log");
-  if (error) goto QUIT;
+  for (i=1; i<argc; i++) {
+    if (strcmp(argv[i], "-backend") == 0 && i+1 < argc) {
+      i++;
+      if (strcmp(argv[i], "auto") == 0) backend = LM_AUTO;
+      else if (strcmp(argv[i], "dense") == 0) backend = LM_DENSE;
+      else if (strcmp(argv[i], "gurobi") == 0) backend = LM_GUROBI;
+      else {
+        fprintf(stderr, "%s: unknown backend %s\n", argv[0], argv[i]);
+        exit(1);
+      }
+    } else {
+      fprintf(stderr, "usage: %s [-backend auto|dense|gurobi]\n", argv[0]);
+      exit(1);
+    }
+  }
 
-  /* Create an empty model */
+  /* Create an empty model; the environment is only started if Gurobi
+     solves it */
 
-  error = GRBnewmodel(env, &model, "diet", 0, NULL, NULL, NULL, NULL, NULL);
+  error = lm_new(backend, "diet", "diet.log", &lp);
   if (error) goto QUIT;
 
 
   /* Add variables */
 
   obj[0] = 21; obj[1] = 12;
-  for ( i = 0; i < 2; i++) {
-	  vtype[i] = GRB_CONTINUOUS;
-  }
-  error = GRBaddvars(model, 2, 0, NULL, NULL, NULL, obj, NULL, NULL, vtype, varnames);
+  error = lm_addvars(lp, 2, obj, NULL, NULL, varnames);
   if (error) goto QUIT;
 
   /* Change objective sense to minimization */
 
-  error = GRBsetintattr(model, GRB_INT_ATTR_MODELSENSE, GRB_MAXIMIZE);
-  if (error) goto QUIT;
-
-  /* Integrate new variables */
-
-  error = GRBupdatemodel(model);
+  error = lm_setsense(lp, GRB_MAXIMIZE);
   if (error) goto QUIT;
 
 
@@ -70,7 +82,7 @@ main(int   argc,
   ind[0] = 0; ind[1] = 1;
   val[0] = 2; val[1] = 0;
 
-  error = GRBaddconstr(model, 2, ind, val, GRB_LESS_EQUAL, 20.0, "c1");
+  error = lm_addconstr(lp, 2, ind, val, GRB_LESS_EQUAL, 20.0, "c1");
   if (error) goto QUIT;
 
   /* 2nd constraint: 0pi + 1pc <= 10 */
@@ -78,7 +90,7 @@ main(int   argc,
   ind[0] = 0; ind[1] = 1;
   val[0] = 0; val[1] = 1;
 
-  error = GRBaddconstr(model, 2, ind, val, GRB_LESS_EQUAL, 10.0, "c2");
+  error = lm_addconstr(lp, 2, ind, val, GRB_LESS_EQUAL, 10.0, "c2");
   if (error) goto QUIT;
 
   /* 3rd constraint: 3pi + 2pc <= 31 */
@@ -86,7 +98,7 @@ main(int   argc,
   ind[0] = 0; ind[1] = 1;
   val[0] = 3; val[1] = 2;
 
-  error = GRBaddconstr(model, 2, ind, val, GRB_LESS_EQUAL, 31.0, "c3");
+  error = lm_addconstr(lp, 2, ind, val, GRB_LESS_EQUAL, 31.0, "c3");
   if (error) goto QUIT;
 
   /* 4th constraint: 1pi + 2pc <= 11 */
@@ -94,7 +106,7 @@ main(int   argc,
   ind[0] = 0; ind[1] = 1;
   val[0] = 1; val[1] = 2;
 
-  error = GRBaddconstr(model, 2, ind, val, GRB_LESS_EQUAL, 11.0, "c4");
+  error = lm_addconstr(lp, 2, ind, val, GRB_LESS_EQUAL, 11.0, "c4");
   if (error) goto QUIT;
 
   /* 5th constraint: 2pi + 1pc <= 12 */
@@ -102,47 +114,49 @@ main(int   argc,
   ind[0] = 0; ind[1] = 1;
   val[0] = 2; val[1] = 1;
 
-  error = GRBaddconstr(model, 2, ind, val, GRB_LESS_EQUAL, 12.0, "c5");
+  error = lm_addconstr(lp, 2, ind, val, GRB_LESS_EQUAL, 12.0, "c5");
   if (error) goto QUIT;
 
 
   /* Optimize model */
 
-  error = GRBoptimize(model);
+  error = lm_optimize(lp);
   if (error) goto QUIT;
 
   /* Write model to 'mip1.lp' */
 
-  error = GRBwrite(model, "diet.lp");
+  error = lm_write(lp, "diet.lp");
   if (error) goto QUIT;
 
   /* Capture solution information */
 
-  error = GRBgetintattr(model, GRB_INT_ATTR_STATUS, &optimstatus);
+  error = lm_getstatus(lp, &optimstatus);
   if (error) goto QUIT;
 
-  error = GRBgetdblattr(model, GRB_DBL_ATTR_OBJVAL, &objval);
-  if (error) goto QUIT;
+  if (optimstatus == GRB_OPTIMAL) {
+    error = lm_getobjval(lp, &objval);
+    if (error) goto QUIT;
 
-  error = GRBgetstrattrarray(model, GRB_STR_ATTR_VARNAME, 0, 2, name);
-  if (error) goto QUIT;
+    error = lm_getstrarray(lp, GRB_STR_ATTR_VARNAME, 0, 2, name);
+    if (error) goto QUIT;
 
-  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_X, 0, 2, sol);
-  if (error) goto QUIT;
+    error = lm_getdblarray(lp, GRB_DBL_ATTR_X, 0, 2, sol);
+    if (error) goto QUIT;
 
-  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_RC, 0, 2, rc);
-  if (error) goto QUIT;
+    error = lm_getdblarray(lp, GRB_DBL_ATTR_RC, 0, 2, rc);
+    if (error) goto QUIT;
 
-  error = GRBgetstrattrarray(model, GRB_STR_ATTR_CONSTRNAME, 0, 5, conname);
-  if (error) goto QUIT;
+    error = lm_getstrarray(lp, GRB_STR_ATTR_CONSTRNAME, 0, 5, conname);
+    if (error) goto QUIT;
 
-  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_SLACK, 0, 5, slack);
-  if (error) goto QUIT;
+    error = lm_getdblarray(lp, GRB_DBL_ATTR_SLACK, 0, 5, slack);
+    if (error) goto QUIT;
 
-  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_PI, 0, 5, pi);
-  if (error) goto QUIT;
+    error = lm_getdblarray(lp, GRB_DBL_ATTR_PI, 0, 5, pi);
+    if (error) goto QUIT;
+  }
 
-  printf("\nOptimization complete\n");
+  printf("\nOptimization complete (%s)\n", lm_solvedby(lp));
   if (optimstatus == GRB_OPTIMAL) {
 	printf("\nVariables:\nV Name      Value    Red. Cost\n");
 	for (i=0; i<2; i++) {
@@ -155,6 +169,10 @@ main(int   argc,
 	for (i=0; i<5; i++) {
         printf("%7s    %5.1f     %8.4f\n",conname[i],slack[i],pi[i]);
 	}
+  } else if (optimstatus == GRB_INFEASIBLE) {
+    printf("Model is infeasible\n");
+  } else if (optimstatus == GRB_UNBOUNDED) {
+    printf("Model is unbounded\n");
   } else if (optimstatus == GRB_INF_OR_UNBD) {
     printf("Model is infeasible or unbounded\n");
   } else {
@@ -166,17 +184,13 @@ QUIT:
   /* Error reporting */
 
   if (error) {
-    printf("ERROR: %s\n", GRBgeterrormsg(env));
+    printf("ERROR: %s\n", lm_errormsg(lp));
     exit(1);
   }
 
-  /* Free model */
-
-  GRBfreemodel(model);
-
-  /* Free environment */
+  /* Free model, and the environment if it was started */
 
-  GRBfreeenv(env);
+  lm_free(lp);
 
   return 0;
 }
@@ -0,0 +1,613 @@
+/* This example keeps one Gurobi environment and one diet model alive and
+   solves a stream of diet instances against it:
+
+     minimize    c'x
+     subject to  Ax ≥ b,  x ≥ 0
+
+   Each instance only changes the objective, the nutrient matrix and the
+   requirements, so they are pushed into the existing model in place
+   (GRBsetdblattrlist, GRBchgcoeffs) and the dual simplex restarts from the
+   previous basis.  Foods and nutrients are added or deleted at the end only
+   when an instance has a different size than the one before it.
+*/
+
+/* Usage:  diet_server [-socket path]
+
+   Reads instances from stdin, or serves clients one at a time on the Unix
+   domain socket path.  An instance is a sequence of whitespace separated
+   numbers ('#' starts a comment that runs to the end of the line):
+
+     n m                       number of foods and of nutrients
+     c_1 ... c_n               cost of each food
+     a_i1 ... a_in b_i         m rows: nutrient content of each food and the
+                               requirement, for i = 1..m
+
+   The original diet.c instance is
+
+     5 2
+     20 10 31 11 12
+     2 0 3 1 2  21
+     0 1 2 2 1  12
+
+   One line is written back per instance:
+
+     seq status objval x_1 ... x_n pi_1 ... pi_m
+
+   where seq counts the instances of the stream from 1 and status is the
+   Gurobi status code.  If status is not GRB_OPTIMAL the line stops after
+   status.  A malformed instance is answered with "error seq message" and
+   ends the stream.  Output is flushed whenever the server is about to wait
+   for more input, so pipelined clients get full buffers and interactive
+   ones get every answer.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "gurobi_c.h"
+
+#define MAXDIM   100000
+#define READBUF  65536
+
+/* Buffered reader over a file descriptor */
+
+typedef struct {
+  int    fd;
+  FILE  *out;		/* flushed before every blocking read */
+  char   buf[READBUF];
+  size_t pos;
+  size_t len;
+} Reader;
+
+/* The model and a copy of the data it currently holds */
+
+typedef struct {
+  GRBmodel *model;
+  int       n;		/* foods */
+  int       m;		/* nutrients */
+  double   *obj;	/* [n] */
+  double   *A;		/* [m*n] row major */
+  double   *rhs;	/* [m] */
+  double   *nobj;	/* [n] the instance being read, kept apart until */
+  double   *nA;		/* [m*n] all of it has parsed */
+  double   *nrhs;	/* [m] */
+  double   *x;		/* [n] */
+  double   *pi;		/* [m] */
+  char     *sense;	/* [m] */
+  int      *rind;	/* [m] requirement change list */
+  double   *rval;
+  int      *cind;	/* [m*n] coefficient and objective change lists */
+  int      *vind;
+  double   *val;
+  size_t    capn;
+  size_t    capm;
+  size_t    capnm;
+  long      resized;	/* number of instances that changed n or m */
+} DietModel;
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig)
+{
+	(void) sig;
+	stop = 1;
+}
+
+/* grow
+ * inputs: array *p, new element count and size
+ * output: 0 with *p reallocated (contents kept), -1 if out of memory
+ */
+static int grow(void **p, size_t count, size_t elsize)
+{
+	void *q = realloc(*p, count*elsize);
+
+	if (q == NULL) return -1;
+	*p = q;
+	return 0;
+}
+
+/* rd_fill
+ * output: number of bytes read into the empty buffer, 0 at end of input
+ */
+static size_t rd_fill(Reader *r)
+{
+	ssize_t got;
+
+	fflush(r->out);
+	do {
+		got = read(r->fd, r->buf, READBUF);
+	} while (got < 0 && errno == EINTR && !stop);
+	r->pos = 0;
+	r->len = got > 0 ? (size_t)got : 0;
+	return r->len;
+}
+
+/* rd_token
+ * inputs: reader, output buffer tok of size cap
+ * output: length of the next token copied to tok ('\0' terminated), 0 at end
+ *         of input, -1 if the token does not fit
+ */
+static int rd_token(Reader *r, char *tok, int cap)
+{
+	int len = 0;
+	int comment = 0;
+	char ch;
+
+	for (;;) {
+		if (r->pos == r->len && rd_fill(r) == 0) break;
+		ch = r->buf[r->pos];
+		if (comment) {
+			r->pos++;
+			if (ch == '\n') comment = 0;
+			continue;
+		}
+		if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') {
+			if (len > 0) break;
+			r->pos++;
+			continue;
+		}
+		if (ch == '#') {
+			if (len > 0) break;
+			comment = 1;
+			r->pos++;
+			continue;
+		}
+		if (len == cap-1) return -1;
+		tok[len++] = ch;
+		r->pos++;
+	}
+	tok[len] = '\0';
+	return len;
+}
+
+/* rd_double
+ * output: 1 and *v set to the next number, 0 at end of input, -1 if the next
+ *         token is not a number
+ */
+static int rd_double(Reader *r, double *v)
+{
+	char tok[64];
+	char *end;
+	int len = rd_token(r, tok, sizeof(tok));
+
+	if (len <= 0) return len;
+	*v = strtod(tok, &end);
+	return *end == '\0' ? 1 : -1;
+}
+
+/* diet_init
+ * output: 0 or a Gurobi error code; an empty minimization model in s
+ */
+static int diet_init(GRBenv *env, DietModel *s)
+{
+	int error;
+
+	memset(s, 0, sizeof(*s));
+	error = GRBnewmodel(env, &s->model, "diet", 0, NULL, NULL, NULL, NULL, NULL);
+	if (error) return error;
+	return GRBsetintattr(s->model, GRB_INT_ATTR_MODELSENSE, GRB_MINIMIZE);
+}
+
+static void diet_free(DietModel *s)
+{
+	GRBfreemodel(s->model);
+	free(s->obj);
+	free(s->A);
+	free(s->rhs);
+	free(s->nobj);
+	free(s->nA);
+	free(s->nrhs);
+	free(s->x);
+	free(s->pi);
+	free(s->sense);
+	free(s->rind);
+	free(s->rval);
+	free(s->cind);
+	free(s->vind);
+	free(s->val);
+}
+
+/* diet_reserve
+ * inputs: model state, size n x m of the next instance
+ * output: 0, or -1 if the buffers cannot be grown to an n x m instance
+ */
+static int diet_reserve(DietModel *s, int n, int m)
+{
+	size_t nm = (size_t)n*m;
+
+	if ((size_t)n > s->capn) {
+		if (grow((void **)&s->obj, n, sizeof(double)) ||
+		    grow((void **)&s->nobj, n, sizeof(double)) ||
+		    grow((void **)&s->x, n, sizeof(double)))
+			return -1;
+		s->capn = n;
+	}
+	if ((size_t)m > s->capm) {
+		if (grow((void **)&s->rhs, m, sizeof(double)) ||
+		    grow((void **)&s->nrhs, m, sizeof(double)) ||
+		    grow((void **)&s->pi, m, sizeof(double)) ||
+		    grow((void **)&s->sense, m, sizeof(char)) ||
+		    grow((void **)&s->rind, m, sizeof(int)) ||
+		    grow((void **)&s->rval, m, sizeof(double)))
+			return -1;
+		s->capm = m;
+	}
+	if (nm > s->capnm) {
+		if (grow((void **)&s->A, nm, sizeof(double)) ||
+		    grow((void **)&s->nA, nm, sizeof(double)) ||
+		    grow((void **)&s->cind, nm, sizeof(int)) ||
+		    grow((void **)&s->vind, nm, sizeof(int)) ||
+		    grow((void **)&s->val, nm, sizeof(double)))
+			return -1;
+		s->capnm = nm;
+	}
+	return 0;
+}
+
+/* diet_resize
+ * inputs: model state with buffers reserved for n x m, new size n x m
+ * output: 0 or a Gurobi error code; foods and nutrients appended or deleted
+ *         at the end so that the model is n x m.  New entries of the cached
+ *         data are zero, which is also what the model holds for them.
+ */
+static int diet_resize(DietModel *s, int n, int m)
+{
+	int error;
+	int i, j;
+	int keep = m < s->m ? m : s->m;
+	int *ind = s->cind;
+
+	if (n < s->n) {
+		for (j = n; j < s->n; j++) ind[j-n] = j;
+		error = GRBdelvars(s->model, s->n-n, ind);
+		if (error) return error;
+	}
+	if (m < s->m) {
+		for (i = m; i < s->m; i++) ind[i-m] = i;
+		error = GRBdelconstrs(s->model, s->m-m, ind);
+		if (error) return error;
+	}
+	if (n > s->n) {
+		error = GRBaddvars(s->model, n-s->n, 0, NULL, NULL, NULL,
+		                   NULL, NULL, NULL, NULL, NULL);
+		if (error) return error;
+		for (j = s->n; j < n; j++) s->obj[j] = 0.0;
+	}
+	if (m > s->m) {
+		for (i = s->m; i < m; i++) {
+			ind[i-s->m] = 0;
+			s->sense[i] = GRB_GREATER_EQUAL;
+			s->rhs[i] = 0.0;
+		}
+		error = GRBaddconstrs(s->model, m-s->m, 0, ind, NULL, NULL,
+		                      s->sense+s->m, s->rhs+s->m, NULL);
+		if (error) return error;
+	}
+
+	/* Re-stride the cached matrix from s->n to n columns in place */
+
+	if (n < s->n) {
+		for (i = 0; i < keep; i++)
+			memmove(s->A+(size_t)i*n, s->A+(size_t)i*s->n, n*sizeof(double));
+	} else if (n > s->n) {
+		for (i = keep-1; i >= 0; i--) {
+			memmove(s->A+(size_t)i*n, s->A+(size_t)i*s->n, s->n*sizeof(double));
+			for (j = s->n; j < n; j++) s->A[(size_t)i*n+j] = 0.0;
+		}
+	}
+	for (i = keep; i < m; i++)
+		for (j = 0; j < n; j++) s->A[(size_t)i*n+j] = 0.0;
+
+	s->n = n;
+	s->m = m;
+	s->resized++;
+	return GRBupdatemodel(s->model);
+}
+
+/* diet_read
+ * inputs: model state, reader positioned at the start of an instance
+ * output: 1 with the instance loaded into the model, 0 at end of input, -1
+ *         with *msg set on malformed input, or a Gurobi error code in *error
+ */
+static int diet_read(DietModel *s, Reader *r, const char **msg, int *error)
+{
+	double v;
+	int n, m, i, j, cnt, rcnt, ok;
+
+	*error = 0;
+	ok = rd_double(r, &v);
+	if (ok <= 0) {
+		*msg = "expected the number of foods";
+		return ok;
+	}
+	n = (int)v;
+	if (rd_double(r, &v) <= 0) {
+		*msg = "expected the number of nutrients";
+		return -1;
+	}
+	m = (int)v;
+	if (n < 1 || m < 1 || n > MAXDIM || m > MAXDIM || (double)n*m > MAXDIM*10.0) {
+		*msg = "bad instance size";
+		return -1;
+	}
+	if (diet_reserve(s, n, m)) {
+		*msg = "out of memory";
+		return -1;
+	}
+
+	/* Parse the whole instance before touching the model, so that a
+	 * malformed one leaves the model and its cached data as they were */
+
+	for (j = 0; j < n; j++)
+		if (rd_double(r, &s->nobj[j]) <= 0) {
+			*msg = "expected a cost";
+			return -1;
+		}
+	for (i = 0; i < m; i++) {
+		for (j = 0; j < n; j++)
+			if (rd_double(r, &s->nA[(size_t)i*n+j]) <= 0) {
+				*msg = "expected a nutrient coefficient";
+				return -1;
+			}
+		if (rd_double(r, &s->nrhs[i]) <= 0) {
+			*msg = "expected a requirement";
+			return -1;
+		}
+	}
+
+	if (n != s->n || m != s->m) {
+		*error = diet_resize(s, n, m);
+		if (*error) return -1;
+	}
+
+	/* Objective */
+
+	for (j = cnt = 0; j < n; j++) {
+		v = s->nobj[j];
+		if (v != s->obj[j]) {
+			s->obj[j] = v;
+			s->vind[cnt] = j;
+			s->val[cnt++] = v;
+		}
+	}
+	if (cnt > 0) {
+		*error = GRBsetdblattrlist(s->model, GRB_DBL_ATTR_OBJ, cnt, s->vind, s->val);
+		if (*error) return -1;
+	}
+
+	/* Nutrient matrix and requirements */
+
+	for (i = cnt = rcnt = 0; i < m; i++) {
+		double *row = s->A+(size_t)i*n;
+		double *nrow = s->nA+(size_t)i*n;
+		for (j = 0; j < n; j++) {
+			if (nrow[j] != row[j]) {
+				row[j] = nrow[j];
+				s->cind[cnt] = i;
+				s->vind[cnt] = j;
+				s->val[cnt++] = nrow[j];
+			}
+		}
+		if (s->nrhs[i] != s->rhs[i]) {
+			s->rhs[i] = s->nrhs[i];
+			s->rind[rcnt] = i;
+			s->rval[rcnt++] = s->nrhs[i];
+		}
+	}
+	if (cnt > 0) {
+		*error = GRBchgcoeffs(s->model, cnt, s->cind, s->vind, s->val);
+		if (*error) return -1;
+	}
+	if (rcnt > 0) {
+		*error = GRBsetdblattrlist(s->model, GRB_DBL_ATTR_RHS, rcnt, s->rind, s->rval);
+		if (*error) return -1;
+	}
+	return 1;
+}
+
+/* diet_solve
+ * output: 0 or a Gurobi error code; the result line for instance seq
+ *         written to out
+ */
+static int diet_solve(DietModel *s, long seq, FILE *out)
+{
+	int error, status, i;
+	double objval;
+
+	error = GRBoptimize(s->model);
+	if (error) return error;
+	error = GRBgetintattr(s->model, GRB_INT_ATTR_STATUS, &status);
+	if (error) return error;
+	if (status != GRB_OPTIMAL) {
+		fprintf(out, "%ld %d\n", seq, status);
+		return 0;
+	}
+	error = GRBgetdblattr(s->model, GRB_DBL_ATTR_OBJVAL, &objval);
+	if (error) return error;
+	error = GRBgetdblattrarray(s->model, GRB_DBL_ATTR_X, 0, s->n, s->x);
+	if (error) return error;
+	error = GRBgetdblattrarray(s->model, GRB_DBL_ATTR_PI, 0, s->m, s->pi);
+	if (error) return error;
+
+	fprintf(out, "%ld %d %.10g", seq, status, objval);
+	for (i = 0; i < s->n; i++) fprintf(out, " %.10g", s->x[i]);
+	for (i = 0; i < s->m; i++) fprintf(out, " %.10g", s->pi[i]);
+	fputc('\n', out);
+	return 0;
+}
+
+/* serve
+ * inputs: model state, input descriptor fd, output stream out
+ * output: 0 or a Gurobi error code; all instances read from fd answered on
+ *         out, throughput reported on stderr
+ */
+static int serve(DietModel *s, int fd, FILE *out)
+{
+	static Reader r;
+	struct timespec t0, t1;
+	const char *msg = NULL;
+	long seq = 0;
+	long resized = s->resized;
+	int error = 0;
+	int ok;
+	double secs;
+
+	r.fd = fd;
+	r.out = out;
+	r.pos = r.len = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	while (!stop && !ferror(out)) {
+		ok = diet_read(s, &r, &msg, &error);
+		if (ok == 0) break;
+		seq++;
+		if (error) break;
+		if (ok < 0) {
+			fprintf(out, "error %ld %s\n", seq, msg);
+			break;
+		}
+		error = diet_solve(s, seq, out);
+		if (error) break;
+	}
+	fflush(out);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	secs = (t1.tv_sec-t0.tv_sec) + 1e-9*(t1.tv_nsec-t0.tv_nsec);
+	fprintf(stderr, "Solved %ld instances in %.3f s (%.0f per second), %ld resized the model\n",
+	        seq, secs, secs > 0 ? seq/secs : 0.0, s->resized-resized);
+	return error;
+}
+
+/* listen_unix
+ * output: listening socket bound to path, -1 with errno set on failure
+ */
+static int listen_unix(const char *path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) return -1;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	unlink(path);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 8) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+int
+main(int   argc,
+     char *argv[])
+{
+  GRBenv   *env   = NULL;
+  DietModel diet;
+  int       error = 0;
+  int       lfd   = -1;
+  int       conn;
+  FILE     *out;
+  const char *sockpath = NULL;
+  struct sigaction sa;
+  int       i;
+
+  memset(&diet, 0, sizeof(diet));
+  for (i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-socket") && i+1 < argc) sockpath = argv[++i];
+    else {
+      fprintf(stderr, "usage: diet_server [-socket path]\n");
+      exit(1);
+    }
+  }
+
+  /* SIGINT/SIGTERM end the server cleanly, a client that hangs up must not
+     kill it */
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_signal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  /* Create the environment once, without logging to keep each solve cheap.
+     Dual simplex warm starts from the previous basis after the data
+     changes. */
+
+  error = GRBloadenv(&env, NULL);
+  if (error) goto QUIT;
+
+  error = GRBsetintparam(env, GRB_INT_PAR_OUTPUTFLAG, 0);
+  if (error) goto QUIT;
+
+  error = GRBsetintparam(env, GRB_INT_PAR_METHOD, GRB_METHOD_DUAL);
+  if (error) goto QUIT;
+
+  error = GRBsetintparam(env, GRB_INT_PAR_THREADS, 1);
+  if (error) goto QUIT;
+
+  error = diet_init(env, &diet);
+  if (error) goto QUIT;
+
+  if (sockpath == NULL) {
+    error = serve(&diet, 0, stdout);
+    goto QUIT;
+  }
+
+  lfd = listen_unix(sockpath);
+  if (lfd < 0) {
+    perror(sockpath);
+    goto QUIT;
+  }
+  fprintf(stderr, "Listening on %s\n", sockpath);
+  while (!stop) {
+    conn = accept(lfd, NULL, NULL);
+    if (conn < 0) {
+      if (errno == EINTR) continue;
+      perror("accept");
+      break;
+    }
+    out = fdopen(dup(conn), "w");
+    if (out == NULL) {
+      close(conn);
+      continue;
+    }
+    error = serve(&diet, conn, out);
+    fclose(out);
+    close(conn);
+    if (error) goto QUIT;
+  }
+
+QUIT:
+
+  /* Error reporting */
+
+  if (error) {
+    printf("ERROR: %s\n", GRBgeterrormsg(env));
+    exit(1);
+  }
+
+  if (lfd >= 0) {
+    close(lfd);
+    unlink(sockpath);
+  }
+
+  /* Free model */
+
+  diet_free(&diet);
+
+  /* Free environment */
+
+  GRBfreeenv(env);
+
+  return 0;
+}
@@ -0,0 +1,170 @@
+/* This example solves the diet model of diet.c for a range of iron and
+   calcium requirements:
+
+     minimize   min z=20x1 + 10x2 + 31x3 + 11x4 + 12x5
+     subject to  2x1 + 0x2 + 3x3 + 1x4 + 2x5 ≥ iron
+                 0x1 + 1x2 + 2x3 + 2x4 + 1x5 ≥ calcium
+
+   The model is built once.  Each point of the sweep only changes the RHS
+   and restarts simplex from the basis of the previous point (sweep.h).
+*/
+
+/* Usage:  diet_sweep [-cold] [-iron lo hi steps] [-calcium lo hi steps]
+
+   A requirement that is not swept stays at its diet.c value (21 and 12).
+   Without options iron is swept from 0 to 60 in 61 steps.  With both
+   options the grid is walked in snake order.  -cold resets the model
+   before every point, for comparison.
+
+   Build with sweep.c.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gurobi_c.h"
+#include "sweep.h"
+
+int
+main(int   argc,
+     char *argv[])
+{
+  GRBenv   *env   = NULL;
+  GRBmodel *model = NULL;
+  int 		i;
+  int       error = 0;
+  char     *varnames[5] = { "x1", "x2", "x3", "x4", "x5" };
+  int       ind[5];
+  double    val[5];
+  double    obj[5];
+  char      vtype[5];
+  char     *label[2];
+  int       sweepind[2];
+  double    lo[2], hi[2];
+  int       steps[2];
+  int       len = 0;
+  int       cold = 0;
+  SweepSpec spec;
+  SweepPoint *pt = NULL;
+
+  memset(&spec, 0, sizeof(spec));
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-cold") == 0) {
+      cold = 1;
+    } else if ((strcmp(argv[i], "-iron") == 0 || strcmp(argv[i], "-calcium") == 0) &&
+               i+3 < argc && len < 2) {
+      label[len]    = argv[i]+1;
+      sweepind[len] = strcmp(argv[i], "-iron") == 0 ? 0 : 1;
+      lo[len]       = atof(argv[i+1]);
+      hi[len]       = atof(argv[i+2]);
+      steps[len]    = atoi(argv[i+3]);
+      if (steps[len] < 1 || (len == 1 && sweepind[0] == sweepind[1])) break;
+      len++;
+      i += 3;
+    } else {
+      break;
+    }
+  }
+  if (i < argc) {
+    fprintf(stderr, "usage: %s [-cold] [-iron lo hi steps] [-calcium lo hi steps]\n",
+            argv[0]);
+    exit(1);
+  }
+  if (len == 0) {
+    label[0] = "iron";
+    sweepind[0] = 0;
+    lo[0] = 0; hi[0] = 60; steps[0] = 61;
+    len = 1;
+  }
+
+  /* Create environment */
+
+  error = GRBloadenv(&env, "diet_sweep.log");
+  if (error) goto QUIT;
+
+  /* Each point logs a few lines at most; keep the report readable */
+
+  error = GRBsetintparam(env, GRB_INT_PAR_OUTPUTFLAG, 0);
+  if (error) goto QUIT;
+
+  /* Simplex warm starts from a basis, barrier does not */
+
+  error = GRBsetintparam(env, GRB_INT_PAR_METHOD, GRB_METHOD_DUAL);
+  if (error) goto QUIT;
+
+  /* Create an empty model */
+
+  error = GRBnewmodel(env, &model, "diet", 0, NULL, NULL, NULL, NULL, NULL);
+  if (error) goto QUIT;
+
+
+  /* Add variables */
+
+  obj[0] = 20; obj[1] = 10; obj[2] = 31; obj[3] = 11; obj[4] = 12;
+  for ( i = 0; i < 5; i++) {
+	  vtype[i] = GRB_CONTINUOUS;
+  }
+  error = GRBaddvars(model, 5, 0, NULL, NULL, NULL, obj, NULL, NULL, vtype, varnames);
+  if (error) goto QUIT;
+
+  /* Change objective sense to minimization */
+
+  error = GRBsetintattr(model, GRB_INT_ATTR_MODELSENSE, GRB_MINIMIZE);
+  if (error) goto QUIT;
+
+  /* First constraint: 2x1 + 0x2 + 3x3 + 1x4 + 2x5 ≥ 21 */
+
+  ind[0] = 0; ind[1] = 1; ind[2] = 2; ind[3] = 3; ind[4] = 4;
+  val[0] = 2; val[1] = 0; val[2] = 3; val[3] = 1; val[4] = 2;
+
+  error = GRBaddconstr(model, 5, ind, val, GRB_GREATER_EQUAL, 21.0, "iron");
+  if (error) goto QUIT;
+
+  /* Second constraint: 0x1 + 1x2 + 2x3 + 2x4 + 1x5 ≥ 12 */
+
+  ind[0] = 0; ind[1] = 1; ind[2] = 2; ind[3] = 3; ind[4] = 4;
+  val[0] = 0; val[1] = 1; val[2] = 2; val[3] = 2; val[4] = 1;
+
+  error = GRBaddconstr(model, 5, ind, val, GRB_GREATER_EQUAL, 12.0, "calcium");
+  if (error) goto QUIT;
+
+  /* Sweep the requirements */
+
+  spec.attr  = GRB_DBL_ATTR_RHS;
+  spec.len   = len;
+  spec.ind   = sweepind;
+  spec.value = sw_grid(len, lo, hi, steps, &spec.npoints);
+  pt = malloc(spec.npoints*sizeof(SweepPoint) + 1);
+  if (!spec.value || !pt) {
+    error = GRB_ERROR_OUT_OF_MEMORY;
+    goto QUIT;
+  }
+
+  error = sw_run(model, &spec, cold, pt);
+  if (error) goto QUIT;
+
+  printf("\nSweep complete (%s start)\n", cold ? "cold" : "warm");
+  sw_report(stdout, &spec, pt, label);
+
+QUIT:
+
+  /* Error reporting */
+
+  if (error) {
+    printf("ERROR: %s\n", GRBgeterrormsg(env));
+    exit(1);
+  }
+
+  free(spec.value);
+  free(pt);
+
+  /* Free model */
+
+  GRBfreemodel(model);
+
+  /* Free environment */
+
+  GRBfreeenv(env);
+
+  return 0;
+}
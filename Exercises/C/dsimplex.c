@@ -0,0 +1,489 @@
+/* Dense bounded-variable primal simplex.  See dsimplex.h */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dsimplex.h"
+
+#define PIVTOL   1e-11
+#define FEASTOL  1e-9
+#define OPTTOL   1e-9
+#define DEGENMAX 50     /* degenerate pivots in a row before Bland's rule */
+
+typedef struct {
+	int     n, m, N, W;  /* structurals, rows, columns n+2m, row width N+1 */
+	double *T;           /* [m*W] B^-1 [A I S | b] */
+	double *c;           /* [N] costs of the phase */
+	double *d;           /* [N] reduced costs */
+	double *lo, *up;     /* [N] bounds */
+	double *x;           /* [N] values */
+	int    *head;        /* [m] basic column of each row */
+	int    *basic;       /* [N] 1 if basic */
+} Tab;
+
+size_t ds_memory(int n, int m)
+{
+	size_t N = (size_t) n + 2*(size_t) m;
+
+	return (size_t) m*(N+1)*sizeof(double) + 5*N*sizeof(double) +
+	       (m + N)*sizeof(int);
+}
+
+static int isfree(double lo, double up)
+{
+	return lo <= -GRB_INFINITY && up >= GRB_INFINITY;
+}
+
+/* pivot
+ * inputs: t  tableau, column q entering in row r
+ * output: T and d updated, row r sweeps every other row once
+ */
+static void pivot(Tab *t, int r, int q)
+{
+	double *pr = t->T + (size_t) r*t->W;
+	double  f = 1.0 / pr[q];
+	int     i, j;
+
+	for (j = 0; j < t->W; j++)
+		pr[j] *= f;
+	pr[q] = 1.0;
+	for (i = 0; i < t->m; i++) {
+		double *pi = t->T + (size_t) i*t->W;
+
+		if (i == r || pi[q] == 0.0)
+			continue;
+		f = pi[q];
+		for (j = 0; j < t->W; j++)
+			pi[j] -= f * pr[j];
+		pi[q] = 0.0;
+	}
+	f = t->d[q];
+	if (f != 0.0) {
+		for (j = 0; j < t->N; j++)
+			t->d[j] -= f * pr[j];
+		t->d[q] = 0.0;
+	}
+	t->basic[t->head[r]] = 0;
+	t->basic[q] = 1;
+	t->head[r] = q;
+}
+
+/* Basic values x_B = B^-1 b - B^-1 N x_N, and reduced costs d = c - c_B B^-1 A,
+   both from scratch */
+
+static void refresh(Tab *t)
+{
+	int i, j;
+
+	for (i = 0; i < t->m; i++) {
+		const double *pi = t->T + (size_t) i*t->W;
+		double        v = pi[t->N];
+
+		for (j = 0; j < t->N; j++)
+			if (!t->basic[j] && t->x[j] != 0.0)
+				v -= pi[j] * t->x[j];
+		t->x[t->head[i]] = v;
+	}
+	memcpy(t->d, t->c, t->N*sizeof(double));
+	for (i = 0; i < t->m; i++) {
+		const double *pi = t->T + (size_t) i*t->W;
+		double        cb = t->c[t->head[i]];
+
+		if (cb == 0.0)
+			continue;
+		for (j = 0; j < t->N; j++)
+			t->d[j] -= cb * pi[j];
+	}
+}
+
+/* iterate
+ * inputs: t        tableau with a primal feasible basis, d current
+ *         maxiter  limit on *iters
+ * output: GRB_OPTIMAL, GRB_UNBOUNDED or GRB_ITERATION_LIMIT
+ */
+static int iterate(Tab *t, int maxiter, int *iters)
+{
+	int degen = 0;
+
+	for (;;) {
+		int    q = -1, r = -1, i, j;
+		double best = 0.0, theta, dir;
+
+		/* Pricing: a nonbasic column whose move off its bound improves */
+
+		for (j = 0; j < t->N; j++) {
+			double dj = t->d[j], v;
+
+			if (t->basic[j] || t->lo[j] == t->up[j])
+				continue;
+			if (isfree(t->lo[j], t->up[j]))
+				v = fabs(dj);
+			else if (t->x[j] == t->lo[j])
+				v = -dj;
+			else
+				v = dj;
+			if (v <= OPTTOL)
+				continue;
+			if (degen >= DEGENMAX) {
+				q = j;
+				break;
+			}
+			if (v > best) {
+				best = v;
+				q = j;
+			}
+		}
+		if (q < 0)
+			return GRB_OPTIMAL;
+		if (*iters >= maxiter)
+			return GRB_ITERATION_LIMIT;
+		(*iters)++;
+
+		/* Ratio test: the bound flip of q or the first basic to hit a bound */
+
+		dir = t->d[q] < 0.0 ? 1.0 : -1.0;
+		theta = isfree(t->lo[q], t->up[q]) || t->lo[q] <= -GRB_INFINITY ||
+		        t->up[q] >= GRB_INFINITY ? GRB_INFINITY : t->up[q] - t->lo[q];
+		for (i = 0; i < t->m; i++) {
+			double a = dir * t->T[(size_t) i*t->W + q], s;
+			int    b = t->head[i];
+
+			if (a > PIVTOL && t->lo[b] > -GRB_INFINITY)
+				s = (t->x[b] - t->lo[b]) / a;
+			else if (a < -PIVTOL && t->up[b] < GRB_INFINITY)
+				s = (t->up[b] - t->x[b]) / -a;
+			else
+				continue;
+			if (s < 0.0)
+				s = 0.0;
+			if (s < theta - 1e-12 ||
+			    (s <= theta + 1e-12 && r >= 0 &&
+			     (degen >= DEGENMAX ? b < t->head[r] :
+			      fabs(a) > fabs(t->T[(size_t) r*t->W + q])))) {
+				theta = s;
+				r = i;
+			}
+		}
+		if (theta >= GRB_INFINITY)
+			return GRB_UNBOUNDED;
+		degen = theta <= 1e-12 ? degen + 1 : 0;
+
+		/* Move q by theta; the basics follow its column */
+
+		t->x[q] += dir * theta;
+		for (i = 0; i < t->m; i++)
+			t->x[t->head[i]] -= dir * theta * t->T[(size_t) i*t->W + q];
+		if (r < 0) {
+			t->x[q] = dir > 0.0 ? t->up[q] : t->lo[q];
+			continue;
+		}
+		j = t->head[r];
+		t->x[j] = dir * t->T[(size_t) r*t->W + q] > 0.0 ? t->lo[j] : t->up[j];
+		pivot(t, r, q);
+	}
+}
+
+/* Clamp to +-GRB_INFINITY what is beyond it */
+
+static double clampinf(double v)
+{
+	return v <= -GRB_INFINITY ? -GRB_INFINITY : v >= GRB_INFINITY ? GRB_INFINITY : v;
+}
+
+/* feasrange
+ * inputs: t     optimal tableau
+ *         col   column whose value moves by delta*sign, the basics moving
+ *               by -delta*sign times its tableau column
+ * output: [*lo, *hi] the deltas that keep every basic within its bounds
+ */
+static void feasrange(const Tab *t, int col, double sign, double *lo, double *hi)
+{
+	int i;
+
+	*lo = -GRB_INFINITY;
+	*hi = GRB_INFINITY;
+	for (i = 0; i < t->m; i++) {
+		double a = sign * t->T[(size_t) i*t->W + col];
+		int    b = t->head[i];
+
+		if (fabs(a) <= PIVTOL)
+			continue;
+		if (a > 0.0) {
+			if (t->lo[b] > -GRB_INFINITY) *hi = fmin(*hi, (t->x[b] - t->lo[b]) / a);
+			if (t->up[b] < GRB_INFINITY)  *lo = fmax(*lo, (t->x[b] - t->up[b]) / a);
+		} else {
+			if (t->lo[b] > -GRB_INFINITY) *lo = fmax(*lo, (t->x[b] - t->lo[b]) / a);
+			if (t->up[b] < GRB_INFINITY)  *hi = fmin(*hi, (t->x[b] - t->up[b]) / a);
+		}
+	}
+}
+
+/* ranging
+ * inputs: t  optimal tableau of p, d of the basics 0
+ * output: sa[6n+2m] filled, see dsimplex.h
+ */
+static void ranging(const Tab *t, const DSProblem *p, double *sa)
+{
+	int n = t->n, m = t->m, j, k, r;
+
+	for (r = 0; r < m; r++) {
+		double lo, hi;
+
+		feasrange(t, n + r, -1.0, &lo, &hi);
+		sa[DS_SARHSLOW(n, m) + r] = clampinf(p->rhs[r] + lo);
+		sa[DS_SARHSUP(n, m) + r]  = clampinf(p->rhs[r] + hi);
+	}
+
+	for (j = 0; j < n; j++) {
+		double lo = -GRB_INFINITY, hi = GRB_INFINITY, c = p->obj[j];
+		int    fixed = t->lo[j] == t->up[j];
+		int    atlo = !t->basic[j] && t->lo[j] > -GRB_INFINITY && t->x[j] == t->lo[j] &&
+		              (!fixed || t->d[j] >= 0.0);
+		int    atup = !t->basic[j] && t->up[j] < GRB_INFINITY && t->x[j] == t->up[j] &&
+		              (!fixed || t->d[j] <= 0.0);
+
+		/* Objective, as delta on the minimized sense*obj: a nonbasic
+		   column keeps the sign of its reduced cost, a basic one moves
+		   the reduced costs of the nonbasics by -delta times its row */
+
+		if (!t->basic[j]) {
+			if (fixed)
+				;
+			else if (atlo)
+				lo = -t->d[j];
+			else if (atup)
+				hi = -t->d[j];
+			else
+				lo = hi = 0.0;
+		} else {
+			for (r = 0; t->head[r] != j; r++)
+				;
+			for (k = 0; k < n + m; k++) {
+				double a = t->T[(size_t) r*t->W + k], q;
+
+				if (t->basic[k] || t->lo[k] == t->up[k] || fabs(a) <= PIVTOL)
+					continue;
+				q = t->d[k] / a;
+				if (isfree(t->lo[k], t->up[k]))
+					lo = hi = 0.0;
+				else if ((t->x[k] == t->lo[k]) == (a > 0.0))
+					hi = fmin(hi, q);
+				else
+					lo = fmax(lo, q);
+			}
+		}
+		if (p->sense == GRB_MINIMIZE) {
+			sa[DS_SAOBJLOW(n, m) + j] = clampinf(c + lo);
+			sa[DS_SAOBJUP(n, m) + j]  = clampinf(c + hi);
+		} else {
+			sa[DS_SAOBJLOW(n, m) + j] = clampinf(c - hi);
+			sa[DS_SAOBJUP(n, m) + j]  = clampinf(c - lo);
+		}
+
+		/* Bounds: the one the column sits at moves it and the basics; a
+		   fixed column sits at the bound its reduced cost pushes it to */
+
+		if (atlo) {
+			feasrange(t, j, 1.0, &lo, &hi);
+			hi = fmin(hi, t->up[j] - t->lo[j]);
+			sa[DS_SALBLOW(n, m) + j] = clampinf(t->lo[j] + lo);
+			sa[DS_SALBUP(n, m) + j]  = clampinf(t->lo[j] + hi);
+		} else {
+			sa[DS_SALBLOW(n, m) + j] = -GRB_INFINITY;
+			sa[DS_SALBUP(n, m) + j]  = t->x[j];
+		}
+		if (atup) {
+			feasrange(t, j, 1.0, &lo, &hi);
+			lo = fmax(lo, t->lo[j] - t->up[j]);
+			sa[DS_SAUBLOW(n, m) + j] = clampinf(t->up[j] + lo);
+			sa[DS_SAUBUP(n, m) + j]  = clampinf(t->up[j] + hi);
+		} else {
+			sa[DS_SAUBLOW(n, m) + j] = t->x[j];
+			sa[DS_SAUBUP(n, m) + j]  = GRB_INFINITY;
+		}
+	}
+}
+
+static void freetab(Tab *t)
+{
+	free(t->T);
+	free(t->c);
+	free(t->d);
+	free(t->lo);
+	free(t->up);
+	free(t->x);
+	free(t->head);
+	free(t->basic);
+}
+
+int ds_solve(const DSProblem *p, int maxiter, DSResult *r)
+{
+	Tab    t;
+	int    n = p->n, m = p->m, i, j, status;
+	double infeas;
+
+	r->status = GRB_NUMERIC;
+	r->iters = 0;
+	r->objval = 0.0;
+	if (maxiter <= 0)
+		maxiter = 50*(n+m) + 100;
+
+	t.n = n;
+	t.m = m;
+	t.N = n + 2*m;
+	t.W = t.N + 1;
+	t.T     = calloc((size_t) m*t.W + 1, sizeof(double));
+	t.c     = calloc(t.N + 1, sizeof(double));
+	t.d     = malloc(t.N*sizeof(double) + 1);
+	t.lo    = malloc(t.N*sizeof(double) + 1);
+	t.up    = malloc(t.N*sizeof(double) + 1);
+	t.x     = calloc(t.N + 1, sizeof(double));
+	t.head  = malloc(m*sizeof(int) + 1);
+	t.basic = calloc(t.N + 1, sizeof(int));
+	if (!t.T || !t.c || !t.d || !t.lo || !t.up || !t.x || !t.head || !t.basic) {
+		freetab(&t);
+		return GRB_ERROR_OUT_OF_MEMORY;
+	}
+
+	/* Bounds; nonbasic structurals at a finite bound, else at 0 */
+
+	for (j = 0; j < n; j++) {
+		t.lo[j] = p->lb ? p->lb[j] : 0.0;
+		t.up[j] = p->ub ? p->ub[j] : GRB_INFINITY;
+		if (t.lo[j] > t.up[j]) {
+			r->status = GRB_INFEASIBLE;
+			freetab(&t);
+			return 0;
+		}
+		t.x[j] = t.lo[j] > -GRB_INFINITY ? t.lo[j] : t.up[j] < GRB_INFINITY ? t.up[j] : 0.0;
+	}
+	for (i = 0; i < m; i++) {
+		int s = n + i, a = n + m + i;
+
+		t.lo[s] = p->rsense[i] == GRB_GREATER_EQUAL ? -GRB_INFINITY : 0.0;
+		t.up[s] = p->rsense[i] == GRB_LESS_EQUAL ? GRB_INFINITY : 0.0;
+		t.lo[a] = 0.0;
+		t.up[a] = GRB_INFINITY;
+	}
+
+	/* Start basis: the slack of a row if the structurals leave it within
+	   its bounds, else the artificial for the rest, its row signed so that
+	   it starts positive and the slack at the bound it was clipped to */
+
+	for (i = 0; i < m; i++) {
+		double *row = t.T + (size_t) i*t.W;
+		double  res = p->rhs[i], s0, sg;
+		int     s = n + i, a = n + m + i;
+
+		memcpy(row, p->A + (size_t) i*n, n*sizeof(double));
+		for (j = 0; j < n; j++)
+			res -= row[j] * t.x[j];
+		s0 = fmin(fmax(res, t.lo[s]), t.up[s]);
+		sg = res - s0 > FEASTOL ? 1.0 : res - s0 < -FEASTOL ? -1.0 : 0.0;
+		row[s] = 1.0;
+		row[a] = sg != 0.0 ? sg : 1.0;
+		row[t.N] = p->rhs[i];
+		t.c[a] = 1.0;
+		if (sg == 0.0) {
+			t.head[i] = s;
+			t.x[s] = res;
+			t.up[a] = 0.0;
+		} else {
+			for (j = 0; j < t.W; j++)
+				row[j] *= sg;
+			t.head[i] = a;
+			t.x[s] = s0;
+			t.x[a] = fabs(res - s0);
+		}
+		t.basic[t.head[i]] = 1;
+	}
+
+	/* Phase 1 */
+
+	refresh(&t);
+	status = iterate(&t, maxiter, &r->iters);
+	if (status != GRB_OPTIMAL) {
+		r->status = status == GRB_ITERATION_LIMIT ? status : GRB_NUMERIC;
+		freetab(&t);
+		return 0;
+	}
+	refresh(&t);
+	for (infeas = 0.0, i = 0; i < m; i++)
+		infeas += t.x[n + m + i];
+	if (infeas > 1e-7) {
+		r->status = GRB_INFEASIBLE;
+		freetab(&t);
+		return 0;
+	}
+
+	/* Fix the artificials at 0 and pivot the basic ones out where their row
+	   has another nonzero; a row without one is redundant */
+
+	for (i = 0; i < m; i++) {
+		int a = n + m + i;
+
+		t.up[a] = 0.0;
+		t.x[a] = 0.0;
+		t.c[a] = 0.0;
+	}
+	for (i = 0; i < m; i++) {
+		const double *row = t.T + (size_t) i*t.W;
+		int           q = -1;
+
+		if (t.head[i] < n + m)
+			continue;
+		for (j = 0; j < n + m; j++)
+			if (!t.basic[j] && fabs(row[j]) > 1e-9 &&
+			    (q < 0 || fabs(row[j]) > fabs(row[q])))
+				q = j;
+		if (q >= 0)
+			pivot(&t, i, q);
+	}
+
+	/* Phase 2, minimizing sense*obj */
+
+	for (j = 0; j < n; j++)
+		t.c[j] = p->sense * p->obj[j];
+	refresh(&t);
+	status = iterate(&t, maxiter, &r->iters);
+	if (status != GRB_OPTIMAL) {
+		r->status = status;
+		freetab(&t);
+		return 0;
+	}
+	refresh(&t);
+
+	/* A basic value off its bounds after the refresh means trouble */
+
+	for (i = 0; i < m; i++) {
+		int    b = t.head[i];
+		double tol = 1e-6 * (1.0 + fabs(t.x[b]));
+
+		if (t.x[b] < t.lo[b] - tol || t.x[b] > t.up[b] + tol) {
+			freetab(&t);
+			return 0;
+		}
+	}
+
+	/* Gurobi's signs: RC = c - A'Pi and Pi = -d of the slack, both taken
+	   back from the minimization of sense*obj.  The reduced cost of a basic
+	   column is 0 by definition, not the rounding left by refresh, and 0 is
+	   not signed */
+
+	for (i = 0; i < m; i++)
+		t.d[t.head[i]] = 0.0;
+	r->status = GRB_OPTIMAL;
+	for (j = 0; j < n; j++) {
+		r->x[j] = t.x[j];
+		r->rc[j] = t.d[j] != 0.0 ? p->sense * t.d[j] : 0.0;
+		r->objval += p->obj[j] * t.x[j];
+	}
+	for (i = 0; i < m; i++) {
+		r->slack[i] = t.x[n + i];
+		r->pi[i] = t.d[n + i] != 0.0 ? -p->sense * t.d[n + i] : 0.0;
+	}
+	if (r->sa)
+		ranging(&t, p, r->sa);
+	freetab(&t);
+	return 0;
+}
@@ -0,0 +1,79 @@
+/* Dense bounded-variable primal simplex for tiny LPs.
+
+   A model like diet (5 columns, 2 rows) solves in a few pivots, so the
+   cost of handing it to Gurobi is all in starting the environment and the
+   log file.  ds_solve solves such models in process instead, with the same
+   answers Gurobi's attributes give: X, RC, Slack, Pi and ObjVal, signed by
+   Gurobi's conventions.
+
+   Row i gets a slack s_i = rhs_i - a_i x, bounded by its sense (>= 0 for
+   <=, <= 0 for >=, 0 for =), and an artificial column.  The method keeps
+   the whole tableau B^-1 [A I S | b] as one row-major block of
+   m*(n+2m+1) doubles, so every pivot is a sweep over contiguous rows;
+   that is only sensible for small m and n, which is what ds_memory is
+   there to check.  Phase 1 minimizes the sum of the artificials from the
+   slack basis, phase 2 the objective.  Nonbasic columns sit at a bound
+   (free ones at 0), bound flips need no pivot, pricing is Dantzig's rule
+   with Bland's rule after a run of degenerate pivots.  The final tableau
+   also gives the sensitivity ranges of the optimal basis, without another
+   solve.
+*/
+
+#ifndef DSIMPLEX_H
+#define DSIMPLEX_H
+
+#include <stddef.h>
+#include "gurobi_c.h"
+
+typedef struct {
+  int           n, m;
+  int           sense;    /* GRB_MINIMIZE or GRB_MAXIMIZE */
+  const double *obj;      /* [n] */
+  const double *lb;       /* [n], -GRB_INFINITY for none */
+  const double *ub;       /* [n], GRB_INFINITY for none */
+  const double *A;        /* [m*n] row major */
+  const char   *rsense;   /* [m] GRB_LESS_EQUAL, GRB_GREATER_EQUAL, GRB_EQUAL */
+  const double *rhs;      /* [m] */
+} DSProblem;
+
+typedef struct {
+  int     status;         /* GRB_OPTIMAL, GRB_INFEASIBLE, GRB_UNBOUNDED,
+                             GRB_ITERATION_LIMIT or GRB_NUMERIC */
+  int     iters;          /* pivots and bound flips of both phases */
+  double  objval;
+  double *x, *rc;         /* [n], allocated by the caller */
+  double *slack, *pi;     /* [m], allocated by the caller */
+  double *sa;             /* [6n+2m] or NULL: the ranges of the optimal
+                             basis, see below */
+} DSResult;
+
+/* Sensitivity ranges in DSResult.sa, as Gurobi's attributes of the same
+   names: for column j the objective coefficient (SAObjLow, SAObjUp), the
+   lower bound (SALBLow, SALBUp) and the upper bound (SAUBLow, SAUBUp) over
+   which the basis stays optimal, for row i the right hand side (SARHSLow,
+   SARHSUp).  The bound of a column that is not nonbasic at it ranges from
+   -GRB_INFINITY up to X (lower) or from X up to GRB_INFINITY (upper). */
+
+#define DS_SAOBJLOW(n, m)  0
+#define DS_SAOBJUP(n, m)   (n)
+#define DS_SALBLOW(n, m)   (2*(n))
+#define DS_SALBUP(n, m)    (3*(n))
+#define DS_SAUBLOW(n, m)   (4*(n))
+#define DS_SAUBUP(n, m)    (5*(n))
+#define DS_SARHSLOW(n, m)  (6*(n))
+#define DS_SARHSUP(n, m)   (6*(n) + (m))
+
+/* ds_memory
+ * output: bytes ds_solve allocates for an n by m problem
+ */
+size_t ds_memory(int n, int m);
+
+/* ds_solve
+ * inputs: p        problem
+ *         maxiter  limit on iterations, <= 0 for 50*(n+m)+100
+ * output: error code (GRB_ERROR_OUT_OF_MEMORY); r filled, its arrays
+ *         only if r->status is GRB_OPTIMAL
+ */
+int ds_solve(const DSProblem *p, int maxiter, DSResult *r);
+
+#endif
@@ -0,0 +1,361 @@
+/* Primal and dual report of an LP from a single solve.  See dualcheck.h */
+
+#include <math.h>
+#include <stdlib.h>
+#include "dualcheck.h"
+
+/* Free model data read by getlp */
+
+typedef struct {
+	int     n, m, nnz, sense;
+	double *obj, *lb, *ub, *rhs;
+	char   *rsense;
+	int    *cbeg, *cind;
+	double *cval;
+} LPData;
+
+static void freelp(LPData *lp)
+{
+	free(lp->obj);
+	free(lp->lb);
+	free(lp->ub);
+	free(lp->rhs);
+	free(lp->rsense);
+	free(lp->cbeg);
+	free(lp->cind);
+	free(lp->cval);
+}
+
+/* getlp
+ * inputs: model  continuous, linear model
+ * output: error code; lp holds its objective, bounds, rows in CSR form and
+ *         sense (cbeg[m] = nnz), freed by freelp also on error
+ */
+static int getlp(GRBmodel *model, LPData *lp)
+{
+	int error, ismip = 0, isqp = 0, isqcp = 0;
+
+	lp->obj = lp->lb = lp->ub = lp->rhs = lp->cval = NULL;
+	lp->rsense = NULL;
+	lp->cbeg = lp->cind = NULL;
+
+	error = GRBgetintattr(model, GRB_INT_ATTR_IS_MIP, &ismip);
+	if (!error) error = GRBgetintattr(model, GRB_INT_ATTR_IS_QP, &isqp);
+	if (!error) error = GRBgetintattr(model, GRB_INT_ATTR_IS_QCP, &isqcp);
+	if (error) return error;
+	if (ismip || isqp || isqcp) return GRB_ERROR_INVALID_ARGUMENT;
+
+	error = GRBgetintattr(model, GRB_INT_ATTR_NUMVARS, &lp->n);
+	if (!error) error = GRBgetintattr(model, GRB_INT_ATTR_NUMCONSTRS, &lp->m);
+	if (!error) error = GRBgetintattr(model, GRB_INT_ATTR_NUMNZS, &lp->nnz);
+	if (!error) error = GRBgetintattr(model, GRB_INT_ATTR_MODELSENSE, &lp->sense);
+	if (error) return error;
+
+	lp->obj    = malloc(lp->n*sizeof(double) + 1);
+	lp->lb     = malloc(lp->n*sizeof(double) + 1);
+	lp->ub     = malloc(lp->n*sizeof(double) + 1);
+	lp->rhs    = malloc(lp->m*sizeof(double) + 1);
+	lp->rsense = malloc(lp->m + 1);
+	lp->cbeg   = malloc((lp->m+1)*sizeof(int));
+	lp->cind   = malloc(lp->nnz*sizeof(int) + 1);
+	lp->cval   = malloc(lp->nnz*sizeof(double) + 1);
+	if (!lp->obj || !lp->lb || !lp->ub || !lp->rhs || !lp->rsense ||
+	    !lp->cbeg || !lp->cind || !lp->cval) {
+		freelp(lp);
+		return GRB_ERROR_OUT_OF_MEMORY;
+	}
+
+	error = GRBgetdblattrarray(model, GRB_DBL_ATTR_OBJ, 0, lp->n, lp->obj);
+	if (!error) error = GRBgetdblattrarray(model, GRB_DBL_ATTR_LB, 0, lp->n, lp->lb);
+	if (!error) error = GRBgetdblattrarray(model, GRB_DBL_ATTR_UB, 0, lp->n, lp->ub);
+	if (!error) error = GRBgetdblattrarray(model, GRB_DBL_ATTR_RHS, 0, lp->m, lp->rhs);
+	if (!error) error = GRBgetcharattrarray(model, GRB_CHAR_ATTR_SENSE, 0, lp->m, lp->rsense);
+	if (!error) error = GRBgetconstrs(model, &lp->nnz, lp->cbeg, lp->cind, lp->cval, 0, lp->m);
+	if (error) {
+		freelp(lp);
+		return error;
+	}
+	lp->cbeg[lp->m] = lp->nnz;
+	return 0;
+}
+
+/* Sign a row dual must have in a minimization: 1 for >= 0, -1 for <= 0,
+   0 for free; the opposite in a maximization */
+
+static int rowsign(char sense)
+{
+	return sense == GRB_GREATER_EQUAL ? 1 : sense == GRB_LESS_EQUAL ? -1 : 0;
+}
+
+int dc_dual_model(GRBenv *env, GRBmodel *primal, GRBmodel **dual)
+{
+	LPData  lp;
+	GRBmodel *model = NULL;
+	int     error, i, j, k, nz = 0;
+	double  *obj = NULL, *lb = NULL, *ub = NULL;
+	int     *beg = NULL, *ind = NULL;
+	double  *val = NULL;
+	char    *eq = NULL;
+
+	*dual = NULL;
+	error = getlp(primal, &lp);
+	if (error) return error;
+
+	/* One row A_j'y + zl_j - zu_j = c_j per primal variable */
+
+	eq = malloc(lp.n + 1);
+	if (!eq) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+	for (j = 0; j < lp.n; j++)
+		eq[j] = GRB_EQUAL;
+	error = GRBnewmodel(env, &model, "dual", 0, NULL, NULL, NULL, NULL, NULL);
+	if (error) goto QUIT;
+	error = GRBsetintattr(model, GRB_INT_ATTR_MODELSENSE, -lp.sense);
+	if (error) goto QUIT;
+	error = GRBaddconstrs(model, lp.n, 0, NULL, NULL, NULL, eq, lp.obj, NULL);
+	if (error) goto QUIT;
+	error = GRBupdatemodel(model);
+	if (error) goto QUIT;
+
+	/* The column of y_i in the dual is row i of the primal, so the CSR
+	   rows of the primal go in as CSC columns unchanged */
+
+	obj = malloc(lp.m*sizeof(double) + 1);
+	lb  = malloc(lp.m*sizeof(double) + 1);
+	ub  = malloc(lp.m*sizeof(double) + 1);
+	if (!obj || !lb || !ub) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+	for (i = 0; i < lp.m; i++) {
+		int s = rowsign(lp.rsense[i]) * lp.sense;
+
+		obj[i] = lp.rhs[i];
+		lb[i]  = s > 0 ? 0.0 : -GRB_INFINITY;
+		ub[i]  = s < 0 ? 0.0 : GRB_INFINITY;
+	}
+	error = GRBaddvars(model, lp.m, lp.nnz, lp.cbeg, lp.cind, lp.cval, obj, lb, ub, NULL, NULL);
+	if (error) goto QUIT;
+
+	/* zl_j and zu_j, one nonzero each, for the finite bounds only */
+
+	free(obj);
+	free(lb);
+	free(ub);
+	obj = malloc(2*lp.n*sizeof(double) + 1);
+	lb  = malloc(2*lp.n*sizeof(double) + 1);
+	ub  = malloc(2*lp.n*sizeof(double) + 1);
+	beg = malloc(2*lp.n*sizeof(int) + 1);
+	ind = malloc(2*lp.n*sizeof(int) + 1);
+	val = malloc(2*lp.n*sizeof(double) + 1);
+	if (!obj || !lb || !ub || !beg || !ind || !val) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+	for (j = 0; j < lp.n; j++) {
+		for (k = 0; k < 2; k++) {
+			double bnd = k == 0 ? lp.lb[j] : lp.ub[j];
+
+			if (bnd <= -GRB_INFINITY || bnd >= GRB_INFINITY)
+				continue;
+			beg[nz] = nz;
+			ind[nz] = j;
+			val[nz] = k == 0 ? 1.0 : -1.0;
+			obj[nz] = k == 0 ? bnd : -bnd;
+			lb[nz]  = lp.sense == GRB_MINIMIZE ? 0.0 : -GRB_INFINITY;
+			ub[nz]  = lp.sense == GRB_MINIMIZE ? GRB_INFINITY : 0.0;
+			nz++;
+		}
+	}
+	error = GRBaddvars(model, nz, nz, beg, ind, val, obj, lb, ub, NULL, NULL);
+	if (error) goto QUIT;
+	error = GRBupdatemodel(model);
+	if (error) goto QUIT;
+
+	*dual = model;
+	model = NULL;
+
+QUIT:
+	GRBfreemodel(model);
+	free(eq);
+	free(obj);
+	free(lb);
+	free(ub);
+	free(beg);
+	free(ind);
+	free(val);
+	freelp(&lp);
+	return error;
+}
+
+int dc_verify(GRBmodel *model, DualCheck *check)
+{
+	GRBmodel *dual = NULL;
+	int      error;
+
+	check->explicitstatus = 0;
+	check->explicitobj = NAN;
+	error = dc_dual_model(GRBgetenv(model), model, &dual);
+	if (error) goto QUIT;
+	error = GRBoptimize(dual);
+	if (error) goto QUIT;
+	error = GRBgetintattr(dual, GRB_INT_ATTR_STATUS, &check->explicitstatus);
+	if (error) goto QUIT;
+	if (check->explicitstatus == GRB_OPTIMAL)
+		error = GRBgetdblattr(dual, GRB_DBL_ATTR_OBJVAL, &check->explicitobj);
+
+QUIT:
+	GRBfreemodel(dual);
+	return error;
+}
+
+void dc_measure(const DCProblem *p, double objval, const double *x, const double *rc,
+                const double *slack, const double *pi, DualCheck *check)
+{
+	double *aty = calloc(p->n + 1, sizeof(double));
+	int     i, j, k;
+
+	check->status = GRB_OPTIMAL;
+	check->primalobj = objval;
+	check->dualobj = 0.0;
+	check->dualresid = check->signviol = check->compslack = 0.0;
+	check->explicitstatus = 0;
+	check->explicitobj = NAN;
+
+	/* Rows: b'y, the sign of y and y_i slack_i */
+
+	for (i = 0; i < p->m; i++) {
+		int s = rowsign(p->rsense[i]) * p->sense;
+
+		check->dualobj += p->rhs[i] * pi[i];
+		if (s != 0 && s*pi[i] < 0.0)
+			check->signviol = fmax(check->signviol, fabs(pi[i]));
+		check->compslack = fmax(check->compslack, fabs(pi[i]*slack[i]));
+		if (aty)
+			for (k = p->cbeg[i]; k < p->cbeg[i+1]; k++)
+				aty[p->cind[k]] += p->cval[k] * pi[i];
+	}
+
+	/* Columns: a reduced cost of the sign of the lower (upper) bound side
+	   is zl_j (-zu_j) and needs that bound finite */
+
+	for (j = 0; j < p->n; j++) {
+		double bnd;
+
+		check->dualresid = aty ? fmax(check->dualresid, fabs(p->obj[j] - aty[j] - rc[j])) : NAN;
+		if (rc[j] == 0.0)
+			continue;
+		bnd = rc[j]*p->sense > 0.0 ? p->lb[j] : p->ub[j];
+		if (bnd <= -GRB_INFINITY || bnd >= GRB_INFINITY) {
+			check->signviol = fmax(check->signviol, fabs(rc[j]));
+			continue;
+		}
+		check->dualobj += rc[j] * bnd;
+		check->compslack = fmax(check->compslack, fabs(rc[j]*(x[j] - bnd)));
+	}
+	check->gap = fabs(check->primalobj - check->dualobj) / fmax(1.0, fabs(check->primalobj));
+	free(aty);
+}
+
+int dc_check(GRBmodel *model, int verify, DualCheck *check)
+{
+	LPData    lp;
+	DCProblem p;
+	int       error;
+	double    objval;
+	double    *x = NULL, *rc = NULL, *slack = NULL, *pi = NULL;
+
+	check->primalobj = check->dualobj = check->gap = NAN;
+	check->dualresid = check->signviol = check->compslack = NAN;
+	check->explicitstatus = 0;
+	check->explicitobj = NAN;
+
+	error = GRBgetintattr(model, GRB_INT_ATTR_STATUS, &check->status);
+	if (error) return error;
+	error = getlp(model, &lp);
+	if (error) return error;
+	if (check->status != GRB_OPTIMAL) goto VERIFY;
+
+	x     = malloc(lp.n*sizeof(double) + 1);
+	rc    = malloc(lp.n*sizeof(double) + 1);
+	slack = malloc(lp.m*sizeof(double) + 1);
+	pi    = malloc(lp.m*sizeof(double) + 1);
+	if (!x || !rc || !slack || !pi) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+	error = GRBgetdblattr(model, GRB_DBL_ATTR_OBJVAL, &objval);
+	if (!error) error = GRBgetdblattrarray(model, GRB_DBL_ATTR_X, 0, lp.n, x);
+	if (!error) error = GRBgetdblattrarray(model, GRB_DBL_ATTR_RC, 0, lp.n, rc);
+	if (!error) error = GRBgetdblattrarray(model, GRB_DBL_ATTR_SLACK, 0, lp.m, slack);
+	if (!error) error = GRBgetdblattrarray(model, GRB_DBL_ATTR_PI, 0, lp.m, pi);
+	if (error) goto QUIT;
+
+	p.n = lp.n;
+	p.m = lp.m;
+	p.sense = lp.sense;
+	p.obj = lp.obj;
+	p.lb = lp.lb;
+	p.ub = lp.ub;
+	p.rsense = lp.rsense;
+	p.rhs = lp.rhs;
+	p.cbeg = lp.cbeg;
+	p.cind = lp.cind;
+	p.cval = lp.cval;
+	dc_measure(&p, objval, x, rc, slack, pi, check);
+
+VERIFY:
+	if (verify)
+		error = dc_verify(model, check);
+
+QUIT:
+	free(x);
+	free(rc);
+	free(slack);
+	free(pi);
+	freelp(&lp);
+	return error;
+}
+
+int dc_ok(const DualCheck *check, double tol)
+{
+	if (check->status != GRB_OPTIMAL)
+		return 0;
+	if (!(check->gap <= tol && check->dualresid <= tol &&
+	      check->signviol <= tol && check->compslack <= tol))
+		return 0;
+	if (check->explicitstatus != 0 &&
+	    !(fabs(check->explicitobj - check->primalobj) <= tol*fmax(1.0, fabs(check->primalobj))))
+		return 0;
+	return 1;
+}
+
+static void print_measure(FILE *out, const char *label, double v)
+{
+	if (v < DC_NOISE)
+		fprintf(out, "  %-19s< %.0e\n", label, DC_NOISE);
+	else
+		fprintf(out, "  %-19s%.3e\n", label, v);
+}
+
+void dc_print(FILE *out, const DualCheck *check)
+{
+	if (check->status != GRB_OPTIMAL) {
+		fprintf(out, "\nDuality check: primal status %d, no duals\n", check->status);
+		return;
+	}
+	fprintf(out, "\nDuality check (from Pi and RC):\n");
+	fprintf(out, "  primal objective   %.10e\n", check->primalobj);
+	fprintf(out, "  dual objective     %.10e\n", check->dualobj);
+	print_measure(out, "relative gap", check->gap);
+	print_measure(out, "dual residual", check->dualresid);
+	print_measure(out, "sign violation", check->signviol);
+	print_measure(out, "compl. slackness", check->compslack);
+	if (check->explicitstatus == GRB_OPTIMAL)
+		fprintf(out, "  explicit dual      %.10e\n", check->explicitobj);
+	else if (check->explicitstatus != 0)
+		fprintf(out, "  explicit dual      status %d\n", check->explicitstatus);
+	fprintf(out, "  strong duality     %s\n", dc_ok(check, 1e-6) ? "holds" : "FAILS");
+}
@@ -0,0 +1,118 @@
+/* Primal and dual report of an LP from a single solve.
+
+   Gurobi already returns the dual solution of an LP with the primal one:
+   Pi holds the row duals y and RC the reduced costs d = c - A'y.  So there
+   is no need to build and solve the dual model (diet_dual) to report both
+   sides.  dc_check reads X, Slack, Pi and RC of the solved primal model and
+   checks them against each other:
+
+     dualobj    b'y + sum_j d_j l_j (d_j at its lower bound side)
+                              + sum_j d_j u_j (d_j at its upper bound side)
+     gap        |primalobj - dualobj| / max(1, |primalobj|)
+     dualresid  max_j |c_j - (A'y)_j - d_j|
+     signviol   largest dual of the wrong sign: y_i of a >= row below zero
+                in a minimization, d_j at a side whose bound is infinite, ...
+     compslack  largest |y_i slack_i| and |d_j (x_j - bound_j)|
+
+   With verify set, dc_check also builds the transposed dual model with
+   dc_dual_model, solves it and compares its objective with the primal
+   one.  That doubles the work and is only meant for testing; the dual
+   model has one row per primal variable,
+
+     A'y + zl - zu = c
+
+   a variable y_i per primal row whose sign follows the row sense, and a
+   variable zl_j / zu_j only for a finite lower / upper bound of x_j.  Its
+   objective b'y + l'zl - u'zu has the opposite sense of the primal one,
+   so that y and zl - zu take the values of Pi and RC.
+
+   Only continuous, linear models have such a dual; the others are refused
+   with GRB_ERROR_INVALID_ARGUMENT.
+*/
+
+#ifndef DUALCHECK_H
+#define DUALCHECK_H
+
+#include <stdio.h>
+#include "gurobi_c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  int      status;        /* of the primal, the rest is NaN unless optimal */
+  double   primalobj;
+  double   dualobj;       /* from Pi and RC */
+  double   gap;
+  double   dualresid;
+  double   signviol;
+  double   compslack;
+  int      explicitstatus;  /* of the dual model, 0 unless verified */
+  double   explicitobj;     /* its objective, NaN unless optimal */
+} DualCheck;
+
+/* An LP in arrays, its rows in CSR form: row i has the nonzeros
+   cbeg[i] .. cbeg[i+1]-1 of cind and cval */
+
+typedef struct {
+  int           n, m;
+  int           sense;    /* GRB_MINIMIZE or GRB_MAXIMIZE */
+  const double *obj;      /* [n] */
+  const double *lb, *ub;  /* [n] */
+  const char   *rsense;   /* [m] */
+  const double *rhs;      /* [m] */
+  const int    *cbeg;     /* [m+1] */
+  const int    *cind;
+  const double *cval;
+} DCProblem;
+
+/* dc_dual_model
+ * inputs: env     environment for the new model
+ *         primal  continuous, linear model (updated, need not be solved)
+ * output: error code; *dual the transposed dual model, free with
+ *         GRBfreemodel
+ */
+int dc_dual_model(GRBenv *env, GRBmodel *primal, GRBmodel **dual);
+
+/* dc_check
+ * inputs: model   primal model, solved
+ *         verify  also build and solve the dual model
+ * output: error code; check filled
+ */
+int dc_check(GRBmodel *model, int verify, DualCheck *check);
+
+/* dc_measure
+ * inputs: p       the LP
+ *         objval, x, rc, slack, pi  an optimal solution of it, however
+ *                 it was found
+ * output: check filled as dc_check would without verify
+ */
+void dc_measure(const DCProblem *p, double objval, const double *x, const double *rc,
+                const double *slack, const double *pi, DualCheck *check);
+
+/* dc_verify
+ * inputs: model  primal model
+ * output: error code; explicitstatus and explicitobj of check filled
+ */
+int dc_verify(GRBmodel *model, DualCheck *check);
+
+/* dc_ok
+ * output: 1 if gap, dualresid, signviol and compslack are all within tol
+ *         (and the verified dual objective, if any, agrees), else 0
+ */
+int dc_ok(const DualCheck *check, double tol);
+
+/* dc_print
+ * Report check; the four measures print as "< 1e-09" below DC_NOISE, so
+ * that rounding noise does not show in the output.
+ */
+#define DC_NOISE 1e-9
+
+void dc_print(FILE *out, const DualCheck *check);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
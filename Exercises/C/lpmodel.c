@@ -0,0 +1,574 @@
+/* An LP solved in process when tiny, by Gurobi otherwise.  See lpmodel.h */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dsimplex.h"
+#include "lpmodel.h"
+
+enum { SOLVED_NONE, SOLVED_DENSE, SOLVED_GUROBI };
+
+struct LPModel {
+	LMBackend backend;
+	char     *name;
+	char     *logfile;
+	int       sense;
+
+	/* Columns */
+	int       n, capn;
+	double   *obj, *lb, *ub;
+	char    **vnames;
+
+	/* Rows in CSR form, cbeg[m] = nnz */
+	int       m, capm, nnz, capnz;
+	int      *cbeg, *cind;
+	double   *cval;
+	char     *rsense;
+	double   *rhs;
+	char    **cnames;
+
+	/* Solution of the dense simplex */
+	int       solved;
+	int       status;
+	double    objval;
+	double   *x, *rc, *slack, *pi;
+	double   *sa;         /* ranges, DS_SA* layout of dsimplex.h */
+
+	GRBenv   *env;
+	GRBmodel *model;
+
+	int       grberror;   /* the last error came from Gurobi */
+	char      msg[256];
+};
+
+static int fail(LPModel *lp, int error, const char *msg)
+{
+	lp->grberror = 0;
+	snprintf(lp->msg, sizeof(lp->msg), "%s", msg);
+	return error;
+}
+
+static int grbfail(LPModel *lp, int error)
+{
+	lp->grberror = 1;
+	return error;
+}
+
+/* Any change drops the solution and the Gurobi copy of the model, which is
+   rebuilt from the arrays by the next Gurobi solve */
+
+static void changed(LPModel *lp)
+{
+	lp->solved = SOLVED_NONE;
+	GRBfreemodel(lp->model);
+	lp->model = NULL;
+}
+
+/* Make room for need elements in an array of cap elements */
+
+static int grow(void **p, size_t size, int need, int cap)
+{
+	void *q;
+
+	if (need <= cap)
+		return 0;
+	q = realloc(*p, (size_t) (2*need + 8)*size);
+	if (q == NULL)
+		return -1;
+	*p = q;
+	return 0;
+}
+
+int lm_new(LMBackend backend, const char *name, const char *logfile, LPModel **lpP)
+{
+	LPModel *lp = calloc(1, sizeof(LPModel));
+
+	*lpP = NULL;
+	if (lp == NULL)
+		return GRB_ERROR_OUT_OF_MEMORY;
+	lp->backend = backend;
+	lp->sense = GRB_MINIMIZE;
+	lp->name = strdup(name ? name : "");
+	lp->logfile = logfile ? strdup(logfile) : NULL;
+	lp->cbeg = malloc(sizeof(int));
+	if (!lp->name || (logfile && !lp->logfile) || !lp->cbeg) {
+		lm_free(lp);
+		return GRB_ERROR_OUT_OF_MEMORY;
+	}
+	lp->cbeg[0] = 0;
+	*lpP = lp;
+	return 0;
+}
+
+static char *defname(char prefix, int i)
+{
+	char buf[16];
+
+	snprintf(buf, sizeof(buf), "%c%d", prefix, i);
+	return strdup(buf);
+}
+
+int lm_addvars(LPModel *lp, int numvars, const double *obj, const double *lb,
+               const double *ub, char **names)
+{
+	int j, need = lp->n + numvars;
+
+	if (numvars < 0)
+		return fail(lp, GRB_ERROR_INVALID_ARGUMENT, "Negative number of variables");
+	if (grow((void **) &lp->obj, sizeof(double), need, lp->capn) ||
+	    grow((void **) &lp->lb, sizeof(double), need, lp->capn) ||
+	    grow((void **) &lp->ub, sizeof(double), need, lp->capn) ||
+	    grow((void **) &lp->vnames, sizeof(char *), need, lp->capn))
+		return fail(lp, GRB_ERROR_OUT_OF_MEMORY, "Out of memory");
+	if (need > lp->capn)
+		lp->capn = 2*need + 8;
+
+	for (j = 0; j < numvars; j++) {
+		int k = lp->n + j;
+
+		lp->obj[k] = obj ? obj[j] : 0.0;
+		lp->lb[k] = lb ? lb[j] : 0.0;
+		lp->ub[k] = ub ? ub[j] : GRB_INFINITY;
+		lp->vnames[k] = names && names[j] ? strdup(names[j]) : defname('C', k);
+		if (lp->vnames[k] == NULL) {
+			lp->n = k;
+			return fail(lp, GRB_ERROR_OUT_OF_MEMORY, "Out of memory");
+		}
+	}
+	lp->n = need;
+	changed(lp);
+	return 0;
+}
+
+int lm_addconstr(LPModel *lp, int numnz, const int *ind, const double *val,
+                 char sense, double rhs, const char *name)
+{
+	int k, need = lp->m + 1, needz = lp->nnz + numnz;
+
+	for (k = 0; k < numnz; k++)
+		if (ind[k] < 0 || ind[k] >= lp->n)
+			return fail(lp, GRB_ERROR_INDEX_OUT_OF_RANGE, "Variable index out of range");
+	if (sense != GRB_LESS_EQUAL && sense != GRB_GREATER_EQUAL && sense != GRB_EQUAL)
+		return fail(lp, GRB_ERROR_INVALID_ARGUMENT, "Invalid constraint sense");
+
+	/* cbeg has one element more than the other row arrays */
+
+	if (grow((void **) &lp->rsense, sizeof(char), need, lp->capm) ||
+	    grow((void **) &lp->rhs, sizeof(double), need, lp->capm) ||
+	    grow((void **) &lp->cnames, sizeof(char *), need, lp->capm) ||
+	    grow((void **) &lp->cbeg, sizeof(int), need + 1, lp->capm + 1) ||
+	    grow((void **) &lp->cind, sizeof(int), needz, lp->capnz) ||
+	    grow((void **) &lp->cval, sizeof(double), needz, lp->capnz))
+		return fail(lp, GRB_ERROR_OUT_OF_MEMORY, "Out of memory");
+	if (need > lp->capm)
+		lp->capm = 2*need + 8;
+	if (needz > lp->capnz)
+		lp->capnz = 2*needz + 8;
+
+	lp->cnames[lp->m] = name ? strdup(name) : defname('R', lp->m);
+	if (lp->cnames[lp->m] == NULL)
+		return fail(lp, GRB_ERROR_OUT_OF_MEMORY, "Out of memory");
+	memcpy(lp->cind + lp->nnz, ind, numnz*sizeof(int));
+	memcpy(lp->cval + lp->nnz, val, numnz*sizeof(double));
+	lp->rsense[lp->m] = sense;
+	lp->rhs[lp->m] = rhs;
+	lp->nnz = needz;
+	lp->m++;
+	lp->cbeg[lp->m] = lp->nnz;
+	changed(lp);
+	return 0;
+}
+
+int lm_setsense(LPModel *lp, int sense)
+{
+	if (sense != GRB_MINIMIZE && sense != GRB_MAXIMIZE)
+		return fail(lp, GRB_ERROR_INVALID_ARGUMENT, "Invalid objective sense");
+	lp->sense = sense;
+	changed(lp);
+	return 0;
+}
+
+/* loadgurobi
+ * Start the environment and copy the model into Gurobi, each unless done
+ */
+static int loadgurobi(LPModel *lp)
+{
+	int error;
+
+	if (lp->env == NULL) {
+		error = GRBloadenv(&lp->env, lp->logfile);
+		if (error) return grbfail(lp, error);
+	}
+	if (lp->model != NULL)
+		return 0;
+	error = GRBnewmodel(lp->env, &lp->model, lp->name, lp->n, lp->obj, lp->lb, lp->ub,
+	                    NULL, lp->vnames);
+	if (!error) error = GRBsetintattr(lp->model, GRB_INT_ATTR_MODELSENSE, lp->sense);
+	if (!error) error = GRBaddconstrs(lp->model, lp->m, lp->nnz, lp->cbeg, lp->cind,
+	                                  lp->cval, lp->rsense, lp->rhs, lp->cnames);
+	if (!error) error = GRBupdatemodel(lp->model);
+	if (error) {
+		GRBfreemodel(lp->model);
+		lp->model = NULL;
+		return grbfail(lp, error);
+	}
+	return 0;
+}
+
+/* densesolve
+ * output: error code; solved, status, objval and the solution arrays set
+ */
+static int densesolve(LPModel *lp)
+{
+	DSProblem p;
+	DSResult  r;
+	double   *A;
+	int       i, k, error;
+
+	free(lp->x);
+	free(lp->rc);
+	free(lp->slack);
+	free(lp->pi);
+	free(lp->sa);
+	lp->x     = malloc(lp->n*sizeof(double) + 1);
+	lp->rc    = malloc(lp->n*sizeof(double) + 1);
+	lp->slack = malloc(lp->m*sizeof(double) + 1);
+	lp->pi    = malloc(lp->m*sizeof(double) + 1);
+	lp->sa    = malloc((6*lp->n + 2*lp->m)*sizeof(double) + 1);
+	A = calloc((size_t) lp->m*lp->n + 1, sizeof(double));
+	if (!lp->x || !lp->rc || !lp->slack || !lp->pi || !lp->sa || !A) {
+		free(A);
+		return fail(lp, GRB_ERROR_OUT_OF_MEMORY, "Out of memory");
+	}
+	for (i = 0; i < lp->m; i++)
+		for (k = lp->cbeg[i]; k < lp->cbeg[i+1]; k++)
+			A[(size_t) i*lp->n + lp->cind[k]] += lp->cval[k];
+
+	p.n = lp->n;
+	p.m = lp->m;
+	p.sense = lp->sense;
+	p.obj = lp->obj;
+	p.lb = lp->lb;
+	p.ub = lp->ub;
+	p.A = A;
+	p.rsense = lp->rsense;
+	p.rhs = lp->rhs;
+	r.x = lp->x;
+	r.rc = lp->rc;
+	r.slack = lp->slack;
+	r.pi = lp->pi;
+	r.sa = lp->sa;
+	error = ds_solve(&p, 0, &r);
+	free(A);
+	if (error)
+		return fail(lp, error, "Out of memory");
+
+	lp->solved = SOLVED_DENSE;
+	lp->status = r.status;
+	lp->objval = r.objval;
+	return 0;
+}
+
+int lm_optimize(LPModel *lp)
+{
+	LMBackend backend = lp->backend;
+	int       error;
+
+	if (backend == LM_AUTO && ds_memory(lp->n, lp->m) <= LM_DENSE_MAXBYTES)
+		backend = LM_DENSE;
+	if (backend == LM_DENSE) {
+		error = densesolve(lp);
+		if (error) return error;
+		if (lp->backend == LM_DENSE ||
+		    (lp->status != GRB_ITERATION_LIMIT && lp->status != GRB_NUMERIC))
+			return 0;
+	}
+
+	error = loadgurobi(lp);
+	if (error) return error;
+	error = GRBoptimize(lp->model);
+	if (error) return grbfail(lp, error);
+	lp->solved = SOLVED_GUROBI;
+	return 0;
+}
+
+int lm_getstatus(LPModel *lp, int *status)
+{
+	int error;
+
+	if (lp->solved == SOLVED_GUROBI) {
+		error = GRBgetintattr(lp->model, GRB_INT_ATTR_STATUS, status);
+		return error ? grbfail(lp, error) : 0;
+	}
+	*status = lp->solved == SOLVED_DENSE ? lp->status : GRB_LOADED;
+	return 0;
+}
+
+/* The dense solution is there if the dense simplex found an optimum */
+
+static int densedata(LPModel *lp)
+{
+	if (lp->solved != SOLVED_DENSE || lp->status != GRB_OPTIMAL)
+		return fail(lp, GRB_ERROR_DATA_NOT_AVAILABLE, "No solution available");
+	return 0;
+}
+
+int lm_getobjval(LPModel *lp, double *objval)
+{
+	int error;
+
+	if (lp->solved == SOLVED_GUROBI) {
+		error = GRBgetdblattr(lp->model, GRB_DBL_ATTR_OBJVAL, objval);
+		return error ? grbfail(lp, error) : 0;
+	}
+	error = densedata(lp);
+	if (error) return error;
+	*objval = lp->objval;
+	return 0;
+}
+
+int lm_getdblarray(LPModel *lp, const char *attr, int first, int len, double *values)
+{
+	const double *src;
+	int           error, size;
+
+	if (lp->solved == SOLVED_GUROBI) {
+		error = GRBgetdblattrarray(lp->model, attr, first, len, values);
+		return error ? grbfail(lp, error) : 0;
+	}
+	if (strcmp(attr, GRB_DBL_ATTR_X) == 0) {
+		src = lp->x;
+		size = lp->n;
+	} else if (strcmp(attr, GRB_DBL_ATTR_RC) == 0) {
+		src = lp->rc;
+		size = lp->n;
+	} else if (strcmp(attr, GRB_DBL_ATTR_SLACK) == 0) {
+		src = lp->slack;
+		size = lp->m;
+	} else if (strcmp(attr, GRB_DBL_ATTR_PI) == 0) {
+		src = lp->pi;
+		size = lp->m;
+	} else if (strcmp(attr, GRB_DBL_ATTR_SAOBJLOW) == 0) {
+		src = lp->sa + DS_SAOBJLOW(lp->n, lp->m);
+		size = lp->n;
+	} else if (strcmp(attr, GRB_DBL_ATTR_SAOBJUP) == 0) {
+		src = lp->sa + DS_SAOBJUP(lp->n, lp->m);
+		size = lp->n;
+	} else if (strcmp(attr, GRB_DBL_ATTR_SALBLOW) == 0) {
+		src = lp->sa + DS_SALBLOW(lp->n, lp->m);
+		size = lp->n;
+	} else if (strcmp(attr, GRB_DBL_ATTR_SALBUP) == 0) {
+		src = lp->sa + DS_SALBUP(lp->n, lp->m);
+		size = lp->n;
+	} else if (strcmp(attr, GRB_DBL_ATTR_SAUBLOW) == 0) {
+		src = lp->sa + DS_SAUBLOW(lp->n, lp->m);
+		size = lp->n;
+	} else if (strcmp(attr, GRB_DBL_ATTR_SAUBUP) == 0) {
+		src = lp->sa + DS_SAUBUP(lp->n, lp->m);
+		size = lp->n;
+	} else if (strcmp(attr, GRB_DBL_ATTR_SARHSLOW) == 0) {
+		src = lp->sa + DS_SARHSLOW(lp->n, lp->m);
+		size = lp->m;
+	} else if (strcmp(attr, GRB_DBL_ATTR_SARHSUP) == 0) {
+		src = lp->sa + DS_SARHSUP(lp->n, lp->m);
+		size = lp->m;
+	} else {
+		return fail(lp, GRB_ERROR_INVALID_ARGUMENT, "Unknown attribute");
+	}
+	error = densedata(lp);
+	if (error) return error;
+	if (first < 0 || len < 0 || first + len > size)
+		return fail(lp, GRB_ERROR_INDEX_OUT_OF_RANGE, "Index out of range");
+	memcpy(values, src + first, len*sizeof(double));
+	return 0;
+}
+
+int lm_getstrarray(LPModel *lp, const char *attr, int first, int len, char **values)
+{
+	char **src;
+	int    size, i;
+
+	if (strcmp(attr, GRB_STR_ATTR_VARNAME) == 0) {
+		src = lp->vnames;
+		size = lp->n;
+	} else if (strcmp(attr, GRB_STR_ATTR_CONSTRNAME) == 0) {
+		src = lp->cnames;
+		size = lp->m;
+	} else {
+		return fail(lp, GRB_ERROR_INVALID_ARGUMENT, "Unknown attribute");
+	}
+	if (first < 0 || len < 0 || first + len > size)
+		return fail(lp, GRB_ERROR_INDEX_OUT_OF_RANGE, "Index out of range");
+	for (i = 0; i < len; i++)
+		values[i] = src[first + i];
+	return 0;
+}
+
+int lm_dualcheck(LPModel *lp, int verify, DualCheck *check)
+{
+	DCProblem p;
+	int       error;
+
+	if (lp->solved == SOLVED_GUROBI) {
+		error = dc_check(lp->model, verify, check);
+		return error ? grbfail(lp, error) : 0;
+	}
+	if (lp->solved != SOLVED_DENSE)
+		return fail(lp, GRB_ERROR_DATA_NOT_AVAILABLE, "Model not optimized");
+
+	if (lp->status == GRB_OPTIMAL) {
+		p.n = lp->n;
+		p.m = lp->m;
+		p.sense = lp->sense;
+		p.obj = lp->obj;
+		p.lb = lp->lb;
+		p.ub = lp->ub;
+		p.rsense = lp->rsense;
+		p.rhs = lp->rhs;
+		p.cbeg = lp->cbeg;
+		p.cind = lp->cind;
+		p.cval = lp->cval;
+		dc_measure(&p, lp->objval, lp->x, lp->rc, lp->slack, lp->pi, check);
+	} else {
+		check->status = lp->status;
+		check->primalobj = check->dualobj = check->gap = NAN;
+		check->dualresid = check->signviol = check->compslack = NAN;
+		check->explicitstatus = 0;
+		check->explicitobj = NAN;
+	}
+	if (!verify)
+		return 0;
+
+	/* loadgurobi keeps the dense solution: the model is unchanged */
+
+	error = loadgurobi(lp);
+	if (error) return error;
+	error = dc_verify(lp->model, check);
+	return error ? grbfail(lp, error) : 0;
+}
+
+/* Write a term of a linear expression in LP format */
+
+static void writeterm(FILE *fp, double coef, const char *name, int first)
+{
+	if (coef == 0.0)
+		return;
+	if (!first || coef < 0.0)
+		fprintf(fp, " %c", coef < 0.0 ? '-' : '+');
+	if (fabs(coef) != 1.0)
+		fprintf(fp, " %.15g", fabs(coef));
+	fprintf(fp, " %s", name);
+}
+
+static int writelp(LPModel *lp, const char *filename)
+{
+	FILE *fp = fopen(filename, "w");
+	int   i, j, k;
+
+	if (fp == NULL)
+		return fail(lp, GRB_ERROR_FILE_WRITE, "Unable to open file for writing");
+
+	fprintf(fp, "\\ Model %s\n%s\n ", lp->name, lp->sense == GRB_MINIMIZE ? "Minimize" : "Maximize");
+	for (j = 0, k = 1; j < lp->n; j++) {
+		writeterm(fp, lp->obj[j], lp->vnames[j], k);
+		k = k && lp->obj[j] == 0.0;
+	}
+	fprintf(fp, "\nSubject To\n");
+	for (i = 0; i < lp->m; i++) {
+		int first = 1;
+
+		fprintf(fp, " %s:", lp->cnames[i]);
+		for (k = lp->cbeg[i]; k < lp->cbeg[i+1]; k++) {
+			writeterm(fp, lp->cval[k], lp->vnames[lp->cind[k]], first);
+			first = first && lp->cval[k] == 0.0;
+		}
+		if (first)
+			fprintf(fp, " 0");
+		fprintf(fp, " %s %.15g\n", lp->rsense[i] == GRB_LESS_EQUAL ? "<=" :
+		        lp->rsense[i] == GRB_GREATER_EQUAL ? ">=" : "=", lp->rhs[i]);
+	}
+	fprintf(fp, "Bounds\n");
+	for (j = 0; j < lp->n; j++) {
+		double l = lp->lb[j], u = lp->ub[j];
+		char  *v = lp->vnames[j];
+
+		if (l == 0.0 && u >= GRB_INFINITY)
+			continue;
+		if (l <= -GRB_INFINITY && u >= GRB_INFINITY)
+			fprintf(fp, " %s free\n", v);
+		else if (l == u)
+			fprintf(fp, " %s = %.15g\n", v, l);
+		else if (l <= -GRB_INFINITY)
+			fprintf(fp, " -infinity <= %s <= %.15g\n", v, u);
+		else if (u >= GRB_INFINITY)
+			fprintf(fp, " %s >= %.15g\n", v, l);
+		else
+			fprintf(fp, " %.15g <= %s <= %.15g\n", l, v, u);
+	}
+	fprintf(fp, "End\n");
+	if (fclose(fp) != 0)
+		return fail(lp, GRB_ERROR_FILE_WRITE, "Error writing file");
+	return 0;
+}
+
+int lm_write(LPModel *lp, const char *filename)
+{
+	int error;
+
+	if (lp->model == NULL)
+		return writelp(lp, filename);
+	error = GRBwrite(lp->model, filename);
+	return error ? grbfail(lp, error) : 0;
+}
+
+const char *lm_solvedby(LPModel *lp)
+{
+	return lp->solved == SOLVED_DENSE ? "dense" : lp->solved == SOLVED_GUROBI ? "gurobi" : "none";
+}
+
+GRBmodel *lm_gurobi(LPModel *lp)
+{
+	return lp->model;
+}
+
+const char *lm_errormsg(LPModel *lp)
+{
+	if (lp == NULL)
+		return "Out of memory";
+	if (lp->grberror && lp->env)
+		return GRBgeterrormsg(lp->env);
+	return lp->msg;
+}
+
+void lm_free(LPModel *lp)
+{
+	int i;
+
+	if (lp == NULL)
+		return;
+	GRBfreemodel(lp->model);
+	GRBfreeenv(lp->env);
+	for (i = 0; i < lp->n; i++)
+		free(lp->vnames[i]);
+	for (i = 0; i < lp->m; i++)
+		free(lp->cnames[i]);
+	free(lp->vnames);
+	free(lp->cnames);
+	free(lp->obj);
+	free(lp->lb);
+	free(lp->ub);
+	free(lp->cbeg);
+	free(lp->cind);
+	free(lp->cval);
+	free(lp->rsense);
+	free(lp->rhs);
+	free(lp->x);
+	free(lp->rc);
+	free(lp->slack);
+	free(lp->pi);
+	free(lp->sa);
+	free(lp->name);
+	free(lp->logfile);
+	free(lp);
+}
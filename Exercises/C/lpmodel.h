@@ -0,0 +1,96 @@
+/* An LP that is solved in process when it is tiny and by Gurobi otherwise.
+
+   LPModel follows the C API's build, solve and extract steps (lm_addvars,
+   lm_addconstr, lm_optimize, lm_getdblarray, ...) but only records the
+   model until lm_optimize.  Then the backend decides who solves it:
+
+     LM_DENSE   the dense simplex of dsimplex.h, in process
+     LM_GUROBI  Gurobi; the environment (and its log file) is only started
+                here, on first use
+     LM_AUTO    LM_DENSE while its tableau fits in LM_DENSE_MAXBYTES, else
+                LM_GUROBI; also LM_GUROBI when the dense simplex runs into
+                its iteration limit or numerical trouble
+
+   The diet models take the dense path in microseconds, without a license
+   and without the environment setup that dominates their Gurobi run.  The
+   attributes read back are X, RC, Slack and Pi, ObjVal and Status, with
+   Gurobi's signs whoever solved the model, and the sensitivity ranges
+   SAObjLow/Up, SALBLow/Up, SAUBLow/Up and SARHSLow/Up.
+*/
+
+#ifndef LPMODEL_H
+#define LPMODEL_H
+
+#include "gurobi_c.h"
+#include "dualcheck.h"
+
+typedef enum { LM_AUTO, LM_DENSE, LM_GUROBI } LMBackend;
+
+#define LM_DENSE_MAXBYTES (4 << 20)
+
+typedef struct LPModel LPModel;
+
+/* lm_new
+ * inputs: backend  see above
+ *         name     model name
+ *         logfile  log file of the Gurobi environment, may be NULL
+ * output: error code; *lp the empty minimization model
+ */
+int lm_new(LMBackend backend, const char *name, const char *logfile, LPModel **lp);
+
+/* lm_addvars
+ * inputs: obj, lb, ub  [numvars] or NULL for 0, 0 and GRB_INFINITY
+ *         names        [numvars] or NULL
+ * output: error code
+ */
+int lm_addvars(LPModel *lp, int numvars, const double *obj, const double *lb,
+               const double *ub, char **names);
+
+/* lm_addconstr
+ * inputs: as GRBaddconstr; the indices refer to variables already added
+ * output: error code
+ */
+int lm_addconstr(LPModel *lp, int numnz, const int *ind, const double *val,
+                 char sense, double rhs, const char *name);
+
+int lm_setsense(LPModel *lp, int sense);
+
+/* lm_optimize
+ * output: error code; a status that is not GRB_OPTIMAL is not an error
+ */
+int lm_optimize(LPModel *lp);
+
+/* lm_write
+ * Write the model, through GRBwrite if Gurobi has it, else in LP format.
+ */
+int lm_write(LPModel *lp, const char *filename);
+
+int lm_getstatus(LPModel *lp, int *status);
+int lm_getobjval(LPModel *lp, double *objval);
+
+/* lm_getdblarray, lm_getstrarray
+ * inputs: attr  GRB_DBL_ATTR_X, _RC, _SLACK, _PI, the GRB_DBL_ATTR_SA*
+ *               ranges; GRB_STR_ATTR_VARNAME, _CONSTRNAME
+ * output: error code; values[len] from element first on.  The names stay
+ *         valid until lm_free
+ */
+int lm_getdblarray(LPModel *lp, const char *attr, int first, int len, double *values);
+int lm_getstrarray(LPModel *lp, const char *attr, int first, int len, char **values);
+
+/* lm_dualcheck
+ * dc_check of the solution (dualcheck.h); verify solves the dual model
+ * with Gurobi also when the dense simplex solved the primal.
+ */
+int lm_dualcheck(LPModel *lp, int verify, DualCheck *check);
+
+/* "dense" or "gurobi" once optimized, else "none" */
+const char *lm_solvedby(LPModel *lp);
+
+/* The Gurobi model, NULL unless Gurobi has been used */
+GRBmodel *lm_gurobi(LPModel *lp);
+
+const char *lm_errormsg(LPModel *lp);
+
+void lm_free(LPModel *lp);
+
+#endif
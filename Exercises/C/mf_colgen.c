@@ -0,0 +1,483 @@
+/* Dantzig-Wolfe column generation for the multi commodity network flow.
+   See mf_colgen.h */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "mf_colgen.h"
+#include "walltime.h"
+
+#define RC_TOL 1e-6
+
+/* Paths found for one commodity in one pricing round */
+
+typedef struct {
+  int     n, cap;
+  int    *src, *dst;     /* [cap] supply and demand node of each path */
+  double *cost;          /* [cap] true cost of each path */
+  int    *arcbeg;        /* [cap+1] arcs of path i are arcs[arcbeg[i]..arcbeg[i+1]-1] */
+  int    *arcs;
+  int     narcs, arccap;
+} PathBuf;
+
+/* Per worker scratch space for Dijkstra */
+
+typedef struct {
+  double *dist;          /* [numnodes] */
+  int    *pred;          /* [numnodes] arc into the node on the shortest path, -1 at the root */
+  int    *heap;          /* [numnodes] binary heap of nodes keyed by dist */
+  int    *pos;           /* [numnodes] position in heap, -1 if not in it */
+  int    *path;          /* [numnodes] scratch for reversing a path */
+} Workspace;
+
+typedef struct {
+  const MFData *d;
+  const double *pi;      /* duals of the master rows */
+  const int    *supplyrow, *demandrow;   /* [C*N] master row or -1 */
+  int           caprow;  /* first capacity row */
+  int           phase;   /* 1: artificials only, 2: true costs */
+  Workspace    *ws;      /* [tp_size] */
+  PathBuf      *out;     /* [numcommodities] */
+  int           failed;  /* set by a task that ran out of memory; atomic,
+                            several tasks may set it at once */
+} Pricing;
+
+/* Binary heap on ws->dist */
+
+static void heap_up(Workspace *w, int i)
+{
+	int v = w->heap[i];
+	while (i > 0 && w->dist[w->heap[(i-1)/2]] > w->dist[v]) {
+		w->heap[i] = w->heap[(i-1)/2];
+		w->pos[w->heap[i]] = i;
+		i = (i-1)/2;
+	}
+	w->heap[i] = v;
+	w->pos[v] = i;
+}
+
+static void heap_down(Workspace *w, int i, int n)
+{
+	int v = w->heap[i], c;
+	while ((c = 2*i+1) < n) {
+		if (c+1 < n && w->dist[w->heap[c+1]] < w->dist[w->heap[c]]) c++;
+		if (w->dist[w->heap[c]] >= w->dist[v]) break;
+		w->heap[i] = w->heap[c];
+		w->pos[w->heap[i]] = i;
+		i = c;
+	}
+	w->heap[i] = v;
+	w->pos[v] = i;
+}
+
+/* dijkstra
+ * Shortest paths of commodity k from node s, arc a costing len(a) =
+ * cost (phase 2 only) minus the capacity dual of a, which is <= 0.
+ */
+static void dijkstra(const Pricing *p, Workspace *w, int k, int s)
+{
+	const MFData *d = p->d;
+	int    N = d->numnodes, A = d->numarcs;
+	int    n, e, v, size = 0;
+	double len, nd;
+
+	for (n=0; n<N; n++) {
+		w->dist[n] = GRB_INFINITY;
+		w->pred[n] = -1;
+		w->pos[n]  = -1;
+	}
+	w->dist[s] = 0;
+	w->heap[size++] = s;
+	w->pos[s] = 0;
+
+	while (size > 0) {
+		n = w->heap[0];
+		w->pos[n] = -1;
+		if (--size > 0) {
+			w->heap[0] = w->heap[size];
+			heap_down(w, 0, size);
+		}
+		for (e=d->outbeg[n]; e<d->outbeg[n+1]; e++) {
+			len = (p->phase == 2 ? d->cost[(size_t) k*A+e] : 0.0) - p->pi[p->caprow+e];
+			if (len < 0) len = 0;        /* dual noise */
+			v  = d->head[e];
+			nd = w->dist[n] + len;
+			if (nd < w->dist[v]) {
+				w->dist[v] = nd;
+				w->pred[v] = e;
+				if (w->pos[v] < 0) {
+					w->heap[size] = v;
+					heap_up(w, size++);
+				} else {
+					heap_up(w, w->pos[v]);
+				}
+			}
+		}
+	}
+}
+
+/* pathbuf_add
+ * Append the shortest path s -> t found by the last dijkstra call.
+ * output: 0 on success, 1 if out of memory
+ */
+static int pathbuf_add(PathBuf *b, const MFData *d, Workspace *w, int k, int s, int t)
+{
+	int    len = 0, v, i;
+	double cost = 0;
+
+	for (v=t; v!=s; v=d->tail[w->pred[v]]) {
+		w->path[len++] = w->pred[v];
+		cost += d->cost[(size_t) k*d->numarcs+w->pred[v]];
+	}
+
+	if (b->n+1 >= b->cap) {
+		int cap = 2*b->cap + 16;
+		int    *src = realloc(b->src, cap*sizeof(int));
+		int    *dst = src ? realloc(b->dst, cap*sizeof(int)) : NULL;
+		double *cst = dst ? realloc(b->cost, cap*sizeof(double)) : NULL;
+		int    *beg = cst ? realloc(b->arcbeg, (cap+1)*sizeof(int)) : NULL;
+		if (src) b->src = src;
+		if (dst) b->dst = dst;
+		if (cst) b->cost = cst;
+		if (beg) b->arcbeg = beg;
+		if (!beg) return 1;
+		b->cap = cap;
+	}
+	if (b->narcs+len > b->arccap) {
+		int  cap  = 2*b->arccap + len + 64;
+		int *arcs = realloc(b->arcs, cap*sizeof(int));
+		if (!arcs) return 1;
+		b->arcs = arcs;
+		b->arccap = cap;
+	}
+
+	b->src[b->n]  = s;
+	b->dst[b->n]  = t;
+	b->cost[b->n] = cost;
+	b->arcbeg[b->n] = b->narcs;
+	for (i=len-1; i>=0; i--)
+		b->arcs[b->narcs++] = w->path[i];
+	b->n++;
+	b->arcbeg[b->n] = b->narcs;
+	return 0;
+}
+
+/* price_commodity
+ * Thread pool task: find every supply/demand node pair of commodity k whose
+ * shortest path has negative reduced cost.
+ */
+static void price_commodity(void *arg, int k, int worker)
+{
+	Pricing      *p = arg;
+	const MFData *d = p->d;
+	Workspace    *w = &p->ws[worker];
+	PathBuf      *b = &p->out[k];
+	int           N = d->numnodes;
+	int           s, t;
+	double        rc;
+
+	b->n = b->narcs = 0;
+	for (s=0; s<N; s++) {
+		if (p->supplyrow[k*N+s] < 0) continue;
+		dijkstra(p, w, k, s);
+		for (t=0; t<N; t++) {
+			if (p->demandrow[k*N+t] < 0 || w->dist[t] >= GRB_INFINITY) continue;
+			rc = w->dist[t] - p->pi[p->supplyrow[k*N+s]] - p->pi[p->demandrow[k*N+t]];
+			if (rc < -RC_TOL && pathbuf_add(b, d, w, k, s, t))
+				__atomic_store_n(&p->failed, 1, __ATOMIC_RELAXED);
+		}
+	}
+}
+
+int mf_colgen(GRBenv *env, const MFData *d, ThreadPool *tp, int maxiter,
+              MFColgenResult *res)
+{
+	GRBmodel  *master = NULL;
+	Pricing    pr;
+	int        C = d->numcommodities, N = d->numnodes, A = d->numarcs;
+	int        nthreads = tp_size(tp);
+	int       *supplyrow = NULL, *demandrow = NULL;
+	int        nsupply = 0, ndemand = 0, nrows, nart;
+	double    *rhs = NULL, *pi = NULL, *x = NULL, *obj = NULL, *ub = NULL;
+	char      *sense = NULL;
+	int       *cbeg = NULL;
+
+	/* Column pool: commodity and arcs of every path column, in master order
+	 * after the artificials */
+	int       *colk = NULL, *colbeg = NULL, *colarcs = NULL;
+	double    *colcost = NULL;
+	int        ncols = 0, colcap = 0, ncolarcs = 0, colarccap = 0;
+
+	/* GRBaddvars buffers for one round of new columns */
+	int       *vbeg = NULL, *vind = NULL;
+	double    *vval = NULL, *vobj = NULL;
+	int        vcap = 0, vnzcap = 0;
+
+	int        i, k, e, j, nz, nnew, nnz, status;
+	int        error = 0;
+	int        phase = 1;
+	double     t0, artsum;
+
+	memset(res, 0, sizeof(*res));
+	memset(&pr, 0, sizeof(pr));
+
+	for (i=0; i<C*A; i++) {
+		if (d->cost[i] < 0) {
+			fprintf(stderr, "Column generation needs nonnegative arc costs\n");
+			return GRB_ERROR_INVALID_ARGUMENT;
+		}
+	}
+
+	/* Master rows: supply rows, demand rows, capacity rows */
+
+	supplyrow = malloc(((size_t) C*N+1)*sizeof(int));
+	demandrow = malloc(((size_t) C*N+1)*sizeof(int));
+	if (!supplyrow || !demandrow) goto NOMEM;
+	for (i=0; i<C*N; i++) {
+		supplyrow[i] = d->demand[i] < 0 ? nsupply++ : -1;
+		demandrow[i] = d->demand[i] > 0 ? ndemand++ : -1;
+	}
+	for (i=0; i<C*N; i++)
+		if (demandrow[i] >= 0) demandrow[i] += nsupply;
+	nrows = nsupply + ndemand + A;
+	nart  = ndemand;
+
+	rhs   = malloc((nrows+1)*sizeof(double));
+	sense = malloc(nrows+1);
+	cbeg  = calloc(nrows+1, sizeof(int));
+	pi    = malloc((nrows+1)*sizeof(double));
+	if (!rhs || !sense || !cbeg || !pi) goto NOMEM;
+	for (i=0; i<C*N; i++) {
+		if (supplyrow[i] >= 0) {
+			sense[supplyrow[i]] = GRB_LESS_EQUAL;
+			rhs[supplyrow[i]]   = -d->demand[i];
+		}
+		if (demandrow[i] >= 0) {
+			sense[demandrow[i]] = GRB_GREATER_EQUAL;
+			rhs[demandrow[i]]   = d->demand[i];
+		}
+	}
+	for (e=0; e<A; e++) {
+		sense[nsupply+ndemand+e] = GRB_LESS_EQUAL;
+		rhs[nsupply+ndemand+e]   = d->capacity[e];
+	}
+
+	error = GRBnewmodel(env, &master, "multi_flow_master", 0, NULL, NULL, NULL, NULL, NULL);
+	if (error) goto QUIT;
+	error = GRBsetintparam(GRBgetenv(master), GRB_INT_PAR_OUTPUTFLAG, 0);
+	if (error) goto QUIT;
+	error = GRBaddconstrs(master, nrows, 0, cbeg, NULL, NULL, sense, rhs, NULL);
+	if (error) goto QUIT;
+
+	/* Artificial columns: one unit of demand row i each, cost 1 in phase 1 */
+
+	vcap = nart > 64 ? nart : 64;
+	vnzcap = 4*vcap;
+	vbeg = malloc((vcap+1)*sizeof(int));
+	vind = malloc(vnzcap*sizeof(int));
+	vval = malloc(vnzcap*sizeof(double));
+	vobj = malloc(vcap*sizeof(double));
+	if (!vbeg || !vind || !vval || !vobj) goto NOMEM;
+	for (i=0; i<nart; i++) {
+		vbeg[i] = i;
+		vind[i] = nsupply+i;
+		vval[i] = 1;
+		vobj[i] = 1;
+	}
+	error = GRBaddvars(master, nart, nart, vbeg, vind, vval, vobj, NULL, NULL, NULL, NULL);
+	if (error) goto QUIT;
+
+	/* Pricing workspaces */
+
+	pr.d = d;
+	pr.pi = pi;
+	pr.supplyrow = supplyrow;
+	pr.demandrow = demandrow;
+	pr.caprow = nsupply+ndemand;
+	pr.ws  = calloc(nthreads, sizeof(Workspace));
+	pr.out = calloc(C > 0 ? C : 1, sizeof(PathBuf));
+	if (!pr.ws || !pr.out) goto NOMEM;
+	for (i=0; i<nthreads; i++) {
+		pr.ws[i].dist = malloc((N+1)*sizeof(double));
+		pr.ws[i].pred = malloc((N+1)*sizeof(int));
+		pr.ws[i].heap = malloc((N+1)*sizeof(int));
+		pr.ws[i].pos  = malloc((N+1)*sizeof(int));
+		pr.ws[i].path = malloc((N+1)*sizeof(int));
+		if (!pr.ws[i].dist || !pr.ws[i].pred || !pr.ws[i].heap ||
+		    !pr.ws[i].pos || !pr.ws[i].path) goto NOMEM;
+	}
+
+	for (;;) {
+
+		/* Solve the restricted master and read its duals */
+
+		t0 = walltime();
+		error = GRBoptimize(master);
+		if (error) goto QUIT;
+		res->tmaster += walltime() - t0;
+		res->iterations++;
+
+		error = GRBgetintattr(master, GRB_INT_ATTR_STATUS, &status);
+		if (error) goto QUIT;
+		if (status != GRB_OPTIMAL) {
+			res->status = status;
+			break;
+		}
+		error = GRBgetdblattrarray(master, GRB_DBL_ATTR_PI, 0, nrows, pi);
+		if (error) goto QUIT;
+
+		/* Price every commodity in parallel */
+
+		t0 = walltime();
+		pr.phase = phase;
+		tp_run(tp, C, price_commodity, &pr);
+		res->tpricing += walltime() - t0;
+		if (__atomic_load_n(&pr.failed, __ATOMIC_RELAXED)) goto NOMEM;
+
+		nnew = nnz = 0;
+		for (k=0; k<C; k++) {
+			nnew += pr.out[k].n;
+			nnz  += pr.out[k].narcs + 2*pr.out[k].n;
+		}
+
+		if (nnew == 0) {
+			if (phase == 2) {
+				res->status = GRB_OPTIMAL;
+				break;
+			}
+
+			/* End of phase 1: artificials must be zero */
+
+			error = GRBgetdblattr(master, GRB_DBL_ATTR_OBJVAL, &artsum);
+			if (error) goto QUIT;
+			if (artsum > 1e-6) {
+				res->status = GRB_INFEASIBLE;
+				break;
+			}
+			obj = malloc((nart+ncols+1)*sizeof(double));
+			ub  = calloc(nart+1, sizeof(double));
+			if (!obj || !ub) goto NOMEM;
+			for (i=0; i<nart; i++)  obj[i] = 0;
+			for (j=0; j<ncols; j++) obj[nart+j] = colcost[j];
+			error = GRBsetdblattrarray(master, GRB_DBL_ATTR_OBJ, 0, nart+ncols, obj);
+			if (error) goto QUIT;
+			error = GRBsetdblattrarray(master, GRB_DBL_ATTR_UB, 0, nart, ub);
+			if (error) goto QUIT;
+			phase = 2;
+			continue;
+		}
+		if (maxiter > 0 && res->iterations >= maxiter) {
+			res->status = GRB_ITERATION_LIMIT;   /* paths left to price */
+			break;
+		}
+
+		/* Gather the new paths in commodity order into one GRBaddvars call
+		 * and remember their arcs in the column pool */
+
+		if (nnew > vcap || nnz > vnzcap) {
+			vcap   = nnew > vcap ? 2*nnew : vcap;
+			vnzcap = nnz > vnzcap ? 2*nnz : vnzcap;
+			free(vbeg); free(vind); free(vval); free(vobj);
+			vbeg = malloc((vcap+1)*sizeof(int));
+			vind = malloc(vnzcap*sizeof(int));
+			vval = malloc(vnzcap*sizeof(double));
+			vobj = malloc(vcap*sizeof(double));
+			if (!vbeg || !vind || !vval || !vobj) goto NOMEM;
+		}
+		if (ncols+nnew > colcap) {
+			int     cap = 2*(ncols+nnew);
+			int    *nk  = realloc(colk, cap*sizeof(int));
+			int    *nb  = nk ? realloc(colbeg, (cap+1)*sizeof(int)) : NULL;
+			double *nc  = nb ? realloc(colcost, cap*sizeof(double)) : NULL;
+			if (nk) colk = nk;
+			if (nb) colbeg = nb;
+			if (nc) colcost = nc;
+			if (!nc) goto NOMEM;
+			colcap = cap;
+		}
+		if (ncolarcs+nnz > colarccap) {
+			int  cap = 2*(ncolarcs+nnz);
+			int *na  = realloc(colarcs, cap*sizeof(int));
+			if (!na) goto NOMEM;
+			colarcs = na;
+			colarccap = cap;
+		}
+
+		j = nz = 0;
+		for (k=0; k<C; k++) {
+			PathBuf *b = &pr.out[k];
+			for (i=0; i<b->n; i++, j++) {
+				vbeg[j] = nz;
+				vobj[j] = phase == 2 ? b->cost[i] : 0.0;
+				vind[nz] = supplyrow[k*N+b->src[i]]; vval[nz++] = 1;
+				vind[nz] = demandrow[k*N+b->dst[i]]; vval[nz++] = 1;
+				colk[ncols]    = k;
+				colcost[ncols] = b->cost[i];
+				colbeg[ncols]  = ncolarcs;
+				for (e=b->arcbeg[i]; e<b->arcbeg[i+1]; e++) {
+					vind[nz] = pr.caprow+b->arcs[e];
+					vval[nz++] = 1;
+					colarcs[ncolarcs++] = b->arcs[e];
+				}
+				ncols++;
+				colbeg[ncols] = ncolarcs;
+			}
+		}
+		error = GRBaddvars(master, nnew, nz, vbeg, vind, vval, vobj, NULL, NULL, NULL, NULL);
+		if (error) goto QUIT;
+	}
+
+	/* Map path flows back to arc flows */
+
+	res->numcolumns = ncols;
+	res->flow = calloc((size_t) C*A+1, sizeof(double));
+	x = malloc((ncols+1)*sizeof(double));
+	if (!res->flow || !x) goto NOMEM;
+	if (res->status == GRB_OPTIMAL && ncols > 0) {
+		error = GRBgetdblattr(master, GRB_DBL_ATTR_OBJVAL, &res->objval);
+		if (error) goto QUIT;
+		error = GRBgetdblattrarray(master, GRB_DBL_ATTR_X, nart, ncols, x);
+		if (error) goto QUIT;
+		for (j=0; j<ncols; j++)
+			for (e=colbeg[j]; e<colbeg[j+1]; e++)
+				res->flow[(size_t) colk[j]*A+colarcs[e]] += x[j];
+	}
+	goto QUIT;
+
+NOMEM:
+	error = GRB_ERROR_OUT_OF_MEMORY;
+
+QUIT:
+	if (pr.ws)
+		for (i=0; i<nthreads; i++) {
+			free(pr.ws[i].dist);
+			free(pr.ws[i].pred);
+			free(pr.ws[i].heap);
+			free(pr.ws[i].pos);
+			free(pr.ws[i].path);
+		}
+	if (pr.out)
+		for (k=0; k<C; k++) {
+			free(pr.out[k].src);
+			free(pr.out[k].dst);
+			free(pr.out[k].cost);
+			free(pr.out[k].arcbeg);
+			free(pr.out[k].arcs);
+		}
+	free(pr.ws);
+	free(pr.out);
+	free(colk); free(colbeg); free(colarcs); free(colcost);
+	free(vbeg); free(vind); free(vval); free(vobj);
+	free(x); free(obj); free(ub);
+	free(rhs); free(sense); free(cbeg); free(pi);
+	free(supplyrow); free(demandrow);
+	GRBfreemodel(master);
+	if (error) mf_colgen_free(res);
+	return error;
+}
+
+void mf_colgen_free(MFColgenResult *res)
+{
+	free(res->flow);
+	res->flow = NULL;
+}
@@ -0,0 +1,51 @@
+/* Dantzig-Wolfe column generation for the multi commodity network flow.
+
+   Commodities only interact through the arc capacities, so the flow of each
+   commodity is written as a combination of source-to-sink paths.  The
+   restricted master LP has one row per (commodity, supply node), one per
+   (commodity, demand node) and one capacity row per arc, and one column per
+   path generated so far.  Each iteration reads the duals of the master
+   (GRB_DBL_ATTR_PI) and prices out new paths with a shortest path search per
+   commodity on arc lengths cost - capacity dual.  The commodities are priced
+   in parallel on a ThreadPool.
+
+   The master starts with one artificial column per demand row.  Phase 1
+   minimizes their total; if it stays positive the instance is infeasible.
+   Phase 2 then drops them and minimizes the true path costs.
+
+   Shortest paths are computed with Dijkstra's algorithm, so arc costs must
+   be nonnegative.
+*/
+
+#ifndef MF_COLGEN_H
+#define MF_COLGEN_H
+
+#include "gurobi_c.h"
+#include "mf_data.h"
+#include "threadpool.h"
+
+typedef struct {
+  int      status;       /* GRB_OPTIMAL, GRB_INFEASIBLE, GRB_ITERATION_LIMIT
+                            at maxiter, or the master status */
+  double   objval;
+  int      iterations;   /* master solves, both phases */
+  int      numcolumns;   /* path columns in the final master */
+  double  *flow;         /* [numcommodities*numarcs] arc flows, varind order;
+                            all zero unless status is GRB_OPTIMAL */
+  double   tmaster;      /* seconds in master solves */
+  double   tpricing;     /* seconds in pricing */
+} MFColgenResult;
+
+/* mf_colgen
+ * inputs: env      loaded environment, used for the master LP
+ *         d        instance
+ *         tp       pool the commodities are priced on
+ *         maxiter  limit on master solves, <= 0 for none
+ * output: error code; res filled on success (free with mf_colgen_free)
+ */
+int mf_colgen(GRBenv *env, const MFData *d, ThreadPool *tp, int maxiter,
+              MFColgenResult *res);
+
+void mf_colgen_free(MFColgenResult *res);
+
+#endif
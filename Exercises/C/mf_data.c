@@ -0,0 +1,515 @@
+/* Instance data for the multi commodity network flow problem.
+   See mf_data.h for the file formats. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mf_data.h"
+#include "csvread.h"
+#include "modelcache.h"
+#include "multi_flow.h"
+
+/* Binary .mfb layout: this header, then
+ *   double   capacity[numarcs]
+ *   double   cost[numcommodities*numarcs]
+ *   double   demand[numcommodities*numnodes]
+ *   int64_t  nameoff[numcommodities+numnodes]   offsets into strings
+ *   int32_t  tail[numarcs]
+ *   int32_t  head[numarcs]
+ *   char     strings[strbytes]                  '\0' terminated names
+ * Everything 8-byte wide comes first so that all arrays are aligned in the map.
+ */
+#define MFB_MAGIC "MFLOWB1\n"
+
+typedef struct {
+  char     magic[8];
+  int32_t  numcommodities;
+  int32_t  numnodes;
+  int32_t  numarcs;
+  int32_t  reserved;
+  int64_t  strbytes;
+} MFBHeader;
+
+/* copy_names
+ * Copy the next count records into *store, pointing names[i] at each.
+ */
+static void copy_names(CsvCursor *c, int count, char **names, char **store)
+{
+	const char *rec, *end;
+	int         i;
+
+	for (i=0; i<count; i++) {
+		csv_next_record(c, &rec, &end);
+		names[i] = *store;
+		memcpy(*store, rec, end - rec);
+		(*store)[end - rec] = '\0';
+		*store += (end - rec) + 1;
+	}
+}
+
+static int load_csv(const char *map, size_t len, const char *filename, MFData *d)
+{
+	CsvCursor   c = { map, map+len, 0 };
+	CsvCursor   cc, cn;
+	NameHash    hash = { NULL, 0 };
+	const char *rec, *end, *f;
+	size_t      flen;
+	long        cbytes, nbytes;
+	char       *store;
+	double      v;
+	int         C, N, A, numdemand;
+	int         i, k, n;
+
+	/* Names: measure both sections, then copy them into one block */
+
+	if (csv_parse_header(&c, "commodities", 1, &d->numcommodities)) goto BADHEADER;
+	C = d->numcommodities;
+	cc = c;
+	if ((cbytes = csv_measure_names(&c, C, '\n')) < 0) goto SHORT;
+	if (csv_parse_header(&c, "nodes", 1, &d->numnodes)) goto BADHEADER;
+	N = d->numnodes;
+	cn = c;
+	if ((nbytes = csv_measure_names(&c, N, '\n')) < 0) goto SHORT;
+
+	d->strings   = malloc(cbytes+nbytes > 0 ? cbytes+nbytes : 1);
+	d->commodity = malloc((C > 0 ? C : 1)*sizeof(char *));
+	d->node      = malloc((N > 0 ? N : 1)*sizeof(char *));
+	if (!d->strings || !d->commodity || !d->node || csv_hash_init(&hash, N))
+		goto NOMEM;
+	store = d->strings;
+	copy_names(&cc, C, d->commodity, &store);
+	copy_names(&cn, N, d->node, &store);
+	for (n=0; n<N; n++) {
+		if (csv_hash_find(&hash, d->node, d->node[n], strlen(d->node[n]), 1, n) != n) {
+			fprintf(stderr, "%s: duplicate node '%s'\n", filename, d->node[n]);
+			goto FAIL;
+		}
+	}
+
+	/* Arcs: tail,head,capacity,cost per commodity */
+
+	if (csv_parse_header(&c, "arcs", 1, &d->numarcs)) goto BADHEADER;
+	A = d->numarcs;
+	d->tail     = malloc((A > 0 ? A : 1)*sizeof(int));
+	d->head     = malloc((A > 0 ? A : 1)*sizeof(int));
+	d->capacity = malloc((A > 0 ? A : 1)*sizeof(double));
+	d->cost     = malloc(((size_t) C*A > 0 ? (size_t) C*A : 1)*sizeof(double));
+	if (!d->tail || !d->head || !d->capacity || !d->cost) goto NOMEM;
+
+	for (i=0; i<A; i++) {
+		if (!csv_next_record(&c, &rec, &end)) goto SHORT;
+		f = csv_next_field(&rec, end, ',', &flen);
+		if ((d->tail[i] = csv_hash_find(&hash, d->node, f, flen, 0, 0)) < 0) goto BADNODE;
+		f = csv_next_field(&rec, end, ',', &flen);
+		if (f == NULL || (d->head[i] = csv_hash_find(&hash, d->node, f, flen, 0, 0)) < 0)
+			goto BADNODE;
+		if (d->head[i] == d->tail[i]) {
+			fprintf(stderr, "%s:%d: arc from a node to itself\n", filename, c.line);
+			goto FAIL;
+		}
+		f = csv_next_field(&rec, end, ',', &flen);
+		if (f == NULL || csv_parse_num(f, flen, &d->capacity[i])) goto BADNUM;
+		for (k=0; k<C; k++) {
+			f = csv_next_field(&rec, end, ',', &flen);
+			if (f == NULL || csv_parse_num(f, flen, &d->cost[(size_t) k*A+i])) goto BADNUM;
+		}
+	}
+
+	/* Demand: node,demand per commodity; nodes not listed have none */
+
+	if (csv_parse_header(&c, "demand", 1, &numdemand)) goto BADHEADER;
+	d->demand = calloc((size_t) C*N > 0 ? (size_t) C*N : 1, sizeof(double));
+	if (!d->demand) goto NOMEM;
+
+	for (i=0; i<numdemand; i++) {
+		if (!csv_next_record(&c, &rec, &end)) goto SHORT;
+		f = csv_next_field(&rec, end, ',', &flen);
+		if ((n = csv_hash_find(&hash, d->node, f, flen, 0, 0)) < 0) goto BADNODE;
+		for (k=0; k<C; k++) {
+			f = csv_next_field(&rec, end, ',', &flen);
+			if (f == NULL || csv_parse_num(f, flen, &v)) goto BADNUM;
+			d->demand[(size_t) k*N+n] = v;
+		}
+	}
+
+	free(hash.slot);
+	return 0;
+
+BADHEADER:
+	fprintf(stderr, "%s:%d: expected section header\n", filename, c.line);
+	goto FAIL;
+SHORT:
+	fprintf(stderr, "%s: unexpected end of file\n", filename);
+	goto FAIL;
+BADNODE:
+	fprintf(stderr, "%s:%d: unknown node\n", filename, c.line);
+	goto FAIL;
+BADNUM:
+	fprintf(stderr, "%s:%d: bad or missing number\n", filename, c.line);
+	goto FAIL;
+NOMEM:
+	fprintf(stderr, "%s: out of memory\n", filename);
+FAIL:
+	free(hash.slot);
+	return 1;
+}
+
+/* take
+ * Add an array of n*m elements of size bytes to *need (<= len).  Returns 1,
+ * leaving *need alone, if the file of len bytes cannot hold it, so that no
+ * size computed from the counts in a header can overflow.
+ */
+static int take(size_t *need, size_t n, size_t m, size_t size, size_t len)
+{
+	size_t room = (len - *need) / size;
+
+	if (n != 0 && m > room / n) return 1;
+	*need += n*m*size;
+	return 0;
+}
+
+static int load_binary(void *map, size_t len, const char *filename, MFData *d)
+{
+	const MFBHeader *h = map;
+	char            *p = (char *) map + sizeof(MFBHeader);
+	const int64_t   *nameoff;
+	size_t           C, N, A, need = sizeof(MFBHeader);
+	size_t           i;
+
+	if (h->numcommodities < 0 || h->numnodes < 0 || h->numarcs < 0 ||
+	    h->strbytes < 0 || (uint64_t) h->strbytes > len) {
+		fprintf(stderr, "%s: corrupt binary instance\n", filename);
+		return 1;
+	}
+	C = h->numcommodities;
+	N = h->numnodes;
+	A = h->numarcs;
+	if (take(&need, A, 1, 8, len) || take(&need, C, A, 8, len) ||
+	    take(&need, C, N, 8, len) || take(&need, C+N, 1, 8, len) ||
+	    take(&need, A, 2, 4, len) || take(&need, (size_t) h->strbytes, 1, 1, len) ||
+	    need != len) {
+		fprintf(stderr, "%s: corrupt binary instance\n", filename);
+		return 1;
+	}
+
+	d->numcommodities = C;
+	d->numnodes = N;
+	d->numarcs  = A;
+	d->capacity = (double *) p;  p += A*8;
+	d->cost     = (double *) p;  p += C*A*8;
+	d->demand   = (double *) p;  p += C*N*8;
+	nameoff     = (int64_t *) p; p += (C+N)*8;
+	d->tail     = (int *) p;     p += A*4;
+	d->head     = (int *) p;     p += A*4;
+
+	/* Only the name pointer tables are built; everything else is the map */
+
+	d->commodity = malloc((C > 0 ? C : 1)*sizeof(char *));
+	d->node      = malloc((N > 0 ? N : 1)*sizeof(char *));
+	if (!d->commodity || !d->node) {
+		fprintf(stderr, "%s: out of memory\n", filename);
+		return 1;
+	}
+	for (i=0; i<C+N; i++) {
+		if (nameoff[i] < 0 || nameoff[i] >= h->strbytes) {
+			fprintf(stderr, "%s: corrupt binary instance\n", filename);
+			return 1;
+		}
+		if (i < C) d->commodity[i] = p + nameoff[i];
+		else       d->node[i-C]    = p + nameoff[i];
+	}
+	if (h->strbytes > 0 && p[h->strbytes-1] != '\0') {
+		fprintf(stderr, "%s: corrupt binary instance\n", filename);
+		return 1;
+	}
+	for (i=0; i<A; i++) {
+		if (d->tail[i] < 0 || d->tail[i] >= (int) N ||
+		    d->head[i] < 0 || d->head[i] >= (int) N || d->tail[i] == d->head[i]) {
+			fprintf(stderr, "%s: corrupt binary instance\n", filename);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* mf_adjacency
+ * Put the arcs of d in CSR order (stable counting sort by tail, done only
+ * if they are not sorted already) and build outbeg, inbeg and inarc.
+ * output: 0 on success
+ */
+static int mf_adjacency(MFData *d, const char *filename)
+{
+	int     N = d->numnodes, A = d->numarcs, C = d->numcommodities;
+	int    *pos = NULL, *tail = NULL, *head = NULL;
+	double *capacity = NULL, *cost = NULL;
+	int     a, k, n, sorted = 1;
+
+	d->outbeg = calloc(N+1, sizeof(int));
+	d->inbeg  = calloc(N+1, sizeof(int));
+	d->inarc  = malloc((A > 0 ? A : 1)*sizeof(int));
+	if (!d->outbeg || !d->inbeg || !d->inarc) goto NOMEM;
+
+	for (a=0; a<A; a++) {
+		d->outbeg[d->tail[a]+1]++;
+		d->inbeg[d->head[a]+1]++;
+		if (a > 0 && d->tail[a] < d->tail[a-1]) sorted = 0;
+	}
+	for (n=0; n<N; n++) {
+		d->outbeg[n+1] += d->outbeg[n];
+		d->inbeg[n+1]  += d->inbeg[n];
+	}
+
+	if (!sorted) {
+		if (d->map) {
+			fprintf(stderr, "%s: arcs are not sorted by tail node\n", filename);
+			return 1;
+		}
+		pos      = malloc((N > 0 ? N : 1)*sizeof(int));
+		tail     = malloc(A*sizeof(int));
+		head     = malloc(A*sizeof(int));
+		capacity = malloc(A*sizeof(double));
+		cost     = malloc((size_t) C*A*sizeof(double) + 1);
+		if (!pos || !tail || !head || !capacity || !cost) goto NOMEM;
+		memcpy(pos, d->outbeg, N*sizeof(int));
+		for (a=0; a<A; a++) {
+			int b = pos[d->tail[a]]++;
+			tail[b]     = d->tail[a];
+			head[b]     = d->head[a];
+			capacity[b] = d->capacity[a];
+			for (k=0; k<C; k++)
+				cost[(size_t) k*A+b] = d->cost[(size_t) k*A+a];
+		}
+		free(d->tail);     d->tail = tail;
+		free(d->head);     d->head = head;
+		free(d->capacity); d->capacity = capacity;
+		free(d->cost);     d->cost = cost;
+		free(pos);
+	}
+
+	/* In-adjacency: bucket the (now sorted) arcs by head */
+
+	pos = malloc((N > 0 ? N : 1)*sizeof(int));
+	if (!pos) goto NOMEM;
+	memcpy(pos, d->inbeg, N*sizeof(int));
+	for (a=0; a<A; a++)
+		d->inarc[pos[d->head[a]]++] = a;
+	free(pos);
+	return 0;
+
+NOMEM:
+	fprintf(stderr, "%s: out of memory\n", filename);
+	free(pos);
+	free(tail);
+	free(head);
+	free(capacity);
+	free(cost);
+	return 1;
+}
+
+int mf_load(const char *filename, MFData *d)
+{
+	struct stat st;
+	void       *map;
+	int         fd;
+	int         error;
+
+	memset(d, 0, sizeof(*d));
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		perror(filename);
+		if (fd >= 0) close(fd);
+		return 1;
+	}
+	if (st.st_size == 0) {
+		fprintf(stderr, "%s: empty file\n", filename);
+		close(fd);
+		return 1;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		perror(filename);
+		return 1;
+	}
+
+	if ((size_t) st.st_size >= sizeof(MFBHeader) &&
+	    memcmp(map, MFB_MAGIC, 8) == 0) {
+		d->map    = map;
+		d->maplen = st.st_size;
+		error = load_binary(map, st.st_size, filename, d);
+	} else {
+		madvise(map, st.st_size, MADV_SEQUENTIAL);
+		error = load_csv(map, st.st_size, filename, d);
+		munmap(map, st.st_size);
+	}
+	if (!error) error = mf_adjacency(d, filename);
+	if (error) mf_free(d);
+	return error;
+}
+
+int mf_save_binary(const MFData *d, const char *filename)
+{
+	MFBHeader  h;
+	FILE      *fp;
+	int64_t    off = 0;
+	size_t     C = d->numcommodities, N = d->numnodes, A = d->numarcs;
+	size_t     i;
+	int        error = 0;
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, MFB_MAGIC, 8);
+	h.numcommodities = C;
+	h.numnodes = N;
+	h.numarcs  = A;
+	for (i=0; i<C; i++) h.strbytes += strlen(d->commodity[i])+1;
+	for (i=0; i<N; i++) h.strbytes += strlen(d->node[i])+1;
+
+	fp = fopen(filename, "wb");
+	if (fp == NULL) {
+		perror(filename);
+		return 1;
+	}
+	fwrite(&h, sizeof(h), 1, fp);
+	fwrite(d->capacity, sizeof(double), A, fp);
+	fwrite(d->cost, sizeof(double), C*A, fp);
+	fwrite(d->demand, sizeof(double), C*N, fp);
+	for (i=0; i<C+N; i++) {
+		const char *s = i < C ? d->commodity[i] : d->node[i-C];
+		fwrite(&off, sizeof(off), 1, fp);
+		off += strlen(s)+1;
+	}
+	fwrite(d->tail, sizeof(int), A, fp);
+	fwrite(d->head, sizeof(int), A, fp);
+	for (i=0; i<C+N; i++) {
+		const char *s = i < C ? d->commodity[i] : d->node[i-C];
+		fwrite(s, 1, strlen(s)+1, fp);
+	}
+	if (ferror(fp)) error = 1;
+	if (fclose(fp) != 0) error = 1;
+	if (error) perror(filename);
+	return error;
+}
+
+int mf_default(MFData *d)
+{
+	int C = NUMCOMMODITIES, S = NUMSOURCES, D = NUMDESTINATIONS;
+	int N = S+D, A = S*D;
+	int i, j, k;
+
+	memset(d, 0, sizeof(*d));
+	d->numcommodities = C;
+	d->numnodes = N;
+	d->numarcs  = A;
+	d->commodity = malloc(C*sizeof(char *));
+	d->node      = malloc(N*sizeof(char *));
+	d->tail      = malloc(A*sizeof(int));
+	d->head      = malloc(A*sizeof(int));
+	d->capacity  = malloc(A*sizeof(double));
+	d->cost      = malloc(C*A*sizeof(double));
+	d->demand    = calloc(C*N, sizeof(double));
+	if (!d->commodity || !d->node || !d->tail || !d->head ||
+	    !d->capacity || !d->cost || !d->demand) {
+		mf_free(d);
+		return 1;
+	}
+
+	/* Nodes are the sources followed by the destinations; arcs join every
+	 * source to every destination in source-major order */
+
+	for (k=0; k<C; k++) d->commodity[k] = Commodity[k];
+	for (j=0; j<S; j++) d->node[j]   = Source[j];
+	for (j=0; j<D; j++) d->node[S+j] = Destination[j];
+
+	for (i=0; i<S; i++)
+		for (j=0; j<D; j++) {
+			d->tail[i*D+j]     = i;
+			d->head[i*D+j]     = S+j;
+			d->capacity[i*D+j] = capacity[i][j];
+			for (k=0; k<C; k++)
+				d->cost[k*A+i*D+j] = cost[k][i][j];
+		}
+
+	for (k=0; k<C; k++) {
+		for (i=0; i<S; i++) d->demand[k*N+i]   = -supply[k][i];
+		for (j=0; j<D; j++) d->demand[k*N+S+j] =  demand[k][j];
+	}
+	if (mf_adjacency(d, "multi_flow.h")) {
+		mf_free(d);
+		return 1;
+	}
+	return 0;
+}
+
+uint64_t mf_hash(const MFData *d)
+{
+	uint64_t h = 1469598103934665603ULL;
+	size_t   C = d->numcommodities, N = d->numnodes, A = d->numarcs;
+	size_t   i;
+
+	h = mc_hash(h, &d->numcommodities, sizeof(int));
+	h = mc_hash(h, &d->numnodes, sizeof(int));
+	h = mc_hash(h, &d->numarcs, sizeof(int));
+	for (i=0; i<C; i++) h = mc_hash(h, d->commodity[i], strlen(d->commodity[i])+1);
+	for (i=0; i<N; i++) h = mc_hash(h, d->node[i], strlen(d->node[i])+1);
+	h = mc_hash(h, d->tail, A*sizeof(int));
+	h = mc_hash(h, d->head, A*sizeof(int));
+	h = mc_hash(h, d->capacity, A*sizeof(double));
+	h = mc_hash(h, d->cost, C*A*sizeof(double));
+	h = mc_hash(h, d->demand, C*N*sizeof(double));
+	return h;
+}
+
+void mf_scenario_demand(const MFData *d, double spread, uint64_t seed, int s,
+                        double *demand)
+{
+	int      k, N = d->numnodes;
+	size_t   i, n = (size_t) d->numcommodities*N;
+	uint64_t state = seed ^ (0xD1B54A32D192ED03ULL * ((uint64_t) s + 1));
+	double   before, after;
+
+	for (i=0; i<n; i++) {
+		demand[i] = d->demand[i];
+		if (demand[i] > 0)
+			demand[i] *= 1 + spread*(2*((splitmix64(&state) >> 11) * 0x1.0p-53) - 1);
+	}
+
+	/* Supplies follow their commodity's total demand */
+
+	for (k=0; k<d->numcommodities; k++) {
+		before = after = 0;
+		for (i=(size_t) k*N; i<(size_t) (k+1)*N; i++)
+			if (d->demand[i] > 0) {
+				before += d->demand[i];
+				after  += demand[i];
+			}
+		if (before > 0)
+			for (i=(size_t) k*N; i<(size_t) (k+1)*N; i++)
+				if (demand[i] < 0) demand[i] *= after/before;
+	}
+}
+
+void mf_free(MFData *d)
+{
+	free(d->commodity);
+	free(d->node);
+	free(d->outbeg);
+	free(d->inbeg);
+	free(d->inarc);
+	if (d->map) {
+		munmap(d->map, d->maplen);
+	} else {
+		free(d->tail);
+		free(d->head);
+		free(d->capacity);
+		free(d->cost);
+		free(d->demand);
+	}
+	free(d->strings);
+	memset(d, 0, sizeof(*d));
+}
@@ -0,0 +1,109 @@
+/* Instance data for the multi commodity network flow problem.
+
+   An instance is a list of commodities, a list of nodes, a list of arcs with
+   a capacity and a per-commodity cost, and a per-commodity, per-node demand
+   (negative for supply), exactly as in the python data in multi_flow.c.
+
+   Instances come from three places:
+     mf_default      the hard-coded data in multi_flow.h
+     mf_load         a CSV file or a binary .mfb file (detected by its magic)
+     mf_save_binary  writes any instance as .mfb for fast reloading
+
+   CSV layout (lines starting with '#' and blank lines are ignored):
+
+     commodities,2
+     Pencils
+     Pens
+     nodes,5
+     Detroit
+     ...
+     arcs,6
+     Detroit,Boston,100,10,20       tail,head,capacity,cost per commodity
+     ...
+     demand,5
+     Detroit,-50,-60                node,demand per commodity
+     ...
+
+   The file is memory mapped and parsed in a single pass; every array is
+   allocated once from the section counts.  A binary file is mapped and used
+   in place: the numeric arrays of the MFData point straight into the map.
+
+   Arcs are kept in CSR order, sorted by tail node, so the arcs leaving node
+   n are outbeg[n]..outbeg[n+1]-1; the arcs entering n are listed through
+   inarc.  CSV arcs may come in any order and are sorted on load; .mfb files
+   are always written sorted and are rejected otherwise.  Nodes need not be
+   sources or sinks: a node whose demand is zero for a commodity is a
+   transshipment node for it.
+*/
+
+#ifndef MF_DATA_H
+#define MF_DATA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  int      numcommodities;
+  int      numnodes;
+  int      numarcs;
+  char   **commodity;  /* [numcommodities] names */
+  char   **node;       /* [numnodes] names */
+  int     *tail;       /* [numarcs] node index the arc leaves */
+  int     *head;       /* [numarcs] node index the arc enters */
+  double  *capacity;   /* [numarcs] */
+  double  *cost;       /* [numcommodities*numarcs], commodity k on arc a at k*numarcs+a */
+  double  *demand;     /* [numcommodities*numnodes], commodity k at node n at k*numnodes+n;
+                          negative values are supplies */
+  int     *outbeg;     /* [numnodes+1] arcs leaving n are outbeg[n]..outbeg[n+1]-1 */
+  int     *inbeg;      /* [numnodes+1] arcs entering n are inarc[inbeg[n]..inbeg[n+1]-1] */
+  int     *inarc;      /* [numarcs] */
+
+  /* storage, owned by the MFData */
+  char    *strings;    /* name characters, unless the names live in the map */
+  void    *map;        /* mapped .mfb file, or NULL */
+  size_t   maplen;
+} MFData;
+
+/* mf_default
+ * output: 0 on success; d holds the instance from multi_flow.h
+ */
+int mf_default(MFData *d);
+
+/* mf_load
+ * inputs: filename  CSV or .mfb file
+ * output: 0 on success; on failure d is left empty and a message naming
+ *         the file and line is printed to stderr
+ */
+int mf_load(const char *filename, MFData *d);
+
+/* mf_save_binary
+ * output: 0 on success; writes d in .mfb format to filename
+ */
+int mf_save_binary(const MFData *d, const char *filename);
+
+/* mf_hash
+ * output: 64-bit FNV-1a hash of the instance: its sizes, names, arcs,
+ *         capacities, costs and demands.  Equal instances hash equal
+ *         whichever file they were loaded from.
+ */
+uint64_t mf_hash(const MFData *d);
+
+/* mf_scenario_demand
+ * inputs: spread, seed  every positive demand is scaled by a factor drawn
+ *                       uniformly from [1-spread, 1+spread]; the supplies
+ *                       of each commodity are scaled by the ratio of its
+ *                       new to its old total demand, so an instance whose
+ *                       supply covers its demand still does
+ *         s             scenario number; the draws depend on seed and s
+ *                       alone, so scenarios can be made in any order
+ * output: demand[numcommodities*numnodes] of scenario s, d->demand layout
+ */
+void mf_scenario_demand(const MFData *d, double spread, uint64_t seed, int s,
+                        double *demand);
+
+/* mf_free
+ * Release everything held by d.  Safe to call on a zeroed MFData.
+ */
+void mf_free(MFData *d);
+
+#endif
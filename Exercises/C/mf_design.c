@@ -0,0 +1,366 @@
+/* Fixed-charge network design: the MIP, its LP-rounding start and the
+   lazy linking rows.  See mf_design.h */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "mf_design.h"
+#include "walltime.h"
+
+/* The callback's view of the model: y[k,a] at k*A+a, open[a] at C*A+a */
+
+typedef struct {
+  const MFData *d;
+  const double *u;       /* [C*A] flow bounds */
+  double       *x;       /* [C*A+A] node relaxation or candidate solution */
+  int           added;
+} LinkCuts;
+
+/* flow_bounds
+ * output: u[k*A+a] = min(capacity[a], supply of k, demand of k)
+ */
+static void flow_bounds(const MFData *d, double *u)
+{
+	int    C = d->numcommodities, N = d->numnodes, A = d->numarcs;
+	int    k, n, a;
+	double supply, demand, b;
+
+	for (k=0; k<C; k++) {
+		supply = demand = 0;
+		for (n=0; n<N; n++) {
+			b = d->demand[k*N+n];
+			if (b < 0) supply -= b;
+			else       demand += b;
+		}
+		b = supply < demand ? supply : demand;
+		for (a=0; a<A; a++)
+			u[k*A+a] = d->capacity[a] < b ? d->capacity[a] : b;
+	}
+}
+
+/* linking
+ * output: 1 if y[k,a] <= u[k,a] open[a] is not implied by the capacity row
+ */
+static int linking(const MFData *d, const double *u, int k, int a)
+{
+	return u[k*d->numarcs+a] < d->capacity[a];
+}
+
+/* build
+ * inputs: model  empty model
+ *         u      [C*A] flow bounds
+ * output: error code; adds y, open, the C*N node rows, the A capacity
+ *         rows and, for MD_STATIC, every linking row, in that order
+ */
+static int build(GRBmodel *model, const MFData *d, const MFDesignSpec *ds,
+                 const double *u, int *numlinking)
+{
+	int     C = d->numcommodities, N = d->numnodes, A = d->numarcs;
+	int     nv = C*A + A, nr = C*N;
+	int     k, n, a, e, r, nz;
+	int     error = 0;
+	double *obj   = malloc(nv*sizeof(double) + 1);
+	double *ub    = malloc(nv*sizeof(double) + 1);
+	char   *vtype = malloc(nv + 1);
+	double *rhs   = malloc((nr > A ? nr : A)*sizeof(double) + 1);
+	char   *sense = malloc((nr > A ? nr : A) + 1);
+	int    *cbeg  = malloc(((nr > A ? nr : A)+1)*sizeof(int));
+	int    *cind  = malloc((2*(size_t) C*A + (size_t) A*(C+1))*sizeof(int) + 1);
+	double *cval  = malloc((2*(size_t) C*A + (size_t) A*(C+1))*sizeof(double) + 1);
+
+	*numlinking = 0;
+	if (!obj || !ub || !vtype || !rhs || !sense || !cbeg || !cind || !cval) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+
+	for (k=0; k<C*A; k++) {
+		obj[k]   = d->cost[k];
+		ub[k]    = u[k];
+		vtype[k] = GRB_CONTINUOUS;
+	}
+	for (a=0; a<A; a++) {
+		obj[C*A+a]   = ds->fixed[a];
+		ub[C*A+a]    = 1;
+		vtype[C*A+a] = GRB_BINARY;
+	}
+	error = GRBaddvars(model, nv, 0, NULL, NULL, NULL, obj, NULL, ub, vtype, NULL);
+	if (error) goto QUIT;
+
+	/* Node rows: inflow - outflow >= demand, = 0 where there is none */
+
+	r = nz = 0;
+	for (k=0; k<C; k++)
+		for (n=0; n<N; n++, r++) {
+			cbeg[r]  = nz;
+			rhs[r]   = d->demand[k*N+n];
+			sense[r] = rhs[r] == 0 ? GRB_EQUAL : GRB_GREATER_EQUAL;
+			for (e=d->inbeg[n]; e<d->inbeg[n+1]; e++, nz++) {
+				cind[nz] = k*A + d->inarc[e];
+				cval[nz] = 1;
+			}
+			for (e=d->outbeg[n]; e<d->outbeg[n+1]; e++, nz++) {
+				cind[nz] = k*A + e;
+				cval[nz] = -1;
+			}
+		}
+	error = GRBaddconstrs(model, nr, nz, cbeg, cind, cval, sense, rhs, NULL);
+	if (error) goto QUIT;
+
+	/* Capacity rows: total flow <= capacity, only on an open arc */
+
+	nz = 0;
+	for (a=0; a<A; a++) {
+		cbeg[a]  = nz;
+		sense[a] = GRB_LESS_EQUAL;
+		rhs[a]   = 0;
+		for (k=0; k<C; k++, nz++) {
+			cind[nz] = k*A + a;
+			cval[nz] = 1;
+		}
+		cind[nz]   = C*A + a;
+		cval[nz++] = -d->capacity[a];
+	}
+	error = GRBaddconstrs(model, A, nz, cbeg, cind, cval, sense, rhs, NULL);
+	if (error) goto QUIT;
+
+	/* Linking rows up front, one arc at a time */
+
+	if (ds->linking == MD_STATIC)
+		for (a=0; a<A; a++) {
+			r = nz = 0;
+			for (k=0; k<C; k++) {
+				if (!linking(d, u, k, a)) continue;
+				cbeg[r]  = nz;
+				sense[r] = GRB_LESS_EQUAL;
+				rhs[r++] = 0;
+				cind[nz] = k*A + a;
+				cval[nz++] = 1;
+				cind[nz] = C*A + a;
+				cval[nz++] = -u[k*A+a];
+			}
+			error = GRBaddconstrs(model, r, nz, cbeg, cind, cval, sense, rhs, NULL);
+			if (error) goto QUIT;
+			*numlinking += r;
+		}
+
+	error = GRBupdatemodel(model);
+
+QUIT:
+	free(obj);
+	free(ub);
+	free(vtype);
+	free(rhs);
+	free(sense);
+	free(cbeg);
+	free(cind);
+	free(cval);
+	return error;
+}
+
+/* link_callback
+ * Adds the linking rows that the node relaxation or candidate solution
+ * violates as lazy constraints
+ */
+static int __stdcall link_callback(GRBmodel *model, void *cbdata, int where, void *usrdata)
+{
+	LinkCuts     *lc = usrdata;
+	const MFData *d = lc->d;
+	int           C = d->numcommodities, A = d->numarcs;
+	int           k, a, status;
+	int           ind[2];
+	double        val[2];
+	int           error = 0;
+
+	(void) model;
+	if (where == GRB_CB_MIPNODE) {
+		error = GRBcbget(cbdata, where, GRB_CB_MIPNODE_STATUS, &status);
+		if (error || status != GRB_OPTIMAL) return error;
+		error = GRBcbget(cbdata, where, GRB_CB_MIPNODE_REL, lc->x);
+	} else if (where == GRB_CB_MIPSOL) {
+		error = GRBcbget(cbdata, where, GRB_CB_MIPSOL_SOL, lc->x);
+	} else {
+		return 0;
+	}
+	if (error) return error;
+
+	for (a=0; a<A; a++)
+		for (k=0; k<C; k++) {
+			double u = lc->u[k*A+a];
+			if (!linking(d, lc->u, k, a) ||
+			    lc->x[k*A+a] - u*lc->x[C*A+a] <= 1e-6*(1 + u))
+				continue;
+			ind[0] = k*A + a;
+			val[0] = 1;
+			ind[1] = C*A + a;
+			val[1] = -u;
+			error = GRBcblazy(cbdata, 2, ind, val, GRB_LESS_EQUAL, 0);
+			if (error) return error;
+			lc->added++;
+		}
+	return 0;
+}
+
+/* round_start
+ * inputs: model  the design MIP
+ *         x      [C*A+A] work buffer
+ * output: error code; unless the LP relaxation has no solution, sets the
+ *         Start of every variable of model to the rounded design, and
+ *         res->lpobj, res->startobj to the objectives
+ */
+static int round_start(GRBmodel *model, const MFData *d, const MFDesignSpec *ds,
+                       double *x, MFDesignResult *res)
+{
+	int       C = d->numcommodities, A = d->numarcs;
+	int       k, a, status;
+	int       error = 0;
+	char     *vtype = malloc(A + 1);
+	double   *open  = malloc(A*sizeof(double) + 1);
+	double    flow;
+	GRBmodel *lp = GRBcopymodel(model);
+
+	if (!vtype || !open || !lp) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+
+	/* LP relaxation */
+
+	for (a=0; a<A; a++)
+		vtype[a] = GRB_CONTINUOUS;
+	error = GRBsetcharattrarray(lp, GRB_CHAR_ATTR_VTYPE, C*A, A, vtype);
+	if (error) goto QUIT;
+	error = GRBoptimize(lp);
+	if (error) goto QUIT;
+	error = GRBgetintattr(lp, GRB_INT_ATTR_STATUS, &status);
+	if (error || status != GRB_OPTIMAL) goto QUIT;
+	error = GRBgetdblattr(lp, GRB_DBL_ATTR_OBJVAL, &res->lpobj);
+	if (error) goto QUIT;
+
+	/* Open every arc in use; the relaxation's flow still fits, so the
+	 * flows re-solved on the open arcs are feasible */
+
+	error = GRBgetdblattrarray(lp, GRB_DBL_ATTR_X, C*A, A, open);
+	if (error) goto QUIT;
+	for (a=0; a<A; a++)
+		open[a] = open[a] > 1e-6;
+	error = GRBsetdblattrarray(lp, GRB_DBL_ATTR_LB, C*A, A, open);
+	if (error) goto QUIT;
+	error = GRBsetdblattrarray(lp, GRB_DBL_ATTR_UB, C*A, A, open);
+	if (error) goto QUIT;
+	error = GRBoptimize(lp);
+	if (error) goto QUIT;
+	error = GRBgetintattr(lp, GRB_INT_ATTR_STATUS, &status);
+	if (error || status != GRB_OPTIMAL) goto QUIT;
+	error = GRBgetdblattr(lp, GRB_DBL_ATTR_OBJVAL, &res->startobj);
+	if (error) goto QUIT;
+	error = GRBgetdblattrarray(lp, GRB_DBL_ATTR_X, 0, C*A, x);
+	if (error) goto QUIT;
+
+	/* Close the arcs the re-solved flows leave unused */
+
+	for (a=0; a<A; a++) {
+		for (flow=0, k=0; k<C; k++)
+			flow += x[k*A+a];
+		if (open[a] && flow <= 1e-9) {
+			open[a] = 0;
+			res->startobj -= ds->fixed[a];
+		}
+		x[C*A+a] = open[a];
+	}
+	error = GRBsetdblattrarray(model, GRB_DBL_ATTR_START, 0, C*A+A, x);
+
+QUIT:
+	GRBfreemodel(lp);
+	free(vtype);
+	free(open);
+	return error;
+}
+
+int md_solve(GRBenv *env, const MFData *d, const MFDesignSpec *ds,
+             MFDesignResult *res)
+{
+	int       C = d->numcommodities, A = d->numarcs;
+	int       a, k, count;
+	int       error = 0;
+	double   *u = NULL;
+	GRBmodel *model = NULL;
+	LinkCuts  lc;
+	double    start;
+
+	memset(res, 0, sizeof(*res));
+	memset(&lc, 0, sizeof(lc));
+	res->objval   = GRB_INFINITY;
+	res->bound    = -GRB_INFINITY;
+	res->startobj = GRB_INFINITY;
+	res->lpobj    = GRB_INFINITY;
+	res->open     = calloc(A+1, sizeof(double));
+	res->flow     = calloc((size_t) C*A+1, sizeof(double));
+	u             = malloc((size_t) C*A*sizeof(double) + 1);
+	lc.x          = malloc(((size_t) C*A+A)*sizeof(double) + 1);
+	if (!res->open || !res->flow || !u || !lc.x) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+	flow_bounds(d, u);
+
+	error = GRBnewmodel(env, &model, "multi_flow_design", 0, NULL, NULL, NULL, NULL, NULL);
+	if (error) goto QUIT;
+	error = build(model, d, ds, u, &res->numlinking);
+	if (error) goto QUIT;
+
+	if (ds->mipstart) {
+		start = walltime();
+		error = round_start(model, d, ds, lc.x, res);
+		if (error) goto QUIT;
+		res->tstart = walltime() - start;
+	}
+
+	if (ds->linking == MD_LAZY) {
+		lc.d = d;
+		lc.u = u;
+		error = GRBsetintparam(GRBgetenv(model), GRB_INT_PAR_LAZYCONSTRAINTS, 1);
+		if (error) goto QUIT;
+		error = GRBsetcallbackfunc(model, link_callback, &lc);
+		if (error) goto QUIT;
+	}
+
+	start = walltime();
+	error = GRBoptimize(model);
+	if (error) goto QUIT;
+	res->tsolve = walltime() - start;
+	res->numlinking += lc.added;
+
+	error = GRBgetintattr(model, GRB_INT_ATTR_STATUS, &res->status);
+	if (error) goto QUIT;
+	error = GRBgetdblattr(model, GRB_DBL_ATTR_NODECOUNT, &res->nodes);
+	if (error) goto QUIT;
+	error = GRBgetintattr(model, GRB_INT_ATTR_SOLCOUNT, &count);
+	if (error || count == 0) goto QUIT;
+
+	error = GRBgetdblattr(model, GRB_DBL_ATTR_OBJVAL, &res->objval);
+	if (error) goto QUIT;
+	error = GRBgetdblattr(model, GRB_DBL_ATTR_OBJBOUND, &res->bound);
+	if (error) goto QUIT;
+	error = GRBgetdblattrarray(model, GRB_DBL_ATTR_X, 0, C*A, res->flow);
+	if (error) goto QUIT;
+	error = GRBgetdblattrarray(model, GRB_DBL_ATTR_X, C*A, A, res->open);
+	if (error) goto QUIT;
+	for (a=0; a<A; a++)
+		res->open[a] = res->open[a] > 0.5;
+	for (k=0; k<C*A; k++)
+		if (res->flow[k] < 1e-9) res->flow[k] = 0;
+
+QUIT:
+	GRBfreemodel(model);
+	free(u);
+	free(lc.x);
+	return error;
+}
+
+void md_free(MFDesignResult *res)
+{
+	free(res->open);
+	free(res->flow);
+	memset(res, 0, sizeof(*res));
+}
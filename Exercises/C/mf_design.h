@@ -0,0 +1,75 @@
+/* Fixed-charge network design for the multi commodity network flow.
+
+   Which arcs to build is a decision: arc a can carry flow only if it is
+   opened, at fixed[a], by the binary open[a].  The flows and their costs
+   are as in multi_flow.c:
+
+     min  sum_k,a cost[k,a] y[k,a] + sum_a fixed[a] open[a]
+     s.t. inflow - outflow >= demand[k,n]    (= 0 at transshipment nodes)
+          sum_k y[k,a] <= capacity[a] open[a]                      every a
+          0 <= y[k,a] <= u[k,a],  open[a] binary
+
+   with u[k,a] = min(capacity[a], supply of k, demand of k), no commodity
+   ever moving more than it has or needs.
+
+   The aggregated capacity row is enough for a correct model but its LP
+   relaxation is weak: open[a] only needs to pay for the fraction of the
+   capacity in use.  The per-commodity linking rows
+
+     y[k,a] <= u[k,a] open[a]
+
+   close most of that gap, but there are C times as many of them as arcs.
+   MD_LAZY leaves them out of the model and adds only the violated ones,
+   from node relaxations and candidate solutions, through a lazy
+   constraint callback; MD_STATIC adds all of them up front, MD_NONE
+   none, for comparison.  Rows with u[k,a] = capacity[a] are implied by
+   the aggregated one and never added.
+
+   The MIP start rounds the LP relaxation: every arc that carries flow in
+   it is opened, which always admits that flow, the flows are re-solved
+   with the other arcs closed, and arcs left without flow are closed too.
+*/
+
+#ifndef MF_DESIGN_H
+#define MF_DESIGN_H
+
+#include "gurobi_c.h"
+#include "mf_data.h"
+
+#define MD_NONE   0
+#define MD_LAZY   1
+#define MD_STATIC 2
+
+typedef struct {
+  double  *fixed;       /* [numarcs] cost of opening each arc */
+  int      linking;     /* MD_NONE, MD_LAZY or MD_STATIC */
+  int      mipstart;    /* 1 to start from the rounded LP relaxation */
+} MFDesignSpec;
+
+typedef struct {
+  int      status;      /* of the MIP solve */
+  double   objval;      /* best design found, GRB_INFINITY if none */
+  double   bound;
+  double   startobj;    /* of the MIP start, GRB_INFINITY if none */
+  double   lpobj;       /* LP relaxation the start was rounded from */
+  double  *open;        /* [numarcs] of the best design */
+  double  *flow;        /* [numcommodities*numarcs], d->cost layout */
+  int      numlinking;  /* linking rows added, lazily or up front */
+  double   nodes;
+  double   tstart;      /* seconds in the LP rounding */
+  double   tsolve;      /* seconds in the MIP solve */
+} MFDesignResult;
+
+/* md_solve
+ * inputs: env   loaded environment; its parameters (TimeLimit, MIPGap,
+ *               ...) apply to the MIP
+ *         d     instance
+ *         ds    fixed costs and formulation
+ * output: error code; res filled
+ */
+int md_solve(GRBenv *env, const MFData *d, const MFDesignSpec *ds,
+             MFDesignResult *res);
+
+void md_free(MFDesignResult *res);
+
+#endif
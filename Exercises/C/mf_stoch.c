@@ -0,0 +1,420 @@
+/* Two-stage stochastic multi commodity network flow, extensive form and
+   L-shaped method.  See mf_stoch.h */
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "mf_stoch.h"
+#include "walltime.h"
+
+/* Per worker: its own environment and subproblem, and a demand buffer */
+
+typedef struct {
+  GRBenv    *env;
+  GRBmodel  *model;
+  double    *demand;     /* [C*N] */
+} SubWorker;
+
+/* One round of subproblem solves at the master's x */
+
+typedef struct {
+  const MFData       *d;
+  const MFStochData  *sd;
+  const double       *xhat;  /* [A] */
+  SubWorker          *w;     /* [tp_size] */
+  double             *h;     /* [nscen] recourse costs */
+  double             *pi;    /* [nscen*A] capacity row duals */
+  pthread_mutex_t     lock;
+  int                 error;
+  int                 status; /* GRB_OPTIMAL unless a subproblem was not */
+} Round;
+
+static double prob(const MFStochData *sd, int s)
+{
+	return sd->prob ? sd->prob[s] : 1.0/sd->nscen;
+}
+
+/* add_recourse
+ * inputs: model   the variables added so far number yfirst
+ *         demand  [C*N] demand of the scenario
+ *         weight  factor of the recourse costs in the objective
+ *         xfirst  index of x[0] in model, or -1 to leave x out of the
+ *                 capacity rows and use xhat as their right hand sides
+ * output: error code; adds y[k,a] (at yfirst + k*A + a), s[k,n] (after
+ *         them), the C*N balance rows and the A capacity rows, in that
+ *         order
+ */
+static int add_recourse(GRBmodel *model, const MFData *d, const MFStochData *sd,
+                        const double *demand, double weight, int yfirst,
+                        int xfirst, const double *xhat)
+{
+	int     C = d->numcommodities, N = d->numnodes, A = d->numarcs;
+	int     nv = C*A + C*N, nr = C*N + A;
+	int     k, n, a, e, r, nz = 0;
+	int     error = 0;
+	double *obj   = malloc(nv*sizeof(double) + 1);
+	double *ub    = malloc(nv*sizeof(double) + 1);
+	double *rhs   = malloc(nr*sizeof(double) + 1);
+	char   *sense = malloc(nr + 1);
+	int    *cbeg  = malloc((nr+1)*sizeof(int));
+	int    *cind  = malloc(((size_t) 2*C*A + C*N + (size_t) A*(C+1))*sizeof(int) + 1);
+	double *cval  = malloc(((size_t) 2*C*A + C*N + (size_t) A*(C+1))*sizeof(double) + 1);
+
+	if (!obj || !ub || !rhs || !sense || !cbeg || !cind || !cval) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+
+	for (k=0; k<C; k++)
+		for (a=0; a<A; a++) {
+			obj[k*A+a] = weight*d->cost[k*A+a];
+			ub[k*A+a]  = GRB_INFINITY;
+		}
+	for (k=0; k<C*N; k++) {
+		obj[C*A+k] = weight*sd->penalty;
+		ub[C*A+k]  = d->demand[k] > 0 ? GRB_INFINITY : 0;
+	}
+	error = GRBaddvars(model, nv, 0, NULL, NULL, NULL, obj, NULL, ub, NULL, NULL);
+	if (error) goto QUIT;
+
+	/* Balance rows: inflow - outflow + shortage >= demand */
+
+	r = 0;
+	for (k=0; k<C; k++)
+		for (n=0; n<N; n++, r++) {
+			cbeg[r]  = nz;
+			sense[r] = GRB_GREATER_EQUAL;
+			rhs[r]   = demand[k*N+n];
+			for (e=d->inbeg[n]; e<d->inbeg[n+1]; e++, nz++) {
+				cind[nz] = yfirst + k*A + d->inarc[e];
+				cval[nz] = 1;
+			}
+			for (e=d->outbeg[n]; e<d->outbeg[n+1]; e++, nz++) {
+				cind[nz] = yfirst + k*A + e;
+				cval[nz] = -1;
+			}
+			cind[nz]   = yfirst + C*A + k*N + n;
+			cval[nz++] = 1;
+		}
+
+	/* Capacity rows: total flow <= installed capacity */
+
+	for (a=0; a<A; a++, r++) {
+		cbeg[r]  = nz;
+		sense[r] = GRB_LESS_EQUAL;
+		rhs[r]   = xfirst >= 0 ? 0 : xhat[a];
+		for (k=0; k<C; k++, nz++) {
+			cind[nz] = yfirst + k*A + a;
+			cval[nz] = 1;
+		}
+		if (xfirst >= 0) {
+			cind[nz]   = xfirst + a;
+			cval[nz++] = -1;
+		}
+	}
+	error = GRBaddconstrs(model, nr, nz, cbeg, cind, cval, sense, rhs, NULL);
+
+QUIT:
+	free(obj);
+	free(ub);
+	free(rhs);
+	free(sense);
+	free(cbeg);
+	free(cind);
+	free(cval);
+	return error;
+}
+
+/* start_sub
+ * output: error code; w has its own single threaded, silent environment
+ *         and the subproblem model
+ */
+static int start_sub(Round *r, SubWorker *w)
+{
+	const MFData *d = r->d;
+	int           error;
+
+	w->demand = malloc((size_t) d->numcommodities*d->numnodes*sizeof(double) + 1);
+	if (w->demand == NULL)
+		return GRB_ERROR_OUT_OF_MEMORY;
+	error = GRBemptyenv(&w->env);
+	if (error) return error;
+	error = GRBsetintparam(w->env, GRB_INT_PAR_OUTPUTFLAG, 0);
+	if (error) return error;
+	error = GRBsetintparam(w->env, GRB_INT_PAR_THREADS, 1);
+	if (error) return error;
+	error = GRBstartenv(w->env);
+	if (error) return error;
+
+	error = GRBnewmodel(w->env, &w->model, "multi_flow_recourse", 0, NULL, NULL, NULL, NULL, NULL);
+	if (error) return error;
+	return add_recourse(w->model, d, r->sd, d->demand, 1.0, 0, -1, r->xhat);
+}
+
+static void solve_sub(void *arg, int s, int worker)
+{
+	Round        *r = arg;
+	SubWorker    *w = &r->w[worker];
+	const MFData *d = r->d;
+	int           CN = d->numcommodities*d->numnodes, A = d->numarcs;
+	int           error, status = GRB_OPTIMAL;
+
+	pthread_mutex_lock(&r->lock);
+	error = r->error || r->status != GRB_OPTIMAL;
+	pthread_mutex_unlock(&r->lock);
+	if (error) return;
+
+	if (w->model == NULL) {
+		error = start_sub(r, w);
+		if (error) goto QUIT;
+	}
+
+	mf_scenario_demand(d, r->sd->spread, r->sd->seed, s, w->demand);
+	error = GRBsetdblattrarray(w->model, GRB_DBL_ATTR_RHS, 0, CN, w->demand);
+	if (error) goto QUIT;
+	error = GRBsetdblattrarray(w->model, GRB_DBL_ATTR_RHS, CN, A, (double *) r->xhat);
+	if (error) goto QUIT;
+	error = GRBoptimize(w->model);
+	if (error) goto QUIT;
+	error = GRBgetintattr(w->model, GRB_INT_ATTR_STATUS, &status);
+	if (error || status != GRB_OPTIMAL) goto QUIT;
+	error = GRBgetdblattr(w->model, GRB_DBL_ATTR_OBJVAL, &r->h[s]);
+	if (error) goto QUIT;
+	error = GRBgetdblattrarray(w->model, GRB_DBL_ATTR_PI, CN, A, r->pi + (size_t) s*A);
+
+QUIT:
+	if (error || status != GRB_OPTIMAL) {
+		pthread_mutex_lock(&r->lock);
+		if (error && !r->error) r->error = error;
+		if (status != GRB_OPTIMAL && r->status == GRB_OPTIMAL) r->status = status;
+		pthread_mutex_unlock(&r->lock);
+	}
+}
+
+int ms_extensive(GRBenv *env, const MFData *d, const MFStochData *sd,
+                 MFStochResult *res)
+{
+	int       C = d->numcommodities, N = d->numnodes, A = d->numarcs;
+	int       s, a;
+	int       error = 0;
+	double   *demand = NULL;
+	GRBmodel *model = NULL;
+	double    start = walltime();
+
+	memset(res, 0, sizeof(*res));
+	res->capacity = calloc(A+1, sizeof(double));
+	demand        = malloc((size_t) C*N*sizeof(double) + 1);
+	if (!res->capacity || !demand) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+
+	error = GRBnewmodel(env, &model, "multi_flow_extensive", A, sd->capcost, NULL,
+	                    d->capacity, NULL, NULL);
+	if (error) goto QUIT;
+	for (s=0; s<sd->nscen; s++) {
+		mf_scenario_demand(d, sd->spread, sd->seed, s, demand);
+		error = add_recourse(model, d, sd, demand, prob(sd, s),
+		                     A + s*(C*A + C*N), 0, NULL);
+		if (error) goto QUIT;
+	}
+
+	error = GRBoptimize(model);
+	if (error) goto QUIT;
+	error = GRBgetintattr(model, GRB_INT_ATTR_STATUS, &res->status);
+	if (error) goto QUIT;
+	res->iterations = 1;
+	if (res->status == GRB_OPTIMAL) {
+		error = GRBgetdblattr(model, GRB_DBL_ATTR_OBJVAL, &res->objval);
+		if (error) goto QUIT;
+		res->bound = res->objval;
+		error = GRBgetdblattrarray(model, GRB_DBL_ATTR_X, 0, A, res->capacity);
+		if (error) goto QUIT;
+		for (a=0; a<A; a++)
+			res->capcost += sd->capcost[a]*res->capacity[a];
+	}
+	res->tmaster = walltime() - start;
+
+QUIT:
+	free(demand);
+	GRBfreemodel(model);
+	return error;
+}
+
+int ms_lshaped(GRBenv *env, const MFData *d, const MFStochData *sd,
+               ThreadPool *tp, int groups, int maxiter, double tol,
+               MFStochResult *res)
+{
+	int       A = d->numarcs, K = sd->nscen;
+	int       s, a, g, k, nz, ncuts;
+	int       error = 0;
+	Round     r;
+	GRBmodel *master = NULL;
+	double   *xhat = NULL, *theta = NULL, *Q = NULL, *coef = NULL, *obj = NULL;
+	double   *rhs = NULL, *cval = NULL;
+	int      *cbeg = NULL, *cind = NULL;
+	char     *sense = NULL;
+	double    t, lb, ub, xcost;
+
+	if (groups < 1) groups = 1;
+	if (groups > K) groups = K;
+
+	memset(res, 0, sizeof(*res));
+	memset(&r, 0, sizeof(r));
+	pthread_mutex_init(&r.lock, NULL);
+	res->objval   = GRB_INFINITY;
+	res->bound    = -GRB_INFINITY;
+	res->capacity = calloc(A+1, sizeof(double));
+	xhat  = calloc(A+1, sizeof(double));
+	theta = malloc(groups*sizeof(double) + 1);
+	Q     = malloc(groups*sizeof(double) + 1);
+	coef  = malloc((size_t) groups*A*sizeof(double) + 1);
+	obj   = malloc((A+groups)*sizeof(double));
+	rhs   = malloc(groups*sizeof(double) + 1);
+	sense = malloc(groups + 1);
+	cbeg  = malloc((groups+1)*sizeof(int));
+	cind  = malloc((size_t) groups*(A+1)*sizeof(int));
+	cval  = malloc((size_t) groups*(A+1)*sizeof(double));
+	r.w   = calloc(tp_size(tp), sizeof(SubWorker));
+	r.h   = malloc(K*sizeof(double) + 1);
+	r.pi  = malloc((size_t) K*A*sizeof(double) + 1);
+	if (!res->capacity || !xhat || !theta || !Q || !coef || !obj || !rhs || !sense ||
+	    !cbeg || !cind || !cval || !r.w || !r.h || !r.pi) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+	r.d    = d;
+	r.sd   = sd;
+	r.xhat = xhat;
+
+	/* Master: x with its cost and bounds, then one theta >= 0 per group;
+	 * recourse costs are never negative */
+
+	for (a=0; a<A; a++) obj[a] = sd->capcost[a];
+	for (g=0; g<groups; g++) obj[A+g] = 1;
+	error = GRBnewmodel(env, &master, "multi_flow_master", A+groups, obj, NULL, NULL,
+	                    NULL, NULL);
+	if (error) goto QUIT;
+	error = GRBsetdblattrarray(master, GRB_DBL_ATTR_UB, 0, A, d->capacity);
+	if (error) goto QUIT;
+	error = GRBsetintparam(GRBgetenv(master), GRB_INT_PAR_OUTPUTFLAG, 0);
+	if (error) goto QUIT;
+
+	for (;;) {
+		t = walltime();
+		error = GRBoptimize(master);
+		if (error) goto QUIT;
+		res->iterations++;
+		error = GRBgetintattr(master, GRB_INT_ATTR_STATUS, &res->status);
+		if (error || res->status != GRB_OPTIMAL) goto QUIT;
+		error = GRBgetdblattr(master, GRB_DBL_ATTR_OBJVAL, &lb);
+		if (error) goto QUIT;
+		error = GRBgetdblattrarray(master, GRB_DBL_ATTR_X, 0, A, xhat);
+		if (error) goto QUIT;
+		error = GRBgetdblattrarray(master, GRB_DBL_ATTR_X, A, groups, theta);
+		if (error) goto QUIT;
+		res->tmaster += walltime() - t;
+		if (lb > res->bound) res->bound = lb;
+
+		/* All scenarios at xhat, in parallel */
+
+		t = walltime();
+		r.status = GRB_OPTIMAL;
+		tp_run(tp, K, solve_sub, &r);
+		res->tsub += walltime() - t;
+		error = r.error;
+		if (error) goto QUIT;
+		if (r.status != GRB_OPTIMAL) {
+			res->status = r.status;
+			goto QUIT;
+		}
+
+		/* Expected recourse cost and its subgradient per group, summed in
+		 * scenario order so the result does not depend on the workers */
+
+		memset(Q, 0, groups*sizeof(double));
+		memset(coef, 0, (size_t) groups*A*sizeof(double));
+		for (s=0; s<K; s++) {
+			double p = prob(sd, s);
+			g = (int) ((long long) s*groups/K);
+			Q[g] += p*r.h[s];
+			for (a=0; a<A; a++)
+				coef[(size_t) g*A+a] += p*r.pi[(size_t) s*A+a];
+		}
+		xcost = 0;
+		for (a=0; a<A; a++) xcost += sd->capcost[a]*xhat[a];
+		ub = xcost;
+		for (g=0; g<groups; g++) ub += Q[g];
+		if (ub < res->objval) {
+			res->objval  = ub;
+			res->capcost = xcost;
+			memcpy(res->capacity, xhat, A*sizeof(double));
+		}
+		if (res->objval - res->bound <= tol*fmax(1.0, fabs(res->objval)))
+			break;
+
+		/* Optimality cuts theta[g] - coef x >= Q - coef xhat of the groups
+		 * whose theta underestimates them, added in one call */
+
+		ncuts = nz = 0;
+		for (g=0; g<groups; g++) {
+			double *cg = coef + (size_t) g*A;
+			if (theta[g] >= Q[g] - 1e-9*fmax(1.0, fabs(Q[g])))
+				continue;
+			cbeg[ncuts]  = nz;
+			sense[ncuts] = GRB_GREATER_EQUAL;
+			rhs[ncuts]   = Q[g];
+			cind[nz]     = A+g;
+			cval[nz++]   = 1;
+			for (a=0; a<A; a++)
+				if (cg[a] != 0) {
+					cind[nz]   = a;
+					cval[nz++] = -cg[a];
+					rhs[ncuts] -= cg[a]*xhat[a];
+				}
+			ncuts++;
+		}
+		if (ncuts == 0)
+			break;
+		error = GRBaddconstrs(master, ncuts, nz, cbeg, cind, cval, sense, rhs, NULL);
+		if (error) goto QUIT;
+		res->numcuts += ncuts;
+
+		if (maxiter > 0 && res->iterations >= maxiter) {
+			res->status = GRB_ITERATION_LIMIT;
+			break;
+		}
+	}
+
+QUIT:
+	if (r.w)
+		for (k=0; k<tp_size(tp); k++) {
+			GRBfreemodel(r.w[k].model);
+			GRBfreeenv(r.w[k].env);
+			free(r.w[k].demand);
+		}
+	free(r.w);
+	free(r.h);
+	free(r.pi);
+	pthread_mutex_destroy(&r.lock);
+	GRBfreemodel(master);
+	free(xhat);
+	free(theta);
+	free(Q);
+	free(coef);
+	free(obj);
+	free(rhs);
+	free(sense);
+	free(cbeg);
+	free(cind);
+	free(cval);
+	return error;
+}
+
+void ms_free(MFStochResult *res)
+{
+	free(res->capacity);
+	res->capacity = NULL;
+}
@@ -0,0 +1,89 @@
+/* Two-stage stochastic multi commodity network flow.
+
+   The arc capacities become a first-stage decision: before the demands
+   are known, x[a] units of capacity are installed on arc a, at most
+   capacity[a] of them, at capcost[a] per unit.  Then one of nscen demand
+   scenarios is revealed and the flows respond to it.  Demand that cannot
+   be met is bought elsewhere at penalty per unit, so every scenario is
+   feasible whatever x is (complete recourse):
+
+     min  capcost x + sum_w p_w h_w(x)
+
+     h_w(x) = min  sum_k,a cost[k,a] y[k,a] + penalty sum_k,n s[k,n]
+              s.t. inflow - outflow + s[k,n] >= demand_w[k,n]   every k, n
+                   sum_k y[k,a] <= x[a]                         every a
+                   y, s >= 0, s = 0 where the base demand is not positive
+
+   ms_extensive builds the deterministic equivalent, one copy of y and s
+   per scenario, which needs memory for all of them at once.
+
+   ms_lshaped solves it by the L-shaped method (Benders decomposition).
+   The master LP holds x and one variable theta[g] per group of scenarios,
+   bounding their expected recourse cost from below.  Every iteration
+   solves the scenario subproblems at the master's x in parallel, one
+   environment and subproblem model per worker of the pool, and turns the
+   subproblem objectives and capacity row duals of each group into one
+   optimality cut
+
+     theta[g] >= sum_w in g p_w (h_w(xhat) + pi_w (x - xhat))
+
+   which are added to the master in one batch.  One group gives the single
+   cut method, nscen groups the multi-cut method; in between the master
+   grows by groups rows per iteration.  Memory is one subproblem per
+   worker plus the objective and capacity duals of every scenario.
+*/
+
+#ifndef MF_STOCH_H
+#define MF_STOCH_H
+
+#include <stdint.h>
+#include "gurobi_c.h"
+#include "mf_data.h"
+#include "threadpool.h"
+
+typedef struct {
+  int      nscen;
+  double  *prob;        /* [nscen] scenario probabilities, NULL for equal */
+  double   spread;      /* demand of scenario s is mf_scenario_demand(d, */
+  uint64_t seed;        /*   spread, seed, s), made when it is needed */
+  double  *capcost;     /* [numarcs] cost per unit of installed capacity */
+  double   penalty;     /* cost per unit of unmet demand */
+} MFStochData;
+
+typedef struct {
+  int      status;      /* GRB_OPTIMAL, GRB_ITERATION_LIMIT, or the status
+                           of a master or subproblem that failed */
+  double   objval;      /* best expected cost found (upper bound) */
+  double   bound;       /* lower bound, the last master objective */
+  int      iterations;  /* master solves */
+  int      numcuts;
+  double  *capacity;    /* [numarcs] installed capacity of the best x */
+  double   capcost;     /* first-stage cost of the best x */
+  double   tmaster;     /* seconds in master solves */
+  double   tsub;        /* seconds in subproblem rounds */
+} MFStochResult;
+
+/* ms_extensive
+ * inputs: env  loaded environment
+ *         d    instance, its capacities the upper bounds on x
+ *         sd   scenarios and costs
+ * output: error code; res filled (bound = objval for an optimal solve)
+ */
+int ms_extensive(GRBenv *env, const MFData *d, const MFStochData *sd,
+                 MFStochResult *res);
+
+/* ms_lshaped
+ * inputs: env      environment for the master
+ *         tp       pool the subproblems are solved on
+ *         groups   optimality cuts per iteration, 1..nscen
+ *         maxiter  limit on master solves, <= 0 for none
+ *         tol      relative gap between the bounds to stop at
+ * output: error code; res filled
+ */
+int ms_lshaped(GRBenv *env, const MFData *d, const MFStochData *sd,
+               ThreadPool *tp, int groups, int maxiter, double tol,
+               MFStochResult *res);
+
+void ms_free(MFStochResult *res);
+
+#endif
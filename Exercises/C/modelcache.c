@@ -0,0 +1,74 @@
+/* Cache of built models.  See modelcache.h */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "modelcache.h"
+
+uint64_t mc_hash(uint64_t h, const void *p, size_t len)
+{
+	const unsigned char *s = p;
+
+	while (len--) {
+		h ^= *s++;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+char *mc_path(const char *dir, const char *name, uint64_t key, char *buf, size_t len)
+{
+	int n = snprintf(buf, len, "%s/%s-%016llx.mps.gz", dir, name, (unsigned long long) key);
+
+	return n >= 0 && (size_t) n < len ? buf : NULL;
+}
+
+int mc_load(GRBenv *env, const char *dir, const char *name, uint64_t key, GRBmodel **model)
+{
+	char path[4096];
+
+	*model = NULL;
+	if (mc_path(dir, name, key, path, sizeof(path)) == NULL || access(path, R_OK) != 0)
+		return 0;
+
+	/* A truncated or otherwise unreadable entry is a miss: the caller
+	   builds the model and mc_store replaces the entry */
+	if (GRBreadmodel(env, path, model) != 0)
+		*model = NULL;
+	return 0;
+}
+
+int mc_store(GRBmodel *model, const char *dir, const char *name, uint64_t key)
+{
+	char path[4096], tmp[4096];
+	int  error;
+
+	if (mkdir(dir, 0777) != 0 && errno != EEXIST)
+		return -1;
+	if (mc_path(dir, name, key, path, sizeof(path)) == NULL) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+
+	/* The extension tells GRBwrite the format, so it stays at the end */
+
+	if (snprintf(tmp, sizeof(tmp), "%.*s.%ld.tmp.mps.gz", (int) (strlen(path) - 7), path,
+	             (long) getpid()) >= (int) sizeof(tmp)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	error = GRBwrite(model, tmp);
+	if (error) {
+		unlink(tmp);
+		return error;
+	}
+	if (rename(tmp, path) != 0) {
+		int e = errno;
+		unlink(tmp);
+		errno = e;
+		return -1;
+	}
+	return 0;
+}
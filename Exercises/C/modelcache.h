@@ -0,0 +1,57 @@
+/* Cache of built models, keyed by a hash of what they were built from.
+
+   Building a large model through the API costs far more than reading it
+   back, so a driver hashes its input data and every parameter that shapes
+   the model into a 64-bit key and looks the key up before building:
+
+     key = mc_hash(mf_hash(&data), &params, sizeof(params));
+     error = mc_load(env, "cache", "multi_flow", key, &model);
+     if (!error && model == NULL) {
+       ... build the model ...
+       mc_store(model, "cache", "multi_flow", key);
+     }
+
+   Entries are compressed MPS files, dir/name-<key>.mps.gz, which keep the
+   variable and constraint order, bounds and objective sense.  MPS cannot
+   hold names with spaces, so a model whose names may have them is best
+   stored without names and named again after mc_load.  Entries are
+   written under a temporary name and renamed into place, so a reader never
+   sees half an entry and concurrent runs may share the directory.  Nothing
+   is ever evicted; delete the directory to clear the cache.  Bump the
+   version in the parameters when the way the model is built changes.
+*/
+
+#ifndef MODELCACHE_H
+#define MODELCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "gurobi_c.h"
+
+/* mc_hash
+ * inputs: h  hash so far, len bytes at p to add
+ * output: the updated 64-bit FNV-1a hash
+ */
+uint64_t mc_hash(uint64_t h, const void *p, size_t len);
+
+/* mc_path
+ * output: the entry file name of key in buf, NULL if it does not fit
+ */
+char *mc_path(const char *dir, const char *name, uint64_t key, char *buf, size_t len);
+
+/* mc_load
+ * inputs: env        environment to read the model into
+ *         dir, name  cache directory and model name
+ * output: 0; *model is the cached model, or NULL on a miss.  An entry
+ *         that cannot be read is a miss too.
+ */
+int mc_load(GRBenv *env, const char *dir, const char *name, uint64_t key, GRBmodel **model);
+
+/* mc_store
+ * inputs: model  built and updated
+ * output: 0, a Gurobi error code from writing the entry, or -1 with errno
+ *         set if dir could not be created or the entry not put in place
+ */
+int mc_store(GRBmodel *model, const char *dir, const char *name, uint64_t key);
+
+#endif
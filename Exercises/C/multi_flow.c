@@ -35,46 +35,616 @@ demand = {
   ('Pens',    'Seattle'):  30 }
 
 */
-
+#include <errno.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include "gurobi_c.h"
-#include "multi_flow.h"
+#include "mf_data.h"
+#include "name_arena.h"
+#include "threadpool.h"
+#include "mf_colgen.h"
+#include "sweep.h"
+#include "solvetrace.h"
+#include "phase.h"
+#include "modelcache.h"
+#include "scenario.h"
+#include "mf_stoch.h"
+#include "mf_design.h"
+#include "walltime.h"
+
+/* Usage:  multi_flow [-loop] [-nonames] [-bench reps] [-convert out.mfb]
+                      [-cg threads] [-sweep arc lo hi steps [-cold]]
+                      [-trace out.mlog] [-phases report.json]
+                      [-cache dir] [-write file]
+                      [-scenarios count spread [-seed n] [-policy auto|solves|threads]
+                       [-workers n]]
+                      [-stochastic count spread [-capcost c] [-penalty p]
+                       [-groups n] [-extensive] [-seed n] [-workers n]]
+                      [-design fixed [-linking lazy|static|none] [-nostart]
+                       [-timelimit secs]]
+                      [datafile]
+
+   Without a datafile the instance above (multi_flow.h) is solved.  A
+   datafile is either CSV or binary .mfb, see mf_data.h; -convert writes the
+   loaded instance as .mfb and exits.  -cg solves by column generation
+   (mf_colgen.h) instead of the arc formulation, pricing the commodities on
+   the given number of threads (0 for one per processor).  -sweep scales
+   the cost of arc number arc for every commodity by steps factors from lo
+   to hi and re-solves warm from the previous basis at each one (sweep.h);
+   arcs are numbered from 0 in the order mf_data.h keeps them, sorted by
+   tail node and in file order within a tail, and the arc swept is named
+   before the sweep starts; -cold makes every point a cold solve.  -trace
+   records the progress of the solve from a callback and writes it as a
+   log store for logquery (solvetrace.h).  -phases times the phases of the
+   run (load, environment, build, update, write, optimize, extract) with
+   their RSS and writes them as a JSON report (phase.h).  -cache reads the
+   model from dir when the same data was built before, and otherwise
+   builds it and adds it there (modelcache.h).  -write writes the model to
+   file, in the format its extension names (.lp, .mps, ...), for debugging.
+   -scenarios solves count demand scenarios concurrently, each demand
+   scaled by a factor drawn uniformly from [1-spread, 1+spread] and the
+   supplies of every commodity by its change in total demand, and reports
+   objective and dual statistics over them; -policy and -workers split the
+   cores between concurrent solves and their Threads, -workers more solves
+   than cores oversubscribing them (scenario.h).  -stochastic makes the arc
+   capacities a first-stage decision, at most the given capacity at capcost
+   per unit (default 1), against count demand scenarios made as for
+   -scenarios, unmet demand costing penalty per unit (default 10 times the
+   largest arc cost).  It is solved by the L-shaped method with subproblems
+   in parallel on -workers threads and -groups optimality cuts per
+   iteration, or with -extensive as one deterministic equivalent LP
+   (mf_stoch.h).  -design makes opening every arc a binary decision that
+   costs fixed, and solves the fixed-charge network design MIP
+   (mf_design.h) from a MIP start rounded from its LP relaxation, -nostart
+   without one.  The per-commodity linking rows are added lazily from a
+   callback by default, -linking static adds them all to the model and
+   -linking none leaves them out.  -timelimit stops the MIP after secs
+   seconds with the best design found.
+
+   Build with mf_data.c, csvread.c, name_arena.c, threadpool.c,
+   mf_colgen.c, sweep.c, solvetrace.c, phase.c, modelcache.c, scenario.c,
+   mf_stoch.c, mf_design.c, -lm and -lpthread.
+*/
+
+/* Row layout derived from the network: one flow conservation row per
+ * commodity and node, grouped into supply rows (nodes that supply the
+ * commodity), demand rows (nodes that demand it) and transshipment rows
+ * (nodes with arcs and zero demand), followed by one capacity row per arc */
+
+/* Part of the model cache key: bump it whenever build_loop and
+ * build_batched change the model they build */
+
+#define MF_MODEL_VERSION 2
+
+#define SUPPLYROW 0
+#define DEMANDROW 1
+#define FLOWROW   2
+
+char *rowprefix[3] = { "supply", "demand", "flow" };
+char  rowsense[3]  = { GRB_LESS_EQUAL, GRB_GREATER_EQUAL, GRB_EQUAL };
+
+typedef struct {
+  int     *rowkn;      /* node row r: commodity rowkn[r]/N at node rowkn[r]%N */
+  int      numrows[3]; /* supply, demand and transshipment rows, in that order */
+  size_t  *lencom;     /* [numcommodities] strlen of each commodity name */
+  size_t  *lennode;    /* [numnodes] strlen of each node name */
+} MFRows;
+
+/* mf_rows
+ * inputs: d  instance
+ * output: 0 on success; x holds the node rows of every family
+ */
+int mf_rows(const MFData *d, MFRows *x)
+{
+	int    C = d->numcommodities, N = d->numnodes;
+	int    f, k, n, r = 0;
+	double b;
+
+	memset(x, 0, sizeof(*x));
+	x->rowkn   = malloc(((size_t) C*N > 0 ? (size_t) C*N : 1)*sizeof(int));
+	x->lencom  = malloc((C > 0 ? C : 1)*sizeof(size_t));
+	x->lennode = malloc((N > 0 ? N : 1)*sizeof(size_t));
+	if (!x->rowkn || !x->lencom || !x->lennode)
+		return 1;
 
-/* mknam
- * inputs: r, s, t:  Non-NULL strings (but 0 length ok)
- * output: ptr to malloc'd concatenated string separated by two underscores: "r_s_t"
- *         ****** free the returned ptr when no longer needed ******
+	for (f=SUPPLYROW; f<=FLOWROW; f++)
+		for (k=0; k<C; k++)
+			for (n=0; n<N; n++) {
+				b = d->demand[k*N+n];
+				if ((f == SUPPLYROW && b < 0) || (f == DEMANDROW && b > 0) ||
+				    (f == FLOWROW && b == 0 &&
+				     (d->outbeg[n+1] > d->outbeg[n] || d->inbeg[n+1] > d->inbeg[n]))) {
+					x->rowkn[r++] = k*N+n;
+					x->numrows[f]++;
+				}
+			}
+
+	for (n=0; n<C; n++) x->lencom[n]  = strlen(d->commodity[n]);
+	for (n=0; n<N; n++) x->lennode[n] = strlen(d->node[n]);
+	return 0;
+}
+
+void mf_rows_free(MFRows *x)
+{
+	free(x->rowkn);
+	free(x->lencom);
+	free(x->lennode);
+	memset(x, 0, sizeof(*x));
+}
+
+/* rowkind
+ * output: SUPPLYROW, DEMANDROW or FLOWROW for node row r
  */
-char *mknam(char *r, char *s, char *t)
+int rowkind(const MFRows *x, int r)
+{
+	if (r < x->numrows[SUPPLYROW]) return SUPPLYROW;
+	if (r < x->numrows[SUPPLYROW]+x->numrows[DEMANDROW]) return DEMANDROW;
+	return FLOWROW;
+}
+
+/* Model dimensions */
+
+int numvars(const MFData *d)
 {
-	int size = strlen(r)+strlen(s)+strlen(t)+3;
-	char * ptr = malloc(size);
-	strcpy(ptr, r);
-	strcat(ptr,"_");
-	strcat(ptr, s);
-	strcat(ptr,"_");
-	strcat(ptr, t);
-	return ptr;
+	return d->numcommodities*d->numarcs;
+}
+
+int numnoderows(const MFRows *x)
+{
+	return x->numrows[SUPPLYROW]+x->numrows[DEMANDROW]+x->numrows[FLOWROW];
+}
+
+int numconstrs(const MFData *d, const MFRows *x)
+{
+	return numnoderows(x) + d->numarcs;
+}
+
+/* names_size
+ * output: exact number of bytes needed to hold every variable and
+ *         constraint name of the model, terminating '\0's included
+ */
+size_t names_size(const MFData *d, const MFRows *x)
+{
+	size_t lc = 0, la = 0, lr = 0;
+	size_t C = d->numcommodities, A = d->numarcs;
+	int    i, N = d->numnodes;
+
+	for (i=0; i<d->numcommodities; i++) lc += x->lencom[i];
+	for (i=0; i<d->numarcs; i++)
+		la += x->lennode[d->tail[i]] + x->lennode[d->head[i]];
+	for (i=0; i<numnoderows(x); i++)
+		lr += strlen(rowprefix[rowkind(x, i)]) + 3
+		    + x->lencom[x->rowkn[i]/N] + x->lennode[x->rowkn[i]%N];
+
+	return A*lc + C*la + 3*C*A                  /* commodity_tail_head */
+	     + lr                                    /* supply|demand|flow_commodity_node */
+	     + A*(strlen("capacity")+3) + la;        /* capacity_tail_head */
 }
 
 /* varind
- * inputs: i  index into Commodity array
- *         j  index into Source array
- *         k  index into Destination array
- * output  index for variable(Commodity,Source,Destination)
- *         If there are 3 Destinations and 2 Sources, then
- *         (0,0,0) -> 0
- *         (0,0,1) -> 1
- *         (0,0,2) -> 2
- *         (0,1,0) -> 3
- *         (0,1,1) -> 4
+ * inputs: k  index into the commodities
+ *         a  index into the (CSR ordered) arcs
+ * output  index for variable(Commodity,Tail,Head)
+ *         If there are 6 arcs, then
+ *         (0,0) -> 0
+ *         (0,1) -> 1
+ *         (0,5) -> 5
+ *         (1,0) -> 6
  *         etc.
  */
-int varind(int i, int j, int k)
+int varind(const MFData *d, int k, int a)
+{
+	return k*d->numarcs+a;
+}
+
+/* varname
+ * inputs: ind  variable index as returned by varind
+ *         buf  output buffer of len bytes
+ * output: buf holds "commodity_tail_head"; inverts varind so that
+ *         models built without names can still be reported
+ */
+void varname(const MFData *d, int ind, char *buf, size_t len)
+{
+	int k = ind/d->numarcs;
+	int a = ind%d->numarcs;
+	snprintf(buf, len, "%s_%s_%s", d->commodity[k],
+	         d->node[d->tail[a]], d->node[d->head[a]]);
+}
+
+/* constrname
+ * inputs: row  constraint index
+ *         buf  output buffer of len bytes
+ * output: buf holds the name the row would have been given
+ */
+void constrname(const MFData *d, const MFRows *x, int row, char *buf, size_t len)
+{
+	int a, N = d->numnodes;
+
+	if (row < numnoderows(x)) {
+		snprintf(buf, len, "%s_%s_%s", rowprefix[rowkind(x, row)],
+		         d->commodity[x->rowkn[row]/N], d->node[x->rowkn[row]%N]);
+		return;
+	}
+	a = row - numnoderows(x);
+	snprintf(buf, len, "capacity_%s_%s", d->node[d->tail[a]], d->node[d->head[a]]);
+}
+
+/* node_row
+ * inputs: r         node row index
+ *         ind, val  output buffers, large enough for the degree of the node
+ * output: number of nonzeros; *rhs receives the right hand side.  Supply
+ *         rows read outflow - inflow <= supply, demand and transshipment
+ *         rows read inflow - outflow >= demand (resp. = 0)
+ */
+int node_row(const MFData *d, const MFRows *x, int r, int *ind, double *val, double *rhs)
 {
-	return i*(NUMSOURCES*NUMDESTINATIONS)+j*(NUMDESTINATIONS)+k;
+	int    N = d->numnodes;
+	int    k = x->rowkn[r]/N, n = x->rowkn[r]%N;
+	double sign = rowkind(x, r) == SUPPLYROW ? 1.0 : -1.0;
+	int    e, nz = 0;
+
+	for (e=d->outbeg[n]; e<d->outbeg[n+1]; e++, nz++) {
+		ind[nz] = varind(d,k,e);
+		val[nz] = sign;
+	}
+	for (e=d->inbeg[n]; e<d->inbeg[n+1]; e++, nz++) {
+		ind[nz] = varind(d,k,d->inarc[e]);
+		val[nz] = -sign;
+	}
+	*rhs = -sign*d->demand[x->rowkn[r]];
+	return nz;
+}
+
+/* build_loop
+ * inputs: model     empty model
+ *         d, x      instance and its row layout
+ *         usenames  0 to leave variables and constraints unnamed
+ * output: error code; adds every variable with its own GRBaddvar call and
+ *         every row with its own GRBaddconstr call
+ */
+int build_loop(GRBmodel *model, const MFData *d, const MFRows *x, int usenames)
+{
+	int        C = d->numcommodities, N = d->numnodes, A = d->numarcs;
+	int        k,a,r,nz;
+	int        error = 0;
+	int       *ind = NULL;
+	double    *val = NULL;
+	double     rhs;
+	NameArena  arena = { NULL, 0, 0 };
+
+	/* No node has more than numarcs arcs, no arc more than C commodities */
+
+	ind = malloc((A > C ? A : C)*sizeof(int) + 1);
+	val = malloc((A > C ? A : C)*sizeof(double) + 1);
+	if (!ind || !val || (usenames && arena_init(&arena, names_size(d, x)))) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+
+	/* Add variables: one flow variable for each commodity,arc combo */
+
+	for ( k=0; k<C; k++)
+	{
+		for ( a=0; a<A; a++)
+		{
+			error = GRBaddvar(model, 0, NULL, NULL, d->cost[varind(d,k,a)],
+					0, d->capacity[a], GRB_CONTINUOUS,
+					usenames ? arena_mknam(&arena, d->commodity[k], x->lencom[k],
+					                       d->node[d->tail[a]], x->lennode[d->tail[a]],
+					                       d->node[d->head[a]], x->lennode[d->head[a]]) : NULL);
+			if (error) goto QUIT;
+		}
+	}
+
+	/* Integrate new variables */
+
+	error = GRBupdatemodel(model);
+	if (error) goto QUIT;
+
+	/* Flow conservation constraints: supply, demand and transshipment rows */
+
+	for ( r=0; r<numnoderows(x); r++)
+	{
+		nz = node_row(d, x, r, ind, val, &rhs);
+		error = GRBaddconstr(model, nz, ind, val, rowsense[rowkind(x, r)], rhs,
+				usenames ? arena_mknam(&arena, rowprefix[rowkind(x, r)],
+				                       strlen(rowprefix[rowkind(x, r)]),
+				                       d->commodity[x->rowkn[r]/N], x->lencom[x->rowkn[r]/N],
+				                       d->node[x->rowkn[r]%N], x->lennode[x->rowkn[r]%N]) : NULL);
+		if (error) goto QUIT;
+	}
+
+	/* Capacity constraints: one for each arc */
+
+	for( a=0; a<A; a++)
+	{
+		for (k=0; k<C; k++)
+		{
+			ind[k] = varind(d,k,a);
+			val[k] = 1;
+		}
+		error = GRBaddconstr(model, C, ind, val, GRB_LESS_EQUAL,
+				d->capacity[a],
+				usenames ? arena_mknam(&arena, "capacity", 8,
+				                       d->node[d->tail[a]], x->lennode[d->tail[a]],
+				                       d->node[d->head[a]], x->lennode[d->head[a]]) : NULL);
+		if (error) goto QUIT;
+	}
+
+QUIT:
+	arena_free(&arena);
+	free(val);
+	free(ind);
+	return error;
+}
+
+/* build_batched
+ * inputs: model     empty model
+ *         d, x      instance and its row layout
+ *         usenames  0 to leave variables and constraints unnamed
+ * output: error code; assembles all columns and each constraint family as
+ *         CSR buffers (cbeg/cind/cval) and loads them with one GRBaddvars
+ *         call and one GRBaddconstrs call per family
+ */
+int build_batched(GRBmodel *model, const MFData *d, const MFRows *x, int usenames)
+{
+	int        C = d->numcommodities, N = d->numnodes, A = d->numarcs;
+	int        f,k,a,n,r,first,nz;
+	int        error = 0;
+	int        nvars = numvars(d);
+	int        maxrows;
+	double    *ub = NULL, *rhs = NULL, *cval = NULL;
+	int       *cbeg = NULL, *cind = NULL;
+	char      *sense = NULL;
+	char     **names = NULL;
+	NameArena  arena = { NULL, 0, 0 };
+
+	/* The largest family decides the buffer sizes.  A variable appears in
+	 * the node rows of its tail and its head and in one capacity row, so
+	 * 2*nvars nonzeros suffice for any family */
+
+	maxrows = nvars;
+	for (f=SUPPLYROW; f<=FLOWROW; f++)
+		if (x->numrows[f] > maxrows) maxrows = x->numrows[f];
+	if (A > maxrows) maxrows = A;
+
+	ub    = malloc(nvars*sizeof(double) + 1);
+	rhs   = malloc(maxrows*sizeof(double) + 1);
+	sense = malloc(maxrows + 1);
+	cbeg  = malloc((maxrows+1)*sizeof(int));
+	cind  = malloc(2*(size_t) nvars*sizeof(int) + 1);
+	cval  = malloc(2*(size_t) nvars*sizeof(double) + 1);
+	if (usenames)
+		names = malloc(maxrows*sizeof(char *) + 1);
+	if (!ub || !rhs || !sense || !cbeg || !cind || !cval ||
+	    (usenames && (!names || arena_init(&arena, names_size(d, x))))) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+
+	/* Columns: one flow variable for each commodity,arc combo; the cost
+	 * array is already in variable order */
+
+	for (k=0; k<C; k++)
+		for (a=0; a<A; a++) {
+			r = varind(d,k,a);
+			ub[r] = d->capacity[a];
+			if (names)
+				names[r] = arena_mknam(&arena, d->commodity[k], x->lencom[k],
+				                       d->node[d->tail[a]], x->lennode[d->tail[a]],
+				                       d->node[d->head[a]], x->lennode[d->head[a]]);
+		}
+
+	error = GRBaddvars(model, nvars, 0, NULL, NULL, NULL, d->cost, NULL, ub, NULL, names);
+	if (error) goto QUIT;
+
+	error = GRBupdatemodel(model);
+	if (error) goto QUIT;
+
+	/* Flow conservation constraints: one call each for the supply, demand
+	 * and transshipment rows */
+
+	first = 0;
+	for (f=SUPPLYROW; f<=FLOWROW; f++) {
+		nz = 0;
+		for (r=0; r<x->numrows[f]; r++) {
+			k = x->rowkn[first+r]/N;
+			n = x->rowkn[first+r]%N;
+			cbeg[r]  = nz;
+			sense[r] = rowsense[f];
+			nz += node_row(d, x, first+r, cind+nz, cval+nz, &rhs[r]);
+			if (names)
+				names[r] = arena_mknam(&arena, rowprefix[f], strlen(rowprefix[f]),
+				                       d->commodity[k], x->lencom[k],
+				                       d->node[n], x->lennode[n]);
+		}
+		error = GRBaddconstrs(model, x->numrows[f], nz, cbeg, cind, cval, sense, rhs, names);
+		if (error) goto QUIT;
+		first += x->numrows[f];
+	}
+
+	/* Capacity constraints: one for each arc */
+
+	r = nz = 0;
+	for (a=0; a<A; a++, r++) {
+		cbeg[r]  = nz;
+		sense[r] = GRB_LESS_EQUAL;
+		rhs[r]   = d->capacity[a];
+		if (names)
+			names[r] = arena_mknam(&arena, "capacity", 8,
+			                       d->node[d->tail[a]], x->lennode[d->tail[a]],
+			                       d->node[d->head[a]], x->lennode[d->head[a]]);
+		for (k=0; k<C; k++, nz++) {
+			cind[nz] = varind(d,k,a);
+			cval[nz] = 1;
+		}
+	}
+	error = GRBaddconstrs(model, r, nz, cbeg, cind, cval, sense, rhs, names);
+	if (error) goto QUIT;
+
+QUIT:
+	arena_free(&arena);
+	free(names);
+	free(cval);
+	free(cind);
+	free(cbeg);
+	free(sense);
+	free(rhs);
+	free(ub);
+	return error;
+}
+
+/* name_model
+ * inputs: model  built without names and updated
+ *         d, x   instance and its row layout
+ * output: error code; gives every variable and constraint the name the
+ *         builds would have, so that cache entries can be written without
+ *         names (MPS cannot hold names with spaces) and named after reading
+ */
+int name_model(GRBmodel *model, const MFData *d, const MFRows *x)
+{
+	int        C = d->numcommodities, N = d->numnodes, A = d->numarcs;
+	int        k,a,n,r;
+	int        error = 0;
+	int        nvars = numvars(d), nrows = numnoderows(x);
+	const char *pre;
+	char     **names = NULL;
+	NameArena  arena = { NULL, 0, 0 };
+
+	names = malloc((nvars > nrows+A ? nvars : nrows+A)*sizeof(char *) + 1);
+	if (!names || arena_init(&arena, names_size(d, x))) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+
+	for (k=0; k<C; k++)
+		for (a=0; a<A; a++)
+			names[varind(d,k,a)] = arena_mknam(&arena, d->commodity[k], x->lencom[k],
+			                                   d->node[d->tail[a]], x->lennode[d->tail[a]],
+			                                   d->node[d->head[a]], x->lennode[d->head[a]]);
+	error = GRBsetstrattrarray(model, GRB_STR_ATTR_VARNAME, 0, nvars, names);
+	if (error) goto QUIT;
+
+	for (r=0; r<nrows; r++) {
+		k = x->rowkn[r]/N;
+		n = x->rowkn[r]%N;
+		pre = rowprefix[rowkind(x, r)];
+		names[r] = arena_mknam(&arena, pre, strlen(pre), d->commodity[k], x->lencom[k],
+		                       d->node[n], x->lennode[n]);
+	}
+	for (a=0; a<A; a++)
+		names[nrows+a] = arena_mknam(&arena, "capacity", 8,
+		                             d->node[d->tail[a]], x->lennode[d->tail[a]],
+		                             d->node[d->head[a]], x->lennode[d->head[a]]);
+	error = GRBsetstrattrarray(model, GRB_STR_ATTR_CONSTRNAME, 0, nrows+A, names);
+	if (error) goto QUIT;
+
+	error = GRBupdatemodel(model);
+
+QUIT:
+	arena_free(&arena);
+	free(names);
+	return error;
+}
+
+/* bench_build
+ * inputs: env       loaded environment
+ *         build     build_loop or build_batched
+ *         d, x      instance and its row layout
+ *         usenames  passed through to build
+ *         reps      number of models to build
+ * output: error code; *secs receives the total wall time of reps
+ *         new model + build + update cycles
+ */
+int bench_build(GRBenv *env,
+                int (*build)(GRBmodel *, const MFData *, const MFRows *, int),
+                const MFData *d, const MFRows *x, int usenames,
+                int reps, double *secs)
+{
+	GRBmodel *model = NULL;
+	int       rep;
+	int       error = 0;
+	double    start = walltime();
+
+	for (rep=0; rep<reps; rep++) {
+		error = GRBnewmodel(env, &model, "multi_flow", 0, NULL, NULL, NULL, NULL, NULL);
+		if (error) return error;
+		error = build(model, d, x, usenames);
+		if (!error) error = GRBupdatemodel(model);
+		GRBfreemodel(model);
+		if (error) return error;
+	}
+	*secs = walltime() - start;
+	return 0;
+}
+
+/* What a scenario worker builds its model from */
+
+typedef struct {
+  const MFData *d;
+  const MFRows *x;
+  int           usenames;
+  const char   *cachedir;   /* read the model from here if not NULL */
+  uint64_t      cachekey;
+} ScenarioModel;
+
+/* scenario_build
+ * ScBuildFunc for sc_run: the model of one worker, read from the cache if
+ * it holds it and built with build_batched otherwise
+ */
+int scenario_build(GRBenv *env, void *arg, GRBmodel **model)
+{
+	ScenarioModel *sm = arg;
+	int            error = 0;
+
+	if (sm->cachedir) {
+		error = mc_load(env, sm->cachedir, "multi_flow", sm->cachekey, model);
+		if (error) return error;
+		if (*model) return sm->usenames ? name_model(*model, sm->d, sm->x) : 0;
+	}
+	error = GRBnewmodel(env, model, "multi_flow", 0, NULL, NULL, NULL, NULL, NULL);
+	if (error) return error;
+	error = GRBsetintattr(*model, GRB_INT_ATTR_MODELSENSE, GRB_MINIMIZE);
+	if (error) return error;
+	error = build_batched(*model, sm->d, sm->x, sm->usenames);
+	if (error) return error;
+	return GRBupdatemodel(*model);
+}
+
+/* scenario_demands
+ * inputs: d, x          instance and its row layout
+ *         nscen         number of scenarios
+ *         spread, seed  see mf_scenario_demand
+ * output: 0 on success; spec holds the supply and demand rows and their
+ *         right hand sides in every scenario
+ */
+int scenario_demands(const MFData *d, const MFRows *x, int nscen, double spread,
+                     uint64_t seed, ScenarioSpec *spec)
+{
+	int     nsupply = x->numrows[SUPPLYROW];
+	int     len = nsupply + x->numrows[DEMANDROW];
+	int     s, r;
+	double *demand = malloc((size_t) d->numcommodities*d->numnodes*sizeof(double) + 1);
+
+	spec->len   = len;
+	spec->nscen = nscen;
+	spec->ind   = malloc(len*sizeof(int) + 1);
+	spec->rhs   = malloc((size_t) nscen*len*sizeof(double) + 1);
+	if (!demand || !spec->ind || !spec->rhs) {
+		free(demand);
+		return 1;
+	}
+	for (r=0; r<len; r++)
+		spec->ind[r] = r;
+	for (s=0; s<nscen; s++) {
+		mf_scenario_demand(d, spread, seed, s, demand);
+		for (r=0; r<len; r++)
+			spec->rhs[(size_t) s*len+r] = r < nsupply ? -demand[x->rowkn[r]]
+			                                          : demand[x->rowkn[r]];
+	}
+	free(demand);
+	return 0;
 }
 
 int
@@ -83,169 +653,642 @@ main(int   argc,
 {
   GRBenv   *env   = NULL;
   GRBmodel *model = NULL;
+  MFData    data;
+  MFRows    rows;
+  ThreadPool *pool = NULL;
+  MFColgenResult cgres;
 
 
-  int 		i,j,k;
+  int 		i;
   int       error = 0;
-  char	   *ptr;
-  char     *name[NUMVARS];
-  double    sol[NUMVARS];
-  double    rc[NUMVARS];
-  char     *conname[NUMCONSTRAINTS];
-  double    slack[NUMCONSTRAINTS];
-  double    pi[NUMCONSTRAINTS];
-  int       ind[NUMVARS];
-  double    val[NUMVARS];
+  int       useloop = 0;
+  int       usenames = 1;
+  int       benchreps = 0;
+  int       usecg = 0, cgthreads = 0;
+  int       sweeparc = -1, sweepsteps = 0, cold = 0;
+  double    sweeplo = 0, sweephi = 0;
+  SweepSpec spec;
+  SweepPoint *pt = NULL;
+  char    **label = NULL;
+  const char *tracefile = NULL;
+  SolveTrace *trace = NULL;
+  TraceInstance traceinst;
+  const char *phasefile = NULL;
+  PhaseLog *phases = NULL;
+  const char *cachedir = NULL;
+  const char *writefile = NULL;
+  uint64_t  cachekey = 0;
+  int       version = MF_MODEL_VERSION;
+  int       nscen = 0, scworkers = 0;
+  double    spread = 0;
+  uint64_t  seed = 1;
+  ScPolicy  policy = SC_AUTO;
+  ScenarioSpec scspec;
+  ScenarioResult *scres = NULL;
+  ScenarioStats scstats;
+  ScenarioModel scmodel;
+  char    **rowlabel = NULL;
+  int       nstoch = 0, groups = 1, extensive = 0;
+  double    capcost = 1, penalty = -1;
+  MFStochData sd;
+  MFStochResult sres;
+  double    fixed = -1, timelimit = -1;
+  MFDesignSpec dspec;
+  MFDesignResult dres;
+  int       nvars, nconstrs;
+  const char *datafile = NULL;
+  const char *convert = NULL;
+  double    tstart, tload, tbuild, tsolve;
+  double    tloop, tbatch;
+  char      nambuf[256];
+  char    **name = NULL;
+  double   *sol = NULL;
+  double   *rc = NULL;
+  char    **conname = NULL;
+  double   *slack = NULL;
+  double   *pi = NULL;
   int       optimstatus;
   double    objval;
 
+  memset(&rows, 0, sizeof(rows));
+  memset(&cgres, 0, sizeof(cgres));
+  memset(&spec, 0, sizeof(spec));
+  memset(&scspec, 0, sizeof(scspec));
+  memset(&scstats, 0, sizeof(scstats));
+  memset(&sd, 0, sizeof(sd));
+  memset(&sres, 0, sizeof(sres));
+  memset(&dspec, 0, sizeof(dspec));
+  memset(&dres, 0, sizeof(dres));
+  dspec.linking  = MD_LAZY;
+  dspec.mipstart = 1;
+
+  for (i=1; i<argc; i++) {
+    if (strcmp(argv[i], "-loop") == 0) {
+      useloop = 1;
+    } else if (strcmp(argv[i], "-nonames") == 0) {
+      usenames = 0;
+    } else if (strcmp(argv[i], "-bench") == 0 && i+1 < argc) {
+      benchreps = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-convert") == 0 && i+1 < argc) {
+      convert = argv[++i];
+    } else if (strcmp(argv[i], "-cg") == 0 && i+1 < argc) {
+      usecg = 1;
+      cgthreads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-sweep") == 0 && i+4 < argc) {
+      sweeparc   = atoi(argv[++i]);
+      sweeplo    = atof(argv[++i]);
+      sweephi    = atof(argv[++i]);
+      sweepsteps = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-cold") == 0) {
+      cold = 1;
+    } else if (strcmp(argv[i], "-trace") == 0 && i+1 < argc) {
+      tracefile = argv[++i];
+    } else if (strcmp(argv[i], "-phases") == 0 && i+1 < argc) {
+      phasefile = argv[++i];
+    } else if (strcmp(argv[i], "-cache") == 0 && i+1 < argc) {
+      cachedir = argv[++i];
+    } else if (strcmp(argv[i], "-write") == 0 && i+1 < argc) {
+      writefile = argv[++i];
+    } else if (strcmp(argv[i], "-scenarios") == 0 && i+2 < argc) {
+      nscen  = atoi(argv[++i]);
+      spread = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-seed") == 0 && i+1 < argc) {
+      seed = strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "-policy") == 0 && i+1 < argc) {
+      i++;
+      if (strcmp(argv[i], "auto") == 0) policy = SC_AUTO;
+      else if (strcmp(argv[i], "solves") == 0) policy = SC_SOLVES;
+      else if (strcmp(argv[i], "threads") == 0) policy = SC_THREADS;
+      else {
+        fprintf(stderr, "%s: unknown policy %s\n", argv[0], argv[i]);
+        exit(1);
+      }
+    } else if (strcmp(argv[i], "-workers") == 0 && i+1 < argc) {
+      scworkers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-stochastic") == 0 && i+2 < argc) {
+      nstoch = atoi(argv[++i]);
+      spread = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-capcost") == 0 && i+1 < argc) {
+      capcost = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-penalty") == 0 && i+1 < argc) {
+      penalty = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-groups") == 0 && i+1 < argc) {
+      groups = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-extensive") == 0) {
+      extensive = 1;
+    } else if (strcmp(argv[i], "-design") == 0 && i+1 < argc) {
+      fixed = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-linking") == 0 && i+1 < argc) {
+      i++;
+      if (strcmp(argv[i], "lazy") == 0) dspec.linking = MD_LAZY;
+      else if (strcmp(argv[i], "static") == 0) dspec.linking = MD_STATIC;
+      else if (strcmp(argv[i], "none") == 0) dspec.linking = MD_NONE;
+      else {
+        fprintf(stderr, "%s: unknown linking %s\n", argv[0], argv[i]);
+        exit(1);
+      }
+    } else if (strcmp(argv[i], "-nostart") == 0) {
+      dspec.mipstart = 0;
+    } else if (strcmp(argv[i], "-timelimit") == 0 && i+1 < argc) {
+      timelimit = atof(argv[++i]);
+    } else if (argv[i][0] != '-' && datafile == NULL) {
+      datafile = argv[i];
+    } else {
+      fprintf(stderr, "usage: %s [-loop] [-nonames] [-bench reps] "
+              "[-convert out.mfb] [-cg threads] [-sweep arc lo hi steps [-cold]] "
+              "[-trace out.mlog] [-phases report.json] [-cache dir] [-write file] "
+              "[-scenarios count spread [-seed n] [-policy auto|solves|threads] "
+              "[-workers n]] [-stochastic count spread [-capcost c] [-penalty p] "
+              "[-groups n] [-extensive] [-seed n] [-workers n]] "
+              "[-design fixed [-linking lazy|static|none] [-nostart] [-timelimit secs]] "
+              "[datafile]\n", argv[0]);
+      exit(1);
+    }
+  }
+
+  if (phasefile && (phases = ph_create("multi_flow")) == NULL) {
+    fprintf(stderr, "Out of memory\n");
+    exit(1);
+  }
+
+  /* Load instance data */
+
+  ph_begin(phases, "load");
+  tstart = walltime();
+  if (datafile ? mf_load(datafile, &data) : mf_default(&data)) {
+    fprintf(stderr, "Could not load instance data\n");
+    exit(1);
+  }
+  if (mf_rows(&data, &rows)) {
+    fprintf(stderr, "Out of memory\n");
+    exit(1);
+  }
+  tload = walltime() - tstart;
+  ph_end(phases);
+
+  if (convert) {
+    error = mf_save_binary(&data, convert);
+    mf_rows_free(&rows);
+    mf_free(&data);
+    return error;
+  }
+
+  if (sweeparc >= data.numarcs || (sweeparc >= 0 && sweepsteps < 1)) {
+    fprintf(stderr, "-sweep needs an arc below %d and at least one step\n",
+            data.numarcs);
+    exit(1);
+  }
+
+  nvars    = numvars(&data);
+  nconstrs = numconstrs(&data, &rows);
+  printf("Loaded %d commodities, %d nodes, %d arcs\n",
+         data.numcommodities, data.numnodes, data.numarcs);
+
   /* Create environment */
 
+  ph_begin(phases, "loadenv");
   error = GRBloadenv(&env, "multi_flow.log");
   if (error) goto QUIT;
+  ph_end(phases);
 
-  /* Create an empty model */
+  /* Benchmark: compare the per-element loop against the batched build */
 
-  error = GRBnewmodel(env, &model, "multi_flow", 0, NULL, NULL, NULL, NULL, NULL);
-  if (error) goto QUIT;
+  if (benchreps > 0) {
+    ph_begin(phases, "bench");
+    error = bench_build(env, build_loop, &data, &rows, usenames, benchreps, &tloop);
+    if (error) goto QUIT;
+    error = bench_build(env, build_batched, &data, &rows, usenames, benchreps, &tbatch);
+    if (error) goto QUIT;
+    ph_end(phases);
+    printf("\nBuild benchmark: %d vars, %d constrs, %d reps, names %s\n",
+           nvars, nconstrs, benchreps, usenames ? "on" : "off");
+    printf("  loop     %10.3f ms/build\n", 1e3*tloop/benchreps);
+    printf("  batched  %10.3f ms/build\n", 1e3*tbatch/benchreps);
+    printf("  speedup  %10.2fx\n", tbatch > 0 ? tloop/tbatch : 0.0);
+    goto QUIT;
+  }
 
+  /* Column generation: path master plus parallel per-commodity pricing */
 
-  /* Add variables: one flow variable for each commodity,source,dest combo */
+  if (usecg) {
+    pool = tp_create(cgthreads);
+    if (pool == NULL) {
+      error = GRB_ERROR_OUT_OF_MEMORY;
+      goto QUIT;
+    }
+    ph_begin(phases, "colgen");
+    tstart = walltime();
+    error = mf_colgen(env, &data, pool, 0, &cgres);
+    if (error) goto QUIT;
+    tsolve = walltime() - tstart;
+    ph_end(phases);
 
-  for ( i=0; i<NUMCOMMODITIES; i++)
-  {
-	  for ( j=0; j<NUMSOURCES; j++)
-	  {
-		  for ( k=0; k<NUMDESTINATIONS; k++)
-		  {
-			  error = GRBaddvar(model, 0, NULL, NULL, cost[i][j][k],
-					       0, capacity[j][k], GRB_CONTINUOUS,
-					       ptr=mknam(Commodity[i],Source[j],Destination[k]));
-			  if (error) goto QUIT;
-			  free(ptr);
+    printf("\nColumn generation complete: %d master solves, %d path columns, "
+           "%d pricing threads\n", cgres.iterations, cgres.numcolumns, tp_size(pool));
+    if (cgres.status == GRB_OPTIMAL) {
+      printf("\nNonzero flows:\nV Name      Value\n");
+      for (i=0; i<nvars; i++) {
+        if (cgres.flow[i] > 1e-9) {
+          varname(&data, i, nambuf, sizeof(nambuf));
+          printf("%4s       %5.1f\n", nambuf, cgres.flow[i]);
+        }
+      }
+      printf("\nOptimal objective: %.4e\n", cgres.objval);
+    } else if (cgres.status == GRB_INFEASIBLE) {
+      printf("Model is infeasible\n");
+    } else {
+      printf("Optimization was stopped early\n");
+    }
+    printf("\nTiming: load %.3f s, solve %.3f s (master %.3f s, pricing %.3f s)\n",
+           tload, tsolve, cgres.tmaster, cgres.tpricing);
+    goto QUIT;
+  }
 
-		  }
-	  }
+  if (cachedir) {
+    cachekey = mc_hash(mf_hash(&data), &version, sizeof(version));
   }
 
-  /* Change objective sense to minimization */
+  /* Two-stage stochastic version: capacities first, then the demands */
 
-  error = GRBsetintattr(model, GRB_INT_ATTR_MODELSENSE, GRB_MINIMIZE);
-  if (error) goto QUIT;
+  if (nstoch > 0) {
+    sd.nscen   = nstoch;
+    sd.spread  = spread;
+    sd.seed    = seed;
+    sd.capcost = malloc(data.numarcs*sizeof(double) + 1);
+    if (sd.capcost == NULL) {
+      error = GRB_ERROR_OUT_OF_MEMORY;
+      goto QUIT;
+    }
+    for (i=0; i<data.numarcs; i++) sd.capcost[i] = capcost;
+    if (penalty < 0) {
+      penalty = 0;
+      for (i=0; i<data.numcommodities*data.numarcs; i++)
+        if (10*data.cost[i] > penalty) penalty = 10*data.cost[i];
+    }
+    sd.penalty = penalty;
+    if (groups > nstoch) groups = nstoch;
+    if (groups < 1) groups = 1;
 
-  /* Integrate new variables */
+    ph_begin(phases, "stochastic");
+    tstart = walltime();
+    if (extensive) {
+      error = ms_extensive(env, &data, &sd, &sres);
+    } else {
+      pool = tp_create(scworkers);
+      if (pool == NULL) {
+        error = GRB_ERROR_OUT_OF_MEMORY;
+        goto QUIT;
+      }
+      error = ms_lshaped(env, &data, &sd, pool, groups, 0, 1e-6, &sres);
+    }
+    if (error) goto QUIT;
+    tsolve = walltime() - tstart;
+    ph_end(phases);
 
-  error = GRBupdatemodel(model);
-  if (error) goto QUIT;
+    printf("\nTwo-stage stochastic: %d scenarios, spread %g, seed %llu, "
+           "capacity cost %g, shortage penalty %g\n",
+           nstoch, spread, (unsigned long long) seed, capcost, penalty);
+    if (extensive)
+      printf("Extensive form, status %d\n", sres.status);
+    else
+      printf("L-shaped, %d groups on %d threads: status %d, %d iterations, %d cuts\n",
+             groups, tp_size(pool),
+             sres.status, sres.iterations, sres.numcuts);
+    if (sres.objval < GRB_INFINITY) {
+      printf("\nExpected cost %.6e (capacity %.6e, recourse %.6e), bound %.6e\n",
+             sres.objval, sres.capcost, sres.objval - sres.capcost, sres.bound);
+      printf("\nInstalled capacity:\nArc                  Capacity      Limit\n");
+      for (i=0; i<data.numarcs; i++)
+        if (sres.capacity[i] > 1e-9) {
+          snprintf(nambuf, sizeof(nambuf), "%s_%s",
+                   data.node[data.tail[i]], data.node[data.head[i]]);
+          printf("%-20s %8.2f   %8.2f\n", nambuf, sres.capacity[i], data.capacity[i]);
+        }
+    }
+    printf("\nTiming: load %.3f s, solve %.3f s (master %.3f s, subproblems %.3f s)\n",
+           tload, tsolve, sres.tmaster, sres.tsub);
+    goto QUIT;
+  }
+
+  /* Fixed-charge network design: which arcs to open */
+
+  if (fixed >= 0) {
+    static const char *linkname[3] = { "none", "lazy", "static" };
+    int open = 0;
 
+    dspec.fixed = malloc(data.numarcs*sizeof(double) + 1);
+    if (dspec.fixed == NULL) {
+      error = GRB_ERROR_OUT_OF_MEMORY;
+      goto QUIT;
+    }
+    for (i=0; i<data.numarcs; i++) dspec.fixed[i] = fixed;
+    if (timelimit > 0) {
+      error = GRBsetdblparam(env, GRB_DBL_PAR_TIMELIMIT, timelimit);
+      if (error) goto QUIT;
+    }
 
-  /* Supply constraints: one for each commodity,source pair */
-
-  for(i=0; i<NUMCOMMODITIES; i++)
-  {
-	  for(j=0; j<NUMSOURCES; j++)
-	  {
-		  for ( k=0; k<NUMDESTINATIONS; k++)
-		  {
-			  ind[k] = varind(i,j,k);
-			  val[k] = 1;
-		  }
-		  error = GRBaddconstr(model, NUMDESTINATIONS, ind, val, GRB_LESS_EQUAL,
-				    supply[i][j], mknam("supply",Commodity[i],Source[j]));
-		  if (error) goto QUIT;
-	  }
+    ph_begin(phases, "design");
+    tstart = walltime();
+    error = md_solve(env, &data, &dspec, &dres);
+    if (error) goto QUIT;
+    tsolve = walltime() - tstart;
+    ph_end(phases);
+
+    printf("\nNetwork design: fixed cost %g per arc, %s linking rows, %s\n",
+           fixed, linkname[dspec.linking],
+           dspec.mipstart ? "LP rounding start" : "no start");
+    if (dres.lpobj < GRB_INFINITY)
+      printf("LP relaxation %.6e, MIP start %.6e\n", dres.lpobj, dres.startobj);
+    printf("Status %d, %.0f nodes, %d linking rows\n",
+           dres.status, dres.nodes, dres.numlinking);
+    if (dres.objval < GRB_INFINITY) {
+      printf("\nCost %.6e, bound %.6e, gap %.2f%%\n", dres.objval, dres.bound,
+             dres.objval != 0 ? 100*(dres.objval - dres.bound)/dres.objval : 0.0);
+      printf("\nOpen arcs:\nArc                      Flow   Capacity\n");
+      for (i=0; i<data.numarcs; i++) {
+        double flow = 0;
+        int    k;
+        if (dres.open[i] == 0) continue;
+        for (k=0; k<data.numcommodities; k++)
+          flow += dres.flow[varind(&data, k, i)];
+        snprintf(nambuf, sizeof(nambuf), "%s_%s",
+                 data.node[data.tail[i]], data.node[data.head[i]]);
+        printf("%-20s %8.2f   %8.2f\n", nambuf, flow, data.capacity[i]);
+        open++;
+      }
+      printf("\n%d of %d arcs open\n", open, data.numarcs);
+    } else if (dres.status == GRB_INFEASIBLE || dres.status == GRB_INF_OR_UNBD) {
+      printf("Model is infeasible\n");
+    } else {
+      printf("No design found\n");
+    }
+    printf("\nTiming: load %.3f s, solve %.3f s (LP rounding %.3f s, MIP %.3f s)\n",
+           tload, tsolve, dres.tstart, dres.tsolve);
+    goto QUIT;
   }
 
+  /* Demand scenarios: one model per worker, solved concurrently */
+
+  if (nscen > 0) {
+    scres = malloc(nscen*sizeof(ScenarioResult));
+    rowlabel = calloc(nconstrs+1, sizeof(char *));
+    if (!scres || !rowlabel ||
+        scenario_demands(&data, &rows, nscen, spread, seed, &scspec)) {
+      error = GRB_ERROR_OUT_OF_MEMORY;
+      goto QUIT;
+    }
+    scmodel.d        = &data;
+    scmodel.x        = &rows;
+    scmodel.usenames = usenames;
+    scmodel.cachedir = cachedir;
+    scmodel.cachekey = cachekey;
 
-  /* Demand constraints: one for each commodity,dest pair */
-
-  for(i=0; i<NUMCOMMODITIES; i++)
-  {
-	  for( k=0; k<NUMDESTINATIONS; k++)
-	  {
-		  for (j=0; j<NUMSOURCES; j++)
-		  {
-			  ind[j] = varind(i,j,k);
-			  val[j] = 1;
-		  }
-		  error = GRBaddconstr(model, NUMSOURCES, ind, val, GRB_GREATER_EQUAL,
-				    demand[i][k], mknam("demand",Commodity[i],Destination[k]));
-		  if (error) goto QUIT;
-	  }
+    ph_begin(phases, "scenarios");
+    error = sc_run(scenario_build, &scmodel, &scspec, 0, policy, scworkers,
+                   scres, &scstats);
+    if (error) goto QUIT;
+    ph_end(phases);
+
+    for (i=0; i<nconstrs; i++) {
+      constrname(&data, &rows, i, nambuf, sizeof(nambuf));
+      rowlabel[i] = strdup(nambuf);
+      if (rowlabel[i] == NULL) {
+        error = GRB_ERROR_OUT_OF_MEMORY;
+        goto QUIT;
+      }
+    }
+    printf("\nDemand scenarios, spread %g, seed %llu\n",
+           spread, (unsigned long long) seed);
+    sc_report(stdout, &scspec, scres, &scstats, rowlabel, 10);
+    printf("\nTiming: load %.3f s, scenarios %.3f s\n", tload, scstats.secs);
+    goto QUIT;
   }
 
-  /* Capacity constraints: one for each source,dest pair */
-
-  for(j=0; j<NUMSOURCES; j++)
-  {
-	  for( k=0; k<NUMDESTINATIONS; k++)
-	  {
-		  for (i=0; i<NUMCOMMODITIES; i++)
-		  {
-			  ind[i] = varind(i,j,k);
-			  val[i] = 1;
-		  }
-		  error = GRBaddconstr(model, NUMCOMMODITIES, ind, val, GRB_LESS_EQUAL,
-				    capacity[j][k], mknam("capacity",Source[j],Destination[k]));
-		  if (error) goto QUIT;
-	  }
+  /* Read the model from the cache if it was built from the same data */
+
+  tstart = walltime();
+
+  if (cachedir) {
+    ph_begin(phases, "cacheread");
+    error = mc_load(env, cachedir, "multi_flow", cachekey, &model);
+    if (error) goto QUIT;
+    ph_end(phases);
+    if (model)
+      printf("Model read from cache %s\n",
+             mc_path(cachedir, "multi_flow", cachekey, nambuf, sizeof(nambuf)));
   }
 
-  /* Integrate constraints */
+  if (model == NULL) {
 
-  error = GRBupdatemodel(model);
-  if (error) goto QUIT;
+    /* Create an empty model */
 
-  /* Write model  */
+    ph_begin(phases, "newmodel");
 
-  error = GRBwrite(model, "multi_flow.lp");
-  if (error) goto QUIT;
+    error = GRBnewmodel(env, &model, "multi_flow", 0, NULL, NULL, NULL, NULL, NULL);
+    if (error) goto QUIT;
+
+    /* Change objective sense to minimization */
+
+    error = GRBsetintattr(model, GRB_INT_ATTR_MODELSENSE, GRB_MINIMIZE);
+    if (error) goto QUIT;
+
+    ph_end(phases);
+
+    /* Add variables and flow conservation and capacity constraints */
+
+    ph_begin(phases, "build");
+    error = useloop ? build_loop(model, &data, &rows, usenames && !cachedir)
+                    : build_batched(model, &data, &rows, usenames && !cachedir);
+    if (error) goto QUIT;
+    ph_end(phases);
+
+    /* Integrate constraints */
+
+    ph_begin(phases, "update");
+    error = GRBupdatemodel(model);
+    if (error) goto QUIT;
+    ph_end(phases);
+
+    /* Keep it for the next run; a run that cannot is still a run */
+
+    if (cachedir) {
+      ph_begin(phases, "cachewrite");
+      error = mc_store(model, cachedir, "multi_flow", cachekey);
+      if (error == -1)
+        fprintf(stderr, "%s: %s\n", cachedir, strerror(errno));
+      else if (error)
+        fprintf(stderr, "%s: %s\n", cachedir, GRBgeterrormsg(env));
+      error = 0;
+      ph_end(phases);
+    }
+  }
+
+  /* Cache entries are unnamed, see name_model */
+
+  if (cachedir && usenames) {
+    error = name_model(model, &data, &rows);
+    if (error) goto QUIT;
+  }
+
+  tbuild = walltime() - tstart;
+
+  /* Write model, only when asked to: text formats are slow for big models */
+
+  if (writefile) {
+    ph_begin(phases, "write");
+    error = GRBwrite(model, writefile);
+    if (error) goto QUIT;
+    ph_end(phases);
+  }
+
+  /* Parametric sweep: scale the cost of one arc for all commodities */
 
+  if (sweeparc >= 0) {
+    int C = data.numcommodities, k, p;
 
-  /* Optimize model */
+    spec.attr    = GRB_DBL_ATTR_OBJ;
+    spec.len     = C;
+    spec.ind     = malloc(C*sizeof(int) + 1);
+    spec.npoints = sweepsteps;
+    spec.value   = malloc((size_t) sweepsteps*C*sizeof(double) + 1);
+    pt           = malloc(sweepsteps*sizeof(SweepPoint) + 1);
+    label        = calloc(C+1, sizeof(char *));
+    if (!spec.ind || !spec.value || !pt || !label) {
+      error = GRB_ERROR_OUT_OF_MEMORY;
+      goto QUIT;
+    }
+    for (k=0; k<C; k++) {
+      spec.ind[k] = varind(&data, k, sweeparc);
+      varname(&data, spec.ind[k], nambuf, sizeof(nambuf));
+      label[k] = strdup(nambuf);
+      if (label[k] == NULL) {
+        error = GRB_ERROR_OUT_OF_MEMORY;
+        goto QUIT;
+      }
+    }
+    for (p=0; p<sweepsteps; p++) {
+      double f = sweepsteps == 1 ? sweeplo
+                                 : sweeplo + (sweephi-sweeplo)*p/(sweepsteps-1);
+      for (k=0; k<C; k++)
+        spec.value[(size_t) p*C+k] = f*data.cost[k*data.numarcs+sweeparc];
+    }
+
+    error = GRBsetintparam(GRBgetenv(model), GRB_INT_PAR_OUTPUTFLAG, 0);
+    if (error) goto QUIT;
+    /* A new cost leaves the old basis primal feasible: primal simplex
+     * continues from it */
+
+    error = GRBsetintparam(GRBgetenv(model), GRB_INT_PAR_METHOD, GRB_METHOD_PRIMAL);
+    if (error) goto QUIT;
+
+    printf("\nSweeping arc %d, %s -> %s, cost x %g to %g in %d steps\n", sweeparc,
+           data.node[data.tail[sweeparc]], data.node[data.head[sweeparc]],
+           sweeplo, sweephi, sweepsteps);
+
+    ph_begin(phases, "sweep");
+    tstart = walltime();
+    error = sw_run(model, &spec, cold, pt);
+    if (error) goto QUIT;
+    tsolve = walltime() - tstart;
+    ph_end(phases);
+
+    printf("\nSweep of arc %s -> %s complete (%s start)\n",
+           data.node[data.tail[sweeparc]], data.node[data.head[sweeparc]],
+           cold ? "cold" : "warm");
+    sw_report(stdout, &spec, pt, label);
+    printf("\nTiming: load %.3f s, build %.3f s, sweep %.3f s\n", tload, tbuild, tsolve);
+    goto QUIT;
+  }
+
+  /* Optimize model, recording its progress if asked to */
+
+  if (tracefile) {
+    trace = st_create(0);
+    if (!trace) {
+      error = GRB_ERROR_OUT_OF_MEMORY;
+      goto QUIT;
+    }
+    error = GRBsetcallbackfunc(model, st_callback, trace);
+    if (error) goto QUIT;
+  }
+
+  tstart = walltime();
+  ph_begin(phases, "optimize");
 
   error = GRBoptimize(model);
   if (error) goto QUIT;
 
+  ph_end(phases);
+  tsolve = walltime() - tstart;
+
+  if (trace) {
+    error = st_instance(model, datafile ? datafile : "multi_flow", &traceinst);
+    if (error) goto QUIT;
+    if (st_finish(trace, &traceinst, tracefile) != 0)
+      fprintf(stderr, "%s: %s\n", tracefile, strerror(errno));
+    else
+      printf("\nTrace: %lld callback records (%lld dropped) written to %s\n",
+             (long long) st_count(trace), (long long) st_dropped(trace), tracefile);
+  }
+
 
   /* Capture solution information */
 
+  ph_begin(phases, "extract");
+  name    = malloc(nvars*sizeof(char *) + 1);
+  sol     = malloc(nvars*sizeof(double) + 1);
+  rc      = malloc(nvars*sizeof(double) + 1);
+  conname = malloc(nconstrs*sizeof(char *) + 1);
+  slack   = malloc(nconstrs*sizeof(double) + 1);
+  pi      = malloc(nconstrs*sizeof(double) + 1);
+  if (!name || !sol || !rc || !conname || !slack || !pi) {
+    error = GRB_ERROR_OUT_OF_MEMORY;
+    goto QUIT;
+  }
+
   error = GRBgetintattr(model, GRB_INT_ATTR_STATUS, &optimstatus);
   if (error) goto QUIT;
 
   error = GRBgetdblattr(model, GRB_DBL_ATTR_OBJVAL, &objval);
   if (error) goto QUIT;
 
-  error = GRBgetstrattrarray(model, GRB_STR_ATTR_VARNAME, 0, NUMVARS, name);
-  if (error) goto QUIT;
+  if (usenames) {
+    error = GRBgetstrattrarray(model, GRB_STR_ATTR_VARNAME, 0, nvars, name);
+    if (error) goto QUIT;
+  }
 
-  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_X, 0, NUMVARS, sol);
+  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_X, 0, nvars, sol);
   if (error) goto QUIT;
 
-  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_RC, 0, NUMVARS, rc);
+  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_RC, 0, nvars, rc);
   if (error) goto QUIT;
 
-  error = GRBgetstrattrarray(model, GRB_STR_ATTR_CONSTRNAME, 0, NUMCONSTRAINTS, conname);
-  if (error) goto QUIT;
+  if (usenames) {
+    error = GRBgetstrattrarray(model, GRB_STR_ATTR_CONSTRNAME, 0, nconstrs, conname);
+    if (error) goto QUIT;
+  }
 
-  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_SLACK, 0, NUMCONSTRAINTS, slack);
+  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_SLACK, 0, nconstrs, slack);
   if (error) goto QUIT;
 
-  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_PI, 0, NUMCONSTRAINTS, pi);
+  error = GRBgetdblattrarray(model, GRB_DBL_ATTR_PI, 0, nconstrs, pi);
   if (error) goto QUIT;
+  ph_end(phases);
 
   printf("\nOptimization complete\n");
   if (optimstatus == GRB_OPTIMAL) {
 	printf("\nVariables:\nV Name      Value    Red. Cost\n");
-	for (i=0; i<NUMVARS; i++) {
-        printf("%4s       %5.1f     %8.4f\n",name[i],sol[i],rc[i]);
+	for (i=0; i<nvars; i++) {
+        if (!usenames) varname(&data, i, nambuf, sizeof(nambuf));
+        printf("%4s       %5.1f     %8.4f\n",usenames ? name[i] : nambuf,sol[i],rc[i]);
 	}
 
     printf("\nOptimal objective: %.4e\n", objval);
 
 	printf("\nConstraints:\n C Name     Slack    Dual Value\n");
-	for (i=0; i<NUMCONSTRAINTS; i++) {
-        printf("%7s    %5.1f     %8.4f\n",conname[i],slack[i],pi[i]);
+	for (i=0; i<nconstrs; i++) {
+        if (!usenames) constrname(&data, &rows, i, nambuf, sizeof(nambuf));
+        printf("%7s    %5.1f     %8.4f\n",usenames ? conname[i] : nambuf,slack[i],pi[i]);
 	}
   } else if (optimstatus == GRB_INF_OR_UNBD) {
     printf("Model is infeasible or unbounded\n");
@@ -253,8 +1296,18 @@ main(int   argc,
     printf("Optimization was stopped early\n");
   }
 
+  printf("\nTiming: load %.3f s, build %.3f s, solve %.3f s\n", tload, tbuild, tsolve);
+
 QUIT:
 
+  /* Phase report, also of a failed run: the failed phase ends here */
+
+  if (phases) {
+    if (ph_write_json(phases, phasefile) != 0)
+      fprintf(stderr, "%s: %s\n", phasefile, strerror(errno));
+    ph_print(phases, stdout);
+  }
+
   /* Error reporting */
 
   if (error) {
@@ -262,6 +1315,34 @@ QUIT:
     exit(1);
   }
 
+  free(name);
+  free(sol);
+  free(rc);
+  free(conname);
+  free(slack);
+  free(pi);
+  mf_colgen_free(&cgres);
+  if (label)
+    for (i=0; i<data.numcommodities; i++) free(label[i]);
+  free(label);
+  if (rowlabel)
+    for (i=0; i<nconstrs; i++) free(rowlabel[i]);
+  free(rowlabel);
+  free(scspec.ind);
+  free(scspec.rhs);
+  free(scres);
+  sc_stats_free(&scstats);
+  free(sd.capcost);
+  ms_free(&sres);
+  free(dspec.fixed);
+  md_free(&dres);
+  free(spec.ind);
+  free(spec.value);
+  free(pt);
+  tp_free(pool);
+  st_free(trace);
+  ph_free(phases);
+
   /* Free model */
 
   GRBfreemodel(model);
@@ -270,5 +1351,8 @@ QUIT:
 
   GRBfreeenv(env);
 
+  mf_rows_free(&rows);
+  mf_free(&data);
+
   return 0;
 }
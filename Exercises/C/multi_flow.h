@@ -59,26 +59,26 @@ demand = {
     { {10, 20, 60}, {40, 40, 30} },
     { {20, 20, 80}, {60, 70, 30} }
   };
-#define NUMVARS NUMSOURCES*NUMSOURCES*NUMDESTINATIONS
+#define NUMVARS (NUMCOMMODITIES*NUMSOURCES*NUMDESTINATIONS)
 
 
   double capacity[NUMSOURCES][NUMDESTINATIONS] = {
     {100, 80, 120},
     {120, 120, 120}
   };
-#define NUMCAPACITYCONSTRS NUMSOURCES*NUMDESTINATIONS
+#define NUMCAPACITYCONSTRS (NUMSOURCES*NUMDESTINATIONS)
 
   double supply[NUMCOMMODITIES][NUMSOURCES] = {
     {50, 60},
     {60, 40}
   };
-#define NUMSUPPLYCONSTRS NUMCOMMODITIES*NUMSOURCES
+#define NUMSUPPLYCONSTRS (NUMCOMMODITIES*NUMSOURCES)
 
   double demand[NUMCOMMODITIES][NUMDESTINATIONS] = {
     {50, 50, 10},
     {40, 30, 30}
   };
-#define NUMDEMANDCONSTRS NUMCOMMODITIES*NUMDESTINATIONS
+#define NUMDEMANDCONSTRS (NUMCOMMODITIES*NUMDESTINATIONS)
 
-#define NUMCONSTRAINTS NUMCAPACITYCONSTRS+NUMSUPPLYCONSTRS+NUMDEMANDCONSTRS
+#define NUMCONSTRAINTS (NUMCAPACITYCONSTRS+NUMSUPPLYCONSTRS+NUMDEMANDCONSTRS)
 
@@ -0,0 +1,46 @@
+/* Bump-pointer storage for generated variable and constraint names.
+   See name_arena.h */
+
+#include <stdlib.h>
+#include <string.h>
+#include "name_arena.h"
+
+int arena_init(NameArena *a, size_t size)
+{
+	a->used = 0;
+	a->size = size;
+	a->buf  = malloc(size > 0 ? size : 1);
+	return a->buf == NULL;
+}
+
+char *arena_mknam(NameArena *a, const char *r, size_t rlen,
+                  const char *s, size_t slen, const char *t, size_t tlen)
+{
+	size_t need = rlen+slen+tlen+3;
+	char  *ptr;
+
+	if (a->used + need > a->size)
+		return NULL;
+	ptr = a->buf + a->used;
+	a->used += need;
+
+	memcpy(ptr, r, rlen);
+	ptr[rlen] = '_';
+	memcpy(ptr+rlen+1, s, slen);
+	ptr[rlen+1+slen] = '_';
+	memcpy(ptr+rlen+slen+2, t, tlen);
+	ptr[rlen+slen+tlen+2] = '\0';
+	return ptr;
+}
+
+void arena_reset(NameArena *a)
+{
+	a->used = 0;
+}
+
+void arena_free(NameArena *a)
+{
+	free(a->buf);
+	a->buf  = NULL;
+	a->size = a->used = 0;
+}
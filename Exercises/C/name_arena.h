@@ -0,0 +1,47 @@
+/* Bump-pointer storage for generated variable and constraint names.
+
+   All names of a model are carved out of one block whose size is computed
+   up front from the label lengths, so building n names costs one malloc and
+   n memcpy's instead of n mallocs and 3n strcat scans.  The whole block is
+   released with a single arena_free once the names have been handed to
+   Gurobi (which copies them).
+*/
+
+#ifndef NAME_ARENA_H
+#define NAME_ARENA_H
+
+#include <stddef.h>
+
+typedef struct {
+  char   *buf;    /* start of the block */
+  size_t  size;   /* bytes reserved */
+  size_t  used;   /* bytes handed out so far */
+} NameArena;
+
+/* arena_init
+ * inputs: a     arena to initialize
+ *         size  total bytes needed, including the terminating '\0's
+ * output: 0 on success, nonzero if the block could not be allocated
+ */
+int arena_init(NameArena *a, size_t size);
+
+/* arena_mknam
+ * inputs: r, s, t           Non-NULL strings (but 0 length ok)
+ *         rlen, slen, tlen  their lengths, computed once by the caller
+ * output: ptr into the arena to "r_s_t", or NULL if the arena is full.
+ *         Valid until arena_reset or arena_free; do NOT free it.
+ */
+char *arena_mknam(NameArena *a, const char *r, size_t rlen,
+                  const char *s, size_t slen, const char *t, size_t tlen);
+
+/* arena_reset
+ * Forget all names handed out so far but keep the block for reuse.
+ */
+void arena_reset(NameArena *a);
+
+/* arena_free
+ * Release the block.  Safe to call on a zeroed or already freed arena.
+ */
+void arena_free(NameArena *a);
+
+#endif
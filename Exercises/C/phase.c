@@ -0,0 +1,254 @@
+/* Phase timing and memory of a driver run.  See phase.h */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "phase.h"
+
+#define MAXDEPTH 32
+
+typedef struct {
+  char    name[48];
+  int     depth, done;
+  double  start, wall;        /* seconds since the log was created */
+  double  cpu0, cpu;
+  long    rss0, rss1, peak;   /* kB */
+} Phase;
+
+struct PhaseLog {
+  char   *program;
+  time_t  start_time;
+  double  t0, cpu0;
+  int     resettable;         /* the high-water mark can be reset */
+  Phase  *phase;
+  int     n, cap;
+  int     open[MAXDEPTH];     /* indices of the open phases, innermost last */
+  int     depth;
+  int     lost;               /* open phases not recorded, nested too deep
+                                 or out of memory; always the innermost */
+};
+
+static double clock_s(clockid_t id)
+{
+	struct timespec ts;
+
+	clock_gettime(id, &ts);
+	return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+/* status_kb
+ * inputs: key  "VmRSS:" or "VmHWM:"
+ * output: its value in /proc/self/status in kB, -1 if not available
+ */
+static long status_kb(const char *key)
+{
+	char  line[256];
+	long  kb = -1;
+	FILE *f = fopen("/proc/self/status", "r");
+
+	if (f == NULL)
+		return -1;
+	while (fgets(line, sizeof(line), f))
+		if (strncmp(line, key, strlen(key)) == 0) {
+			kb = strtol(line + strlen(key), NULL, 10);
+			break;
+		}
+	fclose(f);
+	return kb;
+}
+
+static long maxrss_kb(void)
+{
+	struct rusage ru;
+
+	return getrusage(RUSAGE_SELF, &ru) == 0 ? ru.ru_maxrss : -1;
+}
+
+/* reset_hwm
+ * Reset the RSS high-water mark to the current RSS.  Returns 0 on success.
+ */
+static int reset_hwm(void)
+{
+	FILE *f = fopen("/proc/self/clear_refs", "w");
+	int   ok;
+
+	if (f == NULL)
+		return -1;
+	ok = fputs("5", f) >= 0;
+	if (fclose(f) != 0)
+		ok = 0;
+	return ok ? 0 : -1;
+}
+
+/* peak_kb
+ * Peak RSS since the last reset, or of the process if resets do not work.
+ */
+static long peak_kb(const PhaseLog *pl)
+{
+	long kb = pl->resettable ? status_kb("VmHWM:") : -1;
+
+	return kb >= 0 ? kb : maxrss_kb();
+}
+
+PhaseLog *ph_create(const char *program)
+{
+	PhaseLog *pl = calloc(1, sizeof(PhaseLog));
+
+	if (pl == NULL || (pl->program = strdup(program)) == NULL) {
+		free(pl);
+		return NULL;
+	}
+	pl->start_time = time(NULL);
+	pl->t0         = clock_s(CLOCK_MONOTONIC);
+	pl->cpu0       = clock_s(CLOCK_PROCESS_CPUTIME_ID);
+	pl->resettable = reset_hwm() == 0 && status_kb("VmHWM:") >= 0;
+	return pl;
+}
+
+void ph_begin(PhaseLog *pl, const char *name)
+{
+	Phase *p;
+	long   peak;
+	int    k;
+
+	if (pl == NULL)
+		return;
+	if (pl->lost > 0 || pl->depth == MAXDEPTH) {
+		pl->lost++;
+		return;
+	}
+	if (pl->n == pl->cap) {
+		int    cap = pl->cap ? 2*pl->cap : 16;
+		Phase *q   = realloc(pl->phase, cap * sizeof(Phase));
+		if (q == NULL) {
+			pl->lost++;
+			return;
+		}
+		pl->phase = q;
+		pl->cap   = cap;
+	}
+
+	/* The reset below loses the peak of the open phases so far; keep it */
+	peak = peak_kb(pl);
+	for (k = 0; k < pl->depth; k++)
+		if (peak > pl->phase[pl->open[k]].peak)
+			pl->phase[pl->open[k]].peak = peak;
+	if (pl->resettable)
+		reset_hwm();
+
+	p = &pl->phase[pl->n];
+	memset(p, 0, sizeof(*p));
+	strncpy(p->name, name, sizeof(p->name) - 1);
+	p->depth = pl->depth;
+	p->start = clock_s(CLOCK_MONOTONIC) - pl->t0;
+	p->cpu0  = clock_s(CLOCK_PROCESS_CPUTIME_ID);
+	p->rss0  = status_kb("VmRSS:");
+	p->peak  = p->rss0;
+	pl->open[pl->depth++] = pl->n++;
+}
+
+void ph_end(PhaseLog *pl)
+{
+	Phase *p;
+	long   peak;
+
+	if (pl == NULL)
+		return;
+	if (pl->lost > 0) {
+		pl->lost--;
+		return;
+	}
+	if (pl->depth == 0)
+		return;
+	p = &pl->phase[pl->open[--pl->depth]];
+	p->wall = clock_s(CLOCK_MONOTONIC) - pl->t0 - p->start;
+	p->cpu  = clock_s(CLOCK_PROCESS_CPUTIME_ID) - p->cpu0;
+	p->rss1 = status_kb("VmRSS:");
+	peak    = peak_kb(pl);
+	if (peak > p->peak)
+		p->peak = peak;
+	p->done = 1;
+	if (pl->depth > 0 && p->peak > pl->phase[pl->open[pl->depth-1]].peak)
+		pl->phase[pl->open[pl->depth-1]].peak = p->peak;
+}
+
+void ph_print(PhaseLog *pl, FILE *f)
+{
+	int k;
+
+	if (pl == NULL)
+		return;
+	fprintf(f, "\n%-28s %10s %10s %10s %10s\n", "Phase", "wall s", "cpu s", "RSS MB", "peak MB");
+	for (k = 0; k < pl->n; k++) {
+		const Phase *p = &pl->phase[k];
+		if (!p->done)
+			continue;
+		fprintf(f, "%*s%-*s %10.4f %10.4f %10.1f %10.1f\n", 2*p->depth, "", 28 - 2*p->depth,
+		        p->name, p->wall, p->cpu, p->rss1/1024.0, p->peak/1024.0);
+	}
+}
+
+/* json_string
+ * s as a JSON string literal.
+ */
+static void json_string(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			fprintf(f, "\\%c", *s);
+		else if ((unsigned char) *s < 0x20)
+			fprintf(f, "\\u%04x", *s);
+		else
+			fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+int ph_write_json(PhaseLog *pl, const char *file)
+{
+	FILE *f;
+	int   k, ok;
+
+	if (pl == NULL)
+		return 0;
+	pl->lost = 0;
+	while (pl->depth > 0)
+		ph_end(pl);
+	if ((f = fopen(file, "w")) == NULL)
+		return -1;
+
+	fprintf(f, "{\n  \"program\": ");
+	json_string(f, pl->program);
+	fprintf(f, ",\n  \"start_time\": %lld,\n  \"peak_rss_scope\": \"%s\",\n  \"phases\": [",
+	        (long long) pl->start_time, pl->resettable ? "phase" : "process");
+	for (k = 0; k < pl->n; k++) {
+		const Phase *p = &pl->phase[k];
+		fprintf(f, "%s\n    { \"name\": ", k ? "," : "");
+		json_string(f, p->name);
+		fprintf(f, ", \"depth\": %d, \"start_s\": %.6f, \"wall_s\": %.6f, \"cpu_s\": %.6f, "
+		        "\"rss_start_kb\": %ld, \"rss_end_kb\": %ld, \"peak_rss_kb\": %ld }",
+		        p->depth, p->start, p->wall, p->cpu, p->rss0, p->rss1, p->peak);
+	}
+	fprintf(f, "\n  ],\n  \"wall_s\": %.6f,\n  \"cpu_s\": %.6f,\n  \"peak_rss_kb\": %ld\n}\n",
+	        clock_s(CLOCK_MONOTONIC) - pl->t0, clock_s(CLOCK_PROCESS_CPUTIME_ID) - pl->cpu0,
+	        maxrss_kb());
+	ok = !ferror(f);
+	if (fclose(f) != 0)
+		ok = 0;
+	if (!ok && errno == 0)
+		errno = EIO;
+	return ok ? 0 : -1;
+}
+
+void ph_free(PhaseLog *pl)
+{
+	if (pl == NULL)
+		return;
+	free(pl->program);
+	free(pl->phase);
+	free(pl);
+}
@@ -0,0 +1,81 @@
+/* Phase timing and memory of a driver run.
+
+   ph_begin and ph_end bracket a phase of the run (load the environment,
+   build, update, write, optimize, read the solution, ...); phases may nest.
+   For every phase the log keeps the wall time, the CPU time of all threads,
+   the resident set size at its start and end and its peak RSS, and
+   ph_write_json writes them as a JSON report:
+
+     { "program": "multi_flow", "start_time": 1416429804,
+       "peak_rss_scope": "phase",
+       "phases": [ { "name": "optimize", "depth": 0, "start_s": 0.0132,
+                     "wall_s": 1.25, "cpu_s": 4.91, "rss_start_kb": 51200,
+                     "rss_end_kb": 60416, "peak_rss_kb": 81920 }, ... ],
+       "wall_s": 1.31, "cpu_s": 4.97, "peak_rss_kb": 81920 }
+
+   The peak of a phase is its own where the kernel lets the high-water mark
+   be reset (writing 5 to /proc/self/clear_refs, Linux 4.0 and later);
+   otherwise it is the peak of the process so far and peak_rss_scope says
+   "process".
+
+   Every function accepts a NULL log and then does nothing, so drivers can
+   bracket their phases unconditionally and create the log only when a
+   report was asked for.  C++ code can use PhaseScope, which ends its phase
+   when it goes out of scope.
+*/
+
+#ifndef PHASE_H
+#define PHASE_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct PhaseLog PhaseLog;
+
+/* ph_create
+ * inputs: program  name recorded in the report
+ * output: the log, its clock started; NULL if out of memory
+ */
+PhaseLog *ph_create(const char *program);
+
+/* ph_begin, ph_end
+ * Start a phase inside the phases already open; end the innermost one.
+ * Phases nested more than 32 deep, or begun when out of memory, are not
+ * recorded, but their ph_end is still expected.
+ */
+void ph_begin(PhaseLog *pl, const char *name);
+void ph_end(PhaseLog *pl);
+
+/* ph_print
+ * One line per ended phase, indented by depth, for the driver's own output.
+ */
+void ph_print(PhaseLog *pl, FILE *f);
+
+/* ph_write_json
+ * End the phases still open and write the report to file.  Returns 0, or
+ * -1 with errno set.
+ */
+int ph_write_json(PhaseLog *pl, const char *file);
+
+void ph_free(PhaseLog *pl);
+
+#ifdef __cplusplus
+}
+
+class PhaseScope
+{
+  public:
+    PhaseScope(PhaseLog* log, const char* name) : pl(log) { ph_begin(pl, name); }
+    ~PhaseScope() { ph_end(pl); }
+
+  private:
+    PhaseScope(const PhaseScope&);
+    PhaseScope& operator=(const PhaseScope&);
+    PhaseLog* pl;
+};
+#endif
+
+#endif
@@ -0,0 +1,398 @@
+/* Concurrent right hand side scenarios, see scenario.h */
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "scenario.h"
+#include "threadpool.h"
+#include "walltime.h"
+
+/* Per worker: its environment and model, and its share of the dual
+ * statistics as running means and sums of squared deviations (Welford) */
+
+typedef struct {
+  GRBenv    *env;
+  GRBmodel  *model;
+  int        threads;
+  int        nrows;
+  int        nopt;
+  double    *pi;
+  double    *mean, *m2, *min, *max;
+  int       *nonzero;
+} Worker;
+
+typedef struct {
+  ScBuildFunc          build;
+  void                *arg;
+  const ScenarioSpec  *spec;
+  ScenarioResult      *res;
+  Worker              *w;
+  pthread_mutex_t      lock;
+  int                  error;     /* first error of any worker */
+} Run;
+
+int sc_plan(int cores, int nscen, ScPolicy policy, int workers, int *threads)
+{
+	int n, i;
+
+	if (cores < 1) {
+		long online = sysconf(_SC_NPROCESSORS_ONLN);
+		cores = online > 0 ? online : 1;
+	}
+	if (nscen < 1) nscen = 1;
+
+	if (policy == SC_THREADS) {
+		threads[0] = cores;
+		return 1;
+	}
+	n = workers > 0 ? workers : cores;
+	if (n > nscen) n = nscen;
+	for (i=0; i<n; i++)
+		threads[i] = policy == SC_SOLVES || n >= cores ? 1 : cores/n + (i < cores%n);
+	return n;
+}
+
+/* start_worker
+ * output: error code; w has its own environment, with w->threads threads
+ *         and no output, its model and its statistics arrays
+ */
+static int start_worker(Run *r, Worker *w)
+{
+	int error, i;
+
+	error = GRBemptyenv(&w->env);
+	if (error) return error;
+	error = GRBsetintparam(w->env, GRB_INT_PAR_OUTPUTFLAG, 0);
+	if (error) return error;
+	error = GRBsetintparam(w->env, GRB_INT_PAR_THREADS, w->threads);
+	if (error) return error;
+	error = GRBstartenv(w->env);
+	if (error) return error;
+
+	error = r->build(w->env, r->arg, &w->model);
+	if (error) return error;
+	error = GRBgetintattr(w->model, GRB_INT_ATTR_NUMCONSTRS, &w->nrows);
+	if (error) return error;
+
+	w->pi      = malloc(w->nrows*sizeof(double) + 1);
+	w->mean    = calloc(w->nrows+1, sizeof(double));
+	w->m2      = calloc(w->nrows+1, sizeof(double));
+	w->min     = malloc(w->nrows*sizeof(double) + 1);
+	w->max     = malloc(w->nrows*sizeof(double) + 1);
+	w->nonzero = calloc(w->nrows+1, sizeof(int));
+	if (!w->pi || !w->mean || !w->m2 || !w->min || !w->max || !w->nonzero)
+		return GRB_ERROR_OUT_OF_MEMORY;
+	for (i=0; i<w->nrows; i++) {
+		w->min[i] =  GRB_INFINITY;
+		w->max[i] = -GRB_INFINITY;
+	}
+	return 0;
+}
+
+static void solve_scenario(void *arg, int s, int worker)
+{
+	Run                *r = arg;
+	Worker             *w = &r->w[worker];
+	const ScenarioSpec *spec = r->spec;
+	ScenarioResult     *res = &r->res[s];
+	double              start, d;
+	int                 error, i;
+
+	pthread_mutex_lock(&r->lock);
+	error = r->error;
+	pthread_mutex_unlock(&r->lock);
+	if (error) return;
+
+	if (w->model == NULL) {
+		error = start_worker(r, w);
+		if (error) goto QUIT;
+	}
+
+	start = walltime();
+	error = GRBsetdblattrlist(w->model, GRB_DBL_ATTR_RHS, spec->len, spec->ind,
+	                          spec->rhs + (size_t) s*spec->len);
+	if (error) goto QUIT;
+	error = GRBoptimize(w->model);
+	if (error) goto QUIT;
+	res->secs   = walltime() - start;
+	res->worker = worker;
+	res->objval = NAN;
+
+	error = GRBgetintattr(w->model, GRB_INT_ATTR_STATUS, &res->status);
+	if (error) goto QUIT;
+	error = GRBgetdblattr(w->model, GRB_DBL_ATTR_ITERCOUNT, &res->iters);
+	if (error) goto QUIT;
+	if (res->status != GRB_OPTIMAL)
+		goto QUIT;
+
+	error = GRBgetdblattr(w->model, GRB_DBL_ATTR_OBJVAL, &res->objval);
+	if (error) goto QUIT;
+	error = GRBgetdblattrarray(w->model, GRB_DBL_ATTR_PI, 0, w->nrows, w->pi);
+	if (error) goto QUIT;
+
+	w->nopt++;
+	for (i=0; i<w->nrows; i++) {
+		d = w->pi[i] - w->mean[i];
+		w->mean[i] += d/w->nopt;
+		w->m2[i]   += d*(w->pi[i] - w->mean[i]);
+		if (w->pi[i] < w->min[i]) w->min[i] = w->pi[i];
+		if (w->pi[i] > w->max[i]) w->max[i] = w->pi[i];
+		if (fabs(w->pi[i]) > 1e-9) w->nonzero[i]++;
+	}
+
+QUIT:
+	if (error) {
+		pthread_mutex_lock(&r->lock);
+		if (!r->error) r->error = error;
+		pthread_mutex_unlock(&r->lock);
+	}
+}
+
+static int cmpdbl(const void *a, const void *b)
+{
+	double x = *(const double *) a, y = *(const double *) b;
+	return x < y ? -1 : x > y;
+}
+
+/* quantile
+ * inputs: v[n] sorted, n >= 1, 0 <= q <= 1
+ * output: the q quantile, interpolated between neighbours
+ */
+static double quantile(const double *v, int n, double q)
+{
+	double pos = q*(n-1);
+	int    i = (int) pos;
+
+	return i+1 < n ? v[i] + (pos-i)*(v[i+1]-v[i]) : v[n-1];
+}
+
+/* merge_stats
+ * output: error code; stats holds the objective statistics of res and the
+ *         dual statistics of the workers, merged pairwise (Chan et al.)
+ */
+static int merge_stats(const Run *r, int nworkers, ScenarioStats *stats)
+{
+	const ScenarioSpec *spec = r->spec;
+	double *obj, sum = 0, sq = 0;
+	int     s, k, i, n = 0, m = 0;
+
+	for (k=0; k<nworkers; k++)
+		if (r->w[k].model) m = r->w[k].nrows;
+
+	obj               = malloc(spec->nscen*sizeof(double) + 1);
+	stats->nrows      = m;
+	stats->pimean     = calloc(m+1, sizeof(double));
+	stats->pistd      = calloc(m+1, sizeof(double));
+	stats->pimin      = malloc(m*sizeof(double) + 1);
+	stats->pimax      = malloc(m*sizeof(double) + 1);
+	stats->pinonzero  = calloc(m+1, sizeof(int));
+	if (!obj || !stats->pimean || !stats->pistd || !stats->pimin || !stats->pimax ||
+	    !stats->pinonzero) {
+		free(obj);
+		return GRB_ERROR_OUT_OF_MEMORY;
+	}
+
+	for (s=0; s<spec->nscen; s++)
+		if (r->res[s].status == GRB_OPTIMAL) {
+			obj[n++] = r->res[s].objval;
+			sum += r->res[s].objval;
+		}
+	stats->nopt = n;
+	if (n > 0) {
+		stats->objmean = sum/n;
+		for (s=0; s<n; s++) sq += (obj[s]-stats->objmean)*(obj[s]-stats->objmean);
+		stats->objstd = n > 1 ? sqrt(sq/(n-1)) : 0;
+		qsort(obj, n, sizeof(double), cmpdbl);
+		stats->objmin = obj[0];
+		stats->objmax = obj[n-1];
+		stats->objp05 = quantile(obj, n, 0.05);
+		stats->objp50 = quantile(obj, n, 0.50);
+		stats->objp95 = quantile(obj, n, 0.95);
+	} else {
+		stats->objmean = stats->objstd = stats->objmin = stats->objmax = NAN;
+		stats->objp05 = stats->objp50 = stats->objp95 = NAN;
+	}
+	free(obj);
+
+	for (i=0; i<m; i++) {
+		double mean = 0, m2 = 0, lo = GRB_INFINITY, hi = -GRB_INFINITY;
+		int    na = 0, nz = 0;
+
+		for (k=0; k<nworkers; k++) {
+			const Worker *w = &r->w[k];
+			double d;
+			if (w->nopt == 0 || w->nrows != m) continue;
+			d     = w->mean[i] - mean;
+			mean += d*w->nopt/(na + w->nopt);
+			m2   += w->m2[i] + d*d*(double) na*w->nopt/(na + w->nopt);
+			na   += w->nopt;
+			if (w->min[i] < lo) lo = w->min[i];
+			if (w->max[i] > hi) hi = w->max[i];
+			nz   += w->nonzero[i];
+		}
+		stats->pimean[i]    = na > 0 ? mean : NAN;
+		stats->pistd[i]     = na > 1 ? sqrt(m2/(na-1)) : 0;
+		stats->pimin[i]     = na > 0 ? lo : NAN;
+		stats->pimax[i]     = na > 0 ? hi : NAN;
+		stats->pinonzero[i] = nz;
+	}
+	return 0;
+}
+
+int sc_run(ScBuildFunc build, void *arg, const ScenarioSpec *spec,
+           int cores, ScPolicy policy, int workers,
+           ScenarioResult *res, ScenarioStats *stats)
+{
+	Run         r;
+	ThreadPool *tp = NULL;
+	int        *threads = NULL;
+	int         nworkers = 0, n, k, error = 0;
+	long        online = sysconf(_SC_NPROCESSORS_ONLN);
+	double      start = walltime();
+
+	memset(stats, 0, sizeof(*stats));
+	memset(&r, 0, sizeof(r));
+	r.build = build;
+	r.arg   = arg;
+	r.spec  = spec;
+	r.res   = res;
+	pthread_mutex_init(&r.lock, NULL);
+
+	n = cores > 0 ? cores : online > 0 ? online : 1;
+	if (workers > n) n = workers;
+	threads = malloc((n + 1)*sizeof(int));
+	if (threads == NULL) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+	nworkers = sc_plan(cores, spec->nscen, policy, workers, threads);
+	r.w = calloc(nworkers, sizeof(Worker));
+	tp  = tp_create(nworkers);
+	if (r.w == NULL || tp == NULL) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+	stats->workers = nworkers;
+	for (k=0; k<nworkers; k++) {
+		r.w[k].threads = threads[k];
+		if (threads[k] > stats->threads) stats->threads = threads[k];
+	}
+
+	for (k=0; k<spec->nscen; k++) {
+		res[k].status = 0;
+		res[k].objval = NAN;
+		res[k].iters  = res[k].secs = 0;
+		res[k].worker = -1;
+	}
+	tp_run(tp, spec->nscen, solve_scenario, &r);
+	error = r.error;
+	if (error) goto QUIT;
+
+	error = merge_stats(&r, nworkers, stats);
+	stats->secs = walltime() - start;
+
+QUIT:
+	tp_free(tp);
+	if (r.w)
+		for (k=0; k<nworkers; k++) {
+			Worker *w = &r.w[k];
+			GRBfreemodel(w->model);
+			GRBfreeenv(w->env);
+			free(w->pi);
+			free(w->mean);
+			free(w->m2);
+			free(w->min);
+			free(w->max);
+			free(w->nonzero);
+		}
+	free(r.w);
+	free(threads);
+	pthread_mutex_destroy(&r.lock);
+	return error;
+}
+
+typedef struct {
+  int     row;
+  int     nonzero;
+  double  absmean;
+} RowRank;
+
+static int cmprank(const void *a, const void *b)
+{
+	const RowRank *x = a, *y = b;
+
+	if (x->nonzero != y->nonzero) return y->nonzero - x->nonzero;
+	if (x->absmean != y->absmean) return x->absmean < y->absmean ? 1 : -1;
+	return x->row - y->row;
+}
+
+void sc_report(FILE *out, const ScenarioSpec *spec, const ScenarioResult *res,
+               const ScenarioStats *stats, char **label, int top)
+{
+	RowRank *rank;
+	double   iters = 0;
+	int      infeas = 0, other = 0, s, i, w = 10;
+
+	for (s=0; s<spec->nscen; s++) {
+		iters += res[s].iters;
+		if (res[s].status == GRB_INFEASIBLE || res[s].status == GRB_INF_OR_UNBD)
+			infeas++;
+		else if (res[s].status != GRB_OPTIMAL)
+			other++;
+	}
+
+	fprintf(out, "\n%d scenarios on %d workers (up to %d threads each), %.3f s, "
+	        "%.1f scenarios/s, %.1f iterations per scenario\n",
+	        spec->nscen, stats->workers, stats->threads, stats->secs,
+	        stats->secs > 0 ? spec->nscen/stats->secs : 0.0,
+	        spec->nscen ? iters/spec->nscen : 0.0);
+	fprintf(out, "  %d optimal, %d infeasible, %d stopped\n", stats->nopt, infeas, other);
+	if (stats->nopt == 0)
+		return;
+	fprintf(out, "\nObjective over the optimal scenarios:\n");
+	fprintf(out, "  mean %13.6e  std %12.4e\n", stats->objmean, stats->objstd);
+	fprintf(out, "  min  %13.6e  p5  %13.6e  p50 %13.6e  p95 %13.6e  max %13.6e\n",
+	        stats->objmin, stats->objp05, stats->objp50, stats->objp95, stats->objmax);
+
+	if (top > stats->nrows) top = stats->nrows;
+	rank = malloc(stats->nrows*sizeof(RowRank) + 1);
+	if (rank == NULL || top < 1) {
+		free(rank);
+		return;
+	}
+	for (i=0; i<stats->nrows; i++) {
+		rank[i].row     = i;
+		rank[i].nonzero = stats->pinonzero[i];
+		rank[i].absmean = fabs(stats->pimean[i]);
+	}
+	qsort(rank, stats->nrows, sizeof(RowRank), cmprank);
+	if (label)
+		for (i=0; i<top; i++)
+			if ((int) strlen(label[rank[i].row]) > w) w = strlen(label[rank[i].row]);
+
+	fprintf(out, "\nRows with the most often nonzero duals:\n");
+	fprintf(out, "  %-*s  nonzero   dual mean    dual std    dual min    dual max\n", w, "row");
+	for (i=0; i<top; i++) {
+		int r = rank[i].row;
+		if (label)
+			fprintf(out, "  %-*s", w, label[r]);
+		else
+			fprintf(out, "  %-*d", w, r);
+		fprintf(out, " %7.1f%% %11.4g %11.4g %11.4g %11.4g\n",
+		        100.0*stats->pinonzero[r]/stats->nopt, stats->pimean[r],
+		        stats->pistd[r], stats->pimin[r], stats->pimax[r]);
+	}
+	free(rank);
+}
+
+void sc_stats_free(ScenarioStats *stats)
+{
+	free(stats->pimean);
+	free(stats->pistd);
+	free(stats->pimin);
+	free(stats->pimax);
+	free(stats->pinonzero);
+}
@@ -0,0 +1,103 @@
+/* Concurrent solves of one LP under many right hand side scenarios.
+
+   A scenario replaces the right hand side of a fixed set of rows, e.g. the
+   demand rows of multi_flow.  sc_run solves all of them on a pool of
+   workers.  Gurobi environments are not shared between threads, so every
+   worker starts its own environment and builds its own copy of the model
+   with the caller's build function, once, on its first scenario.  From
+   then on it only changes the right hand sides in place and re-solves, so
+   each solve starts from the basis of the worker's previous scenario.
+
+   The cores are split between concurrent solves and Gurobi's Threads
+   parameter by a policy:
+
+     SC_SOLVES   one worker per core (or the given number), Threads=1 each;
+                 the best throughput for many small or medium LPs
+     SC_THREADS  one worker with Threads=cores, the scenarios in turn; for
+                 a few big LPs that parallel barrier or concurrent speed up
+     SC_AUTO     min(scenarios, workers or cores) workers, the cores split
+                 evenly between their Threads; SC_SOLVES as soon as there
+                 are at least as many scenarios as cores
+
+   Besides one ScenarioResult per scenario, sc_run gathers statistics over
+   the optimal scenarios: mean, deviation, range and quantiles of the
+   objective and, for every row, mean, deviation and range of its dual and
+   how often it is nonzero.  The dual statistics are accumulated per worker
+   and merged at the end, so their memory does not grow with the number of
+   scenarios.
+*/
+
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <stdio.h>
+#include "gurobi_c.h"
+
+/* Build the model into env, which is the worker's; return an error code */
+typedef int (*ScBuildFunc)(GRBenv *env, void *arg, GRBmodel **model);
+
+typedef enum { SC_AUTO, SC_SOLVES, SC_THREADS } ScPolicy;
+
+typedef struct {
+  int      len;         /* rows whose right hand side changes */
+  int     *ind;         /* [len] their indices */
+  int      nscen;
+  double  *rhs;         /* [nscen*len] right hand sides of ind per scenario */
+} ScenarioSpec;
+
+typedef struct {
+  int      status;
+  double   objval;      /* NaN unless optimal */
+  double   iters;
+  double   secs;        /* wall time of change + solve */
+  int      worker;
+} ScenarioResult;
+
+typedef struct {
+  int      workers;     /* concurrent solves */
+  int      threads;     /* Threads of the busiest worker */
+  int      nopt;        /* optimal scenarios, which the statistics are over */
+  double   objmean, objstd, objmin, objmax;
+  double   objp05, objp50, objp95;
+  int      nrows;
+  double  *pimean;      /* [nrows] */
+  double  *pistd;
+  double  *pimin;
+  double  *pimax;
+  int     *pinonzero;   /* [nrows] optimal scenarios where |dual| > 1e-9 */
+  double   secs;        /* wall time of the whole run */
+} ScenarioStats;
+
+/* sc_plan
+ * inputs: cores    cores to use, < 1 for every online processor
+ *         nscen    number of scenarios
+ *         policy   see above
+ *         workers  concurrent solves for SC_SOLVES and SC_AUTO, < 1 for
+ *                  one per core; more than cores oversubscribes them
+ * output: number of workers; threads[w] receives the Threads parameter of
+ *         worker w (threads must have room for max(cores, workers)
+ *         entries)
+ */
+int sc_plan(int cores, int nscen, ScPolicy policy, int workers, int *threads);
+
+/* sc_run
+ * inputs: build, arg  builds the model of a worker
+ *         spec        scenarios
+ *         cores, policy, workers  as for sc_plan
+ * output: error code (the first a worker met); res[nscen] and stats filled
+ *         (free stats with sc_stats_free)
+ */
+int sc_run(ScBuildFunc build, void *arg, const ScenarioSpec *spec,
+           int cores, ScPolicy policy, int workers,
+           ScenarioResult *res, ScenarioStats *stats);
+
+/* sc_report
+ * Print the objective statistics, the status counts and the top rows with
+ * the most often nonzero duals (label[nrows] names them, may be NULL).
+ */
+void sc_report(FILE *out, const ScenarioSpec *spec, const ScenarioResult *res,
+               const ScenarioStats *stats, char **label, int top);
+
+void sc_stats_free(ScenarioStats *stats);
+
+#endif
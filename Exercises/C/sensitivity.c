@@ -0,0 +1,94 @@
+/* Sensitivity ranges of an optimal LP basis.  See sensitivity.h */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensitivity.h"
+
+int sa_read(LPModel *lp, int n, int m, SARanges *sa)
+{
+	int error;
+
+	memset(sa, 0, sizeof(SARanges));
+	sa->buf = malloc((6*n + 2*m)*sizeof(double) + 1);
+	if (sa->buf == NULL)
+		return GRB_ERROR_OUT_OF_MEMORY;
+	sa->n = n;
+	sa->m = m;
+	sa->objlow = sa->buf;
+	sa->objup  = sa->buf + n;
+	sa->lblow  = sa->buf + 2*n;
+	sa->lbup   = sa->buf + 3*n;
+	sa->ublow  = sa->buf + 4*n;
+	sa->ubup   = sa->buf + 5*n;
+	sa->rhslow = sa->buf + 6*n;
+	sa->rhsup  = sa->buf + 6*n + m;
+
+	error = lm_getdblarray(lp, GRB_DBL_ATTR_SAOBJLOW, 0, n, sa->objlow);
+	if (error) return error;
+	error = lm_getdblarray(lp, GRB_DBL_ATTR_SAOBJUP, 0, n, sa->objup);
+	if (error) return error;
+	error = lm_getdblarray(lp, GRB_DBL_ATTR_SALBLOW, 0, n, sa->lblow);
+	if (error) return error;
+	error = lm_getdblarray(lp, GRB_DBL_ATTR_SALBUP, 0, n, sa->lbup);
+	if (error) return error;
+	error = lm_getdblarray(lp, GRB_DBL_ATTR_SAUBLOW, 0, n, sa->ublow);
+	if (error) return error;
+	error = lm_getdblarray(lp, GRB_DBL_ATTR_SAUBUP, 0, n, sa->ubup);
+	if (error) return error;
+	error = lm_getdblarray(lp, GRB_DBL_ATTR_SARHSLOW, 0, m, sa->rhslow);
+	if (error) return error;
+	return lm_getdblarray(lp, GRB_DBL_ATTR_SARHSUP, 0, m, sa->rhsup);
+}
+
+/* Print v in a field of width 9, infinite ends as inf */
+
+static void num(FILE *out, double v)
+{
+	if (v >= GRB_INFINITY)
+		fprintf(out, " %9s", "inf");
+	else if (v <= -GRB_INFINITY)
+		fprintf(out, " %9s", "-inf");
+	else
+		fprintf(out, " %9.4g", v);
+}
+
+void sa_print_columns(FILE *out, char **varnames, const double *x, const double *rc,
+                      const SARanges *sa)
+{
+	int j;
+
+	fprintf(out, "\nVariables:\nV Name      Value    Red. Cost"
+	        "   Obj Low    Obj Up    LB Low     LB Up    UB Low     UB Up\n");
+	for (j = 0; j < sa->n; j++) {
+		fprintf(out, "%4s       %5.1f     %8.4f ", varnames[j], x[j], rc[j]);
+		num(out, sa->objlow[j]);
+		num(out, sa->objup[j]);
+		num(out, sa->lblow[j]);
+		num(out, sa->lbup[j]);
+		num(out, sa->ublow[j]);
+		num(out, sa->ubup[j]);
+		fprintf(out, "\n");
+	}
+}
+
+void sa_print_rows(FILE *out, char **conname, const double *slack, const double *pi,
+                   const SARanges *sa)
+{
+	int i;
+
+	fprintf(out, "\nConstraints:\n C Name     Slack    Dual Value"
+	        "   RHS Low    RHS Up\n");
+	for (i = 0; i < sa->m; i++) {
+		fprintf(out, "%7s    %5.1f     %8.4f ", conname[i], slack[i], pi[i]);
+		num(out, sa->rhslow[i]);
+		num(out, sa->rhsup[i]);
+		fprintf(out, "\n");
+	}
+}
+
+void sa_free(SARanges *sa)
+{
+	free(sa->buf);
+	sa->buf = NULL;
+}
@@ -0,0 +1,57 @@
+/* Sensitivity ranges of an optimal LP basis, read in bulk.
+
+   How far can a cost or a requirement of the diet move before the optimal
+   basis changes?  Re-solving the model over a grid of values answers that
+   with one solve per point.  The final basis already answers it: Gurobi
+   (and the dense simplex of lpmodel.h) return, per column,
+
+     SAObjLow, SAObjUp  range of the objective coefficient
+     SALBLow, SALBUp    range of the lower bound
+     SAUBLow, SAUBUp    range of the upper bound
+
+   and per row SARHSLow, SARHSUp, the range of the right hand side, over
+   which the basis stays optimal.  Within a range X (objective) or Pi and RC
+   (RHS and bounds) stay the same, so the objective moves linearly.  sa_read
+   reads each of them with one array call after the solve, and
+   sa_print_columns and sa_print_rows print them next to the
+   Value/Red. Cost and Slack/Dual tables.
+
+   Infinite ends are GRB_INFINITY and print as "inf".
+*/
+
+#ifndef SENSITIVITY_H
+#define SENSITIVITY_H
+
+#include <stdio.h>
+#include "lpmodel.h"
+
+typedef struct {
+  int      n, m;
+  double  *objlow, *objup;    /* [n] */
+  double  *lblow, *lbup;      /* [n] */
+  double  *ublow, *ubup;      /* [n] */
+  double  *rhslow, *rhsup;    /* [m] */
+  double  *buf;               /* the block all of them point into */
+} SARanges;
+
+/* sa_read
+ * inputs: lp  optimal LP of n columns and m rows
+ * output: error code, GRB_ERROR_OUT_OF_MEMORY or that of lm_getdblarray
+ *         (lm_errormsg); sa filled, free with sa_free also on error
+ */
+int sa_read(LPModel *lp, int n, int m, SARanges *sa);
+
+/* sa_print_columns, sa_print_rows
+ * inputs: varnames, x, rc    [n] of the columns
+ *         conname, slack, pi  [m] of the rows
+ *         sa                  ranges from sa_read
+ * The Variables and Constraints tables of diet, with the ranges appended.
+ */
+void sa_print_columns(FILE *out, char **varnames, const double *x, const double *rc,
+                      const SARanges *sa);
+void sa_print_rows(FILE *out, char **conname, const double *slack, const double *pi,
+                   const SARanges *sa);
+
+void sa_free(SARanges *sa);
+
+#endif
@@ -0,0 +1,495 @@
+/* Progress telemetry from Gurobi callbacks.  See solvetrace.h */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "solvetrace.h"
+#include "../../readlog/logformat.h"
+
+#define CACHELINE 64
+
+/* Records drained from the ring, one array per field */
+typedef struct {
+  int64_t   n, cap;
+  int8_t   *where;
+  int64_t  *ns;
+  double   *runtime, *obj, *objbst, *objbnd, *nodes, *nodlft, *iters, *infeas;
+} TraceColumns;
+
+/* head is written by the producer only, tail by the drain thread only; they
+   sit on cache lines of their own so that neither side invalidates the
+   other's line on every record.  The producer keeps a stale copy of tail and
+   rereads the real one only when the ring looks full. */
+struct SolveTrace {
+  uint64_t      head __attribute__((aligned(CACHELINE)));
+  uint64_t      tailseen;       /* producer's copy of tail */
+  int64_t       dropped;
+
+  uint64_t      tail __attribute__((aligned(CACHELINE)));
+
+  TraceRecord  *ring __attribute__((aligned(CACHELINE)));
+  uint64_t      mask;           /* capacity - 1 */
+  pthread_t     drainer;
+  int           running;
+  int           stop;
+  int           nomem;          /* the columns could not grow */
+  int64_t       start_time, end_time;
+  TraceColumns  cols;
+};
+
+static int64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* grow
+ * Make room for at least need records in c.  Returns 0, or -1 out of memory.
+ */
+static int grow(TraceColumns *c, int64_t need)
+{
+	int64_t cap = c->cap > 0 ? c->cap : 1024;
+	void   *p;
+
+	if (need <= c->cap)
+		return 0;
+	while (cap < need)
+		cap *= 2;
+#define GROW(field) \
+	if ((p = realloc(c->field, cap * sizeof(*c->field))) == NULL) return -1; \
+	c->field = p;
+	GROW(where) GROW(ns) GROW(runtime) GROW(obj) GROW(objbst) GROW(objbnd)
+	GROW(nodes) GROW(nodlft) GROW(iters) GROW(infeas)
+#undef GROW
+	c->cap = cap;
+	return 0;
+}
+
+/* drain
+ * Move everything in the ring to the columns.  Returns the number moved.
+ */
+static uint64_t drain(SolveTrace *st)
+{
+	uint64_t      t = st->tail;
+	uint64_t      h = __atomic_load_n(&st->head, __ATOMIC_ACQUIRE);
+	TraceColumns *c = &st->cols;
+
+	if (h == t)
+		return 0;
+	if (grow(c, c->n + (int64_t) (h - t)) < 0) {
+		st->nomem = 1;
+		__atomic_fetch_add(&st->dropped, (int64_t) (h - t), __ATOMIC_RELAXED);
+	} else {
+		for (uint64_t k = t; k < h; k++) {
+			const TraceRecord *r = &st->ring[k & st->mask];
+			int64_t            n = c->n++;
+
+			c->where[n]   = (int8_t) r->where;
+			c->ns[n]      = r->ns;
+			c->runtime[n] = r->runtime;
+			c->obj[n]     = r->obj;
+			c->objbst[n]  = r->objbst;
+			c->objbnd[n]  = r->objbnd;
+			c->nodes[n]   = r->nodes;
+			c->nodlft[n]  = r->nodlft;
+			c->iters[n]   = r->iters;
+			c->infeas[n]  = r->infeas;
+		}
+	}
+	__atomic_store_n(&st->tail, h, __ATOMIC_RELEASE);
+	return h - t;
+}
+
+static void *drain_main(void *p)
+{
+	SolveTrace            *st = p;
+	const struct timespec  ms = { 0, 1000000 };
+
+	while (!__atomic_load_n(&st->stop, __ATOMIC_ACQUIRE))
+		if (drain(st) == 0)
+			nanosleep(&ms, NULL);
+	drain(st);
+	return NULL;
+}
+
+SolveTrace *st_create(int capacity)
+{
+	SolveTrace *st;
+	uint64_t    cap = 1;
+
+	if (capacity < 1)
+		capacity = 65536;
+	while (cap < (uint64_t) capacity)
+		cap *= 2;
+
+	if (posix_memalign((void **) &st, CACHELINE, sizeof(*st)) != 0)
+		return NULL;
+	memset(st, 0, sizeof(*st));
+	st->mask = cap - 1;
+	st->start_time = time(NULL);
+	st->ring = malloc(cap * sizeof(TraceRecord));
+	if (st->ring == NULL || pthread_create(&st->drainer, NULL, drain_main, st) != 0) {
+		free(st->ring);
+		free(st);
+		return NULL;
+	}
+	st->running = 1;
+	return st;
+}
+
+void st_push(SolveTrace *st, const TraceRecord *r)
+{
+	uint64_t h = st->head;
+
+	if (h - st->tailseen > st->mask) {
+		st->tailseen = __atomic_load_n(&st->tail, __ATOMIC_ACQUIRE);
+		if (h - st->tailseen > st->mask) {
+			__atomic_fetch_add(&st->dropped, 1, __ATOMIC_RELAXED);
+			return;
+		}
+	}
+	st->ring[h & st->mask] = *r;
+	if (r->ns == 0)
+		st->ring[h & st->mask].ns = now_ns();
+	__atomic_store_n(&st->head, h + 1, __ATOMIC_RELEASE);
+}
+
+int __stdcall st_callback(GRBmodel *model, void *cbdata, int where, void *usrdata)
+{
+	TraceRecord r;
+	int         itrcnt;
+
+	(void) model;
+	r.ns = 0;
+	r.runtime = r.obj = r.objbst = r.objbnd = NAN;
+	r.nodes = r.nodlft = r.iters = r.infeas = NAN;
+	r.where = where;
+
+	switch (where) {
+	case GRB_CB_SIMPLEX:
+		GRBcbget(cbdata, where, GRB_CB_SPX_ITRCNT, &r.iters);
+		GRBcbget(cbdata, where, GRB_CB_SPX_OBJVAL, &r.obj);
+		GRBcbget(cbdata, where, GRB_CB_SPX_PRIMINF, &r.infeas);
+		break;
+	case GRB_CB_BARRIER:
+		if (GRBcbget(cbdata, where, GRB_CB_BARRIER_ITRCNT, &itrcnt) == 0)
+			r.iters = itrcnt;
+		GRBcbget(cbdata, where, GRB_CB_BARRIER_PRIMOBJ, &r.obj);
+		break;
+	case GRB_CB_MIP:
+		GRBcbget(cbdata, where, GRB_CB_MIP_OBJBST, &r.objbst);
+		GRBcbget(cbdata, where, GRB_CB_MIP_OBJBND, &r.objbnd);
+		GRBcbget(cbdata, where, GRB_CB_MIP_NODCNT, &r.nodes);
+		GRBcbget(cbdata, where, GRB_CB_MIP_NODLFT, &r.nodlft);
+		GRBcbget(cbdata, where, GRB_CB_MIP_ITRCNT, &r.iters);
+		break;
+	case GRB_CB_MIPSOL:
+		GRBcbget(cbdata, where, GRB_CB_MIPSOL_OBJ, &r.obj);
+		GRBcbget(cbdata, where, GRB_CB_MIPSOL_OBJBST, &r.objbst);
+		GRBcbget(cbdata, where, GRB_CB_MIPSOL_OBJBND, &r.objbnd);
+		GRBcbget(cbdata, where, GRB_CB_MIPSOL_NODCNT, &r.nodes);
+		break;
+	default:
+		return 0;
+	}
+	GRBcbget(cbdata, where, GRB_CB_RUNTIME, &r.runtime);
+	st_push(usrdata, &r);
+	return 0;
+}
+
+int st_instance(GRBmodel *model, const char *name, TraceInstance *inst)
+{
+	int error;
+
+	inst->name = name;
+	inst->objval = inst->objbound = inst->timelimit = NAN;
+	inst->nodes = inst->iters = NAN;
+	error = GRBgetintattr(model, GRB_INT_ATTR_NUMCONSTRS, &inst->rows);
+	if (!error) error = GRBgetintattr(model, GRB_INT_ATTR_NUMVARS, &inst->cols);
+	if (!error) {
+		int nz;
+		error = GRBgetintattr(model, GRB_INT_ATTR_NUMNZS, &nz);
+		inst->nonzeros = nz;
+	}
+	if (!error) error = GRBgetintattr(model, GRB_INT_ATTR_STATUS, &inst->status);
+	if (!error) error = GRBgetdblattr(model, GRB_DBL_ATTR_RUNTIME, &inst->runtime);
+	if (!error) error = GRBgetdblparam(GRBgetenv(model), GRB_DBL_PAR_TIMELIMIT, &inst->timelimit);
+	if (error)
+		return error;
+
+	/* Not available for every model or status */
+	if (GRBgetdblattr(model, GRB_DBL_ATTR_OBJVAL, &inst->objval)) inst->objval = NAN;
+	if (GRBgetdblattr(model, GRB_DBL_ATTR_OBJBOUND, &inst->objbound)) inst->objbound = NAN;
+	if (GRBgetdblattr(model, GRB_DBL_ATTR_NODECOUNT, &inst->nodes)) inst->nodes = NAN;
+	if (GRBgetdblattr(model, GRB_DBL_ATTR_ITERCOUNT, &inst->iters)) inst->iters = NAN;
+	return 0;
+}
+
+/* Writing the trace as a log store.  The layout, the instance and node
+   columns and the instance name are those of readlog/logformat.h, which
+   the log tools read the store with. */
+
+#define MAXCOLUMNS 64
+
+typedef struct {
+  LogStoreColumn  col[MAXCOLUMNS];
+  const void     *data[MAXCOLUMNS];
+  int             n;
+} StoreDir;
+
+#define TYPE_CODE(x) _Generic((x), char: 'c', int8_t: 'b', int32_t: 'i', int64_t: 'l', double: 'd')
+
+static void add(StoreDir *d, char table, const char *name, char type, int elsize,
+                const void *data, uint64_t count)
+{
+	LogStoreColumn *c = &d->col[d->n];
+
+	memset(c, 0, sizeof(*c));
+	strncpy(c->name, name, sizeof(c->name) - 1);
+	c->table  = table;
+	c->type   = type;
+	c->elsize = elsize;
+	c->count  = count;
+	d->data[d->n++] = data;
+}
+
+#define ADD(d, t, name, p, n) add(d, t, name, TYPE_CODE(*(p)), sizeof(*(p)), p, n)
+
+static int write_dir(const StoreDir *d, const LogStoreHeader *h, const char *file)
+{
+	static const char zeros[LOGSTORE_ALIGN];
+	LogStoreColumn    col[MAXCOLUMNS];
+	uint64_t          offset = sizeof(*h) + d->n * sizeof(LogStoreColumn);
+	char             *tmp;
+	FILE             *f;
+	int               i, ok, saved;
+
+	for (i = 0; i < d->n; i++) {
+		col[i] = d->col[i];
+		offset = (offset + LOGSTORE_ALIGN - 1) / LOGSTORE_ALIGN * LOGSTORE_ALIGN;
+		col[i].offset = offset;
+		offset += col[i].count * col[i].elsize;
+	}
+
+	tmp = malloc(strlen(file) + 5);
+	if (tmp == NULL)
+		return -1;
+	sprintf(tmp, "%s.tmp", file);
+	f = fopen(tmp, "wb");
+	if (f == NULL) {
+		free(tmp);
+		return -1;
+	}
+	ok = fwrite(h, sizeof(*h), 1, f) == 1 && fwrite(col, sizeof(LogStoreColumn), d->n, f) == (size_t) d->n;
+	for (i = 0; ok && i < d->n; i++) {
+		long   pad   = (long) col[i].offset - ftell(f);
+		size_t bytes = col[i].count * col[i].elsize;
+		ok = (pad == 0 || fwrite(zeros, pad, 1, f) == 1) &&
+		     (bytes == 0 || fwrite(d->data[i], bytes, 1, f) == 1);
+	}
+	if (fclose(f) != 0)
+		ok = 0;
+	if (!ok || rename(tmp, file) != 0) {
+		saved = errno;
+		unlink(tmp);
+		free(tmp);
+		errno = saved;
+		return -1;
+	}
+	free(tmp);
+	return 0;
+}
+
+static double finite_or_nan(double x)
+{
+	return fabs(x) < GRB_INFINITY ? x : NAN;
+}
+
+static double mip_gap(double bst, double bnd)
+{
+	bst = finite_or_nan(bst);
+	bnd = finite_or_nan(bnd);
+	if (isnan(bst) || isnan(bnd))
+		return NAN;
+	return bst != 0 ? fabs(bst - bnd) / fabs(bst) : (bnd == 0 ? 0 : INFINITY);
+}
+
+/* One field per column of the lists in logformat.h: the instance's value,
+   or the array of the node rows */
+#define INST_FIELD(type, name) type name;
+#define NODE_FIELD(type, name) type *name;
+typedef struct { LOG_INSTANCE_COLUMNS(INST_FIELD) } StoreInstance;
+typedef struct { LOG_NODE_COLUMNS(NODE_FIELD) } StoreNodes;
+#undef INST_FIELD
+#undef NODE_FIELD
+
+static int write_store(SolveTrace *st, const TraceInstance *inst, const char *file)
+{
+	const TraceColumns *c = &st->cols;
+	StoreDir            d;
+	LogStoreHeader      h;
+	StoreInstance       si;
+	StoreNodes          sn;
+	int64_t             nn = 0, k, r;
+	char               *strings = NULL;
+	size_t              plen = strlen(inst->name), flen = strlen(file), nfirst, nlen;
+	int64_t             name_first, run_first = (int64_t) plen, by_name = 0;
+	int32_t             name_len, run_len = (int32_t) flen;
+	int                 ok, error = -1;
+
+	/* One instance; what a trace does not know is missing, as the parser
+	   leaves it: NaN for doubles, -1 for integers */
+#define MISSING(type, name) si.name = (type) (TYPE_CODE(si.name) == 'd' ? NAN : -1);
+	LOG_INSTANCE_COLUMNS(MISSING)
+#undef MISSING
+	si.path_first = 0;
+	si.path_len   = (int32_t) plen;
+	si.run        = 0;
+	si.start_time = st->start_time;
+	si.end_time   = st->end_time;
+	si.time_limit = inst->timelimit < GRB_INFINITY ? inst->timelimit : NAN;
+	si.rows       = inst->rows;
+	si.cols       = inst->cols;
+	si.nonzeros   = inst->nonzeros;
+	si.nodes      = isnan(inst->nodes) ? -1 : (int64_t) inst->nodes;
+	si.simplex_iters = isnan(inst->iters) ? -1 : (int64_t) inst->iters;
+	si.runtime    = inst->runtime;
+	si.best_obj   = inst->objval;
+	si.best_bound = inst->objbound;
+	si.gap        = mip_gap(inst->objval, inst->objbound);
+	si.status     = inst->status == GRB_OPTIMAL ? LOG_OPTIMAL :
+	                inst->status == GRB_TIME_LIMIT ? LOG_TIMELIMIT :
+	                inst->status == GRB_INFEASIBLE ? LOG_INFEASIBLE : LOG_UNKNOWN;
+	si.node_first = 0;
+	log_instance_name(inst->name, plen, &nfirst, &nlen);
+	name_first = (int64_t) nfirst;
+	name_len   = (int32_t) nlen;
+
+	/* Node rows from the MIP and MIPSOL records */
+	for (k = 0; k < c->n; k++)
+		nn += c->where[k] == GRB_CB_MIP || c->where[k] == GRB_CB_MIPSOL;
+	si.node_count = nn;
+	memset(&sn, 0, sizeof(sn));
+	strings = malloc(plen + flen + 1);
+	ok = strings != NULL;
+#define ALLOC(type, name) sn.name = malloc((nn + 1) * sizeof(type)); ok = ok && sn.name != NULL;
+	LOG_NODE_COLUMNS(ALLOC)
+#undef ALLOC
+	if (!ok) {
+		errno = ENOMEM;
+		goto QUIT;
+	}
+	memcpy(strings, inst->name, plen);
+	memcpy(strings + plen, file, flen);
+
+	/* The callbacks report neither depth nor integer infeasibilities */
+	for (k = 0, r = 0; k < c->n; k++) {
+		if (c->where[k] != GRB_CB_MIP && c->where[k] != GRB_CB_MIPSOL)
+			continue;
+		sn.type[r]      = c->where[k] == GRB_CB_MIPSOL ? LOG_NODE_BRANCHSOL : LOG_NODE_BRANCH;
+		sn.note[r]      = LOG_NOTE_NONE;
+		sn.expl[r]      = isnan(c->nodes[k]) ? -1 : (int64_t) c->nodes[k];
+		sn.unexpl[r]    = isnan(c->nodlft[k]) ? -1 : (int64_t) c->nodlft[k];
+		sn.obj[r]       = finite_or_nan(c->obj[k]);
+		sn.depth[r]     = -1;
+		sn.intinf[r]    = -1;
+		sn.incumbent[r] = finite_or_nan(c->objbst[k]);
+		sn.bestbd[r]    = finite_or_nan(c->objbnd[k]);
+		sn.gap[r]       = mip_gap(c->objbst[k], c->objbnd[k]);
+		sn.itnode[r]    = c->nodes[k] > 0 ? c->iters[k] / c->nodes[k] : NAN;
+		sn.time[r]      = c->runtime[k];
+		r++;
+	}
+
+	d.n = 0;
+#define ADD_INST(type, name) ADD(&d, 'i', #name, &si.name, 1);
+#define ADD_NODE(type, name) ADD(&d, 'n', #name, sn.name, nn);
+	LOG_INSTANCE_COLUMNS(ADD_INST)
+	ADD(&d, 'i', "name_first", &name_first, 1);
+	ADD(&d, 'i', "name_len", &name_len, 1);
+	LOG_NODE_COLUMNS(ADD_NODE)
+#undef ADD_INST
+#undef ADD_NODE
+
+	ADD(&d, 'r', "run_first", &run_first, 1);
+	ADD(&d, 'r', "run_len", &run_len, 1);
+	ADD(&d, 's', "strings", strings, plen + flen);
+	ADD(&d, 'x', "by_name", &by_name, 1);
+
+	ADD(&d, 't', "where", c->where, c->n);
+	ADD(&d, 't', "ns", c->ns, c->n);
+	ADD(&d, 't', "runtime", c->runtime, c->n);
+	ADD(&d, 't', "obj", c->obj, c->n);
+	ADD(&d, 't', "objbst", c->objbst, c->n);
+	ADD(&d, 't', "objbnd", c->objbnd, c->n);
+	ADD(&d, 't', "nodes", c->nodes, c->n);
+	ADD(&d, 't', "nodlft", c->nodlft, c->n);
+	ADD(&d, 't', "iters", c->iters, c->n);
+	ADD(&d, 't', "infeas", c->infeas, c->n);
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, LOGSTORE_MAGIC, sizeof(h.magic));
+	h.version      = LOGSTORE_VERSION;
+	h.numcolumns   = d.n;
+	h.numinstances = 1;
+	h.numnodes     = nn;
+	h.numruns      = 1;
+	h.numstrings   = plen + flen;
+	error = write_dir(&d, &h, file);
+
+QUIT:
+	free(strings);
+#define FREE(type, name) free(sn.name);
+	LOG_NODE_COLUMNS(FREE)
+#undef FREE
+	return error;
+}
+
+int st_finish(SolveTrace *st, const TraceInstance *inst, const char *file)
+{
+	if (st->running) {
+		__atomic_store_n(&st->stop, 1, __ATOMIC_RELEASE);
+		pthread_join(st->drainer, NULL);
+		st->running = 0;
+		st->end_time = time(NULL);
+	}
+	if (file == NULL)
+		return 0;
+	return write_store(st, inst, file);
+}
+
+int64_t st_count(const SolveTrace *st)
+{
+	return __atomic_load_n(&st->tail, __ATOMIC_ACQUIRE);
+}
+
+int64_t st_dropped(const SolveTrace *st)
+{
+	return __atomic_load_n(&st->dropped, __ATOMIC_RELAXED);
+}
+
+void st_free(SolveTrace *st)
+{
+	if (st == NULL)
+		return;
+	st_finish(st, NULL, NULL);
+	free(st->cols.where);
+	free(st->cols.ns);
+	free(st->cols.runtime);
+	free(st->cols.obj);
+	free(st->cols.objbst);
+	free(st->cols.objbnd);
+	free(st->cols.nodes);
+	free(st->cols.nodlft);
+	free(st->cols.iters);
+	free(st->cols.infeas);
+	free(st->ring);
+	free(st);
+}
@@ -0,0 +1,111 @@
+/* Progress telemetry from Gurobi callbacks.
+
+   The callback (st_callback, or st_push from a callback of your own) takes
+   one TraceRecord of node count, incumbent, best bound, iterations and
+   times per call and puts it in a single-producer single-consumer ring
+   buffer: a few stores and one release store of the head, no lock, no
+   system call and no allocation, so the solver thread never waits.  Gurobi
+   runs callbacks one at a time, on one thread, whatever Threads is, so one
+   producer is all there is.  When the ring is full the record is dropped
+   and counted rather than blocking the solve.
+
+   A drain thread empties the ring into growing column arrays every
+   millisecond.  st_finish stops it and writes the trace as a log store,
+   the columnar .mlog format of readlog/logstore.h, with one instance:
+   its MIP and MIPSOL records become node log rows, so logquery and logdiff
+   read a traced solve like a parsed log.  Every record, including the
+   SIMPLEX and BARRIER ones of LP solves, is also kept in a 't' table of
+   the store, which the log tools skip:
+
+     where  runtime  ns  obj  objbst  objbnd  nodes  nodlft  iters  infeas
+*/
+
+#ifndef SOLVETRACE_H
+#define SOLVETRACE_H
+
+#include <stdint.h>
+#include "gurobi_c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  int64_t  ns;         /* CLOCK_MONOTONIC nanoseconds at the callback */
+  double   runtime;    /* GRB_CB_RUNTIME */
+  double   obj;        /* SIMPLEX objective, BARRIER primal objective,
+                          MIPSOL objective of the new solution */
+  double   objbst;     /* MIP, MIPSOL: incumbent */
+  double   objbnd;     /* MIP, MIPSOL: best bound */
+  double   nodes;      /* MIP, MIPSOL: explored nodes */
+  double   nodlft;     /* MIP: unexplored nodes */
+  double   iters;      /* simplex or barrier iterations */
+  double   infeas;     /* SIMPLEX primal infeasibility */
+  int32_t  where;      /* GRB_CB_SIMPLEX, _MIP, _MIPSOL or _BARRIER */
+} TraceRecord;
+
+/* What the store records about the solve besides its progress, usually
+   read from the model after it (st_instance) */
+typedef struct {
+  const char *name;        /* instance name, e.g. the model file */
+  int         rows, cols;
+  int64_t     nonzeros;
+  int         status;      /* GRB_OPTIMAL, ... */
+  double      runtime;
+  double      objval;      /* NaN when there is no solution */
+  double      objbound;    /* NaN for LPs */
+  double      nodes;
+  double      iters;
+  double      timelimit;
+} TraceInstance;
+
+typedef struct SolveTrace SolveTrace;
+
+/* st_create
+ * inputs: capacity  records in the ring, rounded up to a power of 2;
+ *                   < 1 for 65536
+ * output: the trace with its drain thread running, NULL on failure
+ */
+SolveTrace *st_create(int capacity);
+
+/* st_callback
+ * Callback for GRBsetcallbackfunc with usrdata the SolveTrace: records the
+ * SIMPLEX, MIP, MIPSOL and BARRIER calls, ignores the others.  Returns 0.
+ */
+int __stdcall st_callback(GRBmodel *model, void *cbdata, int where, void *usrdata);
+
+/* st_push
+ * Append r (ns is filled in if 0).  Only ever from one thread at a time.
+ */
+void st_push(SolveTrace *st, const TraceRecord *r);
+
+/* st_instance
+ * inputs: model  after GRBoptimize, name  instance name
+ * output: error code; inst filled from the model attributes
+ */
+int st_instance(GRBmodel *model, const char *name, TraceInstance *inst);
+
+/* st_finish
+ * Stop the drain thread, take the records left in the ring and, if file
+ * is not NULL, write the trace of inst to file.  Returns 0, or -1 with
+ * errno set if the file could not be written.  No more records may be
+ * pushed afterwards.
+ */
+int st_finish(SolveTrace *st, const TraceInstance *inst, const char *file);
+
+/* st_count, st_dropped
+ * output: records taken from the ring so far, records lost to a full ring
+ */
+int64_t st_count(const SolveTrace *st);
+int64_t st_dropped(const SolveTrace *st);
+
+/* st_free
+ * Finish if needed and release everything.  Safe to call with NULL.
+ */
+void st_free(SolveTrace *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,170 @@
+/* Warm-started parametric sweeps, see sweep.h */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "sweep.h"
+#include "walltime.h"
+
+double *sw_grid(int len, const double *lo, const double *hi, const int *steps,
+                int *npoints)
+{
+	double *value;
+	int    *idx, *dir;
+	int     i, p, n = 1;
+
+	for (i=0; i<len; i++) {
+		if (steps[i] < 1) return NULL;
+		n *= steps[i];
+	}
+	value = malloc((size_t) n*len*sizeof(double) + 1);
+	idx   = calloc(len+1, sizeof(int));
+	dir   = malloc((len+1)*sizeof(int));
+	if (!value || !idx || !dir) {
+		free(value);
+		value = NULL;
+		goto QUIT;
+	}
+	for (i=0; i<len; i++) dir[i] = 1;
+
+	for (p=0; p<n; p++) {
+		for (i=0; i<len; i++)
+			value[(size_t) p*len+i] = steps[i] == 1 ? lo[i] :
+			        lo[i] + (hi[i]-lo[i])*idx[i]/(steps[i]-1);
+
+		/* Reflected mixed radix counter: step the first parameter that
+		   can still move in its direction, turning around the ones
+		   before it */
+
+		for (i=0; i<len; i++) {
+			if (idx[i]+dir[i] >= 0 && idx[i]+dir[i] < steps[i]) {
+				idx[i] += dir[i];
+				break;
+			}
+			dir[i] = -dir[i];
+		}
+	}
+	*npoints = n;
+
+QUIT:
+	free(idx);
+	free(dir);
+	return value;
+}
+
+int sw_run(GRBmodel *model, const SweepSpec *spec, int cold, SweepPoint *pt)
+{
+	int    *vbasis = NULL, *cbasis = NULL;
+	int     nvars, nconstrs, p;
+	int     havebasis = 0;
+	int     error;
+	double  start;
+
+	error = GRBupdatemodel(model);
+	if (error) return error;
+	error = GRBgetintattr(model, GRB_INT_ATTR_NUMVARS, &nvars);
+	if (error) return error;
+	error = GRBgetintattr(model, GRB_INT_ATTR_NUMCONSTRS, &nconstrs);
+	if (error) return error;
+
+	vbasis = malloc(nvars*sizeof(int) + 1);
+	cbasis = malloc(nconstrs*sizeof(int) + 1);
+	if (!vbasis || !cbasis) {
+		error = GRB_ERROR_OUT_OF_MEMORY;
+		goto QUIT;
+	}
+
+	for (p=0; p<spec->npoints; p++) {
+		start = walltime();
+		memset(&pt[p], 0, sizeof(pt[p]));
+
+		error = GRBsetdblattrlist(model, spec->attr, spec->len, spec->ind,
+		                          spec->value + (size_t) p*spec->len);
+		if (error) goto QUIT;
+
+		if (cold) {
+			error = GRBreset(model, 0);
+			if (error) goto QUIT;
+		} else if (havebasis) {
+			error = GRBsetintattrarray(model, GRB_INT_ATTR_VBASIS, 0, nvars, vbasis);
+			if (error) goto QUIT;
+			error = GRBsetintattrarray(model, GRB_INT_ATTR_CBASIS, 0, nconstrs, cbasis);
+			if (error) goto QUIT;
+		}
+
+		error = GRBoptimize(model);
+		if (error) goto QUIT;
+
+		error = GRBgetintattr(model, GRB_INT_ATTR_STATUS, &pt[p].status);
+		if (error) goto QUIT;
+		error = GRBgetdblattr(model, GRB_DBL_ATTR_ITERCOUNT, &pt[p].iters);
+		if (error) goto QUIT;
+
+		/* Keep the basis of the last optimal point; an infeasible point
+		   in the middle of a sweep does not lose it */
+
+		if (pt[p].status == GRB_OPTIMAL) {
+			error = GRBgetdblattr(model, GRB_DBL_ATTR_OBJVAL, &pt[p].objval);
+			if (error) goto QUIT;
+			if (!cold) {
+				error = GRBgetintattrarray(model, GRB_INT_ATTR_VBASIS, 0, nvars, vbasis);
+				if (error) goto QUIT;
+				error = GRBgetintattrarray(model, GRB_INT_ATTR_CBASIS, 0, nconstrs, cbasis);
+				if (error) goto QUIT;
+				havebasis = 1;
+			}
+		}
+		pt[p].secs = walltime() - start;
+	}
+
+QUIT:
+	free(vbasis);
+	free(cbasis);
+	return error;
+}
+
+/* status_name
+ * output: what to print in place of the objective of a point that has none
+ */
+static const char *status_name(int status)
+{
+	switch (status) {
+	case GRB_INFEASIBLE:      return "infeasible";
+	case GRB_UNBOUNDED:       return "unbounded";
+	case GRB_INF_OR_UNBD:     return "inf_or_unbd";
+	case GRB_ITERATION_LIMIT: return "iterlimit";
+	case GRB_TIME_LIMIT:      return "timelimit";
+	case GRB_NUMERIC:         return "numeric";
+	default:                  return "no solution";
+	}
+}
+
+void sw_report(FILE *out, const SweepSpec *spec, const SweepPoint *pt,
+               char **label)
+{
+	double iters = 0, secs = 0;
+	int    p, i;
+	int    w = 10;
+
+	for (i=0; i<spec->len; i++)
+		if ((int) strlen(label[i]) > w) w = strlen(label[i]);
+
+	fprintf(out, "\n");
+	for (i=0; i<spec->len; i++) fprintf(out, "%*s ", w, label[i]);
+	fprintf(out, "status     objective   iters        ms\n");
+	for (p=0; p<spec->npoints; p++) {
+		for (i=0; i<spec->len; i++)
+			fprintf(out, "%*.4g ", w, spec->value[(size_t) p*spec->len+i]);
+		if (pt[p].status == GRB_OPTIMAL)
+			fprintf(out, "%6d %13.6e %7.0f %9.3f\n", pt[p].status,
+			        pt[p].objval, pt[p].iters, 1e3*pt[p].secs);
+		else
+			fprintf(out, "%6d %13s %7.0f %9.3f\n", pt[p].status,
+			        status_name(pt[p].status), pt[p].iters, 1e3*pt[p].secs);
+		iters += pt[p].iters;
+		secs  += pt[p].secs;
+	}
+	fprintf(out, "\n%d points: %.0f iterations (%.2f per point), %.3f s (%.3f ms per point)\n",
+	        spec->npoints, iters, spec->npoints ? iters/spec->npoints : 0.0,
+	        secs, spec->npoints ? 1e3*secs/spec->npoints : 0.0);
+}
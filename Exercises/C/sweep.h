@@ -0,0 +1,63 @@
+/* Parametric sweeps over the RHS or the objective of a loaded LP.
+
+   sw_run solves the model once per point of the sweep.  Between points only
+   the swept coefficients are changed in place, and the basis of the last
+   optimal point (GRB_INT_ATTR_VBASIS / GRB_INT_ATTR_CBASIS) is loaded again
+   before the next solve, so simplex starts a few pivots away from the new
+   optimum.  With cold set the model is reset before each point instead,
+   which gives the from-scratch cost to compare against.
+
+   Points are solved in the order given, so callers should order them so
+   that neighbouring points are close (see sw_grid).
+*/
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdio.h>
+#include "gurobi_c.h"
+
+typedef struct {
+  const char *attr;     /* GRB_DBL_ATTR_RHS or GRB_DBL_ATTR_OBJ */
+  int         len;      /* number of rows or columns changed per point */
+  int        *ind;      /* [len] their indices */
+  int         npoints;
+  double     *value;    /* [npoints*len] values of ind at each point */
+} SweepSpec;
+
+typedef struct {
+  int      status;
+  double   objval;
+  double   iters;       /* simplex iterations of this point */
+  double   secs;        /* wall time of change + solve */
+} SweepPoint;
+
+/* sw_grid
+ * inputs: lo, hi, steps  range of each of the len parameters, steps >= 1
+ *                        values per parameter including both ends
+ * output: [prod steps * len] values of the full grid, the first parameter
+ *         varying fastest and reversing direction on every pass (snake
+ *         order), so consecutive points differ in one parameter by one
+ *         step; NULL if out of memory.  *npoints receives the grid size.
+ */
+double *sw_grid(int len, const double *lo, const double *hi, const int *steps,
+                int *npoints);
+
+/* sw_run
+ * inputs: model  optimized or not, with the swept rows/columns in place
+ *         spec   sweep
+ *         cold   nonzero to reset the model before every point
+ * output: error code; pt[npoints] filled.  The model is left at the last
+ *         point.
+ */
+int sw_run(GRBmodel *model, const SweepSpec *spec, int cold, SweepPoint *pt);
+
+/* sw_report
+ * Print one line per point (parameter values, status, objective,
+ * iterations, milliseconds) and the totals.  Points without an optimal
+ * solution show why in place of the objective.
+ */
+void sw_report(FILE *out, const SweepSpec *spec, const SweepPoint *pt,
+               char **label);
+
+#endif
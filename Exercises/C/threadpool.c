@@ -0,0 +1,154 @@
+/* A small fixed-size pool of worker threads.  See threadpool.h */
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "threadpool.h"
+
+struct ThreadPool {
+  int              nthreads;
+  pthread_t       *threads;
+  pthread_mutex_t  lock;
+  pthread_cond_t   start;      /* signalled when a new batch is posted */
+  pthread_cond_t   done;       /* signalled when the last worker leaves a batch */
+  unsigned long    batch;      /* incremented for each tp_run */
+  int              busy;       /* workers still inside the current batch */
+  int              quit;
+
+  /* current batch */
+  TaskFunc         fn;
+  void            *arg;
+  int              ntasks;
+  int              next;       /* next task index to hand out */
+};
+
+typedef struct {
+  ThreadPool *tp;
+  int         worker;
+} WorkerArg;
+
+/* drain
+ * Take tasks of the current batch until none are left.
+ */
+static void drain(ThreadPool *tp, int worker)
+{
+	int task;
+
+	for (;;) {
+		pthread_mutex_lock(&tp->lock);
+		task = tp->next < tp->ntasks ? tp->next++ : -1;
+		pthread_mutex_unlock(&tp->lock);
+		if (task < 0) return;
+		tp->fn(tp->arg, task, worker);
+	}
+}
+
+static void *worker_main(void *p)
+{
+	WorkerArg     *w  = p;
+	ThreadPool    *tp = w->tp;
+	int            id = w->worker;
+	unsigned long  seen = 0;
+
+	free(w);
+	for (;;) {
+		pthread_mutex_lock(&tp->lock);
+		while (!tp->quit && tp->batch == seen)
+			pthread_cond_wait(&tp->start, &tp->lock);
+		if (tp->quit) {
+			pthread_mutex_unlock(&tp->lock);
+			return NULL;
+		}
+		seen = tp->batch;
+		pthread_mutex_unlock(&tp->lock);
+
+		drain(tp, id);
+
+		pthread_mutex_lock(&tp->lock);
+		if (--tp->busy == 0)
+			pthread_cond_signal(&tp->done);
+		pthread_mutex_unlock(&tp->lock);
+	}
+}
+
+ThreadPool *tp_create(int nthreads)
+{
+	ThreadPool *tp;
+	WorkerArg  *w;
+	int         i;
+
+	if (nthreads < 1) {
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = n > 0 ? (int) n : 1;
+	}
+
+	tp = calloc(1, sizeof(ThreadPool));
+	if (tp == NULL) return NULL;
+	tp->threads = calloc(nthreads, sizeof(pthread_t));
+	if (tp->threads == NULL) {
+		free(tp);
+		return NULL;
+	}
+	pthread_mutex_init(&tp->lock, NULL);
+	pthread_cond_init(&tp->start, NULL);
+	pthread_cond_init(&tp->done, NULL);
+
+	/* Worker 0 is the thread that calls tp_run */
+
+	tp->nthreads = 1;
+	for (i=1; i<nthreads; i++) {
+		w = malloc(sizeof(WorkerArg));
+		if (w == NULL) break;
+		w->tp = tp;
+		w->worker = i;
+		if (pthread_create(&tp->threads[i], NULL, worker_main, w) != 0) {
+			free(w);
+			break;
+		}
+		tp->nthreads++;
+	}
+	return tp;
+}
+
+int tp_size(const ThreadPool *tp)
+{
+	return tp->nthreads;
+}
+
+void tp_run(ThreadPool *tp, int ntasks, TaskFunc fn, void *arg)
+{
+	pthread_mutex_lock(&tp->lock);
+	tp->fn     = fn;
+	tp->arg    = arg;
+	tp->ntasks = ntasks;
+	tp->next   = 0;
+	tp->busy   = tp->nthreads-1;
+	tp->batch++;
+	pthread_cond_broadcast(&tp->start);
+	pthread_mutex_unlock(&tp->lock);
+
+	drain(tp, 0);
+
+	pthread_mutex_lock(&tp->lock);
+	while (tp->busy > 0)
+		pthread_cond_wait(&tp->done, &tp->lock);
+	pthread_mutex_unlock(&tp->lock);
+}
+
+void tp_free(ThreadPool *tp)
+{
+	int i;
+
+	if (tp == NULL) return;
+	pthread_mutex_lock(&tp->lock);
+	tp->quit = 1;
+	pthread_cond_broadcast(&tp->start);
+	pthread_mutex_unlock(&tp->lock);
+	for (i=1; i<tp->nthreads; i++)
+		pthread_join(tp->threads[i], NULL);
+	pthread_cond_destroy(&tp->done);
+	pthread_cond_destroy(&tp->start);
+	pthread_mutex_destroy(&tp->lock);
+	free(tp->threads);
+	free(tp);
+}
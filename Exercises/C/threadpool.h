@@ -0,0 +1,47 @@
+/* A small fixed-size pool of worker threads.
+
+   tp_run hands out task indices 0..ntasks-1 to the workers (and the calling
+   thread) one at a time, so uneven tasks balance themselves, and returns
+   when every task has finished.  Each call of fn also receives the index of
+   the worker running it, 0..tp_size()-1, so that callers can give every
+   worker its own scratch space.
+*/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ThreadPool ThreadPool;
+
+typedef void (*TaskFunc)(void *arg, int task, int worker);
+
+/* tp_create
+ * inputs: nthreads  number of workers, including the calling thread;
+ *                   values < 1 mean one per online processor
+ * output: the pool, or NULL if it could not be created
+ */
+ThreadPool *tp_create(int nthreads);
+
+/* tp_size
+ * output: number of workers, including the calling thread
+ */
+int tp_size(const ThreadPool *tp);
+
+/* tp_run
+ * Run fn(arg, task, worker) for task = 0..ntasks-1 and wait for all of them.
+ */
+void tp_run(ThreadPool *tp, int ntasks, TaskFunc fn, void *arg);
+
+/* tp_free
+ * Stop and join the workers.  Safe to call with NULL.
+ */
+void tp_free(ThreadPool *tp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,19 @@
+/* Wall clock for timing the phases of a run, shared by the drivers and
+   the solver modules so that their times add up. */
+
+#ifndef WALLTIME_H
+#define WALLTIME_H
+
+#include <time.h>
+
+/* walltime
+ * output: seconds on a monotonic clock, for timing the load/build/solve phases
+ */
+static inline double walltime(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+#endif
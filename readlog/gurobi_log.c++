@@ -0,0 +1,749 @@
+/* Columnar parser for Gurobi MIP logs, see gurobi_log.h */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <limits>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "gurobi_log.h"
+#include "workpool.h"
+using namespace std;
+
+void LogColumns::clear()
+{
+#define LOG_CLEAR_INST(type, name) inst.name.clear();
+#define LOG_CLEAR_NODE(type, name) node.name.clear();
+  LOG_INSTANCE_COLUMNS(LOG_CLEAR_INST)
+  LOG_NODE_COLUMNS(LOG_CLEAR_NODE)
+#undef LOG_CLEAR_INST
+#undef LOG_CLEAR_NODE
+  strings.clear();
+  runs.clear();
+}
+
+string LogColumns::name(size_t i) const
+{
+  size_t first, len;
+  log_instance_name(strings.data() + inst.path_first[i], inst.path_len[i], &first, &len);
+  return strings.substr(inst.path_first[i] + first, len);
+}
+
+/* Line scanning.  Newlines are located 64 bytes at a time: the block is
+   compared against '\n' with SIMD compares and the result packed into a
+   64 bit mask, whose set bits are then the line ends of the block. */
+
+static inline uint64_t newline_mask(const char* p)
+{
+#if defined(__AVX2__)
+  const __m256i nl = _mm256_set1_epi8('\n');
+  uint64_t lo = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) p), nl));
+  uint64_t hi = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (p+32)), nl));
+  return lo | hi << 32;
+#elif defined(__SSE2__)
+  const __m128i nl = _mm_set1_epi8('\n');
+  uint64_t m0 = (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) p), nl));
+  uint64_t m1 = (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (p+16)), nl));
+  uint64_t m2 = (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (p+32)), nl));
+  uint64_t m3 = (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (p+48)), nl));
+  return m0 | m1 << 16 | m2 << 32 | m3 << 48;
+#else
+  uint64_t m = 0;
+  for (int i = 0; i < 64; i++)
+    m |= (uint64_t) (p[i] == '\n') << i;
+  return m;
+#endif
+}
+
+class LineScanner
+{
+  public:
+    LineScanner(const char* b, const char* e) : base(b), len(e-b), blk(0), start(0)
+    {
+      mask = block_mask(0);
+    }
+
+    // Next line without its terminator; false at the end of the text
+    bool next(const char*& b, const char*& e)
+    {
+      while (mask == 0) {
+        blk += 64;
+        if (blk >= len) {
+          if (start >= len)
+            return false;
+          b = base + start;
+          e = base + len;
+          start = len;
+          return true;
+        }
+        mask = block_mask(blk);
+      }
+      size_t pos = blk + __builtin_ctzll(mask);
+      mask &= mask - 1;
+      b = base + start;
+      e = base + pos;
+      start = pos + 1;
+      return true;
+    }
+
+  private:
+    uint64_t block_mask(size_t off) const
+    {
+      if (off + 64 <= len)
+        return newline_mask(base + off);
+      uint64_t m = 0;
+      for (size_t i = off; i < len; i++)
+        m |= (uint64_t) (base[i] == '\n') << (i - off);
+      return m;
+    }
+
+    const char* base;
+    size_t      len;
+    size_t      blk;      // offset of the current 64 byte block
+    size_t      start;    // offset of the next line
+    uint64_t    mask;     // line ends of the block not returned yet
+};
+
+/* Tokens and numbers */
+
+struct Tok {
+  const char* b;
+  int         n;
+};
+
+#define MAXTOK 16
+
+// Split [b,e) at blanks, commas and parentheses; at most MAXTOK tokens
+
+struct SeparatorTable {
+  bool sep[256];
+  SeparatorTable()
+  {
+    memset(sep, 0, sizeof(sep));
+    sep[(unsigned char) ' '] = sep[(unsigned char) '\t'] = true;
+    sep[(unsigned char) ','] = sep[(unsigned char) '('] = sep[(unsigned char) ')'] = true;
+  }
+};
+
+static const SeparatorTable separator;
+
+static int tokenize(const char* b, const char* e, Tok* tok)
+{
+  const bool* sep = separator.sep;
+  int n = 0;
+
+  while (b < e && n < MAXTOK) {
+    while (b < e && sep[(unsigned char) *b])
+      b++;
+    if (b == e)
+      break;
+    tok[n].b = b;
+    while (b < e && !sep[(unsigned char) *b])
+      b++;
+    tok[n].n = (int) (b - tok[n].b);
+    n++;
+  }
+  return n;
+}
+
+static bool tok_is(const Tok& t, const char* s)
+{
+  return (int) strlen(s) == t.n && memcmp(t.b, s, t.n) == 0;
+}
+
+static const double NaN = numeric_limits<double>::quiet_NaN();
+
+static const double pow10tab[23] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* tok_double
+ * output: true and v set if t is a number, optionally followed by '%'
+ *         (v is then a fraction) or 's' (seconds); "-" gives NaN.  Numbers
+ *         with at most 15 significant digits and a small exponent are
+ *         converted exactly without strtod.
+ */
+static bool tok_double(const Tok& t, double& v)
+{
+  const char* p = t.b;
+  const char* e = t.b + t.n;
+  double      scale = 1.0;
+  bool        neg = false;
+  uint64_t    mant = 0;
+  int         digits = 0, exp10 = 0;
+
+  if (t.n == 1 && *p == '-') {
+    v = NaN;
+    return true;
+  }
+  if (e > p && e[-1] == '%') {
+    scale = 0.01;
+    e--;
+  } else if (e > p && e[-1] == 's') {
+    e--;
+  }
+  const char* num = p;
+  if (p < e && (*p == '-' || *p == '+'))
+    neg = *p++ == '-';
+  for (; p < e && *p >= '0' && *p <= '9'; p++, digits++)
+    mant = mant*10 + (*p - '0');
+  if (p < e && *p == '.') {
+    for (p++; p < e && *p >= '0' && *p <= '9'; p++, digits++, exp10--)
+      mant = mant*10 + (*p - '0');
+  }
+  if (digits == 0)
+    return false;
+  if (p < e && (*p == 'e' || *p == 'E')) {
+    bool eneg = false;
+    int  x = 0;
+    p++;
+    if (p < e && (*p == '-' || *p == '+'))
+      eneg = *p++ == '-';
+    if (p == e)
+      return false;
+    for (; p < e && *p >= '0' && *p <= '9'; p++)
+      x = x < 10000 ? x*10 + (*p - '0') : x;
+    exp10 += eneg ? -x : x;
+  }
+  if (p != e)
+    return false;
+
+  if (digits <= 15 && exp10 >= -22 && exp10 <= 22) {
+    v = exp10 < 0 ? (double) mant / pow10tab[-exp10] : (double) mant * pow10tab[exp10];
+  } else {
+    char buf[64];
+    size_t n = e - num;
+    if (n >= sizeof(buf))
+      return false;
+    memcpy(buf, num, n);
+    buf[n] = '\0';
+    v = fabs(strtod(buf, NULL));
+  }
+  if (neg)
+    v = -v;
+  v *= scale;
+  return true;
+}
+
+/* tok_int
+ * output: true and v set if t is an integer; "-" gives -1
+ */
+static bool tok_int(const Tok& t, int64_t& v)
+{
+  const char* p = t.b;
+  const char* e = t.b + t.n;
+  bool        neg = false;
+
+  if (t.n == 1 && *p == '-') {
+    v = -1;
+    return true;
+  }
+  if (p < e && *p == '-')
+    neg = *p++ == '-';
+  if (p == e)
+    return false;
+  for (v = 0; p < e; p++) {
+    if (*p < '0' || *p > '9')
+      return false;
+    v = v*10 + (*p - '0');
+  }
+  if (neg)
+    v = -v;
+  return true;
+}
+
+template <class T> static T missing()         { return (T) -1; }
+template <>        double missing<double>()    { return NaN; }
+
+static bool starts(const char* b, const char* e, const char* s)
+{
+  size_t n = strlen(s);
+  return (size_t) (e - b) >= n && memcmp(b, s, n) == 0;
+}
+
+static size_t begin_instance(LogColumns& out, LogState& st, const char* path, int pathlen)
+{
+#define LOG_PUSH(type, name) out.inst.name.push_back(missing<type>());
+  LOG_INSTANCE_COLUMNS(LOG_PUSH)
+#undef LOG_PUSH
+  size_t i = out.numInstances() - 1;
+  out.inst.path_first[i] = out.strings.size();
+  out.inst.path_len[i]   = pathlen;
+  out.inst.run[i]        = st.run;
+  out.inst.status[i]     = LOG_UNKNOWN;
+  out.inst.node_first[i] = out.numNodes();
+  out.inst.node_count[i] = 0;
+  out.strings.append(path, pathlen);
+  return i;
+}
+
+static size_t current(LogColumns& out, LogState& st)
+{
+  if (st.inst < 0)
+    st.inst = (long) begin_instance(out, st, "", 0);
+  return (size_t) st.inst;
+}
+
+/* node_row
+ * inputs: [b,e) a line of the node log
+ * output: the row appended to the node columns of the current instance,
+ *         unless the line does not have the layout of its row type
+ */
+static void node_row(LogColumns& out, LogState& st, const char* b, const char* e)
+{
+  Tok     t[MAXTOK];
+  char    type = LOG_NODE_BRANCH;
+  int8_t  note = LOG_NOTE_NONE;
+  int64_t expl, unexpl, depth = -1, intinf = -1;
+  double  obj = NaN, incumbent, bestbd, gap, itnode, time;
+  int     n, k;
+
+  if (*b == 'H' || *b == '*')
+    type = *b++;
+  n = tokenize(b, e, t);
+
+  // Expl Unexpl | Obj Depth IntInf | Incumbent BestBd Gap | It/Node Time,
+  // with the columns that a row type leaves blank missing from the line
+
+  if (n < 7 || !tok_int(t[0], expl) || !tok_int(t[1], unexpl))
+    return;
+  if (type == LOG_NODE_BRANCH && n == 10) {
+    if (!tok_double(t[2], obj) || !tok_int(t[3], depth) || !tok_int(t[4], intinf))
+      return;
+    k = 5;
+  } else if (type == LOG_NODE_BRANCH && n == 9) {
+    if (tok_is(t[2], "infeasible"))
+      note = LOG_NOTE_INFEASIBLE;
+    else if (tok_is(t[2], "cutoff"))
+      note = LOG_NOTE_CUTOFF;
+    else
+      return;
+    if (!tok_int(t[3], depth))
+      return;
+    k = 4;
+  } else if (type == LOG_NODE_HEURISTIC && n == 7) {
+    k = 2;
+  } else if (type == LOG_NODE_BRANCHSOL && n == 8) {
+    if (!tok_int(t[2], depth))
+      return;
+    k = 3;
+  } else {
+    return;
+  }
+  if (!tok_double(t[k], incumbent) || !tok_double(t[k+1], bestbd) ||
+      !tok_double(t[k+2], gap) || !tok_double(t[k+3], itnode) ||
+      !tok_double(t[k+4], time))
+    return;
+
+  size_t i = current(out, st);
+  LogColumns::Nodes& c = out.node;
+  c.type.push_back(type);
+  c.note.push_back(note);
+  c.expl.push_back(expl);
+  c.unexpl.push_back(unexpl);
+  c.obj.push_back(obj);
+  c.depth.push_back((int32_t) depth);
+  c.intinf.push_back((int32_t) intinf);
+  c.incumbent.push_back(incumbent);
+  c.bestbd.push_back(bestbd);
+  c.gap.push_back(gap);
+  c.itnode.push_back(itnode);
+  c.time.push_back(time);
+  out.inst.node_count[i]++;
+}
+
+// Helpers for the summary lines: store token k if it parses
+
+static void set_int(const Tok* t, int n, int k, int32_t& dst)
+{
+  int64_t v;
+  if (k < n && tok_int(t[k], v)) dst = (int32_t) v;
+}
+
+static void set_int(const Tok* t, int n, int k, int64_t& dst)
+{
+  int64_t v;
+  if (k < n && tok_int(t[k], v)) dst = v;
+}
+
+static void set_double(const Tok* t, int n, int k, double& dst)
+{
+  double v;
+  if (k < n && tok_double(t[k], v)) dst = v;
+}
+
+static void parse_line(LogColumns& out, LogState& st, const char* b, const char* e)
+{
+  LogColumns::Instances& c = out.inst;
+  Tok    t[MAXTOK];
+  int    n;
+  size_t i;
+
+  if (b == e) {
+    if (st.nodelog == 1) st.nodelog = 2;
+    else if (st.nodelog == 2) st.nodelog = 0;
+    return;
+  }
+  if (st.nodelog == 2) {
+    node_row(out, st, b, e);
+    return;
+  }
+
+  switch (*b) {
+  case '@':
+    if (starts(b, e, "@01 ")) {
+      n = tokenize(b, e, t);
+      st.inst = (long) begin_instance(out, st, n > 1 ? t[1].b : "", n > 1 ? t[1].n : 0);
+      st.nodelog = 0;
+    } else if (st.inst >= 0 && (starts(b, e, "@03 ") || starts(b, e, "@04 ") || starts(b, e, "@05 "))) {
+      n = tokenize(b, e, t);
+      if (b[2] == '3') set_int(t, n, 1, c.start_time[st.inst]);
+      else if (b[2] == '4') set_int(t, n, 1, c.end_time[st.inst]);
+      else set_double(t, n, 1, c.time_limit[st.inst]);
+    }
+    break;
+  case 'O':
+    if (starts(b, e, "Optimize a model with ")) {
+      i = current(out, st);
+      if (c.rows[i] < 0) {
+        n = tokenize(b, e, t);
+        set_int(t, n, 4, c.rows[i]);
+        set_int(t, n, 6, c.cols[i]);
+        set_int(t, n, 9, c.nonzeros[i]);
+      }
+    } else if (starts(b, e, "Optimal solution found")) {
+      c.status[current(out, st)] = LOG_OPTIMAL;
+    }
+    break;
+  case 'P':
+    if (starts(b, e, "Presolve removed ")) {
+      i = current(out, st);
+      if (c.removed_rows[i] < 0 && memchr(b, '(', e-b) == NULL) {
+        n = tokenize(b, e, t);
+        set_int(t, n, 2, c.removed_rows[i]);
+        set_int(t, n, 5, c.removed_cols[i]);
+      }
+    } else if (starts(b, e, "Presolve time: ")) {
+      i = current(out, st);
+      if (std::isnan(c.presolve_time[i])) {
+        n = tokenize(b, e, t);
+        set_double(t, n, 2, c.presolve_time[i]);
+      }
+    } else if (starts(b, e, "Presolved: ")) {
+      i = current(out, st);
+      if (c.presolved_rows[i] < 0) {
+        n = tokenize(b, e, t);
+        set_int(t, n, 1, c.presolved_rows[i]);
+        set_int(t, n, 3, c.presolved_cols[i]);
+        set_int(t, n, 5, c.presolved_nonzeros[i]);
+      }
+    }
+    break;
+  case 'R':
+    if (starts(b, e, "Root relaxation: ")) {
+      i = current(out, st);
+      n = tokenize(b, e, t);
+      if (n > 2 && tok_is(t[2], "cutoff")) {
+        set_int(t, n, 3, c.root_iters[i]);
+        set_double(t, n, 5, c.root_time[i]);
+      } else {
+        set_double(t, n, 3, c.root_obj[i]);
+        set_int(t, n, 4, c.root_iters[i]);
+        set_double(t, n, 6, c.root_time[i]);
+      }
+    }
+    break;
+  case 'E':
+    if (starts(b, e, "Explored ")) {
+      i = current(out, st);
+      n = tokenize(b, e, t);
+      set_int(t, n, 1, c.nodes[i]);
+      set_int(t, n, 3, c.simplex_iters[i]);
+      set_double(t, n, 7, c.runtime[i]);
+    }
+    break;
+  case 'B':
+    if (starts(b, e, "Best objective ")) {
+      i = current(out, st);
+      n = tokenize(b, e, t);
+      set_double(t, n, 2, c.best_obj[i]);
+      set_double(t, n, 5, c.best_bound[i]);
+      set_double(t, n, 7, c.gap[i]);
+    }
+    break;
+  case 'T':
+    if (starts(b, e, "Time limit reached"))
+      c.status[current(out, st)] = LOG_TIMELIMIT;
+    break;
+  case 'M':
+    if (starts(b, e, "Model is infeasible"))
+      c.status[current(out, st)] = LOG_INFEASIBLE;
+    break;
+  case ' ':
+    if (starts(b, e, " Expl Unexpl "))
+      st.nodelog = 1;
+    break;
+  }
+}
+
+/* reserve_nodes
+ * Make room for the node rows of a log of the given size, estimated at one
+ * row per 80 bytes, growing geometrically so that many small logs do not
+ * reallocate every time.
+ */
+static void reserve_nodes(LogColumns& out, size_t bytes)
+{
+  size_t need = out.numNodes() + bytes/80;
+  size_t cap  = out.node.type.capacity();
+
+  if (need <= cap)
+    return;
+  if (need < 2*cap)
+    need = 2*cap;
+#define LOG_RESERVE(type, name) out.node.name.reserve(need);
+  LOG_NODE_COLUMNS(LOG_RESERVE)
+#undef LOG_RESERVE
+}
+
+static void parse_lines(const char* begin, const char* end, LogColumns& out, LogState& st)
+{
+  LineScanner lines(begin, end);
+  const char *b, *e;
+
+  while (lines.next(b, e)) {
+    if (e > b && e[-1] == '\r')
+      e--;
+    parse_line(out, st, b, e);
+  }
+}
+
+void parse_log(const char* begin, const char* end, LogColumns& out, int32_t run)
+{
+  LogState st(run);
+
+  reserve_nodes(out, end - begin);
+  parse_lines(begin, end, out, st);
+}
+
+void parse_log_part(const char* begin, const char* end, LogColumns& out, LogState& st)
+{
+  // Complete the line left over from the previous part
+
+  if (!st.partial.empty()) {
+    const char* nl = (const char*) memchr(begin, '\n', end - begin);
+    if (nl == NULL) {
+      st.partial.append(begin, end);
+      return;
+    }
+    st.partial.append(begin, nl);
+    parse_lines(st.partial.data(), st.partial.data() + st.partial.size(), out, st);
+    st.partial.clear();
+    begin = nl + 1;
+  }
+
+  const char* last = end;
+  while (last > begin && last[-1] != '\n')
+    last--;
+  parse_lines(begin, last, out, st);
+  st.partial.assign(last, end);
+}
+
+void finish_log(LogColumns& out, LogState& st)
+{
+  if (!st.partial.empty())
+    parse_lines(st.partial.data(), st.partial.data() + st.partial.size(), out, st);
+  st.partial.clear();
+}
+
+bool parse_log_file(const string& file, LogColumns& out, string& err)
+{
+  struct stat sb;
+  int fd = open(file.c_str(), O_RDONLY);
+
+  if (fd < 0 || fstat(fd, &sb) < 0) {
+    err = file + ": " + strerror(errno);
+    if (fd >= 0) close(fd);
+    return false;
+  }
+  out.runs.push_back(file);
+  if (sb.st_size == 0) {
+    close(fd);
+    return true;
+  }
+  void* map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    err = file + ": " + strerror(errno);
+    return false;
+  }
+  madvise(map, sb.st_size, MADV_SEQUENTIAL);
+  parse_log((const char*) map, (const char*) map + sb.st_size, out, (int32_t) out.runs.size() - 1);
+  munmap(map, sb.st_size);
+  return true;
+}
+
+/* Parallel parsing.  A piece is the text of a log from an @01 marker up to
+   the next one; the first piece of a log starts at its beginning, so the
+   text before the first marker is parsed as parse_log would.  Pieces are
+   parsed into columns of their own and then copied, also in parallel, to
+   the positions they would have had in a sequential parse. */
+
+struct LogPiece {
+  int32_t     run;
+  const char* begin;
+  const char* end;
+  LogColumns  cols;
+  size_t      inst, node, str;     // offsets of cols in the merged columns
+};
+
+/* list_logs
+ * inputs: path  log file or directory, top  path was given by the caller
+ * output: path, or the regular files below it in name order, appended to
+ *         files; dot files in directories are skipped
+ */
+static bool list_logs(const string& path, bool top, vector<string>& files, string& err)
+{
+  struct stat sb;
+
+  if (stat(path.c_str(), &sb) < 0) {
+    err = path + ": " + strerror(errno);
+    return false;
+  }
+  if (!S_ISDIR(sb.st_mode)) {
+    if (top || S_ISREG(sb.st_mode))
+      files.push_back(path);
+    return true;
+  }
+
+  DIR* d = opendir(path.c_str());
+  if (d == NULL) {
+    err = path + ": " + strerror(errno);
+    return false;
+  }
+  vector<string> names;
+  struct dirent* de;
+  while ((de = readdir(d)) != NULL)
+    if (de->d_name[0] != '.')
+      names.push_back(de->d_name);
+  closedir(d);
+  sort(names.begin(), names.end());
+  for (size_t k = 0; k < names.size(); k++)
+    if (!list_logs(path + "/" + names[k], false, files, err))
+      return false;
+  return true;
+}
+
+static void cut_log(const char* b, const char* e, int32_t run, vector<LogPiece>& pieces)
+{
+  while (b < e) {
+    const char* m = (const char*) memmem(b, e - b, "\n@01 ", 5);
+    LogPiece p;
+    p.run   = run;
+    p.begin = b;
+    p.end   = m != NULL ? m + 1 : e;
+    pieces.push_back(p);
+    b = p.end;
+  }
+}
+
+static void copy_piece(LogColumns& out, const LogPiece& p)
+{
+  const LogColumns& c = p.cols;
+
+#define LOG_COPY_INST(type, name) copy(c.inst.name.begin(), c.inst.name.end(), out.inst.name.begin() + p.inst);
+#define LOG_COPY_NODE(type, name) copy(c.node.name.begin(), c.node.name.end(), out.node.name.begin() + p.node);
+  LOG_INSTANCE_COLUMNS(LOG_COPY_INST)
+  LOG_NODE_COLUMNS(LOG_COPY_NODE)
+#undef LOG_COPY_INST
+#undef LOG_COPY_NODE
+  for (size_t i = p.inst; i < p.inst + c.numInstances(); i++) {
+    out.inst.path_first[i] += p.str;
+    out.inst.node_first[i] += p.node;
+  }
+  copy(c.strings.begin(), c.strings.end(), out.strings.begin() + p.str);
+}
+
+bool parse_log_files(const vector<string>& paths, LogColumns& out, int threads, string& err)
+{
+  vector<string>   files;
+  vector<void*>    maps;
+  vector<size_t>   sizes, weight;
+  vector<LogPiece> pieces;
+  bool             ok = true;
+
+  for (size_t k = 0; k < paths.size(); k++)
+    if (!list_logs(paths[k], true, files, err))
+      return false;
+
+  // Map every log and cut it into pieces
+
+  for (size_t f = 0; ok && f < files.size(); f++) {
+    struct stat sb;
+    int fd = open(files[f].c_str(), O_RDONLY);
+    void* map = NULL;
+
+    if (fd < 0 || fstat(fd, &sb) < 0) {
+      ok = false;
+    } else if (sb.st_size > 0) {
+      map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      ok = map != MAP_FAILED;
+    }
+    if (!ok)
+      err = files[f] + ": " + strerror(errno);
+    if (fd >= 0)
+      close(fd);
+    if (ok && map != NULL) {
+      maps.push_back(map);
+      sizes.push_back(sb.st_size);
+      cut_log((const char*) map, (const char*) map + sb.st_size,
+              (int32_t) (out.runs.size() + f), pieces);
+    }
+  }
+
+  if (ok) {
+    for (size_t k = 0; k < pieces.size(); k++)
+      weight.push_back(pieces[k].end - pieces[k].begin);
+    run_tasks(pieces.size(), threads, weight, [&](size_t k, int) {
+      parse_log(pieces[k].begin, pieces[k].end, pieces[k].cols, pieces[k].run);
+    });
+  }
+  for (size_t f = 0; f < maps.size(); f++)
+    munmap(maps[f], sizes[f]);
+  if (!ok)
+    return false;
+
+  // Place the pieces after each other in out and copy them there
+
+  size_t ni = out.numInstances(), nn = out.numNodes(), ns = out.strings.size();
+  for (size_t k = 0; k < pieces.size(); k++) {
+    pieces[k].inst = ni;
+    pieces[k].node = nn;
+    pieces[k].str  = ns;
+    ni += pieces[k].cols.numInstances();
+    nn += pieces[k].cols.numNodes();
+    ns += pieces[k].cols.strings.size();
+  }
+#define LOG_RESIZE_INST(type, name) out.inst.name.resize(ni);
+#define LOG_RESIZE_NODE(type, name) out.node.name.resize(nn);
+  LOG_INSTANCE_COLUMNS(LOG_RESIZE_INST)
+  LOG_NODE_COLUMNS(LOG_RESIZE_NODE)
+#undef LOG_RESIZE_INST
+#undef LOG_RESIZE_NODE
+  out.strings.resize(ns);
+  run_tasks(pieces.size(), threads, weight, [&](size_t k, int) {
+    copy_piece(out, pieces[k]);
+    pieces[k].cols = LogColumns();
+  });
+
+  out.runs.insert(out.runs.end(), files.begin(), files.end());
+  return true;
+}
@@ -0,0 +1,93 @@
+/* Columnar parser for Gurobi MIP logs such as benchmark.gurobi.out.
+
+   A log is split into instances at the "@01 <model file>" markers of the
+   MIPLIB scripts; a plain Gurobi log without markers is one instance.  For
+   every instance the parser records the marker fields (@03 start time,
+   @04 end time, @05 time limit), the original and presolved model size,
+   the presolve reductions, the root relaxation, the final "Explored" and
+   "Best objective" summary lines and the status, and for every row of the
+   branch-and-bound node log its eleven columns.
+
+   Results are appended to LogColumns, one std::vector per column (struct of
+   arrays).  The columns are listed once in LOG_INSTANCE_COLUMNS and
+   LOG_NODE_COLUMNS (logformat.h), so code that needs to touch every column (I/O,
+   merging) can expand the lists instead of naming each one.  Missing
+   doubles are NaN, missing integers -1.  Gaps are fractions (84.6% is
+   0.846) and times are seconds.
+*/
+
+#ifndef GUROBI_LOG_H
+#define GUROBI_LOG_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "logformat.h"
+
+struct LogColumns
+{
+#define LOG_DECLARE(type, name) std::vector<type> name;
+  struct Instances { LOG_INSTANCE_COLUMNS(LOG_DECLARE) } inst;
+  struct Nodes     { LOG_NODE_COLUMNS(LOG_DECLARE) } node;
+#undef LOG_DECLARE
+
+  std::string strings;          // model file names
+  std::vector<std::string> runs; // log files, one run of a test set each
+
+  size_t numInstances() const { return inst.status.size(); }
+  size_t numNodes() const     { return node.type.size(); }
+  std::string path(size_t i) const { return strings.substr(inst.path_first[i], inst.path_len[i]); }
+  std::string name(size_t i) const;
+  void clear();
+};
+
+/* parse_log
+ * inputs: [begin,end) log text, run  index into out.runs or -1
+ * output: the instances of the text appended to out
+ */
+void parse_log(const char* begin, const char* end, LogColumns& out, int32_t run = -1);
+
+/* Parser state carried from one part of a log to the next, for logs that
+   are read as they grow */
+struct LogState
+{
+  long        inst;     // current instance in the columns, -1 before the first
+  int32_t     run;
+  int         nodelog;  // 0 outside the node log, 1 after its header, 2 in it
+  std::string partial;  // unterminated last line of the text so far
+
+  explicit LogState(int32_t r = -1) : inst(-1), run(r), nodelog(0) {}
+};
+
+/* parse_log_part
+ * inputs: [begin,end) text following the text of earlier calls with st
+ * output: its complete lines parsed into out, which must be the same
+ *         columns every time; a final line without newline is kept in st
+ *         until the rest of it arrives, or finish_log
+ */
+void parse_log_part(const char* begin, const char* end, LogColumns& out, LogState& st);
+void finish_log(LogColumns& out, LogState& st);
+
+/* parse_log_file
+ * inputs: file  log file name, memory mapped while it is parsed
+ * output: true with file added to out.runs and its instances appended to
+ *         out, false with err set
+ */
+bool parse_log_file(const std::string& file, LogColumns& out, std::string& err);
+
+/* parse_log_files
+ * inputs: files    log files, or directories whose files (recursively, in
+ *                  name order) are logs
+ *         threads  parser threads, < 1 for one per processor
+ * output: true with the logs added to out.runs and their instances appended
+ *         to out, false with err set
+ *
+ * Every log is cut at its @01 markers and the pieces are parsed in
+ * parallel (workpool.h), then copied into out in file and position order,
+ * so out is the same as from parse_log_file on the files one after the
+ * other, whatever the number of threads.
+ */
+bool parse_log_files(const std::vector<std::string>& files, LogColumns& out, int threads,
+                     std::string& err);
+
+#endif
@@ -0,0 +1,285 @@
+/* Compare two benchmark runs, such as two benchmark.gurobi.out logs from
+   different solver versions or parameter settings, for regressions.
+
+   Usage:  logdiff [-j threads] [-ts shift] [-ns shift] [-is shift]
+                   [-alpha level] [-factor f] [-csv file] base new
+
+   base and new are logs, directories of logs (readlog) or stores written
+   by readlog -o.  Instances are matched by name, the model file without
+   directory and extensions; instances found in only one run are counted
+   but not compared.
+
+   The time of an instance is its runtime, or the time limit if it hit it
+   without printing one.  For every matched instance the ratios new/base
+   of the time, and of the nodes and simplex iterations when both runs
+   solved it, are computed with a shift (default 1 s, 100 nodes, 1000
+   iterations) that keeps easy instances from dominating.  They are
+   summarized as shifted geometric means
+
+     sgm(x) = exp(mean(log(x + shift))) - shift
+
+   over all matched instances and over the brackets of instances that took
+   at least 1, 10, 100 and 1000 s in one of the runs, as is usual for
+   MIPLIB comparisons.  In every bracket a Wilcoxon signed-rank test on the
+   log time ratios tells whether the change is larger than the noise; a
+   significant slowdown at -alpha (default 0.05) is flagged SLOWER.
+
+   Instances whose time grew by more than -factor (default 2) and at least
+   a second, or that base solved and new did not, are listed.  -csv writes
+   every matched instance.  The exit status is 2 if the all-instances
+   bracket is significantly slower, so scripts can reject an upgrade.
+
+   Build with gurobi_log.c++, logstore.c++, workpool.c++ and -pthread.
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <sys/stat.h>
+#include "gurobi_log.h"
+#include "logstore.h"
+using namespace std;
+
+// The fields of every instance the comparison needs
+
+struct Results
+{
+  vector<string>  name;
+  vector<double>  time, nodes, iters;
+  vector<bool>    solved;
+  size_t          untimed = 0;    // instances without runtime or time limit
+};
+
+template <class Columns>
+static void add_instance(Results& r, const Columns& c, size_t i, const string& name)
+{
+  double t = c.runtime[i];
+
+  if (std::isnan(t) && c.status[i] == LOG_TIMELIMIT)
+    t = c.time_limit[i];
+  if (std::isnan(t)) {
+    r.untimed++;
+    return;
+  }
+  r.name.push_back(name);
+  r.time.push_back(t);
+  r.nodes.push_back(c.nodes[i] >= 0 ? (double) c.nodes[i] : NAN);
+  r.iters.push_back(c.simplex_iters[i] >= 0 ? (double) c.simplex_iters[i] : NAN);
+  r.solved.push_back(c.status[i] == LOG_OPTIMAL || c.status[i] == LOG_INFEASIBLE);
+}
+
+static bool is_store(const char* file)
+{
+  struct stat sb;
+  char magic[8];
+  FILE* f;
+
+  if (stat(file, &sb) < 0 || !S_ISREG(sb.st_mode) || (f = fopen(file, "rb")) == NULL)
+    return false;
+  bool yes = fread(magic, sizeof(magic), 1, f) == 1 && memcmp(magic, LOGSTORE_MAGIC, sizeof(magic)) == 0;
+  fclose(f);
+  return yes;
+}
+
+static bool load(const char* file, int threads, Results& r, string& err)
+{
+  if (is_store(file)) {
+    LogStore s;
+    if (!s.open(file, err))
+      return false;
+    for (size_t i = 0; i < s.numInstances; i++)
+      add_instance(r, s.inst, i, s.name(i));
+    return true;
+  }
+
+  LogColumns c;
+  if (!parse_log_files(vector<string>(1, file), c, threads, err))
+    return false;
+  for (size_t i = 0; i < c.numInstances(); i++)
+    add_instance(r, c.inst, i, c.name(i));
+  return true;
+}
+
+static double sgm(const vector<double>& x, double shift)
+{
+  double s = 0;
+  for (size_t k = 0; k < x.size(); k++)
+    s += log(x[k] + shift);
+  return x.empty() ? NAN : exp(s / x.size()) - shift;
+}
+
+/* wilcoxon
+ * inputs: d  paired differences (log ratios)
+ * output: two-sided p-value of the signed-rank test, normal approximation
+ *         with tie and continuity correction; NaN for fewer than 6 nonzero
+ *         differences, where the approximation means nothing
+ */
+static double wilcoxon(const vector<double>& d)
+{
+  vector<double> a;
+  for (size_t k = 0; k < d.size(); k++)
+    if (fabs(d[k]) > 1e-9)
+      a.push_back(d[k]);
+  size_t n = a.size();
+  if (n < 6)
+    return NAN;
+
+  vector<size_t> ord(n);
+  for (size_t k = 0; k < n; k++) ord[k] = k;
+  sort(ord.begin(), ord.end(), [&](size_t i, size_t j) { return fabs(a[i]) < fabs(a[j]); });
+
+  double wplus = 0, ties = 0;
+  for (size_t k = 0; k < n; ) {
+    size_t l = k;
+    while (l < n && fabs(a[ord[l]]) - fabs(a[ord[k]]) <= 1e-9) l++;
+    double rank = (k + 1 + l) / 2.0, t = l - k;
+    for (size_t m = k; m < l; m++)
+      if (a[ord[m]] > 0) wplus += rank;
+    ties += t*t*t - t;
+    k = l;
+  }
+  double mean = n * (n + 1) / 4.0;
+  double var  = n * (n + 1) * (2*n + 1) / 24.0 - ties / 48.0;
+  if (var <= 0)
+    return NAN;
+  double z = (fabs(wplus - mean) - 0.5) / sqrt(var);
+  return erfc(max(z, 0.0) / sqrt(2.0));
+}
+
+static double ratio(double b, double a, double shift)
+{
+  return (b + shift) / (a + shift);
+}
+
+int
+main(int   argc,
+     char *argv[])
+{
+  double      tshift = 1, nshift = 100, ishift = 1000, alpha = 0.05, factor = 2;
+  const char* csv = NULL;
+  int         threads = 0, i, status = 0;
+  string      err;
+  Results     base, cur;
+
+  for (i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+    if (strcmp(argv[i], "-j") == 0) threads = atoi(argv[i+1]);
+    else if (strcmp(argv[i], "-ts") == 0) tshift = atof(argv[i+1]);
+    else if (strcmp(argv[i], "-ns") == 0) nshift = atof(argv[i+1]);
+    else if (strcmp(argv[i], "-is") == 0) ishift = atof(argv[i+1]);
+    else if (strcmp(argv[i], "-alpha") == 0) alpha = atof(argv[i+1]);
+    else if (strcmp(argv[i], "-factor") == 0) factor = atof(argv[i+1]);
+    else if (strcmp(argv[i], "-csv") == 0) csv = argv[i+1];
+    else break;
+  }
+  if (argc - i != 2) {
+    fprintf(stderr, "usage: %s [-j threads] [-ts shift] [-ns shift] [-is shift]\n"
+                    "       [-alpha level] [-factor f] [-csv file] base new\n", argv[0]);
+    return 1;
+  }
+  if (!load(argv[i], threads, base, err) || !load(argv[i+1], threads, cur, err)) {
+    fprintf(stderr, "%s\n", err.c_str());
+    return 1;
+  }
+
+  // Match by name; repeated names (several seeds in one log) keep the first
+
+  unordered_map<string, size_t> where;
+  for (size_t k = cur.name.size(); k-- > 0; )
+    where[cur.name[k]] = k;
+  vector<size_t> ia, ib;
+  unordered_map<string, bool> seen;
+  for (size_t k = 0; k < base.name.size(); k++) {
+    unordered_map<string, size_t>::const_iterator w = where.find(base.name[k]);
+    if (w != where.end() && !seen[base.name[k]]) {
+      seen[base.name[k]] = true;
+      ia.push_back(k);
+      ib.push_back(w->second);
+    }
+  }
+  size_t m = ia.size();
+
+  FILE* out = NULL;
+  if (csv != NULL && (out = fopen(csv, "w")) == NULL) {
+    fprintf(stderr, "%s: %s\n", csv, strerror(errno));
+    return 1;
+  }
+  if (out != NULL)
+    fprintf(out, "name,solved_base,solved_new,time_base,time_new,time_ratio,"
+                 "nodes_base,nodes_new,node_ratio,iters_base,iters_new,iter_ratio\n");
+
+  printf("%zu instances in base, %zu in new, %zu matched", base.name.size(), cur.name.size(), m);
+  if (base.untimed + cur.untimed > 0)
+    printf(" (%zu without a time ignored)", base.untimed + cur.untimed);
+  printf("\n\n%-10s %5s %6s %6s %9s %9s %7s %9s %8s %8s\n", "bracket", "n", "solved", "solved",
+         "time base", "time new", "ratio", "p", "nodes", "iters");
+  printf("%-10s %5s %6s %6s %9s %9s %7s %9s %8s %8s\n", "", "", "base", "new", "sgm", "sgm", "",
+         "", "ratio", "ratio");
+
+  static const double bracket[] = { 0, 1, 10, 100, 1000 };
+  for (size_t b = 0; b < sizeof(bracket)/sizeof(bracket[0]); b++) {
+    vector<double> ta, tb, na, nb, xa, xb, d;
+    int sa = 0, sb = 0;
+
+    for (size_t k = 0; k < m; k++) {
+      size_t p = ia[k], q = ib[k];
+      if (max(base.time[p], cur.time[q]) < bracket[b])
+        continue;
+      ta.push_back(base.time[p]);
+      tb.push_back(cur.time[q]);
+      d.push_back(log(ratio(cur.time[q], base.time[p], tshift)));
+      sa += base.solved[p];
+      sb += cur.solved[q];
+      if (base.solved[p] && cur.solved[q] && !std::isnan(base.nodes[p]) && !std::isnan(cur.nodes[q])) {
+        na.push_back(base.nodes[p]);
+        nb.push_back(cur.nodes[q]);
+      }
+      if (base.solved[p] && cur.solved[q] && !std::isnan(base.iters[p]) && !std::isnan(cur.iters[q])) {
+        xa.push_back(base.iters[p]);
+        xb.push_back(cur.iters[q]);
+      }
+    }
+    if (ta.empty())
+      break;
+
+    double ga = sgm(ta, tshift), gb = sgm(tb, tshift), pval = wilcoxon(d);
+    double r = ratio(gb, ga, tshift);
+    const char* flag = "";
+    if (pval < alpha) flag = r > 1 ? "SLOWER" : "faster";
+    if (b == 0 && r > 1 && pval < alpha) status = 2;
+
+    char label[16];
+    snprintf(label, sizeof(label), b == 0 ? "all" : ">=%gs", bracket[b]);
+    printf("%-10s %5zu %6d %6d %9.2f %9.2f %7.3f %9.2g %8.3f %8.3f%s%s\n", label, ta.size(), sa, sb,
+           ga, gb, r, pval, ratio(sgm(nb, nshift), sgm(na, nshift), nshift),
+           ratio(sgm(xb, ishift), sgm(xa, ishift), ishift), *flag ? "  " : "", flag);
+  }
+
+  // Instances that got much slower or were lost
+
+  bool header = false;
+  for (size_t k = 0; k < m; k++) {
+    size_t p = ia[k], q = ib[k];
+    double r = ratio(cur.time[q], base.time[p], tshift);
+    bool lost = base.solved[p] && !cur.solved[q];
+
+    if (out != NULL)
+      fprintf(out, "%s,%d,%d,%.10g,%.10g,%.10g,%.10g,%.10g,%.10g,%.10g,%.10g,%.10g\n",
+              base.name[p].c_str(), (int) base.solved[p], (int) cur.solved[q], base.time[p],
+              cur.time[q], r, base.nodes[p], cur.nodes[q], ratio(cur.nodes[q], base.nodes[p], nshift),
+              base.iters[p], cur.iters[q], ratio(cur.iters[q], base.iters[p], ishift));
+    if (lost || (r > factor && cur.time[q] - base.time[p] >= 1)) {
+      if (!header)
+        printf("\n%-24s %9s %9s %7s\n", "instance", "time base", "time new", "ratio");
+      header = true;
+      printf("%-24s %9.2f %9.2f %7.2f%s\n", base.name[p].c_str(), base.time[p], cur.time[q], r,
+             lost ? "  not solved" : "");
+    }
+  }
+  if (out != NULL)
+    fclose(out);
+  return status;
+}
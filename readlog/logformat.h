@@ -0,0 +1,130 @@
+/* The columns of a parsed Gurobi log and the layout of the .mlog store.
+
+   Plain C, so that the C++ log tools (gurobi_log.h, logstore.h) and the C
+   solve tracer (Exercises/C/solvetrace.c) share one definition of what a
+   store holds: the instance and node columns, the status codes, how an
+   instance is named and the header and directory of the file.  See
+   logstore.h for the layout itself.
+*/
+
+#ifndef LOGFORMAT_H
+#define LOGFORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Instance status from the final message of the log */
+enum LogStatus {
+  LOG_UNKNOWN    = 0,
+  LOG_OPTIMAL    = 1,   /* Optimal solution found */
+  LOG_TIMELIMIT  = 2,   /* Time limit reached */
+  LOG_INFEASIBLE = 3    /* Model is infeasible */
+};
+
+/* Node log row type, the first column of the row */
+enum LogNodeType {
+  LOG_NODE_BRANCH    = ' ',
+  LOG_NODE_HEURISTIC = 'H',
+  LOG_NODE_BRANCHSOL = '*'
+};
+
+/* What replaced the objective of a node row, if anything */
+enum LogNodeNote {
+  LOG_NOTE_NONE       = 0,
+  LOG_NOTE_INFEASIBLE = 1,
+  LOG_NOTE_CUTOFF     = 2
+};
+
+/*     type      name            log source */
+#define LOG_INSTANCE_COLUMNS(X) \
+  X(int64_t,  path_first)      /* @01 model file, offset into strings */ \
+  X(int32_t,  path_len)        \
+  X(int32_t,  run)             /* index into runs, the log it came from */ \
+  X(int64_t,  start_time)      /* @03 unix time */ \
+  X(int64_t,  end_time)        /* @04 unix time */ \
+  X(double,   time_limit)      /* @05 */ \
+  X(int32_t,  rows)            /* Optimize a model with .. */ \
+  X(int32_t,  cols)            \
+  X(int64_t,  nonzeros)        \
+  X(int32_t,  removed_rows)    /* Presolve removed .. (first, MIP presolve) */ \
+  X(int32_t,  removed_cols)    \
+  X(double,   presolve_time)   /* Presolve time: */ \
+  X(int32_t,  presolved_rows)  /* Presolved: .. (first, MIP presolve) */ \
+  X(int32_t,  presolved_cols)  \
+  X(int64_t,  presolved_nonzeros) \
+  X(double,   root_obj)        /* Root relaxation: objective .., NaN on cutoff */ \
+  X(int64_t,  root_iters)      \
+  X(double,   root_time)       \
+  X(int64_t,  nodes)           /* Explored .. nodes */ \
+  X(int64_t,  simplex_iters)   \
+  X(double,   runtime)         \
+  X(double,   best_obj)        /* Best objective .., best bound .., gap .. */ \
+  X(double,   best_bound)      \
+  X(double,   gap)             \
+  X(int8_t,   status)          /* LogStatus */ \
+  X(int64_t,  node_first)      /* this instance's rows in the node columns */ \
+  X(int64_t,  node_count)
+
+#define LOG_NODE_COLUMNS(X) \
+  X(char,     type)            /* LogNodeType */ \
+  X(int8_t,   note)            /* LogNodeNote */ \
+  X(int64_t,  expl)            \
+  X(int64_t,  unexpl)          \
+  X(double,   obj)             \
+  X(int32_t,  depth)           \
+  X(int32_t,  intinf)          \
+  X(double,   incumbent)       \
+  X(double,   bestbd)          \
+  X(double,   gap)             \
+  X(double,   itnode)          \
+  X(double,   time)
+
+/* log_instance_name
+ * inputs: [path, path+len) model file as given on the @01 line
+ * output: *first, *namelen  the part of it that names the instance: the
+ *         file name without directory, .gz/.bz2 and then .mps/.lp
+ */
+static inline void log_instance_name(const char* path, size_t len, size_t* first, size_t* namelen)
+{
+  static const char* ext[] = { ".gz", ".bz2", ".mps", ".lp" };
+  size_t b = len, e, n;
+
+  while (b > 0 && path[b-1] != '/') b--;
+  for (e = 0; e < sizeof(ext)/sizeof(ext[0]); e++) {
+    n = strlen(ext[e]);
+    if (len - b > n && memcmp(path + len - n, ext[e], n) == 0)
+      len -= n;
+  }
+  *first   = b;
+  *namelen = len - b;
+}
+
+/* Store file: header, directory, then every column on a LOGSTORE_ALIGN
+   byte boundary */
+
+#define LOGSTORE_MAGIC   "MIPLOG1\n"
+#define LOGSTORE_VERSION 1
+#define LOGSTORE_ALIGN   64
+
+typedef struct LogStoreHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t numcolumns;
+  uint64_t numinstances;
+  uint64_t numnodes;
+  uint64_t numruns;
+  uint64_t numstrings;
+} LogStoreHeader;
+
+typedef struct LogStoreColumn {
+  char     name[32];
+  char     table;       /* 'i', 'n', 'r', 's', 'x', 't' */
+  char     type;        /* 'c', 'b', 'i', 'l', 'd' */
+  uint16_t elsize;
+  uint32_t reserved;
+  uint64_t offset;
+  uint64_t count;
+} LogStoreColumn;
+
+#endif
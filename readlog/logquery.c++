@@ -0,0 +1,82 @@
+/* Query a log store written by readlog -o (logstore.h).
+
+   Usage:  logquery store.mlog [instance [run]]
+
+   Without an instance, lists every instance of the store with its run,
+   status, runtime, nodes and final gap, in (name, run) order.  With an
+   instance name (model file without directory and extensions), prints the
+   instance summary and its node log as time, incumbent, bound and gap for
+   every run of it, or only for the given run.
+
+   Nothing is parsed or copied: the columns are read where the store is
+   mapped, so a query touches only the pages it prints.
+
+   Build with logstore.c++.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include "logstore.h"
+using namespace std;
+
+static const char* statusname[] = { "unknown", "optimal", "timelimit", "infeasible" };
+
+static void print_summary(const LogStore& s, size_t i)
+{
+  const LogStore::Instances& x = s.inst;
+
+  printf("%s,%d,%s,%.10g,%lld,%.10g,%.10g,%.10g\n",
+         s.name(i).c_str(), x.run[i], statusname[x.status[i]], x.runtime[i],
+         (long long) x.nodes[i], x.best_obj[i], x.best_bound[i], x.gap[i]);
+}
+
+static void print_series(const LogStore& s, size_t i)
+{
+  const LogStore::Nodes& x = s.node;
+  int64_t first = s.inst.node_first[i], last = first + s.inst.node_count[i];
+
+  printf("# %s run %d (%s)\ntime,incumbent,bestbd,gap\n",
+         s.name(i).c_str(), s.inst.run[i], s.run(s.inst.run[i]).c_str());
+  for (int64_t r = first; r < last; r++)
+    printf("%.10g,%.10g,%.10g,%.10g\n", x.time[r], x.incumbent[r], x.bestbd[r], x.gap[r]);
+}
+
+int
+main(int   argc,
+     char *argv[])
+{
+  LogStore store;
+  string   err;
+
+  if (argc < 2 || argc > 4) {
+    fprintf(stderr, "usage: %s store.mlog [instance [run]]\n", argv[0]);
+    return 1;
+  }
+  if (!store.open(argv[1], err)) {
+    fprintf(stderr, "%s\n", err.c_str());
+    return 1;
+  }
+
+  if (argc == 2) {
+    printf("name,run,status,runtime,nodes,best_obj,best_bound,gap\n");
+    for (size_t k = 0; k < store.numInstances; k++)
+      print_summary(store, store.by_name[k]);
+    return 0;
+  }
+
+  size_t first, last;
+  store.find(argv[2], argc > 3 ? atoi(argv[3]) : -1, &first, &last);
+  if (first == last) {
+    fprintf(stderr, "%s: no instance %s%s%s\n", argv[1], argv[2],
+            argc > 3 ? " run " : "", argc > 3 ? argv[3] : "");
+    return 1;
+  }
+  printf("name,run,status,runtime,nodes,best_obj,best_bound,gap\n");
+  for (size_t k = first; k < last; k++)
+    print_summary(store, store.by_name[k]);
+  for (size_t k = first; k < last; k++) {
+    printf("\n");
+    print_series(store, store.by_name[k]);
+  }
+  return 0;
+}
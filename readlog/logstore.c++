@@ -0,0 +1,293 @@
+/* Columnar binary store for parsed Gurobi logs, see logstore.h */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "logstore.h"
+using namespace std;
+
+template <class T> static char type_code();
+template <> char type_code<char>()    { return 'c'; }
+template <> char type_code<int8_t>()  { return 'b'; }
+template <> char type_code<int32_t>() { return 'i'; }
+template <> char type_code<int64_t>() { return 'l'; }
+template <> char type_code<double>()  { return 'd'; }
+
+// Directory entry plus where the writer finds its data
+
+struct PendingColumn {
+  LogStoreColumn col;
+  const void*    data;
+};
+
+template <class T>
+static void add_column(vector<PendingColumn>& dir, char table, const char* name,
+                       const T* data, size_t count)
+{
+  PendingColumn p;
+  memset(&p.col, 0, sizeof(p.col));
+  strncpy(p.col.name, name, sizeof(p.col.name) - 1);
+  p.col.table  = table;
+  p.col.type   = type_code<T>();
+  p.col.elsize = sizeof(T);
+  p.col.count  = count;
+  p.data = data;
+  dir.push_back(p);
+}
+
+bool write_log_store(const LogColumns& c, const string& file, string& err)
+{
+  size_t ni = c.numInstances(), nr = c.runs.size();
+  string strings = c.strings;
+  vector<int64_t> name_first(ni), run_first(nr), by_name(ni);
+  vector<int32_t> name_len(ni), run_len(nr);
+
+  // Names point into the path strings that are already there
+
+  for (size_t i = 0; i < ni; i++) {
+    size_t first, len;
+    log_instance_name(c.strings.data() + c.inst.path_first[i], c.inst.path_len[i], &first, &len);
+    name_first[i] = c.inst.path_first[i] + first;
+    name_len[i]   = (int32_t) len;
+    by_name[i]    = i;
+  }
+  for (size_t r = 0; r < nr; r++) {
+    run_first[r] = strings.size();
+    run_len[r]   = (int32_t) c.runs[r].size();
+    strings += c.runs[r];
+  }
+
+  const char* s = strings.data();
+  sort(by_name.begin(), by_name.end(), [&](int64_t a, int64_t b) {
+    int cmp = memcmp(s + name_first[a], s + name_first[b], min(name_len[a], name_len[b]));
+    if (cmp != 0) return cmp < 0;
+    if (name_len[a] != name_len[b]) return name_len[a] < name_len[b];
+    if (c.inst.run[a] != c.inst.run[b]) return c.inst.run[a] < c.inst.run[b];
+    return a < b;
+  });
+
+  vector<PendingColumn> dir;
+#define LOGSTORE_ADD_I(type, name) add_column(dir, 'i', #name, c.inst.name.data(), ni);
+#define LOGSTORE_ADD_N(type, name) add_column(dir, 'n', #name, c.node.name.data(), c.numNodes());
+  LOG_INSTANCE_COLUMNS(LOGSTORE_ADD_I)
+  LOG_NODE_COLUMNS(LOGSTORE_ADD_N)
+#undef LOGSTORE_ADD_I
+#undef LOGSTORE_ADD_N
+  add_column(dir, 'i', "name_first", name_first.data(), ni);
+  add_column(dir, 'i', "name_len", name_len.data(), ni);
+  add_column(dir, 'r', "run_first", run_first.data(), nr);
+  add_column(dir, 'r', "run_len", run_len.data(), nr);
+  add_column(dir, 's', "strings", strings.data(), strings.size());
+  add_column(dir, 'x', "by_name", by_name.data(), ni);
+
+  LogStoreHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, LOGSTORE_MAGIC, sizeof(h.magic));
+  h.version      = LOGSTORE_VERSION;
+  h.numcolumns   = dir.size();
+  h.numinstances = ni;
+  h.numnodes     = c.numNodes();
+  h.numruns      = nr;
+  h.numstrings   = strings.size();
+
+  uint64_t offset = sizeof(h) + dir.size() * sizeof(LogStoreColumn);
+  for (size_t k = 0; k < dir.size(); k++) {
+    offset = (offset + LOGSTORE_ALIGN - 1) / LOGSTORE_ALIGN * LOGSTORE_ALIGN;
+    dir[k].col.offset = offset;
+    offset += dir[k].col.count * dir[k].col.elsize;
+  }
+
+  string tmp = file + ".tmp";
+  FILE* f = fopen(tmp.c_str(), "wb");
+  if (f == NULL) {
+    err = tmp + ": " + strerror(errno);
+    return false;
+  }
+
+  static const char zeros[LOGSTORE_ALIGN] = { 0 };
+  bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+  for (size_t k = 0; ok && k < dir.size(); k++)
+    ok = fwrite(&dir[k].col, sizeof(LogStoreColumn), 1, f) == 1;
+  for (size_t k = 0; ok && k < dir.size(); k++) {
+    long pad = dir[k].col.offset - ftell(f);
+    size_t bytes = dir[k].col.count * dir[k].col.elsize;
+    ok = (pad == 0 || fwrite(zeros, pad, 1, f) == 1) &&
+         (bytes == 0 || fwrite(dir[k].data, bytes, 1, f) == 1);
+  }
+  if (fclose(f) != 0) ok = false;
+  if (!ok || rename(tmp.c_str(), file.c_str()) != 0) {
+    err = file + ": " + strerror(errno);
+    unlink(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+LogStore::LogStore()
+  : map(NULL), size(0)
+{
+  close();
+}
+
+LogStore::~LogStore()
+{
+  close();
+}
+
+void LogStore::close()
+{
+  if (map != NULL) munmap(map, size);
+  map  = NULL;
+  size = 0;
+  memset(&inst, 0, sizeof(inst));
+  memset(&node, 0, sizeof(node));
+  run_first = NULL;
+  run_len   = NULL;
+  by_name   = NULL;
+  strings   = NULL;
+  numInstances = numNodes = numRuns = 0;
+}
+
+// Point ptr at column name of table, checking it against the directory
+
+template <class T>
+bool LogStore::bind(char table, const char* name, const T*& ptr, uint64_t count, string& err)
+{
+  const LogStoreHeader* h = (const LogStoreHeader*) map;
+  const LogStoreColumn* dir = (const LogStoreColumn*) (h + 1);
+
+  for (uint32_t k = 0; k < h->numcolumns; k++) {
+    const LogStoreColumn& c = dir[k];
+    if (c.table != table || strncmp(c.name, name, sizeof(c.name)) != 0)
+      continue;
+    if (c.type != type_code<T>() || c.elsize != sizeof(T) || c.count != count ||
+        c.offset % sizeof(T) != 0 || c.offset > size || count > (size - c.offset) / sizeof(T)) {
+      err = string("bad column ") + name;
+      return false;
+    }
+    ptr = (const T*) ((const char*) map + c.offset);
+    return true;
+  }
+  err = string("missing column ") + name;
+  return false;
+}
+
+bool LogStore::open(const string& file, string& err)
+{
+  struct stat sb;
+
+  close();
+  int fd = ::open(file.c_str(), O_RDONLY);
+  if (fd < 0 || fstat(fd, &sb) < 0) {
+    err = file + ": " + strerror(errno);
+    if (fd >= 0) ::close(fd);
+    return false;
+  }
+  if ((size_t) sb.st_size < sizeof(LogStoreHeader)) {
+    ::close(fd);
+    err = file + ": not a log store";
+    return false;
+  }
+  map = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    map = NULL;
+    err = file + ": " + strerror(errno);
+    return false;
+  }
+  size = sb.st_size;
+
+  const LogStoreHeader* h = (const LogStoreHeader*) map;
+  if (memcmp(h->magic, LOGSTORE_MAGIC, sizeof(h->magic)) != 0 || h->version != LOGSTORE_VERSION ||
+      h->numcolumns > (size - sizeof(*h)) / sizeof(LogStoreColumn)) {
+    close();
+    err = file + ": not a log store";
+    return false;
+  }
+
+  bool ok = true;
+#define LOGSTORE_BIND_I(type, name) ok = ok && bind('i', #name, inst.name, h->numinstances, err);
+#define LOGSTORE_BIND_N(type, name) ok = ok && bind('n', #name, node.name, h->numnodes, err);
+  LOG_INSTANCE_COLUMNS(LOGSTORE_BIND_I)
+  LOG_NODE_COLUMNS(LOGSTORE_BIND_N)
+#undef LOGSTORE_BIND_I
+#undef LOGSTORE_BIND_N
+  ok = ok && bind('i', "name_first", inst.name_first, h->numinstances, err)
+          && bind('i', "name_len", inst.name_len, h->numinstances, err)
+          && bind('r', "run_first", run_first, h->numruns, err)
+          && bind('r', "run_len", run_len, h->numruns, err)
+          && bind('s', "strings", strings, h->numstrings, err)
+          && bind('x', "by_name", by_name, h->numinstances, err);
+  if (!ok) {
+    close();
+    err = file + ": " + err;
+    return false;
+  }
+
+  // Offsets and the status and note codes, which index name tables, are
+  // trusted from here on, so check them once
+
+  for (uint64_t i = 0; ok && i < h->numinstances; i++)
+    ok = inst.path_first[i] >= 0 && inst.path_len[i] >= 0 &&
+         (uint64_t) inst.path_first[i] + inst.path_len[i] <= h->numstrings &&
+         inst.name_first[i] >= 0 && inst.name_len[i] >= 0 &&
+         (uint64_t) inst.name_first[i] + inst.name_len[i] <= h->numstrings &&
+         inst.node_first[i] >= 0 && inst.node_count[i] >= 0 &&
+         (uint64_t) inst.node_first[i] + inst.node_count[i] <= h->numnodes &&
+         inst.run[i] < (int64_t) h->numruns &&
+         inst.status[i] >= LOG_UNKNOWN && inst.status[i] <= LOG_INFEASIBLE &&
+         by_name[i] >= 0 && (uint64_t) by_name[i] < h->numinstances;
+  for (uint64_t r = 0; ok && r < h->numnodes; r++)
+    ok = node.note[r] >= LOG_NOTE_NONE && node.note[r] <= LOG_NOTE_CUTOFF;
+  for (uint64_t r = 0; ok && r < h->numruns; r++)
+    ok = run_first[r] >= 0 && run_len[r] >= 0 &&
+         (uint64_t) run_first[r] + run_len[r] <= h->numstrings;
+  if (!ok) {
+    close();
+    err = file + ": corrupt log store";
+    return false;
+  }
+
+  numInstances = h->numinstances;
+  numNodes     = h->numnodes;
+  numRuns      = h->numruns;
+  madvise(map, size, MADV_RANDOM);
+  return true;
+}
+
+string LogStore::run(int32_t r) const
+{
+  if (r < 0 || (size_t) r >= numRuns) return string();
+  return string(strings + run_first[r], run_len[r]);
+}
+
+void LogStore::find(const string& name, int32_t run, size_t* first, size_t* last) const
+{
+  // (name, run) of by_name[k] against the key, run < 0 matching any run
+
+  auto less = [&](int64_t i, bool upper) {
+    int cmp = memcmp(strings + inst.name_first[i], name.data(),
+                     min((size_t) inst.name_len[i], name.size()));
+    if (cmp != 0) return cmp < 0;
+    if ((size_t) inst.name_len[i] != name.size()) return (size_t) inst.name_len[i] < name.size();
+    if (run < 0) return upper;
+    return upper ? inst.run[i] <= run : inst.run[i] < run;
+  };
+  size_t lo = 0, hi = numInstances;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (less(by_name[mid], false)) lo = mid + 1; else hi = mid;
+  }
+  *first = lo;
+  hi = numInstances;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (less(by_name[mid], true)) lo = mid + 1; else hi = mid;
+  }
+  *last = lo;
+}
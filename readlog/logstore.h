@@ -0,0 +1,96 @@
+/* Columnar binary store for parsed Gurobi logs (.mlog).
+
+   write_log_store saves LogColumns (gurobi_log.h) so that later queries
+   need neither the text logs nor a parse.  LogStore maps a store read-only
+   and points straight into the map, so opening it costs one mmap however
+   large it is, and a query only touches the pages of the columns it reads.
+
+   Layout, little endian, every column starting on a 64 byte boundary
+   (LOGSTORE_ALIGN; the structs are in logformat.h, shared with C):
+
+     LogStoreHeader
+     LogStoreColumn[numcolumns]       directory
+     column data
+
+   The directory names every column with the table it belongs to
+   ('i' instances, 'n' node log rows, 'r' runs, 's' strings, 'x' index) and
+   its element type ('c' char, 'b' int8, 'i' int32, 'l' int64, 'd' double),
+   so readers in other languages can find columns by name and skip the ones
+   they do not know.  Besides the LOG_INSTANCE_COLUMNS and LOG_NODE_COLUMNS
+   the store holds
+
+     i  name_first, name_len   instance name: model file without directory
+                               and extensions, offset into strings
+     r  run_first, run_len     log file of each run, offset into strings
+     s  strings
+     x  by_name                instances ordered by (name, run), for find
+
+   Stores written from a solve trace (Exercises/C/solvetrace.h) add a 't'
+   table with every callback record.
+*/
+
+#ifndef LOGSTORE_H
+#define LOGSTORE_H
+
+#include <stdint.h>
+#include <string>
+#include "gurobi_log.h"
+
+/* write_log_store
+ * inputs: c     parsed logs
+ *         file  store to create; written to file.tmp and renamed, so
+ *               readers never see a partial store
+ * output: true, or false with err set
+ */
+bool write_log_store(const LogColumns& c, const std::string& file, std::string& err);
+
+class LogStore
+{
+  public:
+#define LOGSTORE_POINTER(type, name) const type* name;
+    struct Instances {
+      LOG_INSTANCE_COLUMNS(LOGSTORE_POINTER)
+      const int64_t* name_first;
+      const int32_t* name_len;
+    } inst;
+    struct Nodes {
+      LOG_NODE_COLUMNS(LOGSTORE_POINTER)
+    } node;
+#undef LOGSTORE_POINTER
+    const int64_t* run_first;
+    const int32_t* run_len;
+    const int64_t* by_name;
+    const char*    strings;
+
+    size_t numInstances;
+    size_t numNodes;
+    size_t numRuns;
+
+    LogStore();
+    ~LogStore();
+
+    bool open(const std::string& file, std::string& err);
+    void close();
+
+    std::string name(size_t i) const { return std::string(strings + inst.name_first[i], inst.name_len[i]); }
+    std::string path(size_t i) const { return std::string(strings + inst.path_first[i], inst.path_len[i]); }
+    std::string run(int32_t r) const;
+
+    /* find
+     * output: [*first,*last) the positions in by_name of the instances
+     *         called name, in run order; run >= 0 narrows it to that run
+     */
+    void find(const std::string& name, int32_t run, size_t* first, size_t* last) const;
+
+  private:
+    LogStore(const LogStore&);
+    LogStore& operator=(const LogStore&);
+
+    template <class T>
+    bool bind(char table, const char* name, const T*& ptr, uint64_t count, std::string& err);
+
+    void*  map;
+    size_t size;
+};
+
+#endif
@@ -0,0 +1,216 @@
+/* Parse Gurobi logs into columns (gurobi_log.h) and print them as CSV.
+
+   Usage:  readlog [-nodes] [-q] [-j threads] [-o store.mlog] log...
+           readlog -f logfile
+
+   Every log is a file or a directory of log files.  The logs are cut at
+   their @01 markers and parsed on -j threads (default one per processor);
+   the output does not depend on the number of threads.
+
+   Prints one line per instance, or with -nodes one line per node log row
+   tagged with its instance.  -q only parses, for timing.  -o also saves
+   the columns as a binary store (logstore.h) that logquery reads without
+   parsing again.  The parse time and throughput are reported on stderr.
+
+   -f follows a log that is being written, such as the log of a running
+   solve, and prints its node rows as they appear (see follow below).
+
+   Build with gurobi_log.c++, logstore.c++, workpool.c++ and -pthread (add
+   -mavx2 to scan 32 bytes per compare).
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include "gurobi_log.h"
+#include "logstore.h"
+#include "workpool.h"
+using namespace std;
+
+static const char* statusname[] = { "unknown", "optimal", "timelimit", "infeasible" };
+
+static double now()
+{
+  return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void print_instances(const LogColumns& c)
+{
+  const LogColumns::Instances& x = c.inst;
+
+  printf("path,run,status,rows,cols,nonzeros,presolved_rows,presolved_cols,presolved_nonzeros,"
+         "root_obj,root_iters,nodes,simplex_iters,runtime,best_obj,best_bound,gap,node_rows\n");
+  for (size_t i = 0; i < c.numInstances(); i++)
+    printf("%s,%d,%s,%d,%d,%lld,%d,%d,%lld,%.10g,%lld,%lld,%lld,%.10g,%.10g,%.10g,%.10g,%lld\n",
+           c.path(i).c_str(), x.run[i], statusname[x.status[i]], x.rows[i], x.cols[i],
+           (long long) x.nonzeros[i], x.presolved_rows[i], x.presolved_cols[i],
+           (long long) x.presolved_nonzeros[i], x.root_obj[i], (long long) x.root_iters[i],
+           (long long) x.nodes[i], (long long) x.simplex_iters[i], x.runtime[i],
+           x.best_obj[i], x.best_bound[i], x.gap[i], (long long) x.node_count[i]);
+}
+
+static const char* node_header =
+  "instance,type,note,expl,unexpl,obj,depth,intinf,incumbent,bestbd,gap,itnode,time\n";
+
+static void print_node(const LogColumns& c, const string& path, int64_t r)
+{
+  const LogColumns::Nodes& x = c.node;
+  static const char* note[] = { "", "infeasible", "cutoff" };
+
+  printf("%s,%c,%s,%lld,%lld,%.10g,%d,%d,%.10g,%.10g,%.10g,%.10g,%.10g\n",
+         path.c_str(), x.type[r] == ' ' ? '.' : x.type[r], note[x.note[r]],
+         (long long) x.expl[r], (long long) x.unexpl[r], x.obj[r], x.depth[r],
+         x.intinf[r], x.incumbent[r], x.bestbd[r], x.gap[r], x.itnode[r], x.time[r]);
+}
+
+static void print_nodes(const LogColumns& c)
+{
+  printf("%s", node_header);
+  for (size_t i = 0; i < c.numInstances(); i++) {
+    string path = c.path(i);
+    for (int64_t r = c.inst.node_first[i]; r < c.inst.node_first[i] + c.inst.node_count[i]; r++)
+      print_node(c, path, r);
+  }
+}
+
+/* follow
+ * Print the node rows of a log as it is written, like tail -f: whatever
+ * was appended since the last read is parsed with the state of the parse
+ * so far, and the rows it completed are printed and flushed.  inotify
+ * wakes the loop when the file changes; it also polls every 250 ms, for
+ * file systems without inotify.  A log that shrinks was restarted and is
+ * parsed again from the beginning.  Ends when the file is deleted or
+ * renamed.
+ */
+static int follow(const char* file)
+{
+  static char buf[1 << 16];
+  LogColumns  cols;
+  LogState    st(0);
+  off_t       offset = 0;
+  size_t      inst = 0;       // instance of the next row to print
+  int64_t     printed = 0;    // rows printed
+  bool        gone = false;
+
+  int fd = open(file, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "%s: %s\n", file, strerror(errno));
+    return 1;
+  }
+  int in = inotify_init1(IN_CLOEXEC);
+  if (in >= 0 && inotify_add_watch(in, file, IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF) < 0) {
+    close(in);
+    in = -1;
+  }
+  cols.runs.push_back(file);
+  printf("%s", node_header);
+  fflush(stdout);
+
+  for (;;) {
+    struct stat sb;
+    ssize_t n;
+
+    if (fstat(fd, &sb) == 0) {
+      if (sb.st_size < offset) {
+        fprintf(stderr, "%s: truncated, reading it again\n", file);
+        offset = 0;
+        st = LogState(0);
+      }
+      if (sb.st_nlink == 0)
+        gone = true;
+    }
+    while ((n = pread(fd, buf, sizeof(buf), offset)) > 0) {
+      parse_log_part(buf, buf + n, cols, st);
+      offset += n;
+    }
+    if (n < 0) {
+      fprintf(stderr, "%s: %s\n", file, strerror(errno));
+      break;
+    }
+    if (gone)
+      finish_log(cols, st);
+
+    for (; printed < (int64_t) cols.numNodes(); printed++) {
+      while (cols.inst.node_first[inst] + cols.inst.node_count[inst] <= printed)
+        inst++;
+      print_node(cols, cols.path(inst), printed);
+    }
+    fflush(stdout);
+    if (gone)
+      break;
+
+    struct pollfd p = { in, POLLIN, 0 };
+    if (in < 0) {
+      usleep(250000);
+    } else if (poll(&p, 1, 250) > 0) {
+      char ev[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+      ssize_t len = read(in, ev, sizeof(ev));
+      for (char* q = ev; len > 0 && q < ev + len; q += sizeof(struct inotify_event) + ((struct inotify_event*) q)->len)
+        if (((struct inotify_event*) q)->mask & (IN_MOVE_SELF | IN_DELETE_SELF))
+          gone = true;
+    }
+  }
+  if (in >= 0) close(in);
+  close(fd);
+  return 0;
+}
+
+int
+main(int   argc,
+     char *argv[])
+{
+  LogColumns cols;
+  bool       nodes = false, quiet = false;
+  double     bytes = 0, start, secs;
+  string     err, store;
+  int        i, threads = 0;
+
+  for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+    if (strcmp(argv[i], "-nodes") == 0) nodes = true;
+    else if (strcmp(argv[i], "-q") == 0) quiet = true;
+    else if (strcmp(argv[i], "-f") == 0 && i+2 == argc) return follow(argv[i+1]);
+    else if (strcmp(argv[i], "-j") == 0 && i+1 < argc) threads = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-o") == 0 && i+1 < argc) store = argv[++i];
+    else break;
+  }
+  if (i == argc || argv[i][0] == '-') {
+    fprintf(stderr, "usage: %s [-nodes] [-q] [-j threads] [-o store.mlog] log...\n"
+                    "       %s -f logfile\n", argv[0], argv[0]);
+    return 1;
+  }
+
+  start = now();
+  if (!parse_log_files(vector<string>(argv + i, argv + argc), cols, threads, err)) {
+    fprintf(stderr, "%s\n", err.c_str());
+    return 1;
+  }
+  secs = now() - start;
+  for (size_t r = 0; r < cols.runs.size(); r++) {
+    struct stat sb;
+    if (stat(cols.runs[r].c_str(), &sb) == 0)
+      bytes += sb.st_size;
+  }
+
+  if (!quiet) {
+    if (nodes) print_nodes(cols);
+    else print_instances(cols);
+  }
+  fprintf(stderr, "Parsed %.1f MB in %.3f s (%.0f MB/s, %d threads): %zu logs, %zu instances, "
+          "%zu node rows\n", bytes/1e6, secs, secs > 0 ? bytes/1e6/secs : 0.0,
+          threads > 0 ? threads : default_threads(), cols.runs.size(),
+          cols.numInstances(), cols.numNodes());
+
+  if (!store.empty() && !write_log_store(cols, store, err)) {
+    fprintf(stderr, "%s\n", err.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,108 @@
+/* Work-stealing loop over a fixed set of tasks, see workpool.h */
+
+#include <mutex>
+#include <thread>
+#include "workpool.h"
+using namespace std;
+
+// Tasks [lo,hi) not yet started by a worker; the owner takes lo, thieves hi
+
+struct TaskRange {
+  mutex  m;
+  size_t lo, hi;
+};
+
+int default_threads()
+{
+  unsigned n = thread::hardware_concurrency();
+  return n > 0 ? (int) n : 1;
+}
+
+/* steal
+ * inputs: r  every worker's range, w  the thief, whose range is empty
+ * output: true with the back half of the largest other range moved to r[w],
+ *         false if no range has tasks left
+ */
+static bool steal(vector<TaskRange>& r, int w)
+{
+  for (;;) {
+    size_t best = 0;
+    int    victim = -1;
+
+    for (int v = 0; v < (int) r.size(); v++) {
+      lock_guard<mutex> l(r[v].m);
+      if (r[v].hi - r[v].lo > best) {
+        best = r[v].hi - r[v].lo;
+        victim = v;
+      }
+    }
+    if (victim < 0)
+      return false;
+
+    size_t lo, hi;
+    {
+      lock_guard<mutex> l(r[victim].m);
+      if (r[victim].lo == r[victim].hi)
+        continue;                       // emptied meanwhile, look again
+      hi = r[victim].hi;
+      lo = r[victim].lo + (hi - r[victim].lo) / 2;
+      r[victim].hi = lo;
+    }
+    lock_guard<mutex> l(r[w].m);
+    r[w].lo = lo;
+    r[w].hi = hi;
+    return true;
+  }
+}
+
+static void worker(vector<TaskRange>& r, int w, const function<void(size_t, int)>& task)
+{
+  for (;;) {
+    size_t k = 0;
+    bool   have;
+    {
+      lock_guard<mutex> l(r[w].m);
+      have = r[w].lo < r[w].hi;
+      if (have) k = r[w].lo++;
+    }
+    if (have)
+      task(k, w);
+    else if (!steal(r, w))
+      return;
+  }
+}
+
+void run_tasks(size_t ntasks, int threads, const vector<size_t>& weight,
+               const function<void(size_t, int)>& task)
+{
+  if (threads < 1)
+    threads = default_threads();
+  if ((size_t) threads > ntasks)
+    threads = (int) ntasks;
+  if (threads <= 1) {
+    for (size_t k = 0; k < ntasks; k++)
+      task(k, 0);
+    return;
+  }
+
+  // Cut [0,ntasks) into contiguous ranges of about equal weight
+
+  vector<TaskRange> r(threads);
+  double total = 0, sum = 0;
+  for (size_t k = 0; k < ntasks; k++)
+    total += weight.empty() ? 1 : weight[k];
+  size_t k = 0;
+  for (int w = 0; w < threads; w++) {
+    r[w].lo = k;
+    while (k < ntasks && (w == threads - 1 || sum < total * (w + 1) / threads))
+      sum += weight.empty() ? 1 : weight[k++];
+    r[w].hi = k;
+  }
+
+  vector<thread> pool;
+  for (int w = 1; w < threads; w++)
+    pool.push_back(thread(worker, ref(r), w, cref(task)));
+  worker(r, 0, task);
+  for (size_t t = 0; t < pool.size(); t++)
+    pool[t].join();
+}
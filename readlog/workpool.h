@@ -0,0 +1,38 @@
+/* Work-stealing loop over a fixed set of tasks.
+
+   run_tasks calls task(k, worker) once for every k in [0,ntasks) and
+   returns when all calls have finished.  Each worker starts with its own
+   contiguous range of tasks, cut so that the ranges carry about the same
+   weight, and works through it from the front.  A worker whose range runs
+   out steals the back half of the largest remaining range, so a few heavy
+   tasks (long logs, long instances) do not leave the other workers idle.
+
+   Tasks are only assigned, never created while running, so the order in
+   which results are produced is irrelevant as long as every task writes to
+   its own slot; merging the slots in task order makes the output
+   independent of the number of threads.
+*/
+
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <stddef.h>
+#include <functional>
+#include <vector>
+
+/* run_tasks
+ * inputs: ntasks   number of tasks
+ *         threads  workers, including the calling thread; < 1 means one per
+ *                  online processor, and never more than ntasks are started
+ *         weight   estimated cost of every task, or empty for equal costs
+ *         task     task(k, worker), worker in [0, threads)
+ */
+void run_tasks(size_t ntasks, int threads, const std::vector<size_t>& weight,
+               const std::function<void(size_t, int)>& task);
+
+/* default_threads
+ * output: the number of workers run_tasks starts for threads < 1
+ */
+int default_threads();
+
+#endif